@@ -0,0 +1,86 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <time.h>
+#include "fsl_mc_sys.h"
+#include "fsl_mc_lane.h"
+#include "utils.h"
+
+/*
+ * MC command lanes.
+ *
+ * All commands of one restool command go through the same lane, picked
+ * before the command runs. Commands on the priority lane get the
+ * MC_CMD_FLAG_PRI header flag whatever the flib call passed as
+ * cmd_flags. Commands on the normal lane may be paced instead: each one
+ * waits pace microseconds before it is sent.
+ */
+
+static enum mc_lane lane;
+static unsigned long lane_pace_us;
+
+void mc_lane_set(enum mc_lane new_lane)
+{
+	lane = new_lane;
+}
+
+enum mc_lane mc_lane_get(void)
+{
+	return lane;
+}
+
+void mc_lane_set_pace(unsigned long pace_us)
+{
+	lane_pace_us = pace_us;
+}
+
+/**
+ * Applies the current lane to a command about to be sent. The flag
+ * sits at the same header bit for MC 9 and MC 10 command layouts.
+ */
+void mc_lane_prepare_command(struct mc_command *cmd)
+{
+	struct mc_cmd_header *hdr = (struct mc_cmd_header *)&cmd->header;
+	struct timespec delay;
+
+	if (lane == MC_LANE_PRIORITY) {
+		hdr->flags_hw |= MC_CMD_FLAG_PRI;
+		return;
+	}
+
+	if (lane_pace_us == 0)
+		return;
+
+	delay.tv_sec = lane_pace_us / 1000000;
+	delay.tv_nsec = (lane_pace_us % 1000000) * 1000;
+	(void)nanosleep(&delay, NULL);
+}
@@ -39,6 +39,8 @@
 #include <sys/ioctl.h>
 #include "fsl_mc_sys.h"
 #include "fsl_mc_ioctl.h"
+#include "fsl_mc_trace.h"
+#include "fsl_mc_lane.h"
 #include "utils.h"
 
 int mc_io_init(struct fsl_mc_io *mc_io)
@@ -46,6 +48,11 @@ int mc_io_init(struct fsl_mc_io *mc_io)
 	int fd = -1;
 	int error;
 
+	if (mc_trace_is_replaying()) {
+		mc_io->fd = -1;
+		return 0;
+	}
+
 	fd = open(restool.device_file, O_RDWR | O_SYNC);
 
 	if (fd < 0) {
@@ -67,6 +74,9 @@ void mc_io_cleanup(struct fsl_mc_io *mc_io)
 {
 	int error;
 
+	if (mc_trace_is_replaying())
+		return;
+
 	assert(mc_io->fd != -1);
 
 	error = close(mc_io->fd);
@@ -76,8 +86,19 @@ void mc_io_cleanup(struct fsl_mc_io *mc_io)
 
 int mc_send_command(struct fsl_mc_io *mc_io, struct mc_command *cmd)
 {
+	struct mc_command request;
+	uint64_t request_ns = 0;
 	int error;
 
+	if (mc_trace_is_replaying())
+		return mc_trace_replay_command(cmd);
+
+	mc_lane_prepare_command(cmd);
+	if (mc_trace_is_recording()) {
+		request = *cmd;
+		request_ns = mc_trace_timestamp();
+	}
+
 	if (strcmp(restool.device_file, "/dev/mc_restool") == 0)
 		error = ioctl(mc_io->fd, RESTOOL_SEND_MC_COMMAND_LEGACY, cmd);
 	else
@@ -90,5 +111,25 @@ int mc_send_command(struct fsl_mc_io *mc_io, struct mc_command *cmd)
 			error);
 	}
 
+	if (mc_trace_is_recording())
+		mc_trace_log_command(&request, request_ns, cmd, error);
+
 	return error;
 }
+
+int mc_get_root_dprc_id(struct fsl_mc_io *mc_io, uint32_t *root_dprc_id)
+{
+	int error;
+
+	if (mc_trace_is_replaying())
+		return mc_trace_replay_root_dprc(root_dprc_id);
+
+	error = ioctl(mc_io->fd, RESTOOL_GET_ROOT_DPRC_INFO, root_dprc_id);
+	if (error == -1)
+		return -errno;
+
+	if (mc_trace_is_recording())
+		mc_trace_log_root_dprc(*root_dprc_id);
+
+	return 0;
+}
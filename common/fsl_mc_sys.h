@@ -51,4 +51,6 @@ void mc_io_cleanup(struct fsl_mc_io *mc_io);
 
 int mc_send_command(struct fsl_mc_io *mc_io, struct mc_command *cmd);
 
+int mc_get_root_dprc_id(struct fsl_mc_io *mc_io, uint32_t *root_dprc_id);
+
 #endif /* _FSL_MC_SYS_H */
@@ -0,0 +1,296 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "fsl_mc_sys.h"
+#include "fsl_mc_trace.h"
+#include "utils.h"
+
+/*
+ * MC command trace support.
+ *
+ * In record mode every command sent through mc_send_command() is appended
+ * to the trace file twice: once as handed to the kernel and once as
+ * returned by it. In replay mode no device is opened at all, commands are
+ * answered from the trace in the order they were recorded.
+ */
+
+static FILE *trace_fp;
+static bool trace_replay;
+static char trace_device_file[16];
+static unsigned long trace_num_commands;
+
+C_ASSERT(sizeof(struct mc_trace_record) ==
+	 sizeof(uint64_t) * 2 + sizeof(struct mc_command));
+
+uint64_t mc_trace_timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint16_t trace_cmd_id(uint64_t header)
+{
+	struct mc_cmd_header *hdr = (struct mc_cmd_header *)&header;
+
+	return le16_to_cpu(hdr->cmd_id);
+}
+
+static uint16_t trace_token(uint64_t header)
+{
+	struct mc_cmd_header *hdr = (struct mc_cmd_header *)&header;
+
+	return le16_to_cpu(hdr->token);
+}
+
+static void trace_write(enum mc_trace_rec_type type, uint64_t timestamp,
+			const struct mc_command *cmd, int error)
+{
+	struct mc_trace_record rec;
+
+	rec.timestamp_ns = cpu_to_le64(timestamp);
+	rec.type = cpu_to_le32(type);
+	rec.error = (int32_t)cpu_to_le32((uint32_t)error);
+	rec.header = cmd->header;
+	memcpy(rec.params, cmd->params, sizeof(rec.params));
+
+	if (fwrite(&rec, sizeof(rec), 1, trace_fp) != 1)
+		DEBUG_PRINTF("fwrite() to MC trace failed\n");
+}
+
+static int trace_read(enum mc_trace_rec_type expected_type,
+		      struct mc_trace_record *rec)
+{
+	if (fread(rec, sizeof(*rec), 1, trace_fp) != 1) {
+		ERROR_PRINTF("MC trace exhausted after %lu commands\n",
+			     trace_num_commands);
+		return -EIO;
+	}
+
+	if (le32_to_cpu(rec->type) != (uint32_t)expected_type) {
+		ERROR_PRINTF(
+			"MC trace diverged at command %lu: expected record type %d, found %u\n",
+			trace_num_commands, expected_type,
+			le32_to_cpu(rec->type));
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * mc_trace_record_start() - Start appending MC commands to a trace file
+ * @path: trace file to create; an existing file is truncated
+ *
+ * Must be called after restool.device_file is known.
+ */
+int mc_trace_record_start(const char *path)
+{
+	struct mc_trace_file_header hdr;
+	int error;
+
+	trace_fp = fopen(path, "wb");
+	if (trace_fp == NULL) {
+		error = -errno;
+		ERROR_PRINTF("cannot create MC trace %s: %s\n",
+			     path, strerror(errno));
+		return error;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, MC_TRACE_MAGIC, sizeof(MC_TRACE_MAGIC));
+	hdr.version = cpu_to_le32(MC_TRACE_VERSION);
+	strncpy(hdr.device_file, restool.device_file,
+		sizeof(hdr.device_file) - 1);
+
+	if (fwrite(&hdr, sizeof(hdr), 1, trace_fp) != 1) {
+		ERROR_PRINTF("cannot write MC trace header to %s\n", path);
+		fclose(trace_fp);
+		trace_fp = NULL;
+		return -EIO;
+	}
+
+	trace_replay = false;
+	return 0;
+}
+
+/**
+ * mc_trace_replay_start() - Answer MC commands from a recorded trace
+ * @path: trace file previously created with mc_trace_record_start()
+ */
+int mc_trace_replay_start(const char *path)
+{
+	struct mc_trace_file_header hdr;
+	int error;
+
+	trace_fp = fopen(path, "rb");
+	if (trace_fp == NULL) {
+		error = -errno;
+		ERROR_PRINTF("cannot open MC trace %s: %s\n",
+			     path, strerror(errno));
+		return error;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, trace_fp) != 1 ||
+	    memcmp(hdr.magic, MC_TRACE_MAGIC, sizeof(MC_TRACE_MAGIC)) != 0) {
+		ERROR_PRINTF("%s is not an MC trace\n", path);
+		goto error;
+	}
+
+	if (le32_to_cpu(hdr.version) != MC_TRACE_VERSION) {
+		ERROR_PRINTF("unsupported MC trace version %u\n",
+			     le32_to_cpu(hdr.version));
+		goto error;
+	}
+
+	hdr.device_file[sizeof(hdr.device_file) - 1] = '\0';
+	strcpy(trace_device_file, hdr.device_file);
+	trace_replay = true;
+	return 0;
+
+error:
+	fclose(trace_fp);
+	trace_fp = NULL;
+	return -EINVAL;
+}
+
+void mc_trace_stop(void)
+{
+	if (trace_fp == NULL)
+		return;
+
+	DEBUG_PRINTF("MC trace %s %lu commands\n",
+		     trace_replay ? "replayed" : "recorded",
+		     trace_num_commands);
+	fclose(trace_fp);
+	trace_fp = NULL;
+	trace_replay = false;
+}
+
+bool mc_trace_is_recording(void)
+{
+	return trace_fp != NULL && !trace_replay;
+}
+
+bool mc_trace_is_replaying(void)
+{
+	return trace_fp != NULL && trace_replay;
+}
+
+/**
+ * mc_trace_device_file() - Device file the replayed trace was recorded on
+ */
+const char *mc_trace_device_file(void)
+{
+	return trace_device_file;
+}
+
+/**
+ * mc_trace_log_command() - Append a command and its response to the trace
+ * @request_ns: mc_trace_timestamp() taken before the command was sent
+ */
+void mc_trace_log_command(const struct mc_command *request,
+			  uint64_t request_ns,
+			  const struct mc_command *response,
+			  int error)
+{
+	trace_write(MC_TRACE_REC_REQUEST, request_ns, request, 0);
+	trace_write(MC_TRACE_REC_RESPONSE, mc_trace_timestamp(), response,
+		    error);
+	trace_num_commands++;
+}
+
+/**
+ * mc_trace_replay_command() - Fill in the response to 'cmd' from the trace
+ *
+ * Returns the error the command originally completed with, or -EIO if the
+ * trace does not match the command being sent.
+ */
+int mc_trace_replay_command(struct mc_command *cmd)
+{
+	struct mc_trace_record rec;
+	int error;
+
+	error = trace_read(MC_TRACE_REC_REQUEST, &rec);
+	if (error)
+		return error;
+
+	if (trace_cmd_id(rec.header) != trace_cmd_id(cmd->header) ||
+	    trace_token(rec.header) != trace_token(cmd->header)) {
+		ERROR_PRINTF(
+			"MC trace diverged at command %lu: expected cmd %#x (token %#x), got cmd %#x (token %#x)\n",
+			trace_num_commands,
+			trace_cmd_id(rec.header), trace_token(rec.header),
+			trace_cmd_id(cmd->header), trace_token(cmd->header));
+		return -EIO;
+	}
+
+	if (memcmp(rec.params, cmd->params, sizeof(rec.params)) != 0)
+		DEBUG_PRINTF("command %lu (cmd %#x) parameters differ from trace\n",
+			     trace_num_commands, trace_cmd_id(cmd->header));
+
+	error = trace_read(MC_TRACE_REC_RESPONSE, &rec);
+	if (error)
+		return error;
+
+	cmd->header = rec.header;
+	memcpy(cmd->params, rec.params, sizeof(rec.params));
+	trace_num_commands++;
+
+	return (int32_t)le32_to_cpu((uint32_t)rec.error);
+}
+
+void mc_trace_log_root_dprc(uint32_t root_dprc_id)
+{
+	struct mc_command cmd = { 0 };
+
+	cmd.params[0] = cpu_to_le64(root_dprc_id);
+	trace_write(MC_TRACE_REC_ROOT_DPRC, mc_trace_timestamp(), &cmd, 0);
+}
+
+int mc_trace_replay_root_dprc(uint32_t *root_dprc_id)
+{
+	struct mc_trace_record rec;
+	int error;
+
+	error = trace_read(MC_TRACE_REC_ROOT_DPRC, &rec);
+	if (error)
+		return error;
+
+	*root_dprc_id = (uint32_t)le64_to_cpu(rec.params[0]);
+	return 0;
+}
@@ -0,0 +1,116 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _FSL_MC_TRACE_H
+#define _FSL_MC_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct mc_command;
+
+/**
+ * Trace file magic, including the null terminator
+ */
+#define MC_TRACE_MAGIC		"RSTLTRC"
+
+#define MC_TRACE_VERSION	1
+
+/**
+ * struct mc_trace_file_header - Header found at the start of a trace file
+ * @magic: MC_TRACE_MAGIC
+ * @version: MC_TRACE_VERSION, little endian
+ * @reserved: must be 0
+ * @device_file: device file restool talked to when the trace was recorded
+ */
+struct mc_trace_file_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	char device_file[16];
+};
+
+/**
+ * enum mc_trace_rec_type - Type of a trace record
+ * @MC_TRACE_REC_REQUEST: MC command as handed to the kernel
+ * @MC_TRACE_REC_RESPONSE: MC command as returned by the kernel
+ * @MC_TRACE_REC_ROOT_DPRC: result of RESTOOL_GET_ROOT_DPRC_INFO,
+ *	the root container id is kept in params[0]
+ */
+enum mc_trace_rec_type {
+	MC_TRACE_REC_REQUEST = 0,
+	MC_TRACE_REC_RESPONSE = 1,
+	MC_TRACE_REC_ROOT_DPRC = 2,
+};
+
+/**
+ * struct mc_trace_record - One fixed size trace record, little endian
+ * @timestamp_ns: CLOCK_MONOTONIC time the record was taken
+ * @type: one of enum mc_trace_rec_type
+ * @error: error returned to the caller (responses only)
+ * @header: MC command header, exactly as found in struct mc_command
+ * @params: MC command parameters, exactly as found in struct mc_command
+ */
+struct mc_trace_record {
+	uint64_t timestamp_ns;
+	uint32_t type;
+	int32_t error;
+	uint64_t header;
+	uint64_t params[7];
+};
+
+int mc_trace_record_start(const char *path);
+
+int mc_trace_replay_start(const char *path);
+
+void mc_trace_stop(void);
+
+bool mc_trace_is_recording(void);
+
+bool mc_trace_is_replaying(void);
+
+const char *mc_trace_device_file(void);
+
+uint64_t mc_trace_timestamp(void);
+
+void mc_trace_log_command(const struct mc_command *request,
+			  uint64_t request_ns,
+			  const struct mc_command *response,
+			  int error);
+
+int mc_trace_replay_command(struct mc_command *cmd);
+
+void mc_trace_log_root_dprc(uint32_t root_dprc_id);
+
+int mc_trace_replay_root_dprc(uint32_t *root_dprc_id);
+
+#endif /* _FSL_MC_TRACE_H */
@@ -41,6 +41,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpaiop.h"
 #include "mc_v10/fsl_dpaiop.h"
 
@@ -81,6 +82,9 @@ enum dpaiop_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_AIOP_CONTAINER,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpaiop_create_options[] = {
@@ -105,6 +109,27 @@ static struct option dpaiop_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -130,11 +155,12 @@ static struct option dpaiop_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpaiop_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpaiop_ops = {
+const struct flib_ops dpaiop_ops = {
 	.obj_open = dpaiop_open,
 	.obj_close = dpaiop_close,
 	.obj_get_irq_mask = dpaiop_get_irq_mask,
 	.obj_get_irq_status = dpaiop_get_irq_status,
+	.obj_destroy = dpaiop_destroy_v10,
 };
 
 static int cmd_dpaiop_help(void)
@@ -198,7 +224,8 @@ static int print_dpaiop_attr(uint32_t dpaiop_id,
 	uint32_t state;
 	bool dpaiop_opened = false;
 
-	error = dpaiop_open(&restool.mc_io, 0, dpaiop_id, &dpaiop_handle);
+	error = handle_cache_open("dpaiop", dpaiop_id, dpaiop_open,
+				  dpaiop_close, &dpaiop_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -258,18 +285,8 @@ static int print_dpaiop_attr(uint32_t dpaiop_id,
 	error = 0;
 
 out:
-	if (dpaiop_opened) {
-		int error2;
-
-		error2 = dpaiop_close(&restool.mc_io, 0, dpaiop_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpaiop_opened)
+		(void)handle_cache_release(dpaiop_handle);
 
 	return error;
 }
@@ -285,7 +302,8 @@ static int print_dpaiop_attr_v10(uint32_t dpaiop_id,
 	uint32_t state;
 	int error;
 
-	error = dpaiop_open_v10(&restool.mc_io, 0, dpaiop_id, &dpaiop_token);
+	error = handle_cache_open("dpaiop", dpaiop_id, dpaiop_open_v10,
+				  dpaiop_close_v10, &dpaiop_token);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -357,18 +375,8 @@ static int print_dpaiop_attr_v10(uint32_t dpaiop_id,
 	error = 0;
 
 out:
-	if (dpaiop_opened) {
-		int error2;
-
-		error2 = dpaiop_close_v10(&restool.mc_io, 0, dpaiop_token);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpaiop_opened)
+		(void)handle_cache_release(dpaiop_token);
 
 	return error;
 }
@@ -532,7 +540,7 @@ static int create_dpaiop_v10(struct dpaiop_cfg_v10 *dpaiop_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpaiop", dpaiop_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -640,6 +648,7 @@ static int destroy_dpaiop_v9(uint32_t dpaiop_id)
 	uint16_t dpaiop_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpaiop", dpaiop_id);
 	error = dpaiop_open(&restool.mc_io, 0, dpaiop_id, &dpaiop_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -699,6 +708,7 @@ static int destroy_dpaiop_v10(uint32_t dpaiop_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpaiop", dpaiop_id);
 	error = dpaiop_destroy_v10(&restool.mc_io, dprc_handle,
 				   0, dpaiop_id);
 	if (error < 0) {
@@ -711,7 +721,7 @@ static int destroy_dpaiop_v10(uint32_t dpaiop_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpbp.h"
 #include "mc_v10/fsl_dpbp.h"
 
@@ -79,6 +80,9 @@ C_ASSERT(ARRAY_SIZE(dpbp_info_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 enum dpbp_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpbp_create_options[] = {
@@ -96,6 +100,27 @@ static struct option dpbp_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -121,11 +146,12 @@ static struct option dpbp_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpbp_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpbp_ops = {
+const struct flib_ops dpbp_ops = {
 	.obj_open = dpbp_open,
 	.obj_close = dpbp_close,
 	.obj_get_irq_mask = dpbp_get_irq_mask,
 	.obj_get_irq_status = dpbp_get_irq_status,
+	.obj_destroy = dpbp_destroy_v10,
 };
 
 static int cmd_dpbp_help(void)
@@ -153,7 +179,8 @@ static int print_dpbp_attr_v9(uint32_t dpbp_id,
 	struct dpbp_attr dpbp_attr;
 	bool dpbp_opened = false;
 
-	error = dpbp_open(&restool.mc_io, 0, dpbp_id, &dpbp_handle);
+	error = handle_cache_open("dpbp", dpbp_id, dpbp_open,
+				  dpbp_close, &dpbp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -189,18 +216,8 @@ static int print_dpbp_attr_v9(uint32_t dpbp_id,
 
 	error = 0;
 out:
-	if (dpbp_opened) {
-		int error2;
-
-		error2 = dpbp_close(&restool.mc_io, 0, dpbp_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpbp_opened)
+		(void)handle_cache_release(dpbp_handle);
 
 	return error;
 }
@@ -214,7 +231,8 @@ static int print_dpbp_attr_v10(uint32_t dpbp_id,
 	uint16_t dpbp_handle;
 	int error;
 
-	error = dpbp_open_v10(&restool.mc_io, 0, dpbp_id, &dpbp_handle);
+	error = handle_cache_open("dpbp", dpbp_id, dpbp_open_v10,
+				  dpbp_close_v10, &dpbp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -259,18 +277,8 @@ static int print_dpbp_attr_v10(uint32_t dpbp_id,
 
 	error = 0;
 out:
-	if (dpbp_opened) {
-		int error2;
-
-		error2 = dpbp_close_v10(&restool.mc_io, 0, dpbp_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpbp_opened)
+		(void)handle_cache_release(dpbp_handle);
 
 	return error;
 }
@@ -432,7 +440,7 @@ static int create_dpbp_v10(struct dpbp_cfg_v10 *dpbp_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpbp", dpbp_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -503,6 +511,7 @@ static int destroy_dpbp_v9(uint32_t dpbp_id)
 	uint16_t dpbp_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpbp", dpbp_id);
 	error = dpbp_open(&restool.mc_io, 0, dpbp_id, &dpbp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -562,6 +571,7 @@ static int destroy_dpbp_v10(uint32_t dpbp_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpbp", dpbp_id);
 	error = dpbp_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpbp_id);
 	if (error < 0) {
@@ -574,7 +584,7 @@ static int destroy_dpbp_v10(uint32_t dpbp_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -37,10 +37,15 @@
 #include <stdint.h>
 #include <errno.h>
 #include <assert.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
 #include <getopt.h>
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
+#include "dprc_walk.h"
 #include "mc_v9/fsl_dpci.h"
 #include "mc_v10/fsl_dpci.h"
 
@@ -82,6 +87,9 @@ enum dpci_create_options {
 	CREATE_OPT_NUM_PRIORITIES,
 	CREATE_OPT_PARENT_DPRC,
 	CREATE_OPT_OPTIONS,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpci_create_options[] = {
@@ -113,6 +121,27 @@ static struct option dpci_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -138,11 +167,79 @@ static struct option dpci_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpci_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpci_ops = {
+/**
+ * dpci pairs command options
+ */
+enum dpci_pairs_options {
+	PAIRS_OPT_HELP = 0,
+	PAIRS_OPT_INTERVAL,
+	PAIRS_OPT_COUNT,
+};
+
+static struct option dpci_pairs_options[] = {
+	[PAIRS_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[PAIRS_OPT_INTERVAL] = {
+		.name = "interval",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[PAIRS_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpci_pairs_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * struct dpci_end - one DPCI as seen by dpci pairs
+ * @id: dpci id
+ * @container: id of the container holding the dpci
+ * @error: error of the last read, 0 when the fields below are valid
+ * @num_priorities: number of receive priorities
+ * @ep_type: type of the object the container connects the dpci to,
+ *	empty when it is not connected
+ * @ep_id: id of that object
+ * @peer_id: peer reported by the dpci itself, -1 when it has none
+ * @peer_priorities: number of receive priorities of the peer
+ * @up: link state, 1 for up and 0 for down
+ * @changes: number of link state changes seen in watch mode
+ * @flaps: number of up to down changes seen in watch mode
+ */
+struct dpci_end {
+	uint32_t id;
+	uint32_t container;
+	int error;
+	int num_priorities;
+	char ep_type[EP_OBJ_TYPE_MAX_LEN + 1];
+	int ep_id;
+	int peer_id;
+	int peer_priorities;
+	int up;
+	unsigned int changes;
+	unsigned int flaps;
+};
+
+static volatile sig_atomic_t pairs_stop;
+
+const struct flib_ops dpci_ops = {
 	.obj_open = dpci_open,
 	.obj_close = dpci_close,
 	.obj_get_irq_mask = dpci_get_irq_mask,
 	.obj_get_irq_status = dpci_get_irq_status,
+	.obj_destroy = dpci_destroy_v10,
 };
 
 static struct option_entry options_map_v10[] = {
@@ -160,6 +257,7 @@ static int cmd_dpci_help(void)
 		"   info - displays detailed information about a DPCI object.\n"
 		"   create - creates a new child DPCI under the root DPRC.\n"
 		"   destroy - destroys a child DPCI under the root DPRC.\n"
+		"   pairs - lists all DPCI pairs with their peer and link state.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
 		"\n";
@@ -178,7 +276,8 @@ static int print_dpci_attr_v9(uint32_t dpci_id,
 	bool dpci_opened = false;
 	int link_state;
 
-	error = dpci_open(&restool.mc_io, 0, dpci_id, &dpci_handle);
+	error = handle_cache_open("dpci", dpci_id, dpci_open,
+				  dpci_close, &dpci_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -245,18 +344,8 @@ static int print_dpci_attr_v9(uint32_t dpci_id,
 	error = 0;
 
 out:
-	if (dpci_opened) {
-		int error2;
-
-		error2 = dpci_close(&restool.mc_io, 0, dpci_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpci_opened)
+		(void)handle_cache_release(dpci_handle);
 
 	return error;
 }
@@ -269,10 +358,11 @@ static int print_dpci_attr_v10(uint32_t dpci_id,
 	uint16_t obj_major, obj_minor;
 	uint16_t dpci_handle;
 	bool dpci_opened = false;
-	int error, error2;
+	int error;
 	int link_state;
 
-	error = dpci_open_v10(&restool.mc_io, 0, dpci_id, &dpci_handle);
+	error = handle_cache_open("dpci", dpci_id, dpci_open_v10,
+				  dpci_close_v10, &dpci_handle);
 	if (error) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -347,16 +437,8 @@ static int print_dpci_attr_v10(uint32_t dpci_id,
 
 	error = 0;
 out:
-	if (dpci_opened) {
-		error2 = dpci_close_v10(&restool.mc_io, 0, dpci_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpci_opened)
+		(void)handle_cache_release(dpci_handle);
 
 	return error;
 }
@@ -590,7 +672,7 @@ static int create_dpci_v10(const char *usage_msg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpci", dpci_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -662,6 +744,7 @@ static int destroy_dpci_v9(uint32_t dpci_id)
 	uint16_t dpci_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpci", dpci_id);
 	error = dpci_open(&restool.mc_io, 0, dpci_id, &dpci_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -721,6 +804,7 @@ static int destroy_dpci_v10(uint32_t dpci_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpci", dpci_id);
 	error = dpci_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpci_id);
 	if (error < 0) {
@@ -733,7 +817,7 @@ static int destroy_dpci_v10(uint32_t dpci_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -797,6 +881,466 @@ static int cmd_dpci_destroy_v10(void)
 	return destroy_dpci(MC_FW_VERSION_10);
 }
 
+static void pairs_signal_handler(int sig)
+{
+	(void)sig;
+	pairs_stop = 1;
+}
+
+static int add_dpci_ends(struct dprc_walk_node *node, struct dpci_end **ends,
+			 int *num_ends, int *max_ends)
+{
+	struct dpci_end *end;
+	int error;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->obj_types[i] != OBJ_TYPE_DPCI)
+			continue;
+
+		if (*num_ends == *max_ends) {
+			int new_max = *max_ends ? *max_ends * 2 : 16;
+			struct dpci_end *new_ends;
+
+			new_ends = realloc(*ends, new_max * sizeof(**ends));
+			if (!new_ends) {
+				ERROR_PRINTF("realloc failed\n");
+				return -ENOMEM;
+			}
+			*ends = new_ends;
+			*max_ends = new_max;
+		}
+
+		end = &(*ends)[(*num_ends)++];
+		memset(end, 0, sizeof(*end));
+		end->id = node->objs[i].id;
+		end->container = node->id;
+		end->ep_id = -1;
+		end->peer_id = -1;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_dpci_ends(node->children[i], ends, num_ends,
+				      max_ends);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static int cmp_dpci_end(const void *a, const void *b)
+{
+	const struct dpci_end *end_a = a;
+	const struct dpci_end *end_b = b;
+
+	return (end_a->id > end_b->id) - (end_a->id < end_b->id);
+}
+
+static struct dpci_end *find_dpci_end(struct dpci_end *ends, int num_ends,
+				      int id)
+{
+	struct dpci_end key = { .id = id };
+
+	if (id < 0)
+		return NULL;
+
+	return bsearch(&key, ends, num_ends, sizeof(*ends), cmp_dpci_end);
+}
+
+/**
+ * Reads the connection, peer and link state of one dpci. The dpci is
+ * opened once for all of its queries.
+ */
+static int read_dpci_end(struct dpci_end *end)
+{
+	struct dprc_endpoint endpoint1, endpoint2;
+	struct dpci_peer_attr_v10 peer_attr;
+	struct dpci_attr_v10 attr;
+	uint16_t dpci_handle;
+	int state;
+	int error;
+	int error2;
+
+	memset(&endpoint1, 0, sizeof(endpoint1));
+	memset(&endpoint2, 0, sizeof(endpoint2));
+	strcpy(endpoint1.type, "dpci");
+	endpoint1.id = end->id;
+
+	error = dprc_get_connection(&restool.mc_io, 0,
+				    restool.root_dprc_handle,
+				    &endpoint1, &endpoint2, &state);
+	if (error == -ENAVAIL || (error == 0 && state == -1)) {
+		end->ep_type[0] = '\0';
+		end->ep_id = -1;
+	} else if (error < 0) {
+		goto out;
+	} else {
+		strncpy(end->ep_type, endpoint2.type, EP_OBJ_TYPE_MAX_LEN);
+		end->ep_type[EP_OBJ_TYPE_MAX_LEN] = '\0';
+		end->ep_id = endpoint2.id;
+	}
+
+	error = dpci_open_v10(&restool.mc_io, 0, end->id, &dpci_handle);
+	if (error < 0)
+		goto out;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpci_get_attributes_v10(&restool.mc_io, 0, dpci_handle, &attr);
+	if (error < 0)
+		goto out_close;
+	end->num_priorities = attr.num_of_priorities;
+
+	memset(&peer_attr, 0, sizeof(peer_attr));
+	error = dpci_get_peer_attributes_v10(&restool.mc_io, 0, dpci_handle,
+					     &peer_attr);
+	if (error < 0)
+		goto out_close;
+	end->peer_id = peer_attr.peer_id;
+	end->peer_priorities = peer_attr.num_of_priorities;
+
+	error = dpci_get_link_state_v10(&restool.mc_io, 0, dpci_handle,
+					&end->up);
+
+out_close:
+	error2 = dpci_close_v10(&restool.mc_io, 0, dpci_handle);
+	if (error2 < 0 && error == 0)
+		error = error2;
+out:
+	end->error = error;
+	return error;
+}
+
+/**
+ * Reads all dpcis in one pass. A dpci that cannot be read is reported
+ * with its status instead of ending the pass.
+ */
+static void read_dpci_ends(struct dpci_end *ends, int num_ends)
+{
+	for (int i = 0; i < num_ends && !pairs_stop; i++)
+		(void)read_dpci_end(&ends[i]);
+}
+
+/**
+ * A pair whose two ends agree is shown once, under its lowest dpci id
+ */
+static bool is_second_end(struct dpci_end *ends, int num_ends,
+			  const struct dpci_end *end)
+{
+	struct dpci_end *peer;
+
+	if (end->error || end->peer_id < 0 ||
+	    (uint32_t)end->peer_id > end->id)
+		return false;
+
+	peer = find_dpci_end(ends, num_ends, end->peer_id);
+	return peer && !peer->error && peer->peer_id == (int)end->id;
+}
+
+static const char *dpci_end_status(struct dpci_end *ends, int num_ends,
+				   const struct dpci_end *end)
+{
+	struct dpci_end *peer;
+
+	if (end->error)
+		return "read error";
+	if (end->ep_type[0] == '\0' && end->peer_id < 0)
+		return "unpaired";
+	if (end->ep_type[0] != '\0' && strcmp(end->ep_type, "dpci") != 0)
+		return "connected to a non-dpci";
+	if (end->peer_id != end->ep_id)
+		return "peer mismatch";
+
+	peer = find_dpci_end(ends, num_ends, end->peer_id);
+	if (peer && !peer->error && peer->peer_id != (int)end->id)
+		return "peer mismatch";
+	if (!end->up)
+		return "down";
+
+	return "ok";
+}
+
+static void dpci_peer_name(const struct dpci_end *end, char *buf,
+			   size_t size)
+{
+	if (end->peer_id >= 0)
+		snprintf(buf, size, "dpci.%d", end->peer_id);
+	else if (end->ep_type[0] != '\0')
+		snprintf(buf, size, "%s.%d", end->ep_type, end->ep_id);
+	else
+		snprintf(buf, size, "-");
+}
+
+static void print_dpci_pairs(struct dpci_end *ends, int num_ends)
+{
+	int num_pairs = 0;
+	int num_problems = 0;
+	char name[32];
+	char peer[32];
+	char prio[16];
+
+	printf("%-12s  %-12s  %-10s  %-4s  %s\n", "dpci", "peer",
+	       "priorities", "link", "status");
+
+	for (int i = 0; i < num_ends; i++) {
+		const struct dpci_end *end = &ends[i];
+		const char *status;
+
+		if (is_second_end(ends, num_ends, end))
+			continue;
+
+		status = dpci_end_status(ends, num_ends, end);
+		if (strcmp(status, "ok") == 0)
+			num_pairs++;
+		else
+			num_problems++;
+
+		snprintf(name, sizeof(name), "dpci.%u", end->id);
+		if (end->error) {
+			mc_status = flib_error_to_mc_status(end->error);
+			printf("%-12s  %-12s  %-10s  %-4s  %s: %s\n", name,
+			       "-", "-", "-", status,
+			       mc_status_to_string(mc_status));
+			continue;
+		}
+
+		dpci_peer_name(end, peer, sizeof(peer));
+		if (end->peer_id >= 0)
+			snprintf(prio, sizeof(prio), "%d/%d",
+				 end->num_priorities, end->peer_priorities);
+		else
+			snprintf(prio, sizeof(prio), "%d",
+				 end->num_priorities);
+
+		printf("%-12s  %-12s  %-10s  %-4s  %s\n", name, peer, prio,
+		       end->peer_id < 0 ? "-" : end->up ? "up" : "down",
+		       status);
+	}
+
+	printf("\n%d dpci objects, %d healthy pairs, %d problems\n",
+	       num_ends, num_pairs, num_problems);
+}
+
+static void print_pairs_timestamp(void)
+{
+	struct timespec now;
+	struct tm tm;
+	char buf[32];
+
+	(void)clock_gettime(CLOCK_REALTIME, &now);
+	localtime_r(&now.tv_sec, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%06ld ", buf, now.tv_nsec / 1000);
+}
+
+/**
+ * Compares a new read of one dpci with the previous one, prints what
+ * changed and counts link transitions
+ */
+static void check_dpci_end(struct dpci_end *ends, int num_ends,
+			   struct dpci_end *end, const struct dpci_end *old)
+{
+	char peer[32];
+	char old_peer[32];
+
+	if (end->error != old->error) {
+		print_pairs_timestamp();
+		if (end->error) {
+			mc_status = flib_error_to_mc_status(end->error);
+			printf("dpci.%u: read error: %s\n", end->id,
+			       mc_status_to_string(mc_status));
+		} else {
+			printf("dpci.%u: readable again\n", end->id);
+		}
+		return;
+	}
+
+	if (end->error || is_second_end(ends, num_ends, end))
+		return;
+
+	if (end->peer_id != old->peer_id || end->ep_id != old->ep_id ||
+	    strcmp(end->ep_type, old->ep_type) != 0) {
+		dpci_peer_name(end, peer, sizeof(peer));
+		dpci_peer_name(old, old_peer, sizeof(old_peer));
+		print_pairs_timestamp();
+		printf("dpci.%u: peer %s -> %s (%s)\n", end->id, old_peer,
+		       peer, dpci_end_status(ends, num_ends, end));
+	}
+
+	if (end->peer_id >= 0 && end->up != old->up) {
+		end->changes++;
+		if (!end->up)
+			end->flaps++;
+		print_pairs_timestamp();
+		printf("dpci.%u <-> dpci.%d: %s\n", end->id, end->peer_id,
+		       end->up ? "up" : "down");
+	}
+}
+
+/**
+ * Polls all dpcis every interval milliseconds, count times or until
+ * interrupted when count is 0, and prints the changes seen
+ */
+static int watch_dpci_pairs(struct dpci_end *ends, int num_ends,
+			    long interval, long count)
+{
+	struct sigaction sa, old_int, old_term;
+	struct dpci_end *old;
+	struct timespec delay;
+	bool changed = false;
+
+	old = malloc(num_ends * sizeof(*old));
+	if (!old) {
+		ERROR_PRINTF("malloc failed\n");
+		return -ENOMEM;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = pairs_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	(void)sigaction(SIGINT, &sa, &old_int);
+	(void)sigaction(SIGTERM, &sa, &old_term);
+
+	delay.tv_sec = interval / 1000;
+	delay.tv_nsec = (interval % 1000) * 1000000;
+	printf("\nwatching %d dpci objects every %ld ms\n", num_ends,
+	       interval);
+	fflush(stdout);
+
+	for (long poll = 0; !pairs_stop && (count == 0 || poll < count);
+	     poll++) {
+		(void)nanosleep(&delay, NULL);
+		if (pairs_stop)
+			break;
+
+		memcpy(old, ends, num_ends * sizeof(*old));
+		read_dpci_ends(ends, num_ends);
+		if (pairs_stop)
+			break;
+
+		for (int i = 0; i < num_ends; i++)
+			check_dpci_end(ends, num_ends, &ends[i], &old[i]);
+		fflush(stdout);
+	}
+
+	(void)sigaction(SIGINT, &old_int, NULL);
+	(void)sigaction(SIGTERM, &old_term, NULL);
+	free(old);
+
+	printf("\n");
+	for (int i = 0; i < num_ends; i++) {
+		if (ends[i].changes == 0)
+			continue;
+
+		printf("dpci.%u <-> dpci.%d: %u changes, %u flaps\n",
+		       ends[i].id, ends[i].peer_id, ends[i].changes,
+		       ends[i].flaps);
+		changed = true;
+	}
+	if (!changed)
+		printf("no link changes seen\n");
+
+	return 0;
+}
+
+static int cmd_dpci_pairs(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpci pairs [OPTIONS]\n"
+		"   Lists all DPCIs in the root container and the containers\n"
+		"   below it with their peer, number of priorities on both\n"
+		"   ends and link state, and reports unpaired DPCIs, down\n"
+		"   links and peers the two ends disagree on. A healthy pair\n"
+		"   is shown once, on the line of its lowest DPCI id.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--interval=<ms>\n"
+		"   After the list, keep polling every <ms> milliseconds and\n"
+		"   print each peer or link state change with a timestamp,\n"
+		"   until interrupted. The number of changes and flaps of\n"
+		"   each pair is printed at the end.\n"
+		"--count=<number>\n"
+		"   Stop watching after this number of polls. Requires\n"
+		"   --interval.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Watch all DPCI pairs for flaps every 100ms:\n"
+		"   $ restool dpci pairs --interval=100\n"
+		"\n";
+
+	struct dprc_walk_node *root = NULL;
+	struct dpci_end *ends = NULL;
+	int num_ends = 0;
+	int max_ends = 0;
+	long interval = 0;
+	long count = 0;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(PAIRS_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(PAIRS_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		ERROR_PRINTF("Unexpected argument: \'%s\'\n\n",
+			     restool.obj_name);
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(PAIRS_OPT_INTERVAL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(PAIRS_OPT_INTERVAL);
+		error = get_option_value(PAIRS_OPT_INTERVAL, &interval,
+					 "Invalid interval value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(PAIRS_OPT_COUNT)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(PAIRS_OPT_COUNT);
+		if (interval == 0) {
+			ERROR_PRINTF("--count requires --interval\n");
+			puts(usage_msg);
+			return -EINVAL;
+		}
+		error = get_option_value(PAIRS_OPT_COUNT, &count,
+					 "Invalid count value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+	}
+
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = add_dpci_ends(root, &ends, &num_ends, &max_ends);
+	if (error < 0)
+		goto out;
+
+	if (num_ends == 0) {
+		printf("no dpci objects in dprc.%u\n", restool.root_dprc_id);
+		goto out;
+	}
+
+	qsort(ends, num_ends, sizeof(*ends), cmp_dpci_end);
+
+	pairs_stop = 0;
+	read_dpci_ends(ends, num_ends);
+	print_dpci_pairs(ends, num_ends);
+	fflush(stdout);
+
+	if (interval)
+		error = watch_dpci_pairs(ends, num_ends, interval, count);
+out:
+	free(ends);
+	if (root)
+		dprc_walk_free(root);
+	return error;
+}
+
 struct object_command dpci_commands_v9[] = {
 	{ .cmd_name = "help",
 	  .options = NULL,
@@ -834,6 +1378,10 @@ struct object_command dpci_commands_v10[] = {
 	  .options = dpci_destroy_options,
 	  .cmd_func = cmd_dpci_destroy_v10 },
 
+	{ .cmd_name = "pairs",
+	  .options = dpci_pairs_options,
+	  .cmd_func = cmd_dpci_pairs },
+
 	{ .cmd_name = NULL },
 };
 
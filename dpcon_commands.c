@@ -41,6 +41,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpcon.h"
 #include "mc_v10/fsl_dpcon.h"
 
@@ -81,6 +82,9 @@ enum dpcon_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_NUM_PRIORITIES,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpcon_create_options[] = {
@@ -105,6 +109,27 @@ static struct option dpcon_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -130,11 +155,12 @@ static struct option dpcon_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpcon_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpcon_ops = {
+const struct flib_ops dpcon_ops = {
 	.obj_open = dpcon_open,
 	.obj_close = dpcon_close,
 	.obj_get_irq_mask = dpcon_get_irq_mask,
 	.obj_get_irq_status = dpcon_get_irq_status,
+	.obj_destroy = dpcon_destroy_v10,
 };
 
 static int cmd_dpcon_help(void)
@@ -162,7 +188,8 @@ static int print_dpcon_attr_v9(uint32_t dpcon_id,
 	struct dpcon_attr dpcon_attr;
 	bool dpcon_opened = false;
 
-	error = dpcon_open(&restool.mc_io, 0, dpcon_id, &dpcon_handle);
+	error = handle_cache_open("dpcon", dpcon_id, dpcon_open,
+				  dpcon_close, &dpcon_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -203,18 +230,8 @@ static int print_dpcon_attr_v9(uint32_t dpcon_id,
 	error = 0;
 
 out:
-	if (dpcon_opened) {
-		int error2;
-
-		error2 = dpcon_close(&restool.mc_io, 0, dpcon_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpcon_opened)
+		(void)handle_cache_release(dpcon_handle);
 
 	return error;
 }
@@ -228,7 +245,8 @@ static int print_dpcon_attr_v10(uint32_t dpcon_id,
 	uint16_t dpcon_handle;
 	int error;
 
-	error = dpcon_open_v10(&restool.mc_io, 0, dpcon_id, &dpcon_handle);
+	error = handle_cache_open("dpcon", dpcon_id, dpcon_open_v10,
+				  dpcon_close_v10, &dpcon_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -277,18 +295,8 @@ static int print_dpcon_attr_v10(uint32_t dpcon_id,
 	error = 0;
 
 out:
-	if (dpcon_opened) {
-		int error2;
-
-		error2 = dpcon_close_v10(&restool.mc_io, 0, dpcon_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpcon_opened)
+		(void)handle_cache_release(dpcon_handle);
 
 	return error;
 }
@@ -451,7 +459,7 @@ static int create_dpcon_v10(struct dpcon_cfg_v10 *dpcon_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpcon", dpcon_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -558,6 +566,7 @@ static int destroy_dpcon_v9(uint32_t dpcon_id)
 	uint16_t dpcon_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpcon", dpcon_id);
 	error = dpcon_open(&restool.mc_io, 0, dpcon_id, &dpcon_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -617,6 +626,7 @@ static int destroy_dpcon_v10(uint32_t dpcon_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpcon", dpcon_id);
 	error = dpcon_destroy_v10(&restool.mc_io, dprc_handle,
 				  0, dpcon_id);
 	if (error < 0) {
@@ -629,7 +639,7 @@ static int destroy_dpcon_v10(uint32_t dpcon_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
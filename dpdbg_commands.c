@@ -35,10 +35,16 @@
 #include <stdint.h>
 #include <errno.h>
 #include <assert.h>
+#include <stdarg.h>
 #include <getopt.h>
+#include <signal.h>
+#include <time.h>
 #include "restool.h"
 #include "utils.h"
+#include "dprc_walk.h"
+#include "label_index.h"
 #include "mc_v9/fsl_dpdbg.h"
+#include "mc_v9/fsl_dpci.h"
 
 enum mc_cmd_status mc_status;
 
@@ -62,6 +68,326 @@ static struct option dpdbg_info_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpdbg_info_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
+/**
+ * dpdbg trace and mark command options. The mark command takes all of
+ * them up to SET_OPT_SENDER, the ones after it only apply to traces.
+ */
+enum dpdbg_set_options {
+	SET_OPT_HELP = 0,
+	SET_OPT_OBJECT,
+	SET_OPT_MARKING,
+	SET_OPT_DIRECTION,
+	SET_OPT_TC,
+	SET_OPT_FLOW,
+	SET_OPT_DPBP,
+	SET_OPT_SENDER,
+	SET_OPT_VERBOSITY,
+	SET_OPT_ENQUEUE_TYPE,
+};
+
+static struct option dpdbg_trace_options[] = {
+	[SET_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[SET_OPT_OBJECT] = {
+		.name = "object",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_MARKING] = {
+		.name = "marking",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_DIRECTION] = {
+		.name = "direction",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_TC] = {
+		.name = "tc",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_FLOW] = {
+		.name = "flow",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_DPBP] = {
+		.name = "dpbp",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_SENDER] = {
+		.name = "sender",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_VERBOSITY] = {
+		.name = "verbosity",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_ENQUEUE_TYPE] = {
+		.name = "enqueue-type",
+		.has_arg = 1,
+	},
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpdbg_trace_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+static struct option dpdbg_mark_options[] = {
+	[SET_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[SET_OPT_OBJECT] = {
+		.name = "object",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_MARKING] = {
+		.name = "marking",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_DIRECTION] = {
+		.name = "direction",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_TC] = {
+		.name = "tc",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_FLOW] = {
+		.name = "flow",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_DPBP] = {
+		.name = "dpbp",
+		.has_arg = 1,
+	},
+
+	[SET_OPT_SENDER] = {
+		.name = "sender",
+		.has_arg = 1,
+	},
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpdbg_mark_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dpdbg counters command options
+ */
+enum dpdbg_counters_options {
+	COUNTERS_OPT_HELP = 0,
+	COUNTERS_OPT_OBJECT,
+	COUNTERS_OPT_INTERVAL,
+	COUNTERS_OPT_COUNT,
+};
+
+static struct option dpdbg_counters_options[] = {
+	[COUNTERS_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[COUNTERS_OPT_OBJECT] = {
+		.name = "object",
+		.has_arg = 1,
+	},
+
+	[COUNTERS_OPT_INTERVAL] = {
+		.name = "interval",
+		.has_arg = 1,
+	},
+
+	[COUNTERS_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+	},
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpdbg_counters_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * Trace points a single trace command sets, the most any object type
+ * has
+ */
+#define DPDBG_MAX_TRACE_POINTS	2
+
+C_ASSERT(DPDBG_NUM_OF_DPIO_TRACE_POINTS <= DPDBG_MAX_TRACE_POINTS);
+C_ASSERT(DPDBG_NUM_OF_DPCON_TRACE_POINTS <= DPDBG_MAX_TRACE_POINTS);
+C_ASSERT(DPDBG_NUM_OF_DPSECI_TRACE_POINTS <= DPDBG_MAX_TRACE_POINTS);
+
+/**
+ * struct dpdbg_set_cfg - what a trace or mark command applies to
+ * @type: type of the object traced or marked
+ * @id: id of the object traced or marked
+ * @tx: dpni egress (trace) or Tx confirmation (mark) instead of ingress
+ * @markings: debug marking of each trace point, or the only marking
+ * @num_markings: number of entries in @markings
+ * @tc: dpni traffic class, DPDBG_DPNI_ALL_TCS for all
+ * @flow: dpni Rx flow, DPDBG_DPNI_ALL_TC_FLOWS for all
+ * @dpbp: dpni buffer pool, DPDBG_DPNI_ALL_DPBP for all
+ * @sender: dpni sender, DPDBG_DPNI_ALL_SENDERS for all
+ * @verbosity: verbosity of the dpio, dpcon and dpseci trace points
+ * @enqueue_type: dpio trace point type
+ */
+struct dpdbg_set_cfg {
+	enum obj_type type;
+	uint32_t id;
+	bool tx;
+	uint8_t markings[DPDBG_MAX_TRACE_POINTS];
+	int num_markings;
+	uint8_t tc;
+	uint16_t flow;
+	uint16_t dpbp;
+	uint16_t sender;
+	enum dpdbg_verbosity_level verbosity;
+	enum dpdbg_dpio_trace_type enqueue_type;
+};
+
+/**
+ * Counters read by the counters command, in the order they are printed
+ */
+static const struct {
+	enum dpni_counter counter;
+	const char *name;
+} dpni_counters[] = {
+	{ DPNI_CNT_ING_FRAME, "ing_frame" },
+	{ DPNI_CNT_ING_BYTE, "ing_byte" },
+	{ DPNI_CNT_ING_FRAME_DROP, "ing_frame_drop" },
+	{ DPNI_CNT_ING_FRAME_DISCARD, "ing_frame_discard" },
+	{ DPNI_CNT_ING_MCAST_FRAME, "ing_mcast_frame" },
+	{ DPNI_CNT_ING_MCAST_BYTE, "ing_mcast_byte" },
+	{ DPNI_CNT_ING_BCAST_FRAME, "ing_bcast_frame" },
+	{ DPNI_CNT_ING_BCAST_BYTES, "ing_bcast_bytes" },
+	{ DPNI_CNT_EGR_FRAME, "egr_frame" },
+	{ DPNI_CNT_EGR_BYTE, "egr_byte" },
+	{ DPNI_CNT_EGR_FRAME_DISCARD, "egr_frame_discard" },
+};
+
+static const struct {
+	enum dpmac_counter counter;
+	const char *name;
+} dpmac_counters[] = {
+	{ DPMAC_CNT_ING_FRAME_64, "ing_frame_64" },
+	{ DPMAC_CNT_ING_FRAME_127, "ing_frame_127" },
+	{ DPMAC_CNT_ING_FRAME_255, "ing_frame_255" },
+	{ DPMAC_CNT_ING_FRAME_511, "ing_frame_511" },
+	{ DPMAC_CNT_ING_FRAME_1023, "ing_frame_1023" },
+	{ DPMAC_CNT_ING_FRAME_1518, "ing_frame_1518" },
+	{ DPMAC_CNT_ING_FRAME_1519_MAX, "ing_frame_1519_max" },
+	{ DPMAC_CNT_ING_FRAG, "ing_frag" },
+	{ DPMAC_CNT_ING_JABBER, "ing_jabber" },
+	{ DPMAC_CNT_ING_FRAME_DISCARD, "ing_frame_discard" },
+	{ DPMAC_CNT_ING_ALIGN_ERR, "ing_align_err" },
+	{ DPMAC_CNT_EGR_UNDERSIZED, "egr_undersized" },
+	{ DPMAC_CNT_ING_OVERSIZED, "ing_oversized" },
+	{ DPMAC_CNT_ING_VALID_PAUSE_FRAME, "ing_valid_pause_frame" },
+	{ DPMAC_CNT_EGR_VALID_PAUSE_FRAME, "egr_valid_pause_frame" },
+	{ DPMAC_CNT_ING_BYTE, "ing_byte" },
+	{ DPMAC_CNT_ING_MCAST_FRAME, "ing_mcast_frame" },
+	{ DPMAC_CNT_ING_BCAST_FRAME, "ing_bcast_frame" },
+	{ DPMAC_CNT_ING_ALL_FRAME, "ing_all_frame" },
+	{ DPMAC_CNT_ING_UCAST_FRAME, "ing_ucast_frame" },
+	{ DPMAC_CNT_ING_ERR_FRAME, "ing_err_frame" },
+	{ DPMAC_CNT_EGR_BYTE, "egr_byte" },
+	{ DPMAC_CNT_EGR_MCAST_FRAME, "egr_mcast_frame" },
+	{ DPMAC_CNT_EGR_BCAST_FRAME, "egr_bcast_frame" },
+	{ DPMAC_CNT_EGR_UCAST_FRAME, "egr_ucast_frame" },
+	{ DPMAC_CNT_EGR_ERR_FRAME, "egr_err_frame" },
+	{ DPMAC_CNT_ING_GOOD_FRAME, "ing_good_frame" },
+	{ DPMAC_CNT_ENG_GOOD_FRAME, "egr_good_frame" },
+};
+
+#define MAX_DPDBG_COUNTERS	ARRAY_SIZE(dpmac_counters)
+
+C_ASSERT(ARRAY_SIZE(dpni_counters) <= MAX_DPDBG_COUNTERS);
+
+/**
+ * struct counted_obj - dpni or dpmac whose counters are swept
+ * @type: OBJ_TYPE_DPNI or OBJ_TYPE_DPMAC
+ * @id: object id
+ * @values: counter values of the last sweep, in the order of the
+ *	counter table of @type
+ */
+struct counted_obj {
+	enum obj_type type;
+	uint32_t id;
+	uint64_t values[MAX_DPDBG_COUNTERS];
+};
+
+static volatile sig_atomic_t counters_stop;
+
+/**
+ * dpdbg queues command options
+ */
+enum dpdbg_queues_options {
+	QUEUES_OPT_HELP = 0,
+	QUEUES_OPT_ID,
+	QUEUES_OPT_JSON,
+};
+
+static struct option dpdbg_queues_options[] = {
+	[QUEUES_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[QUEUES_OPT_ID] = {
+		.name = "id",
+		.has_arg = 1,
+	},
+
+	[QUEUES_OPT_JSON] = {
+		.name = "json",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpdbg_queues_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+enum queue_kind {
+	QUEUE_QDID,
+	QUEUE_FQID,
+	QUEUE_CHANNEL,
+	QUEUE_BPID,
+};
+
+/**
+ * struct queue_entry - hardware queue id used by an object
+ * @kind: what @qid identifies
+ * @qid: virtual queue, channel or buffer pool id
+ * @type: type of the object using @qid
+ * @obj_id: id of the object using @qid
+ * @use: what the object uses @qid for, may be empty
+ */
+struct queue_entry {
+	enum queue_kind kind;
+	uint32_t qid;
+	enum obj_type type;
+	uint32_t obj_id;
+	char use[24];
+};
+
+/**
+ * struct queue_index - queue ids of all objects, sorted once complete
+ */
+struct queue_index {
+	struct queue_entry *entries;
+	int num_entries;
+	int max_entries;
+};
+
 static int cmd_dpdbg_help(void)
 {
 	static const char help_msg[] =
@@ -69,6 +395,10 @@ static int cmd_dpdbg_help(void)
 		"Usage: restool dpdbg <command> [--help] [ARGS...]\n"
 		"Where <command> can be:\n"
 		"   info - displays detailed information about a DPDBG object.\n"
+		"   trace - configures a datapath trace point.\n"
+		"   mark - configures the debug marking of frames.\n"
+		"   counters - reads dpni and dpmac counters, with deltas.\n"
+		"   queues - lists the queue ids used by all objects.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
 		"\n";
@@ -199,14 +529,1165 @@ out:
 	return error;
 }
 
-struct object_command dpdbg_commands[] = {
-	{ .cmd_name = "help",
-	  .options = NULL,
-	  .cmd_func = cmd_dpdbg_help },
+static int open_dpdbg(uint32_t dpdbg_id, uint16_t *dpdbg_handle)
+{
+	int error;
 
-	{ .cmd_name = "info",
-	  .options = dpdbg_info_options,
-	  .cmd_func = cmd_dpdbg_info },
+	error = dpdbg_open(&restool.mc_io, 0, dpdbg_id, dpdbg_handle);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		return error;
+	}
+
+	if (0 == *dpdbg_handle) {
+		DEBUG_PRINTF(
+			"dpdbg_open() returned invalid handle (auth 0) for dpdbg.%u\n",
+			dpdbg_id);
+		return -ENOENT;
+	}
+
+	return 0;
+}
+
+static int close_dpdbg(uint16_t dpdbg_handle, int error)
+{
+	int error2;
+
+	error2 = dpdbg_close(&restool.mc_io, 0, dpdbg_handle);
+	if (error2 < 0) {
+		mc_status = flib_error_to_mc_status(error2);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+static int parse_dpdbg_arg(uint32_t *dpdbg_id, const char *usage_msg)
+{
+	if (restool.obj_name == NULL) {
+		ERROR_PRINTF("<object> argument missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	return parse_object_name(restool.obj_name, "dpdbg", dpdbg_id);
+}
+
+/**
+ * Parses the object given to --object, which may be of any type
+ */
+static int parse_target_obj(int option, enum obj_type *type, uint32_t *id)
+{
+	const char *obj_name = restool.cmd_option_args[option];
+	char obj_type[OBJ_TYPE_MAX_LENGTH + 1];
+	int error;
+
+	error = resolve_label_arg(obj_name, &obj_name);
+	if (error < 0)
+		return error;
+
+	if (sscanf(obj_name, "%" STRINGIFY(OBJ_TYPE_MAX_LENGTH) "[a-z].%u",
+		   obj_type, id) != 2) {
+		ERROR_PRINTF("Invalid MC object name: %s\n", obj_name);
+		return -EINVAL;
+	}
+
+	*type = obj_type_lookup(obj_type);
+	if (*type == OBJ_TYPE_INVALID) {
+		ERROR_PRINTF("Invalid object type \'%s\'\n", obj_type);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Parses --marking=<code>[,<code>], where a code is 0 to 254 or "off"
+ */
+static int parse_markings(struct dpdbg_set_cfg *cfg, int max_markings)
+{
+	char *arg = restool.cmd_option_args[SET_OPT_MARKING];
+	char *str = arg;
+	char *endptr;
+	long val;
+
+	for (;;) {
+		if (cfg->num_markings == max_markings) {
+			ERROR_PRINTF("At most %d marking%s can be given for %s\n",
+				     max_markings, max_markings > 1 ? "s" : "",
+				     obj_type_name(cfg->type));
+			return -EINVAL;
+		}
+
+		if (strncmp(str, "off", 3) == 0 &&
+		    (str[3] == ',' || str[3] == '\0')) {
+			val = DPDBG_DISABLE_MARKING;
+			endptr = str + 3;
+		} else {
+			errno = 0;
+			val = strtol(str, &endptr, 0);
+			if (endptr == str || errno != 0 || val < 0 ||
+			    val >= DPDBG_DISABLE_MARKING ||
+			    (*endptr != ',' && *endptr != '\0')) {
+				ERROR_PRINTF("Invalid marking: %s\n", arg);
+				return -EINVAL;
+			}
+		}
+
+		cfg->markings[cfg->num_markings++] = val;
+		if (*endptr == '\0')
+			return 0;
+
+		str = endptr + 1;
+	}
+}
+
+static int parse_set_option(int option, long *value, const char *error_msg,
+			    long min, long max)
+{
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(option);
+	return get_option_value(option, value, error_msg, min, max);
+}
+
+/**
+ * Parses the options of the trace and mark commands. Options that do
+ * not apply to the object given are left set, and reported.
+ */
+static int parse_set_cfg(struct dpdbg_set_cfg *cfg, bool trace,
+			 const char *usage_msg)
+{
+	long val;
+	char *str;
+	int error;
+
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->tc = DPDBG_DPNI_ALL_TCS;
+	cfg->flow = DPDBG_DPNI_ALL_TC_FLOWS;
+	cfg->dpbp = DPDBG_DPNI_ALL_DPBP;
+	cfg->sender = DPDBG_DPNI_ALL_SENDERS;
+	cfg->verbosity = DPDBG_VERBOSITY_LEVEL_TERSE;
+	cfg->enqueue_type = DPDBG_DPIO_TRACE_TYPE_ENQUEUE;
+
+	if (!(restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_OBJECT))) {
+		ERROR_PRINTF("--object option missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(SET_OPT_OBJECT);
+	error = parse_target_obj(SET_OPT_OBJECT, &cfg->type, &cfg->id);
+	if (error < 0)
+		return error;
+
+	switch (cfg->type) {
+	case OBJ_TYPE_DPNI:
+	case OBJ_TYPE_DPIO:
+		break;
+	case OBJ_TYPE_DPCON:
+	case OBJ_TYPE_DPSECI:
+		if (trace)
+			break;
+		/* fall through */
+	default:
+		ERROR_PRINTF("%s objects cannot be %s\n",
+			     obj_type_name(cfg->type),
+			     trace ? "traced" : "marked");
+		return -EINVAL;
+	}
+
+	if (!(restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_MARKING))) {
+		ERROR_PRINTF("--marking option missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(SET_OPT_MARKING);
+	error = parse_markings(cfg, trace && cfg->type != OBJ_TYPE_DPNI ?
+				    DPDBG_MAX_TRACE_POINTS : 1);
+	if (error < 0)
+		return error;
+
+	if (cfg->type == OBJ_TYPE_DPNI) {
+		if (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_DIRECTION)) {
+			restool.cmd_option_mask &=
+				~ONE_BIT_MASK(SET_OPT_DIRECTION);
+			str = restool.cmd_option_args[SET_OPT_DIRECTION];
+			if (strcmp(str, "tx") == 0) {
+				cfg->tx = true;
+			} else if (strcmp(str, "rx") != 0) {
+				ERROR_PRINTF("Invalid direction: %s\n", str);
+				return -EINVAL;
+			}
+		}
+
+		if (!cfg->tx &&
+		    (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_TC))) {
+			error = parse_set_option(SET_OPT_TC, &val,
+						 "Invalid traffic class",
+						 0, DPDBG_DPNI_ALL_TCS - 1);
+			if (error < 0)
+				return error;
+			cfg->tc = val;
+		}
+
+		if (!cfg->tx &&
+		    (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_FLOW))) {
+			error = parse_set_option(SET_OPT_FLOW, &val,
+						 "Invalid flow id",
+						 0, DPDBG_DPNI_ALL_TC_FLOWS - 1);
+			if (error < 0)
+				return error;
+			cfg->flow = val;
+		}
+
+		if (!cfg->tx &&
+		    (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_DPBP))) {
+			error = parse_set_option(SET_OPT_DPBP, &val,
+						 "Invalid dpbp id",
+						 0, DPDBG_DPNI_ALL_DPBP - 1);
+			if (error < 0)
+				return error;
+			cfg->dpbp = val;
+		}
+
+		if (cfg->tx &&
+		    (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_SENDER))) {
+			error = parse_set_option(SET_OPT_SENDER, &val,
+						 "Invalid sender id",
+						 0, DPDBG_DPNI_ALL_SENDERS - 1);
+			if (error < 0)
+				return error;
+			cfg->sender = val;
+		}
+	} else if (trace) {
+		if (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_VERBOSITY)) {
+			restool.cmd_option_mask &=
+				~ONE_BIT_MASK(SET_OPT_VERBOSITY);
+			str = restool.cmd_option_args[SET_OPT_VERBOSITY];
+			if (strcmp(str, "off") == 0) {
+				cfg->verbosity = DPDBG_VERBOSITY_LEVEL_DISABLE;
+			} else if (strcmp(str, "verbose") == 0) {
+				cfg->verbosity = DPDBG_VERBOSITY_LEVEL_VERBOSE;
+			} else if (strcmp(str, "terse") != 0) {
+				ERROR_PRINTF("Invalid verbosity: %s\n", str);
+				return -EINVAL;
+			}
+		}
+
+		if (cfg->type == OBJ_TYPE_DPIO &&
+		    (restool.cmd_option_mask &
+		     ONE_BIT_MASK(SET_OPT_ENQUEUE_TYPE))) {
+			restool.cmd_option_mask &=
+				~ONE_BIT_MASK(SET_OPT_ENQUEUE_TYPE);
+			str = restool.cmd_option_args[SET_OPT_ENQUEUE_TYPE];
+			if (strcmp(str, "deferred") == 0) {
+				cfg->enqueue_type =
+					DPDBG_DPIO_TRACE_TYPE_DEFERRED;
+			} else if (strcmp(str, "enqueue") != 0) {
+				ERROR_PRINTF("Invalid enqueue type: %s\n", str);
+				return -EINVAL;
+			}
+		}
+	}
+
+	if (restool.cmd_option_mask != 0) {
+		print_unexpected_options_error(restool.cmd_option_mask,
+					       restool.obj_cmd->options);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Trace points past the markings given are disabled
+ */
+static void get_trace_point(const struct dpdbg_set_cfg *cfg, int i,
+			    uint8_t *marking,
+			    enum dpdbg_verbosity_level *verbosity)
+{
+	if (i < cfg->num_markings) {
+		*marking = cfg->markings[i];
+		*verbosity = cfg->verbosity;
+	} else {
+		*marking = DPDBG_DISABLE_MARKING;
+		*verbosity = DPDBG_VERBOSITY_LEVEL_DISABLE;
+	}
+}
+
+static int set_trace(uint16_t dpdbg_handle, const struct dpdbg_set_cfg *cfg)
+{
+	struct dpdbg_dpni_rx_trace_cfg rx_cfg;
+	struct dpdbg_dpni_tx_trace_cfg tx_cfg;
+	struct dpdbg_dpio_trace_cfg
+		dpio_points[DPDBG_NUM_OF_DPIO_TRACE_POINTS];
+	struct dpdbg_dpcon_trace_cfg
+		dpcon_points[DPDBG_NUM_OF_DPCON_TRACE_POINTS];
+	struct dpdbg_dpseci_trace_cfg
+		dpseci_points[DPDBG_NUM_OF_DPSECI_TRACE_POINTS];
+
+	switch (cfg->type) {
+	case OBJ_TYPE_DPNI:
+		if (cfg->tx) {
+			memset(&tx_cfg, 0, sizeof(tx_cfg));
+			tx_cfg.marking = cfg->markings[0];
+			return dpdbg_set_dpni_tx_trace(&restool.mc_io, 0,
+						       dpdbg_handle, cfg->id,
+						       cfg->sender, &tx_cfg);
+		}
+
+		memset(&rx_cfg, 0, sizeof(rx_cfg));
+		rx_cfg.tc_id = cfg->tc;
+		rx_cfg.flow_id = cfg->flow;
+		rx_cfg.dpbp_id = cfg->dpbp;
+		rx_cfg.marking = cfg->markings[0];
+		return dpdbg_set_dpni_rx_trace(&restool.mc_io, 0, dpdbg_handle,
+					       cfg->id, &rx_cfg);
+
+	case OBJ_TYPE_DPIO:
+		for (int i = 0; i < DPDBG_NUM_OF_DPIO_TRACE_POINTS; i++) {
+			get_trace_point(cfg, i, &dpio_points[i].marking,
+					&dpio_points[i].verbosity);
+			dpio_points[i].enqueue_type = cfg->enqueue_type;
+		}
+
+		return dpdbg_set_dpio_trace(&restool.mc_io, 0, dpdbg_handle,
+					    cfg->id, dpio_points);
+
+	case OBJ_TYPE_DPCON:
+		for (int i = 0; i < DPDBG_NUM_OF_DPCON_TRACE_POINTS; i++)
+			get_trace_point(cfg, i, &dpcon_points[i].marking,
+					&dpcon_points[i].verbosity);
+
+		return dpdbg_set_dpcon_trace(&restool.mc_io, 0, dpdbg_handle,
+					     cfg->id, dpcon_points);
+
+	case OBJ_TYPE_DPSECI:
+		for (int i = 0; i < DPDBG_NUM_OF_DPSECI_TRACE_POINTS; i++)
+			get_trace_point(cfg, i, &dpseci_points[i].marking,
+					&dpseci_points[i].verbosity);
+
+		return dpdbg_set_dpseci_trace(&restool.mc_io, 0, dpdbg_handle,
+					      cfg->id, dpseci_points);
+
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+}
+
+static int set_marking(uint16_t dpdbg_handle, const struct dpdbg_set_cfg *cfg)
+{
+	struct dpdbg_dpni_rx_marking_cfg rx_cfg;
+
+	switch (cfg->type) {
+	case OBJ_TYPE_DPNI:
+		if (cfg->tx)
+			return dpdbg_set_dpni_tx_conf_marking(
+					&restool.mc_io, 0, dpdbg_handle,
+					cfg->id, cfg->sender,
+					cfg->markings[0]);
+
+		memset(&rx_cfg, 0, sizeof(rx_cfg));
+		rx_cfg.tc_id = cfg->tc;
+		rx_cfg.flow_id = cfg->flow;
+		rx_cfg.dpbp_id = cfg->dpbp;
+		rx_cfg.marking = cfg->markings[0];
+		return dpdbg_set_dpni_rx_marking(&restool.mc_io, 0,
+						 dpdbg_handle, cfg->id,
+						 &rx_cfg);
+
+	case OBJ_TYPE_DPIO:
+		return dpdbg_set_dpio_marking(&restool.mc_io, 0, dpdbg_handle,
+					      cfg->id, cfg->markings[0]);
+
+	default:
+		assert(false);
+		return -EINVAL;
+	}
+}
+
+static int dpdbg_set(bool trace, const char *usage_msg)
+{
+	struct dpdbg_set_cfg cfg;
+	uint32_t dpdbg_id;
+	uint16_t dpdbg_handle;
+	int error;
+
+	error = parse_dpdbg_arg(&dpdbg_id, usage_msg);
+	if (error < 0)
+		return error;
+
+	error = parse_set_cfg(&cfg, trace, usage_msg);
+	if (error < 0)
+		return error;
+
+	error = open_dpdbg(dpdbg_id, &dpdbg_handle);
+	if (error < 0)
+		return error;
+
+	if (trace)
+		error = set_trace(dpdbg_handle, &cfg);
+	else
+		error = set_marking(dpdbg_handle, &cfg);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("%s.%u: MC error: %s (status %#x)\n",
+			     obj_type_name(cfg.type), cfg.id,
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	return close_dpdbg(dpdbg_handle, error);
+}
+
+static int cmd_dpdbg_trace(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpdbg trace <dpdbg-object> --object=<object>\n"
+		"	--marking=<code>[,<code>] [OPTIONS]\n"
+		"   Traces the frames carrying a debug marking as they go through\n"
+		"   a dpni, dpio, dpcon or dpseci.\n"
+		"\n"
+		"--object=<object>\n"
+		"   dpni, dpio, dpcon or dpseci to trace.\n"
+		"--marking=<code>[,<code>]\n"
+		"   Debug marking to trace, 0 to 254, or 'off' to stop tracing.\n"
+		"   dpio, dpcon and dpseci have two trace points, one marking\n"
+		"   may be given for each; points without one are disabled.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--direction=<rx|tx>\n"
+		"   dpni only: trace ingress (default) or egress frames.\n"
+		"--tc=<number>\n"
+		"   dpni ingress only: traffic class. Defaults to all.\n"
+		"--flow=<number>\n"
+		"   dpni ingress only: flow of the traffic class. Defaults to all.\n"
+		"--dpbp=<number>\n"
+		"   dpni ingress only: buffer pool. Defaults to all.\n"
+		"--sender=<number>\n"
+		"   dpni egress only: sender. Defaults to all.\n"
+		"--verbosity=<off|terse|verbose>\n"
+		"   dpio, dpcon and dpseci only. Defaults to terse.\n"
+		"--enqueue-type=<enqueue|deferred>\n"
+		"   dpio only: trace when the enqueue command executes (default),\n"
+		"   or when a deferred enqueue completes.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Trace frames marked 5 on ingress of dpni.2, traffic class 0:\n"
+		"   $ restool dpdbg trace dpdbg.0 --object=dpni.2 --marking=5 --tc=0\n"
+		"\n";
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(SET_OPT_HELP);
+		return 0;
+	}
+
+	return dpdbg_set(true, usage_msg);
+}
+
+static int cmd_dpdbg_mark(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpdbg mark <dpdbg-object> --object=<object>\n"
+		"	--marking=<code> [OPTIONS]\n"
+		"   Sets the debug marking of the frames received by a dpni, of\n"
+		"   its Tx confirmations, or of the frames enqueued through a dpio.\n"
+		"\n"
+		"--object=<object>\n"
+		"   dpni or dpio whose frames are marked.\n"
+		"--marking=<code>\n"
+		"   Debug marking, 0 to 254, or 'off' to stop marking.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--direction=<rx|tx>\n"
+		"   dpni only: mark ingress frames (default), or Tx confirmations.\n"
+		"--tc=<number>\n"
+		"   dpni ingress only: traffic class. Defaults to all.\n"
+		"--flow=<number>\n"
+		"   dpni ingress only: flow of the traffic class. Defaults to all.\n"
+		"--dpbp=<number>\n"
+		"   dpni ingress only: buffer pool. Defaults to all.\n"
+		"--sender=<number>\n"
+		"   dpni Tx confirmation only: sender whose confirmation queue is\n"
+		"   marked. Defaults to the global confirmation queue.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Mark all frames received by dpni.2 with 5:\n"
+		"   $ restool dpdbg mark dpdbg.0 --object=dpni.2 --marking=5\n"
+		"\n";
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(SET_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(SET_OPT_HELP);
+		return 0;
+	}
+
+	return dpdbg_set(false, usage_msg);
+}
+
+static void counters_signal_handler(int sig)
+{
+	(void)sig;
+	counters_stop = 1;
+}
+
+static int cmp_counted_obj(const void *a, const void *b)
+{
+	const struct counted_obj *obj_a = a;
+	const struct counted_obj *obj_b = b;
+
+	if (obj_a->type != obj_b->type)
+		return obj_a->type < obj_b->type ? -1 : 1;
+
+	return obj_a->id < obj_b->id ? -1 : obj_a->id > obj_b->id;
+}
+
+static int add_counted_obj(struct counted_obj **objs, int *num_objs,
+			   int *max_objs, enum obj_type type, uint32_t id)
+{
+	struct counted_obj *obj;
+
+	if (*num_objs == *max_objs) {
+		int new_max = *max_objs ? *max_objs * 2 : 16;
+
+		obj = realloc(*objs, new_max * sizeof(**objs));
+		if (!obj) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		*objs = obj;
+		*max_objs = new_max;
+	}
+
+	obj = &(*objs)[(*num_objs)++];
+	memset(obj, 0, sizeof(*obj));
+	obj->type = type;
+	obj->id = id;
+	return 0;
+}
+
+static int find_counted_objs(struct dprc_walk_node *node,
+			     struct counted_obj **objs, int *num_objs,
+			     int *max_objs)
+{
+	int error;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->obj_types[i] != OBJ_TYPE_DPNI &&
+		    node->obj_types[i] != OBJ_TYPE_DPMAC)
+			continue;
+
+		error = add_counted_obj(objs, num_objs, max_objs,
+					node->obj_types[i], node->objs[i].id);
+		if (error < 0)
+			return error;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = find_counted_objs(node->children[i], objs, num_objs,
+					  max_objs);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static int read_counters(uint16_t dpdbg_handle, const struct counted_obj *obj,
+			 uint64_t *values)
+{
+	int error = 0;
+
+	if (obj->type == OBJ_TYPE_DPNI) {
+		for (unsigned int i = 0; i < ARRAY_SIZE(dpni_counters); i++) {
+			error = dpdbg_get_dpni_counter(&restool.mc_io, 0,
+						       dpdbg_handle, obj->id,
+						       dpni_counters[i].counter,
+						       &values[i]);
+			if (error < 0)
+				break;
+		}
+	} else {
+		for (unsigned int i = 0; i < ARRAY_SIZE(dpmac_counters); i++) {
+			error = dpdbg_get_dpmac_counter(&restool.mc_io, 0,
+						dpdbg_handle, obj->id,
+						dpmac_counters[i].counter,
+						&values[i]);
+			if (error < 0)
+				break;
+		}
+	}
+
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("%s.%u: MC error: %s (status %#x)\n",
+			     obj_type_name(obj->type), obj->id,
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	return error;
+}
+
+/**
+ * Prints the counters of obj, with their change since the values kept
+ * in obj when deltas is set
+ */
+static void print_counters(const struct counted_obj *obj,
+			   const uint64_t *values, bool deltas)
+{
+	unsigned int num_counters;
+
+	printf("%s.%u:\n", obj_type_name(obj->type), obj->id);
+	num_counters = obj->type == OBJ_TYPE_DPNI ? ARRAY_SIZE(dpni_counters) :
+						   ARRAY_SIZE(dpmac_counters);
+	for (unsigned int i = 0; i < num_counters; i++) {
+		const char *name = obj->type == OBJ_TYPE_DPNI ?
+				   dpni_counters[i].name :
+				   dpmac_counters[i].name;
+
+		if (deltas)
+			printf("\t%s: %lu (%+ld)\n", name, values[i],
+			       (int64_t)(values[i] - obj->values[i]));
+		else
+			printf("\t%s: %lu\n", name, values[i]);
+	}
+}
+
+/**
+ * Reads the counters of all objects count times, or until interrupted
+ * when count is 0, waiting interval milliseconds between sweeps
+ */
+static int sweep_counters(uint16_t dpdbg_handle, struct counted_obj *objs,
+			  int num_objs, long interval, long count)
+{
+	uint64_t values[MAX_DPDBG_COUNTERS];
+	struct sigaction sa, old_int, old_term;
+	struct timespec delay;
+	int error = 0;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = counters_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	(void)sigaction(SIGINT, &sa, &old_int);
+	(void)sigaction(SIGTERM, &sa, &old_term);
+
+	delay.tv_sec = interval / 1000;
+	delay.tv_nsec = (interval % 1000) * 1000000;
+	counters_stop = 0;
+	for (long sweep = 0; count == 0 || sweep < count; sweep++) {
+		if (sweep > 0) {
+			(void)nanosleep(&delay, NULL);
+			if (counters_stop)
+				break;
+			printf("\n");
+		}
+
+		if (count != 1)
+			printf("sweep %ld:\n", sweep + 1);
+
+		for (int i = 0; i < num_objs && !counters_stop; i++) {
+			error = read_counters(dpdbg_handle, &objs[i], values);
+			if (error < 0)
+				goto out;
+
+			print_counters(&objs[i], values, sweep > 0);
+			memcpy(objs[i].values, values, sizeof(values));
+		}
+
+		fflush(stdout);
+		if (counters_stop)
+			break;
+	}
+
+out:
+	(void)sigaction(SIGINT, &old_int, NULL);
+	(void)sigaction(SIGTERM, &old_term, NULL);
+	return error;
+}
+
+static int cmd_dpdbg_counters(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpdbg counters <dpdbg-object> [OPTIONS]\n"
+		"   Reads the frame and byte counters of all dpni and dpmac\n"
+		"   objects under the root container.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--object=<object>\n"
+		"   Only read the counters of this dpni or dpmac.\n"
+		"--interval=<ms>\n"
+		"   Time between two sweeps, in milliseconds. Sweeps after the\n"
+		"   first one also print the change of each counter since the\n"
+		"   previous sweep. Defaults to 1000 when --count is given.\n"
+		"--count=<number>\n"
+		"   Number of sweeps. Defaults to 1 without --interval, and to\n"
+		"   running until interrupted with it.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Show the counters of dpni.2 every 5 seconds, 10 times:\n"
+		"   $ restool dpdbg counters dpdbg.0 --object=dpni.2 --interval=5000 --count=10\n"
+		"\n";
+
+	struct dprc_walk_node *root = NULL;
+	struct counted_obj *objs = NULL;
+	int num_objs = 0;
+	int max_objs = 0;
+	long interval = 1000;
+	long count = 1;
+	enum obj_type type;
+	uint32_t dpdbg_id;
+	uint32_t id;
+	uint16_t dpdbg_handle;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(COUNTERS_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(COUNTERS_OPT_HELP);
+		return 0;
+	}
+
+	error = parse_dpdbg_arg(&dpdbg_id, usage_msg);
+	if (error < 0)
+		return error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(COUNTERS_OPT_INTERVAL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(COUNTERS_OPT_INTERVAL);
+		error = get_option_value(COUNTERS_OPT_INTERVAL, &interval,
+					 "Invalid interval value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+		count = 0;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(COUNTERS_OPT_COUNT)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(COUNTERS_OPT_COUNT);
+		error = get_option_value(COUNTERS_OPT_COUNT, &count,
+					 "Invalid count value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(COUNTERS_OPT_OBJECT)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(COUNTERS_OPT_OBJECT);
+		error = parse_target_obj(COUNTERS_OPT_OBJECT, &type, &id);
+		if (error < 0)
+			return error;
+
+		if (type != OBJ_TYPE_DPNI && type != OBJ_TYPE_DPMAC) {
+			ERROR_PRINTF("%s objects have no counters\n",
+				     obj_type_name(type));
+			return -EINVAL;
+		}
+
+		error = add_counted_obj(&objs, &num_objs, &max_objs, type, id);
+		if (error < 0)
+			goto out;
+	} else {
+		error = dprc_walk(restool.root_dprc_id, &root);
+		if (error < 0)
+			goto out;
+
+		error = find_counted_objs(root, &objs, &num_objs, &max_objs);
+		if (error < 0)
+			goto out;
+
+		qsort(objs, num_objs, sizeof(*objs), cmp_counted_obj);
+	}
+
+	if (num_objs == 0) {
+		printf("no dpni or dpmac objects found\n");
+		goto out;
+	}
+
+	error = open_dpdbg(dpdbg_id, &dpdbg_handle);
+	if (error < 0)
+		goto out;
+
+	error = sweep_counters(dpdbg_handle, objs, num_objs, interval, count);
+	error = close_dpdbg(dpdbg_handle, error);
+out:
+	if (root)
+		dprc_walk_free(root);
+	free(objs);
+	return error;
+}
+
+static const char *const queue_kind_names[] = {
+	[QUEUE_QDID] = "qdid",
+	[QUEUE_FQID] = "fqid",
+	[QUEUE_CHANNEL] = "channel",
+	[QUEUE_BPID] = "bpid",
+};
+
+static int add_queue(struct queue_index *index, enum queue_kind kind,
+		     uint32_t qid, enum obj_type type, uint32_t obj_id,
+		     const char *use_fmt, ...)
+{
+	struct queue_entry *entry;
+	va_list ap;
+
+	if (index->num_entries == index->max_entries) {
+		int new_max = index->max_entries ?
+			      index->max_entries * 2 : 64;
+
+		entry = realloc(index->entries,
+				new_max * sizeof(*index->entries));
+		if (!entry) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		index->entries = entry;
+		index->max_entries = new_max;
+	}
+
+	entry = &index->entries[index->num_entries++];
+	entry->kind = kind;
+	entry->qid = qid;
+	entry->type = type;
+	entry->obj_id = obj_id;
+	va_start(ap, use_fmt);
+	vsnprintf(entry->use, sizeof(entry->use), use_fmt, ap);
+	va_end(ap);
+	return 0;
+}
+
+static int add_dpni_queues(struct queue_index *index, uint16_t dpdbg_handle,
+			   uint32_t id)
+{
+	struct dpdbg_dpni_info info;
+	uint32_t fqid;
+	int error;
+
+	memset(&info, 0, sizeof(info));
+	error = dpdbg_get_dpni_info(&restool.mc_io, 0, dpdbg_handle, id,
+				    &info);
+	if (error < 0)
+		return error;
+
+	error = add_queue(index, QUEUE_QDID, info.qdid, OBJ_TYPE_DPNI, id,
+			  "tx");
+	if (error < 0)
+		return error;
+
+	error = add_queue(index, QUEUE_FQID, info.err_fqid, OBJ_TYPE_DPNI,
+			  id, "rx_err");
+	if (error < 0)
+		return error;
+
+	error = add_queue(index, QUEUE_FQID, info.tx_conf_fqid,
+			  OBJ_TYPE_DPNI, id, "tx_conf");
+	if (error < 0)
+		return error;
+
+	for (int i = 0; i < info.max_senders; i++) {
+		error = dpdbg_get_dpni_priv_tx_conf_fqid(&restool.mc_io, 0,
+							 dpdbg_handle, id, i,
+							 &fqid);
+		if (error < 0)
+			return error;
+
+		error = add_queue(index, QUEUE_FQID, fqid, OBJ_TYPE_DPNI, id,
+				  "tx_conf sender %d", i);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static int get_dpci_num_priorities(uint32_t id, uint8_t *num_priorities)
+{
+	struct dpci_attr dpci_attr;
+	uint16_t dpci_handle;
+	int error;
+	int error2;
+
+	error = dpci_open(&restool.mc_io, 0, id, &dpci_handle);
+	if (error < 0)
+		return error;
+
+	memset(&dpci_attr, 0, sizeof(dpci_attr));
+	error = dpci_get_attributes(&restool.mc_io, 0, dpci_handle,
+				    &dpci_attr);
+	*num_priorities = dpci_attr.num_of_priorities;
+
+	error2 = dpci_close(&restool.mc_io, 0, dpci_handle);
+	return error < 0 ? error : error2;
+}
+
+static int add_obj_queues(struct queue_index *index, uint16_t dpdbg_handle,
+			  enum obj_type type, uint32_t id)
+{
+	struct dpdbg_dpcon_info dpcon_info;
+	struct dpdbg_dpbp_info dpbp_info;
+	uint8_t num_priorities;
+	uint32_t fqid;
+	int error;
+
+	switch (type) {
+	case OBJ_TYPE_DPNI:
+		return add_dpni_queues(index, dpdbg_handle, id);
+
+	case OBJ_TYPE_DPCON:
+		memset(&dpcon_info, 0, sizeof(dpcon_info));
+		error = dpdbg_get_dpcon_info(&restool.mc_io, 0, dpdbg_handle,
+					     id, &dpcon_info);
+		if (error < 0)
+			return error;
+
+		return add_queue(index, QUEUE_CHANNEL, dpcon_info.ch_id,
+				 type, id, "");
+
+	case OBJ_TYPE_DPBP:
+		memset(&dpbp_info, 0, sizeof(dpbp_info));
+		error = dpdbg_get_dpbp_info(&restool.mc_io, 0, dpdbg_handle,
+					    id, &dpbp_info);
+		if (error < 0)
+			return error;
+
+		return add_queue(index, QUEUE_BPID, dpbp_info.bpid, type, id,
+				 "");
+
+	case OBJ_TYPE_DPCI:
+		error = get_dpci_num_priorities(id, &num_priorities);
+		if (error < 0)
+			return error;
+
+		for (int i = 0; i < num_priorities; i++) {
+			error = dpdbg_get_dpci_fqid(&restool.mc_io, 0,
+						    dpdbg_handle, id, i,
+						    &fqid);
+			if (error < 0)
+				return error;
+
+			error = add_queue(index, QUEUE_FQID, fqid, type, id,
+					  "rx priority %d", i);
+			if (error < 0)
+				return error;
+		}
+
+		return 0;
+
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Adds the queues of all objects in node and below it to index. An
+ * object whose queues cannot be read is reported, and the others are
+ * still added.
+ */
+static int add_walk_queues(struct queue_index *index, uint16_t dpdbg_handle,
+			   struct dprc_walk_node *node, int *num_errors)
+{
+	int error;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		error = add_obj_queues(index, dpdbg_handle, node->obj_types[i],
+				       node->objs[i].id);
+		if (error == -ENOMEM)
+			return error;
+
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("%s.%d: MC error: %s (status %#x)\n",
+				     node->objs[i].type, node->objs[i].id,
+				     mc_status_to_string(mc_status),
+				     mc_status);
+			(*num_errors)++;
+		}
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_walk_queues(index, dpdbg_handle,
+					node->children[i], num_errors);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static int cmp_queue_entry(const void *a, const void *b)
+{
+	const struct queue_entry *entry_a = a;
+	const struct queue_entry *entry_b = b;
+
+	if (entry_a->kind != entry_b->kind)
+		return entry_a->kind < entry_b->kind ? -1 : 1;
+
+	if (entry_a->qid != entry_b->qid)
+		return entry_a->qid < entry_b->qid ? -1 : 1;
+
+	if (entry_a->type != entry_b->type)
+		return entry_a->type < entry_b->type ? -1 : 1;
+
+	return entry_a->obj_id < entry_b->obj_id ? -1 :
+	       entry_a->obj_id > entry_b->obj_id;
+}
+
+static void print_queue_index(const struct queue_index *index, bool json,
+			      bool match_qid, uint32_t qid)
+{
+	char obj_name[OBJ_TYPE_MAX_LENGTH + 12];
+	bool first = true;
+
+	if (json)
+		printf("[");
+	else
+		printf("%-7s  %-10s  %-12s  %s\n", "kind", "id", "object",
+		       "use");
+
+	for (int i = 0; i < index->num_entries; i++) {
+		const struct queue_entry *entry = &index->entries[i];
+
+		if (match_qid && entry->qid != qid)
+			continue;
+
+		snprintf(obj_name, sizeof(obj_name), "%s.%u",
+			 obj_type_name(entry->type), entry->obj_id);
+		if (json) {
+			printf(first ? "{" : ",\n {");
+			printf("\"kind\":\"%s\",\"id\":%u,\"object\":\"%s\",",
+			       queue_kind_names[entry->kind], entry->qid,
+			       obj_name);
+			printf("\"use\":");
+			if (entry->use[0] == '\0')
+				printf("null}");
+			else
+				printf("\"%s\"}", entry->use);
+		} else {
+			printf("%-7s  %#-10x  %-12s  %s\n",
+			       queue_kind_names[entry->kind], entry->qid,
+			       obj_name, entry->use);
+		}
+
+		first = false;
+	}
+
+	if (json)
+		printf("]\n");
+}
+
+static int cmd_dpdbg_queues(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpdbg queues <dpdbg-object> [OPTIONS]\n"
+		"   Lists the hardware queue ids used by the objects under the\n"
+		"   root container, sorted by id: the qdid and frame queues of\n"
+		"   each dpni, the channel of each dpcon, the buffer pool of each\n"
+		"   dpbp and the frame queues of each dpci.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--id=<number>\n"
+		"   Only list the entries with this id, e.g. a queue id reported\n"
+		"   by a QBMan counter.\n"
+		"--json\n"
+		"   Print a JSON array instead of a table.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Find the object owning frame queue 0x1004:\n"
+		"   $ restool dpdbg queues dpdbg.0 --id=0x1004\n"
+		"\n";
+
+	struct dprc_walk_node *root = NULL;
+	struct queue_index index = { 0 };
+	uint32_t dpdbg_id;
+	uint16_t dpdbg_handle;
+	bool match_qid = false;
+	bool json = false;
+	long qid = 0;
+	int num_errors = 0;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(QUEUES_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(QUEUES_OPT_HELP);
+		return 0;
+	}
+
+	error = parse_dpdbg_arg(&dpdbg_id, usage_msg);
+	if (error < 0)
+		return error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(QUEUES_OPT_ID)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(QUEUES_OPT_ID);
+		error = get_option_value(QUEUES_OPT_ID, &qid,
+					 "Invalid id value",
+					 0, UINT32_MAX);
+		if (error < 0)
+			return error;
+		match_qid = true;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(QUEUES_OPT_JSON)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(QUEUES_OPT_JSON);
+		json = true;
+	}
+
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		return error;
+
+	error = open_dpdbg(dpdbg_id, &dpdbg_handle);
+	if (error < 0)
+		goto out;
+
+	error = add_walk_queues(&index, dpdbg_handle, root, &num_errors);
+	error = close_dpdbg(dpdbg_handle, error);
+	if (error < 0)
+		goto out;
+
+	qsort(index.entries, index.num_entries, sizeof(*index.entries),
+	      cmp_queue_entry);
+	print_queue_index(&index, json, match_qid, qid);
+	if (num_errors)
+		error = -EIO;
+out:
+	dprc_walk_free(root);
+	free(index.entries);
+	return error;
+}
+
+struct object_command dpdbg_commands[] = {
+	{ .cmd_name = "help",
+	  .options = NULL,
+	  .cmd_func = cmd_dpdbg_help },
+
+	{ .cmd_name = "info",
+	  .options = dpdbg_info_options,
+	  .cmd_func = cmd_dpdbg_info },
+
+	{ .cmd_name = "trace",
+	  .options = dpdbg_trace_options,
+	  .cmd_func = cmd_dpdbg_trace },
+
+	{ .cmd_name = "mark",
+	  .options = dpdbg_mark_options,
+	  .cmd_func = cmd_dpdbg_mark },
+
+	{ .cmd_name = "counters",
+	  .options = dpdbg_counters_options,
+	  .cmd_func = cmd_dpdbg_counters },
+
+	{ .cmd_name = "queues",
+	  .options = dpdbg_queues_options,
+	  .cmd_func = cmd_dpdbg_queues },
 
 	{ .cmd_name = NULL },
 };
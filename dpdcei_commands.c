@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpdcei.h"
 #include "mc_v10/fsl_dpdcei.h"
 
@@ -81,6 +82,9 @@ enum dpdcei_create_options {
 	CREATE_OPT_ENGINE,
 	CREATE_OPT_PRIORITY,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpdcei_create_options[] = {
@@ -112,6 +116,27 @@ static struct option dpdcei_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -137,11 +162,12 @@ static struct option dpdcei_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpdcei_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpdcei_ops = {
+const struct flib_ops dpdcei_ops = {
 	.obj_open = dpdcei_open,
 	.obj_close = dpdcei_close,
 	.obj_get_irq_mask = dpdcei_get_irq_mask,
 	.obj_get_irq_status = dpdcei_get_irq_status,
+	.obj_destroy = dpdcei_destroy_v10,
 };
 
 static int cmd_dpdcei_help(void)
@@ -185,7 +211,8 @@ static int print_dpdcei_attr_v9(uint32_t dpdcei_id,
 	struct dpdcei_attr dpdcei_attr;
 	bool dpdcei_opened = false;
 
-	error = dpdcei_open(&restool.mc_io, 0, dpdcei_id, &dpdcei_handle);
+	error = handle_cache_open("dpdcei", dpdcei_id, dpdcei_open,
+				  dpdcei_close, &dpdcei_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -223,18 +250,8 @@ static int print_dpdcei_attr_v9(uint32_t dpdcei_id,
 	error = 0;
 
 out:
-	if (dpdcei_opened) {
-		int error2;
-
-		error2 = dpdcei_close(&restool.mc_io, 0, dpdcei_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdcei_opened)
+		(void)handle_cache_release(dpdcei_handle);
 
 	return error;
 }
@@ -248,7 +265,8 @@ static int print_dpdcei_attr_v10(uint32_t dpdcei_id,
 	uint16_t dpdcei_handle;
 	int error;
 
-	error = dpdcei_open_v10(&restool.mc_io, 0, dpdcei_id, &dpdcei_handle);
+	error = handle_cache_open("dpdcei", dpdcei_id, dpdcei_open_v10,
+				  dpdcei_close_v10, &dpdcei_handle);
 	if (error) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -294,18 +312,8 @@ static int print_dpdcei_attr_v10(uint32_t dpdcei_id,
 	error = 0;
 
 out:
-	if (dpdcei_opened) {
-		int error2;
-
-		error2 = dpdcei_close_v10(&restool.mc_io, 0, dpdcei_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdcei_opened)
+		(void)handle_cache_release(dpdcei_handle);
 
 	return error;
 }
@@ -484,7 +492,7 @@ static int create_dpdcei_v10(struct dpdcei_cfg_v10 *dpdcei_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpdcei", dpdcei_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -606,6 +614,7 @@ static int destroy_dpdcei_v9(uint32_t dpdcei_id)
 	uint16_t dpdcei_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpdcei", dpdcei_id);
 	error = dpdcei_open(&restool.mc_io, 0, dpdcei_id, &dpdcei_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -665,6 +674,7 @@ static int destroy_dpdcei_v10(uint32_t dpdcei_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpdcei", dpdcei_id);
 	error = dpdcei_destroy_v10(&restool.mc_io, dprc_handle,
 				   0, dpdcei_id);
 	if (error < 0) {
@@ -677,7 +687,7 @@ static int destroy_dpdcei_v10(uint32_t dpdcei_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
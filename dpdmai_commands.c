@@ -39,6 +39,7 @@
 #include <getopt.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpdmai.h"
 #include "mc_v10/fsl_dpdmai.h"
 
@@ -80,6 +81,9 @@ enum dpdmai_create_options {
 	CREATE_OPT_PRIORITIES,
 	CREATE_OPT_PARENT_DPRC,
 	CREATE_OPT_NUM_QUEUES,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpdmai_create_options[] = {
@@ -111,6 +115,27 @@ static struct option dpdmai_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -136,11 +161,12 @@ static struct option dpdmai_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpdmai_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpdmai_ops = {
+const struct flib_ops dpdmai_ops = {
 	.obj_open = dpdmai_open,
 	.obj_close = dpdmai_close,
 	.obj_get_irq_mask = dpdmai_get_irq_mask,
 	.obj_get_irq_status = dpdmai_get_irq_status,
+	.obj_destroy = dpdmai_destroy_v10,
 };
 
 static int cmd_dpdmai_help(void)
@@ -168,7 +194,8 @@ static int print_dpdmai_attr_v9(uint32_t dpdmai_id,
 	struct dpdmai_attr dpdmai_attr;
 	bool dpdmai_opened = false;
 
-	error = dpdmai_open(&restool.mc_io, 0, dpdmai_id, &dpdmai_handle);
+	error = handle_cache_open("dpdmai", dpdmai_id, dpdmai_open,
+				  dpdmai_close, &dpdmai_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -206,18 +233,8 @@ static int print_dpdmai_attr_v9(uint32_t dpdmai_id,
 	error = 0;
 
 out:
-	if (dpdmai_opened) {
-		int error2;
-
-		error2 = dpdmai_close(&restool.mc_io, 0, dpdmai_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdmai_opened)
+		(void)handle_cache_release(dpdmai_handle);
 
 	return error;
 }
@@ -231,7 +248,8 @@ static int print_dpdmai_attr_v10(uint32_t dpdmai_id,
 	uint16_t dpdmai_handle;
 	int error;
 
-	error = dpdmai_open_v10(&restool.mc_io, 0, dpdmai_id, &dpdmai_handle);
+	error = handle_cache_open("dpdmai", dpdmai_id, dpdmai_open_v10,
+				  dpdmai_close_v10, &dpdmai_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -278,18 +296,8 @@ static int print_dpdmai_attr_v10(uint32_t dpdmai_id,
 	error = 0;
 
 out:
-	if (dpdmai_opened) {
-		int error2;
-
-		error2 = dpdmai_close_v10(&restool.mc_io, 0, dpdmai_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdmai_opened)
+		(void)handle_cache_release(dpdmai_handle);
 
 	return error;
 }
@@ -501,7 +509,7 @@ static int create_dpdmai_v10(struct dpdmai_cfg_v10 *dpdmai_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpdmai", dpdmai_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -618,6 +626,7 @@ static int destroy_dpdmai_v9(uint32_t dpdmai_id)
 	uint16_t dpdmai_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpdmai", dpdmai_id);
 	error = dpdmai_open(&restool.mc_io, 0, dpdmai_id, &dpdmai_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -677,6 +686,7 @@ static int destroy_dpdmai_v10(uint32_t dpdmai_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpdmai", dpdmai_id);
 	error = dpdmai_destroy_v10(&restool.mc_io, dprc_handle,
 				   0, dpdmai_id);
 	if (error < 0) {
@@ -689,7 +699,7 @@ static int destroy_dpdmai_v10(uint32_t dpdmai_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
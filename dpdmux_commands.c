@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpdmux.h"
 #include "mc_v10/fsl_dpdmux.h"
 
@@ -165,6 +166,9 @@ enum dpdmux_create_options_v9 {
 	CREATE_OPT_MAX_DMAT_ENTRIES_V9,
 	CREATE_OPT_MAX_MC_GROUPS_V9,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT_V9,
+	CREATE_OPT_ASSIGN_TO_V9,
+	CREATE_OPT_PLUGGED_V9,
 };
 
 static struct option dpdmux_create_options_v9[] = {
@@ -224,6 +228,27 @@ static struct option dpdmux_create_options_v9[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT_V9] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO_V9] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED_V9] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -256,11 +281,37 @@ static struct option_entry options_map[] = {
 };
 static unsigned options_num = ARRAY_SIZE(options_map);
 
-static const struct flib_ops dpdmux_ops_v9 = {
+/*
+ * MC 9 has no container-level DPDMUX destroy command: the object is
+ * opened and destroyed through its own token, which the MC releases
+ * on success. dprc_token is unused.
+ */
+static int dpdmux_destroy_obj_v9(struct fsl_mc_io *mc_io,
+				 uint16_t dprc_token,
+				 uint32_t cmd_flags,
+				 uint32_t obj_id)
+{
+	uint16_t dpdmux_handle;
+	int error;
+
+	(void)dprc_token;
+	error = dpdmux_open(mc_io, cmd_flags, obj_id, &dpdmux_handle);
+	if (error < 0)
+		return error;
+
+	error = dpdmux_destroy(mc_io, cmd_flags, dpdmux_handle);
+	if (error < 0)
+		dpdmux_close(mc_io, cmd_flags, dpdmux_handle);
+
+	return error;
+}
+
+const struct flib_ops dpdmux_ops_v9 = {
 	.obj_open = dpdmux_open,
 	.obj_close = dpdmux_close,
 	.obj_get_irq_mask = dpdmux_get_irq_mask,
 	.obj_get_irq_status = dpdmux_get_irq_status_v9,
+	.obj_destroy = dpdmux_destroy_obj_v9,
 };
 
 static int cmd_dpdmux_help(void)
@@ -394,7 +445,8 @@ static int print_dpdmux_attr_v9(uint32_t dpdmux_id,
 	struct dpdmux_attr_v9 dpdmux_attr;
 	bool dpdmux_opened = false;
 
-	error = dpdmux_open(&restool.mc_io, 0, dpdmux_id, &dpdmux_handle);
+	error = handle_cache_open("dpdmux", dpdmux_id, dpdmux_open,
+				  dpdmux_close, &dpdmux_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -441,18 +493,8 @@ static int print_dpdmux_attr_v9(uint32_t dpdmux_id,
 	error = 0;
 
 out:
-	if (dpdmux_opened) {
-		int error2;
-
-		error2 = dpdmux_close(&restool.mc_io, 0, dpdmux_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdmux_opened)
+		(void)handle_cache_release(dpdmux_handle);
 
 	return error;
 }
@@ -466,7 +508,8 @@ static int print_dpdmux_attr_v10(uint32_t dpdmux_id,
 	uint16_t dpdmux_handle;
 	int error;
 
-	error = dpdmux_open_v10(&restool.mc_io, 0, dpdmux_id, &dpdmux_handle);
+	error = handle_cache_open("dpdmux", dpdmux_id, dpdmux_open_v10,
+				  dpdmux_close_v10, &dpdmux_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -521,18 +564,8 @@ static int print_dpdmux_attr_v10(uint32_t dpdmux_id,
 	error = 0;
 
 out:
-	if (dpdmux_opened) {
-		int error2;
-
-		error2 = dpdmux_close_v10(&restool.mc_io, 0, dpdmux_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpdmux_opened)
+		(void)handle_cache_release(dpdmux_handle);
 
 	return error;
 }
@@ -993,7 +1026,7 @@ static int create_dpdmux_v10(const char *usage_msg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpdmux", dpdmux_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -1050,6 +1083,7 @@ static int destroy_dpdmux_v9(uint32_t dpdmux_id)
 	uint16_t dpdmux_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpdmux", dpdmux_id);
 	error = dpdmux_open(&restool.mc_io, 0, dpdmux_id, &dpdmux_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -1109,6 +1143,7 @@ static int destroy_dpdmux_v10(uint32_t dpdmux_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpdmux", dpdmux_id);
 	error = dpdmux_destroy_v10(&restool.mc_io, dprc_handle,
 				   0, dpdmux_id);
 	if (error < 0) {
@@ -1121,7 +1156,7 @@ static int destroy_dpdmux_v10(uint32_t dpdmux_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpio.h"
 #include "mc_v10/fsl_dpio.h"
 
@@ -81,6 +82,9 @@ enum dpio_create_options {
 	CREATE_OPT_CHANNEL_MODE,
 	CREATE_OPT_NUM_PRIORITIES,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpio_create_options[] = {
@@ -112,6 +116,27 @@ static struct option dpio_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -137,11 +162,12 @@ static struct option dpio_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpio_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpio_ops = {
+const struct flib_ops dpio_ops = {
 	.obj_open = dpio_open,
 	.obj_close = dpio_close,
 	.obj_get_irq_mask = dpio_get_irq_mask,
 	.obj_get_irq_status = dpio_get_irq_status,
+	.obj_destroy = dpio_destroy_v10,
 };
 
 static int cmd_dpio_help(void)
@@ -169,7 +195,8 @@ static int print_dpio_attr_v9(uint32_t dpio_id,
 	struct dpio_attr dpio_attr;
 	bool dpio_opened = false;
 
-	error = dpio_open(&restool.mc_io, 0, dpio_id, &dpio_handle);
+	error = handle_cache_open("dpio", dpio_id, dpio_open,
+				  dpio_close, &dpio_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -219,18 +246,8 @@ static int print_dpio_attr_v9(uint32_t dpio_id,
 	error = 0;
 
 out:
-	if (dpio_opened) {
-		int error2;
-
-		error2 = dpio_close(&restool.mc_io, 0, dpio_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpio_opened)
+		(void)handle_cache_release(dpio_handle);
 
 	return error;
 }
@@ -244,7 +261,8 @@ static int print_dpio_attr_v10(uint32_t dpio_id,
 	uint16_t obj_major, obj_minor;
 	int error;
 
-	error = dpio_open_v10(&restool.mc_io, 0, dpio_id, &dpio_handle);
+	error = handle_cache_open("dpio", dpio_id, dpio_open_v10,
+				  dpio_close_v10, &dpio_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -302,18 +320,8 @@ static int print_dpio_attr_v10(uint32_t dpio_id,
 	error = 0;
 
 out:
-	if (dpio_opened) {
-		int error2;
-
-		error2 = dpio_close_v10(&restool.mc_io, 0, dpio_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpio_opened)
+		(void)handle_cache_release(dpio_handle);
 
 	return error;
 }
@@ -475,7 +483,7 @@ static int create_dpio_v10(struct dpio_cfg_v10 *dpio_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpio", dpio_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -609,6 +617,7 @@ static int destroy_dpio_v9(uint32_t dpio_id)
 	uint16_t dpio_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpio", dpio_id);
 	error = dpio_open(&restool.mc_io, 0, dpio_id, &dpio_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -668,6 +677,7 @@ static int destroy_dpio_v10(uint32_t dpio_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpio", dpio_id);
 	error = dpio_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpio_id);
 	if (error < 0) {
@@ -680,7 +690,7 @@ static int destroy_dpio_v10(uint32_t dpio_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -0,0 +1,480 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+#include "restool.h"
+#include "utils.h"
+#include "dpl_emit.h"
+
+/*
+ * Writer behind generate-dpl. Source output is streamed as the layout
+ * is walked; blob output is assembled in memory, structure block and
+ * string table side by side, and written with one call once the root
+ * node is closed, so no dtc round trip is needed to get a DTB.
+ */
+
+#define FDT_MAGIC		0xd00dfeed
+#define FDT_VERSION		17
+#define FDT_LAST_COMP_VERSION	16
+#define FDT_BEGIN_NODE		0x1
+#define FDT_END_NODE		0x2
+#define FDT_PROP		0x3
+#define FDT_END			0x9
+
+/* struct fdt_header plus one empty memory reservation entry */
+#define FDT_HEADER_SIZE		40
+#define FDT_RSVMAP_SIZE		16
+
+#define DPL_NAME_MAX_LENGTH	256
+
+/**
+ * struct dpl_blob - growable byte buffer
+ * @data: the bytes
+ * @len: bytes used
+ * @size: bytes allocated
+ */
+struct dpl_blob {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+};
+
+/**
+ * struct dpl_emitter - state of one DPL being written
+ * @format: encoding being written
+ * @fp: stream the DPL goes to
+ * @depth: number of nodes currently open
+ * @error: first error met, reported by dpl_emit_close()
+ * @dt_struct: structure block of the blob
+ * @dt_strings: property name table of the blob
+ */
+struct dpl_emitter {
+	enum dpl_format format;
+	FILE *fp;
+	int depth;
+	int error;
+	struct dpl_blob dt_struct;
+	struct dpl_blob dt_strings;
+};
+
+/**
+ * dpl_format_parse() - map a --format argument to a dpl_format
+ * @name: "dts" or "dtb"
+ * @format: set to the matching format
+ *
+ * Returns 0 on success, -EINVAL for an unknown name
+ */
+int dpl_format_parse(const char *name, enum dpl_format *format)
+{
+	if (strcmp(name, "dts") == 0)
+		*format = DPL_FORMAT_DTS;
+	else if (strcmp(name, "dtb") == 0)
+		*format = DPL_FORMAT_DTB;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+
+static uint8_t *blob_reserve(struct dpl_emitter *emit, struct dpl_blob *blob,
+			     size_t n)
+{
+	uint8_t *data;
+	size_t size;
+
+	if (emit->error)
+		return NULL;
+
+	if (blob->len + n > blob->size) {
+		size = blob->size ? blob->size : 1024;
+		while (size < blob->len + n)
+			size *= 2;
+		data = realloc(blob->data, size);
+		if (!data) {
+			ERROR_PRINTF("realloc failed\n");
+			emit->error = -ENOMEM;
+			return NULL;
+		}
+		blob->data = data;
+		blob->size = size;
+	}
+
+	data = blob->data + blob->len;
+	blob->len += n;
+	return data;
+}
+
+static void blob_put(struct dpl_emitter *emit, struct dpl_blob *blob,
+		     const void *bytes, size_t n)
+{
+	uint8_t *data = blob_reserve(emit, blob, n);
+
+	if (data)
+		memcpy(data, bytes, n);
+}
+
+static void put_be32(uint8_t *data, uint32_t value)
+{
+	data[0] = value >> 24;
+	data[1] = value >> 16;
+	data[2] = value >> 8;
+	data[3] = value;
+}
+
+static void blob_put_be32(struct dpl_emitter *emit, struct dpl_blob *blob,
+			  uint32_t value)
+{
+	uint8_t *data = blob_reserve(emit, blob, 4);
+
+	if (data)
+		put_be32(data, value);
+}
+
+/* the structure block keeps every token 4 byte aligned */
+static void blob_align(struct dpl_emitter *emit, struct dpl_blob *blob)
+{
+	size_t pad = (4 - (blob->len & 3)) & 3;
+	uint8_t *data = blob_reserve(emit, blob, pad);
+
+	if (data)
+		memset(data, 0, pad);
+}
+
+/**
+ * string_offset() - offset of a property name in the string table
+ * @emit: the emitter
+ * @name: property name, added to the table the first time it is seen
+ *
+ * A DPL uses a few dozen distinct names many times each, so a linear
+ * scan of the table is enough to share them.
+ */
+static uint32_t string_offset(struct dpl_emitter *emit, const char *name)
+{
+	struct dpl_blob *strings = &emit->dt_strings;
+	size_t off = 0;
+
+	while (off < strings->len) {
+		const char *s = (const char *)strings->data + off;
+
+		if (strcmp(s, name) == 0)
+			return off;
+		off += strlen(s) + 1;
+	}
+
+	blob_put(emit, strings, name, strlen(name) + 1);
+	return off;
+}
+
+static void fdt_prop(struct dpl_emitter *emit, const char *name,
+		     size_t len)
+{
+	struct dpl_blob *dt = &emit->dt_struct;
+
+	blob_put_be32(emit, dt, FDT_PROP);
+	blob_put_be32(emit, dt, len);
+	blob_put_be32(emit, dt, string_offset(emit, name));
+}
+
+static void print_indent(struct dpl_emitter *emit)
+{
+	for (int i = 0; i < emit->depth; i++)
+		fputc('\t', emit->fp);
+}
+
+/**
+ * dpl_emit_open() - start writing a DPL
+ * @format: encoding to write
+ * @fp: stream to write to, unused for DPL_FORMAT_NONE
+ *
+ * Returns the emitter, to be released with dpl_emit_close(), or NULL
+ * if it cannot be allocated
+ */
+struct dpl_emitter *dpl_emit_open(enum dpl_format format, FILE *fp)
+{
+	struct dpl_emitter *emit;
+
+	emit = calloc(1, sizeof(*emit));
+	if (!emit) {
+		ERROR_PRINTF("calloc failed\n");
+		return NULL;
+	}
+
+	emit->format = format;
+	emit->fp = fp;
+	if (format == DPL_FORMAT_DTS)
+		fprintf(fp, "/dts-v1/;\n");
+
+	return emit;
+}
+
+static int write_blob(struct dpl_emitter *emit)
+{
+	size_t off_struct = FDT_HEADER_SIZE + FDT_RSVMAP_SIZE;
+	size_t off_strings;
+	size_t total;
+	uint8_t *fdt;
+	int error = 0;
+
+	blob_put_be32(emit, &emit->dt_struct, FDT_END);
+	if (emit->error)
+		return emit->error;
+
+	off_strings = off_struct + emit->dt_struct.len;
+	total = off_strings + emit->dt_strings.len;
+
+	fdt = calloc(1, total);
+	if (!fdt) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	put_be32(fdt, FDT_MAGIC);
+	put_be32(fdt + 4, total);
+	put_be32(fdt + 8, off_struct);
+	put_be32(fdt + 12, off_strings);
+	put_be32(fdt + 16, FDT_HEADER_SIZE);
+	put_be32(fdt + 20, FDT_VERSION);
+	put_be32(fdt + 24, FDT_LAST_COMP_VERSION);
+	put_be32(fdt + 28, 0);
+	put_be32(fdt + 32, emit->dt_strings.len);
+	put_be32(fdt + 36, emit->dt_struct.len);
+	memcpy(fdt + off_struct, emit->dt_struct.data, emit->dt_struct.len);
+	memcpy(fdt + off_strings, emit->dt_strings.data,
+	       emit->dt_strings.len);
+
+	if (fwrite(fdt, 1, total, emit->fp) != total) {
+		error = -EIO;
+		ERROR_PRINTF("error writing the DPL blob\n");
+	}
+
+	free(fdt);
+	return error;
+}
+
+/**
+ * dpl_emit_close() - finish a DPL and release the emitter
+ * @emit: the emitter, all of its nodes closed
+ *
+ * For the blob format this is where the DPL is actually written.
+ *
+ * Returns 0 on success, the first error met otherwise
+ */
+int dpl_emit_close(struct dpl_emitter *emit)
+{
+	int error;
+
+	assert(emit->depth == 0);
+	error = emit->error;
+	if (emit->format == DPL_FORMAT_DTB && error == 0)
+		error = write_blob(emit);
+
+	dpl_emit_discard(emit);
+	return error;
+}
+
+/**
+ * dpl_emit_discard() - release an emitter without finishing its DPL
+ * @emit: the emitter
+ *
+ * Source text already written stays written; a blob is dropped.
+ */
+void dpl_emit_discard(struct dpl_emitter *emit)
+{
+	free(emit->dt_struct.data);
+	free(emit->dt_strings.data);
+	free(emit);
+}
+
+/**
+ * dpl_emit_begin_node() - open a node, "/" being the root
+ * @emit: the emitter
+ * @fmt: printf format of the node name
+ */
+void dpl_emit_begin_node(struct dpl_emitter *emit, const char *fmt, ...)
+{
+	char name[DPL_NAME_MAX_LENGTH];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(name, sizeof(name), fmt, ap);
+	va_end(ap);
+
+	if (emit->format == DPL_FORMAT_DTS) {
+		print_indent(emit);
+		fprintf(emit->fp, "%s {\n", name);
+	} else if (emit->format == DPL_FORMAT_DTB) {
+		if (emit->depth == 0)
+			name[0] = '\0';
+		blob_put_be32(emit, &emit->dt_struct, FDT_BEGIN_NODE);
+		blob_put(emit, &emit->dt_struct, name, strlen(name) + 1);
+		blob_align(emit, &emit->dt_struct);
+	}
+
+	emit->depth++;
+}
+
+void dpl_emit_end_node(struct dpl_emitter *emit)
+{
+	assert(emit->depth > 0);
+	emit->depth--;
+
+	if (emit->format == DPL_FORMAT_DTS) {
+		print_indent(emit);
+		fprintf(emit->fp, "};\n");
+	} else if (emit->format == DPL_FORMAT_DTB) {
+		blob_put_be32(emit, &emit->dt_struct, FDT_END_NODE);
+	}
+}
+
+/**
+ * dpl_emit_strings() - write a string list property
+ * @emit: the emitter
+ * @name: property name
+ * @strings: the values
+ * @num_strings: number of entries in @strings
+ */
+void dpl_emit_strings(struct dpl_emitter *emit, const char *name,
+		      const char * const *strings, int num_strings)
+{
+	size_t len = 0;
+	int i;
+
+	if (emit->format == DPL_FORMAT_DTS) {
+		print_indent(emit);
+		fprintf(emit->fp, "%s = ", name);
+		for (i = 0; i < num_strings; i++)
+			fprintf(emit->fp, "%s\"%s\"", i ? ", " : "",
+				strings[i]);
+		fprintf(emit->fp, ";\n");
+	} else if (emit->format == DPL_FORMAT_DTB) {
+		for (i = 0; i < num_strings; i++)
+			len += strlen(strings[i]) + 1;
+		fdt_prop(emit, name, len);
+		for (i = 0; i < num_strings; i++)
+			blob_put(emit, &emit->dt_struct, strings[i],
+				 strlen(strings[i]) + 1);
+		blob_align(emit, &emit->dt_struct);
+	}
+}
+
+/**
+ * dpl_emit_string() - write a single string property
+ * @emit: the emitter
+ * @name: property name
+ * @fmt: printf format of the value
+ */
+void dpl_emit_string(struct dpl_emitter *emit, const char *name,
+		     const char *fmt, ...)
+{
+	char value[DPL_NAME_MAX_LENGTH];
+	const char *values[1] = { value };
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(value, sizeof(value), fmt, ap);
+	va_end(ap);
+
+	dpl_emit_strings(emit, name, values, 1);
+}
+
+/**
+ * dpl_emit_cells() - write a <...> cell list property
+ * @emit: the emitter
+ * @name: property name
+ * @base: how the cells are printed in source form
+ * @cells: the values
+ * @num_cells: number of entries in @cells
+ */
+void dpl_emit_cells(struct dpl_emitter *emit, const char *name,
+		    enum dpl_cell_base base, const uint32_t *cells,
+		    int num_cells)
+{
+	int i;
+
+	if (emit->format == DPL_FORMAT_DTS) {
+		print_indent(emit);
+		fprintf(emit->fp, "%s = <", name);
+		for (i = 0; i < num_cells; i++) {
+			if (i)
+				fputc(' ', emit->fp);
+			if (base == DPL_CELL_DEC)
+				fprintf(emit->fp, "%u", cells[i]);
+			else if (base == DPL_CELL_BYTE)
+				fprintf(emit->fp, "%#02x", cells[i]);
+			else
+				fprintf(emit->fp, "%#x", cells[i]);
+		}
+		fprintf(emit->fp, ">;\n");
+	} else if (emit->format == DPL_FORMAT_DTB) {
+		fdt_prop(emit, name, num_cells * 4);
+		for (i = 0; i < num_cells; i++)
+			blob_put_be32(emit, &emit->dt_struct, cells[i]);
+	}
+}
+
+void dpl_emit_cell(struct dpl_emitter *emit, const char *name,
+		   enum dpl_cell_base base, uint32_t cell)
+{
+	dpl_emit_cells(emit, name, base, &cell, 1);
+}
+
+/**
+ * dpl_emit_comment() - write a comment line, source form only
+ * @emit: the emitter
+ * @fmt: printf format of the line, comment delimiters included
+ */
+void dpl_emit_comment(struct dpl_emitter *emit, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (emit->format != DPL_FORMAT_DTS)
+		return;
+
+	print_indent(emit);
+	va_start(ap, fmt);
+	vfprintf(emit->fp, fmt, ap);
+	va_end(ap);
+	fputc('\n', emit->fp);
+}
+
+/* empty line, source form only */
+void dpl_emit_blank(struct dpl_emitter *emit)
+{
+	if (emit->format == DPL_FORMAT_DTS)
+		fputc('\n', emit->fp);
+}
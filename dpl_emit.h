@@ -0,0 +1,95 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DPL_EMIT_H_
+#define _DPL_EMIT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * enum dpl_format - encoding a DPL is written in
+ * @DPL_FORMAT_NONE: nothing is written, only the walk side effects matter
+ * @DPL_FORMAT_DTS: device tree source text
+ * @DPL_FORMAT_DTB: flattened device tree blob, as produced by dtc
+ */
+enum dpl_format {
+	DPL_FORMAT_NONE = 0,
+	DPL_FORMAT_DTS,
+	DPL_FORMAT_DTB,
+};
+
+/**
+ * enum dpl_cell_base - how the cells of a property are printed in source
+ * form; the blob always holds them as 32 bit big endian values
+ */
+enum dpl_cell_base {
+	DPL_CELL_HEX = 0,
+	DPL_CELL_DEC,
+	DPL_CELL_BYTE,
+};
+
+struct dpl_emitter;
+
+int dpl_format_parse(const char *name, enum dpl_format *format);
+
+struct dpl_emitter *dpl_emit_open(enum dpl_format format, FILE *fp);
+
+int dpl_emit_close(struct dpl_emitter *emit);
+
+void dpl_emit_discard(struct dpl_emitter *emit);
+
+void dpl_emit_begin_node(struct dpl_emitter *emit, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+void dpl_emit_end_node(struct dpl_emitter *emit);
+
+void dpl_emit_string(struct dpl_emitter *emit, const char *name,
+		     const char *fmt, ...)
+	__attribute__((format(printf, 3, 4)));
+
+void dpl_emit_strings(struct dpl_emitter *emit, const char *name,
+		      const char * const *strings, int num_strings);
+
+void dpl_emit_cells(struct dpl_emitter *emit, const char *name,
+		    enum dpl_cell_base base, const uint32_t *cells,
+		    int num_cells);
+
+void dpl_emit_cell(struct dpl_emitter *emit, const char *name,
+		   enum dpl_cell_base base, uint32_t cell);
+
+void dpl_emit_comment(struct dpl_emitter *emit, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+void dpl_emit_blank(struct dpl_emitter *emit);
+
+#endif /* _DPL_EMIT_H_ */
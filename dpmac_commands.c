@@ -40,8 +40,10 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpmac.h"
 #include "mc_v10/fsl_dpmac.h"
+#include "obj_list.h"
 
 enum mc_cmd_status mc_status;
 
@@ -80,6 +82,8 @@ enum dpmac_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_MAC_ID,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpmac_create_options[] = {
@@ -104,6 +108,20 @@ static struct option dpmac_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -129,11 +147,40 @@ static struct option dpmac_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpmac_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpmac_ops = {
+/**
+ * dpmac list command options
+ */
+enum dpmac_list_options {
+	LIST_OPT_HELP = 0,
+	LIST_OPT_JSON,
+};
+
+static struct option dpmac_list_options[] = {
+	[LIST_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[LIST_OPT_JSON] = {
+		.name = "json",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpmac_list_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+const struct flib_ops dpmac_ops = {
 	.obj_open = dpmac_open,
 	.obj_close = dpmac_close,
 	.obj_get_irq_mask = dpmac_get_irq_mask,
 	.obj_get_irq_status = dpmac_get_irq_status,
+	.obj_destroy = dpmac_destroy_v10,
 };
 
 static int cmd_dpmac_help(void)
@@ -145,6 +192,7 @@ static int cmd_dpmac_help(void)
 		"   info - displays detailed information about a DPMAC object.\n"
 		"   create - creates a new child DPMAC under the root DPRC.\n"
 		"   destroy - destroys a child DPMAC under the root DPRC.\n"
+		"   list - lists all DPMACs with their links and interfaces.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
 		"\n";
@@ -270,7 +318,8 @@ static int print_dpmac_attr_v9(uint32_t dpmac_id,
 	struct dpmac_attr dpmac_attr;
 	bool dpmac_opened = false;
 
-	error = dpmac_open(&restool.mc_io, 0, dpmac_id, &dpmac_handle);
+	error = handle_cache_open("dpmac", dpmac_id, dpmac_open,
+				  dpmac_close, &dpmac_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -312,18 +361,8 @@ static int print_dpmac_attr_v9(uint32_t dpmac_id,
 	error = 0;
 
 out:
-	if (dpmac_opened) {
-		int error2;
-
-		error2 = dpmac_close(&restool.mc_io, 0, dpmac_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpmac_opened)
+		(void)handle_cache_release(dpmac_handle);
 
 	return error;
 }
@@ -337,7 +376,8 @@ static int print_dpmac_attr_v10(uint32_t dpmac_id,
 	uint16_t dpmac_handle;
 	int error;
 
-	error = dpmac_open_v10(&restool.mc_io, 0, dpmac_id, &dpmac_handle);
+	error = handle_cache_open("dpmac", dpmac_id, dpmac_open_v10,
+				  dpmac_close_v10, &dpmac_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -387,18 +427,8 @@ static int print_dpmac_attr_v10(uint32_t dpmac_id,
 	error = 0;
 
 out:
-	if (dpmac_opened) {
-		int error2;
-
-		error2 = dpmac_close_v10(&restool.mc_io, 0, dpmac_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpmac_opened)
+		(void)handle_cache_release(dpmac_handle);
 
 	return error;
 }
@@ -561,7 +591,7 @@ static int create_dpmac_v10(struct dpmac_cfg *dpmac_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpmac", dpmac_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -661,6 +691,7 @@ static int destroy_dpmac_v9(uint32_t dpmac_id)
 	uint16_t dpmac_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpmac", dpmac_id);
 	error = dpmac_open(&restool.mc_io, 0, dpmac_id, &dpmac_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -720,6 +751,7 @@ static int destroy_dpmac_v10(uint32_t dpmac_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpmac", dpmac_id);
 	error = dpmac_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpmac_id);
 	if (error < 0) {
@@ -732,7 +764,7 @@ static int destroy_dpmac_v10(uint32_t dpmac_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -796,6 +828,46 @@ static int cmd_dpmac_destroy_v10(void)
 	return destroy_dpmac(MC_FW_VERSION_10);
 }
 
+static int cmd_dpmac_list(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpmac list [--json]\n"
+		"   Lists all DPMACs in the root container and the containers\n"
+		"   below it, with their container path, label, endpoint, link\n"
+		"   state and the Linux network interface of the DPNI it is linked to.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--json\n"
+		"   Print a JSON array instead of a table.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"   $ restool dpmac list\n"
+		"\n";
+
+	bool json = false;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(LIST_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(LIST_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		ERROR_PRINTF("Unexpected argument: \'%s\'\n\n",
+			     restool.obj_name);
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(LIST_OPT_JSON)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(LIST_OPT_JSON);
+		json = true;
+	}
+
+	return list_linked_objs("dpmac", json);
+}
+
 struct object_command dpmac_commands_v9[] = {
 	{ .cmd_name = "help",
 	  .options = NULL,
@@ -813,6 +885,10 @@ struct object_command dpmac_commands_v9[] = {
 	  .options = dpmac_destroy_options,
 	  .cmd_func = cmd_dpmac_destroy_v9 },
 
+	{ .cmd_name = "list",
+	  .options = dpmac_list_options,
+	  .cmd_func = cmd_dpmac_list },
+
 	{ .cmd_name = NULL },
 };
 
@@ -833,6 +909,10 @@ struct object_command dpmac_commands_v10[] = {
 	  .options = dpmac_destroy_options,
 	  .cmd_func = cmd_dpmac_destroy_v10 },
 
+	{ .cmd_name = "list",
+	  .options = dpmac_list_options,
+	  .cmd_func = cmd_dpmac_list },
+
 	{ .cmd_name = NULL },
 };
 
@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpmcp.h"
 #include "mc_v10/fsl_dpmcp.h"
 
@@ -79,6 +80,9 @@ C_ASSERT(ARRAY_SIZE(dpmcp_info_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 enum dpmcp_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpmcp_create_options[] = {
@@ -96,6 +100,27 @@ static struct option dpmcp_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -121,11 +146,12 @@ static struct option dpmcp_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpmcp_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpmcp_ops = {
+const struct flib_ops dpmcp_ops = {
 	.obj_open = dpmcp_open,
 	.obj_close = dpmcp_close,
 	.obj_get_irq_mask = dpmcp_get_irq_mask,
 	.obj_get_irq_status = dpmcp_get_irq_status,
+	.obj_destroy = dpmcp_destroy_v10,
 };
 
 static int cmd_dpmcp_help(void)
@@ -153,7 +179,8 @@ static int print_dpmcp_attr_v9(uint32_t dpmcp_id,
 	struct dpmcp_attr dpmcp_attr;
 	bool dpmcp_opened = false;
 
-	error = dpmcp_open(&restool.mc_io, 0, dpmcp_id, &dpmcp_handle);
+	error = handle_cache_open("dpmcp", dpmcp_id, dpmcp_open,
+				  dpmcp_close, &dpmcp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -190,18 +217,8 @@ static int print_dpmcp_attr_v9(uint32_t dpmcp_id,
 	error = 0;
 
 out:
-	if (dpmcp_opened) {
-		int error2;
-
-		error2 = dpmcp_close(&restool.mc_io, 0, dpmcp_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpmcp_opened)
+		(void)handle_cache_release(dpmcp_handle);
 
 	return error;
 }
@@ -215,7 +232,8 @@ static int print_dpmcp_attr_v10(uint32_t dpmcp_id,
 	uint16_t dpmcp_handle;
 	int error;
 
-	error = dpmcp_open_v10(&restool.mc_io, 0, dpmcp_id, &dpmcp_handle);
+	error = handle_cache_open("dpmcp", dpmcp_id, dpmcp_open_v10,
+				  dpmcp_close_v10, &dpmcp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -260,18 +278,8 @@ static int print_dpmcp_attr_v10(uint32_t dpmcp_id,
 	error = 0;
 
 out:
-	if (dpmcp_opened) {
-		int error2;
-
-		error2 = dpmcp_close_v10(&restool.mc_io, 0, dpmcp_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpmcp_opened)
+		(void)handle_cache_release(dpmcp_handle);
 
 	return error;
 }
@@ -435,7 +443,7 @@ static int create_dpmcp_v10(struct dpmcp_cfg *dpmcp_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpmcp", dpmcp_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -507,6 +515,7 @@ static int destroy_dpmcp_v9(uint32_t dpmcp_id)
 	uint16_t dpmcp_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpmcp", dpmcp_id);
 	error = dpmcp_open(&restool.mc_io, 0, dpmcp_id, &dpmcp_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -566,6 +575,7 @@ static int destroy_dpmcp_v10(uint32_t dpmcp_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpmcp", dpmcp_id);
 	error = dpmcp_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpmcp_id);
 	if (error < 0) {
@@ -578,7 +588,7 @@ static int destroy_dpmcp_v10(uint32_t dpmcp_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
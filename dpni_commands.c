@@ -40,8 +40,10 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpni.h"
 #include "mc_v10/fsl_dpni.h"
+#include "obj_list.h"
 
 #define ALL_DPNI_OPTS (					\
 	DPNI_OPT_ALLOW_DIST_KEY_PER_TC |		\
@@ -148,6 +150,9 @@ enum dpni_create_options {
 	CREATE_OPT_PARENT_DPRC,
 	CREATE_OPT_MAC_FILTER_ENTRIES,
 	CREATE_OPT_VLAN_FILTER_ENTRIES,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpni_create_options[] = {
@@ -305,6 +310,27 @@ static struct option dpni_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -330,6 +356,34 @@ static struct option dpni_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpni_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
+/**
+ * dpni list command options
+ */
+enum dpni_list_options {
+	LIST_OPT_HELP = 0,
+	LIST_OPT_JSON,
+};
+
+static struct option dpni_list_options[] = {
+	[LIST_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[LIST_OPT_JSON] = {
+		.name = "json",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpni_list_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
 enum dpni_update_options_v10 {
 	UPDATE_OPT_HELP = 0,
 	UPDATE_MAC_ADDR,
@@ -355,11 +409,12 @@ static struct option dpni_update_options_v10[] = {
 
 C_ASSERT(ARRAY_SIZE(dpni_update_options_v10) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpni_ops = {
+const struct flib_ops dpni_ops = {
 	.obj_open = dpni_open,
 	.obj_close = dpni_close,
 	.obj_get_irq_mask = dpni_get_irq_mask,
 	.obj_get_irq_status = dpni_get_irq_status,
+	.obj_destroy = dpni_destroy_v10,
 };
 
 static struct option_entry options_map_v9[] = {
@@ -438,6 +493,7 @@ static int cmd_dpni_help(void)
 		"   info - displays detailed information about a DPNI object.\n"
 		"   create - creates a new child DPNI under the root DPRC.\n"
 		"   destroy - destroys a child DPNI under the root DPRC.\n"
+		"   list - lists all DPNIs with their links and interfaces.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
 		"\n";
@@ -455,6 +511,7 @@ static int cmd_dpni_help_v10(void)
 		"   info - displays detailed information about a DPNI object.\n"
 		"   create - creates a new child DPNI under the root DPRC.\n"
 		"   destroy - destroys a child DPNI under the root DPRC.\n"
+		"   list - lists all DPNIs with their links and interfaces.\n"
 		"   update - update attributes of already created DPNI.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
@@ -617,7 +674,8 @@ static int print_dpni_attr_v9(uint32_t dpni_id,
 	bool dpni_opened = false;
 	struct dpni_link_state link_state;
 
-	error = dpni_open(&restool.mc_io, 0, dpni_id, &dpni_handle);
+	error = handle_cache_open("dpni", dpni_id, dpni_open,
+				  dpni_close, &dpni_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -726,18 +784,8 @@ static int print_dpni_attr_v9(uint32_t dpni_id,
 	error = 0;
 
 out:
-	if (dpni_opened) {
-		int error2;
-
-		error2 = dpni_close(&restool.mc_io, 0, dpni_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpni_opened)
+		(void)handle_cache_release(dpni_handle);
 
 	return error;
 }
@@ -767,10 +815,10 @@ static int print_dpni_attr_v10(uint32_t dpni_id,
 	bool dpni_opened = false;
 	uint8_t mac_addr[6];
 	int error = 0;
-	int error2;
 	unsigned int page;
 
-	error = dpni_open_v10(&restool.mc_io, 0, dpni_id, &dpni_handle);
+	error = handle_cache_open("dpni", dpni_id, dpni_open_v10,
+				  dpni_close_v10, &dpni_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -861,17 +909,8 @@ static int print_dpni_attr_v10(uint32_t dpni_id,
 	print_obj_label(target_obj_desc);
 
 out:
-	if (dpni_opened) {
-
-		error2 = dpni_close_v10(&restool.mc_io, 0, dpni_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpni_opened)
+		(void)handle_cache_release(dpni_handle);
 
 	return error;
 }
@@ -1547,7 +1586,7 @@ static int create_dpni_v10(const char *usage_msg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpni", dpni_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -1659,6 +1698,7 @@ static int destroy_dpni_v9(uint32_t dpni_id)
 	uint16_t dpni_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpni", dpni_id);
 	error = dpni_open(&restool.mc_io, 0, dpni_id, &dpni_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -1722,6 +1762,7 @@ static int destroy_dpni_v10(uint32_t dpni_id)
 		}
 	}
 
+	(void)handle_cache_evict("dpni", dpni_id);
 	error = dpni_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpni_id);
 	if (error) {
@@ -1734,7 +1775,7 @@ static int destroy_dpni_v10(uint32_t dpni_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id) {
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 		if (error) {
 			mc_status = flib_error_to_mc_status(error);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1876,6 +1917,46 @@ static int cmd_dpni_update_v10(void)
 	return update_dpni_v10(usage_msg);
 }
 
+static int cmd_dpni_list(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpni list [--json]\n"
+		"   Lists all DPNIs in the root container and the containers\n"
+		"   below it, with their container path, label, endpoint, link\n"
+		"   state and Linux network interface.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--json\n"
+		"   Print a JSON array instead of a table.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"   $ restool dpni list\n"
+		"\n";
+
+	bool json = false;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(LIST_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(LIST_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		ERROR_PRINTF("Unexpected argument: \'%s\'\n\n",
+			     restool.obj_name);
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(LIST_OPT_JSON)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(LIST_OPT_JSON);
+		json = true;
+	}
+
+	return list_linked_objs("dpni", json);
+}
+
 struct object_command dpni_commands_v9[] = {
 	{ .cmd_name = "help",
 	  .options = NULL,
@@ -1893,6 +1974,10 @@ struct object_command dpni_commands_v9[] = {
 	  .options = dpni_destroy_options,
 	  .cmd_func = cmd_dpni_destroy_v9 },
 
+	{ .cmd_name = "list",
+	  .options = dpni_list_options,
+	  .cmd_func = cmd_dpni_list },
+
 	{ .cmd_name = NULL },
 };
 
@@ -1917,6 +2002,10 @@ struct object_command dpni_commands_v10[] = {
 	  .options = dpni_update_options_v10,
 	  .cmd_func = cmd_dpni_update_v10 },
 
+	{ .cmd_name = "list",
+	  .options = dpni_list_options,
+	  .cmd_func = cmd_dpni_list },
+
 	{ .cmd_name = NULL },
 };
 
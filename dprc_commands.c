@@ -42,6 +42,18 @@
 #include "restool.h"
 #include "utils.h"
 #include "dprc_commands_generate_dpl.h"
+#include "dprc_commands_watch.h"
+#include "dprc_commands_link_monitor.h"
+#include "dprc_commands_apply.h"
+#include "dprc_commands_diff_dpl.h"
+#include "dprc_commands_destroy.h"
+#include "dprc_commands_build.h"
+#include "obj_pool.h"
+#include "dprc_walk.h"
+#include "handle_cache.h"
+#include "label_index.h"
+#include "idset.h"
+#include "transaction.h"
 
 #define ALL_DPRC_OPTS (				\
 	DPRC_CFG_OPT_SPAWN_ALLOWED |		\
@@ -148,6 +160,7 @@ enum dprc_create_child_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_OPTIONS,
 	CREATE_OPT_LABEL,
+	CREATE_OPT_COUNT,
 };
 
 static struct option dprc_create_child_options[] = {
@@ -165,6 +178,11 @@ static struct option dprc_create_child_options[] = {
 		.has_arg = 1,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+	},
+
 	{ 0 },
 };
 
@@ -175,6 +193,7 @@ C_ASSERT(ARRAY_SIZE(dprc_create_child_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
  */
 enum dprc_destroy_options {
 	DESTROY_OPT_HELP = 0,
+	DESTROY_OPT_RECURSIVE,
 };
 
 static struct option dprc_destroy_options[] = {
@@ -182,6 +201,10 @@ static struct option dprc_destroy_options[] = {
 		.name = "help",
 	},
 
+	[DESTROY_OPT_RECURSIVE] = {
+		.name = "recursive",
+	},
+
 	{ 0 },
 };
 
@@ -329,6 +352,7 @@ C_ASSERT(ARRAY_SIZE(dprc_disconnect_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
  */
 enum dpl_generate_options {
 	GENERATE_OPT_HELP = 0,
+	GENERATE_OPT_FORMAT,
 };
 
 struct option dpl_generate_options[] = {
@@ -336,12 +360,253 @@ struct option dpl_generate_options[] = {
 		.name = "help",
 	},
 
+	[GENERATE_OPT_FORMAT] = {
+		.name = "format",
+		.has_arg = 1,
+	},
+
 	{ 0 },
 };
 
 C_ASSERT(ARRAY_SIZE(dpl_generate_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dprc_ops = {
+/**
+ * dprc watch command options
+ */
+enum dprc_watch_options {
+	WATCH_OPT_HELP = 0,
+	WATCH_OPT_INTERVAL,
+};
+
+static struct option dprc_watch_options[] = {
+	[WATCH_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[WATCH_OPT_INTERVAL] = {
+		.name = "interval",
+		.has_arg = 1,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_watch_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc monitor-links command options
+ */
+enum dprc_monitor_links_options {
+	MONITOR_OPT_HELP = 0,
+	MONITOR_OPT_INTERVAL,
+	MONITOR_OPT_DURATION,
+	MONITOR_OPT_HISTORY,
+	MONITOR_OPT_QUIET,
+};
+
+static struct option dprc_monitor_links_options[] = {
+	[MONITOR_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[MONITOR_OPT_INTERVAL] = {
+		.name = "interval",
+		.has_arg = 1,
+	},
+
+	[MONITOR_OPT_DURATION] = {
+		.name = "duration",
+		.has_arg = 1,
+	},
+
+	[MONITOR_OPT_HISTORY] = {
+		.name = "history",
+		.has_arg = 1,
+	},
+
+	[MONITOR_OPT_QUIET] = {
+		.name = "quiet",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_monitor_links_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc capacity command options
+ */
+enum dprc_capacity_options {
+	CAPACITY_OPT_HELP = 0,
+};
+
+static struct option dprc_capacity_options[] = {
+	[CAPACITY_OPT_HELP] = {
+		.name = "help",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_capacity_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc apply command options
+ */
+enum dprc_apply_options {
+	APPLY_OPT_HELP = 0,
+};
+
+static struct option dprc_apply_options[] = {
+	[APPLY_OPT_HELP] = {
+		.name = "help",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_apply_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc diff-dpl command options
+ */
+enum dprc_diff_dpl_options {
+	DIFF_DPL_OPT_HELP = 0,
+	DIFF_DPL_OPT_APPLY,
+};
+
+static struct option dprc_diff_dpl_options[] = {
+	[DIFF_DPL_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[DIFF_DPL_OPT_APPLY] = {
+		.name = "apply",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_diff_dpl_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc build command options
+ */
+enum dprc_build_options {
+	BUILD_OPT_HELP = 0,
+	BUILD_OPT_CORES,
+	BUILD_OPT_IFACES,
+	BUILD_OPT_PRIORITIES,
+	BUILD_OPT_LABEL,
+	BUILD_OPT_MACS,
+	BUILD_OPT_DPL,
+};
+
+static struct option dprc_build_options[] = {
+	[BUILD_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[BUILD_OPT_CORES] = {
+		.name = "cores",
+		.has_arg = 1,
+	},
+
+	[BUILD_OPT_IFACES] = {
+		.name = "ifaces",
+		.has_arg = 1,
+	},
+
+	[BUILD_OPT_PRIORITIES] = {
+		.name = "priorities",
+		.has_arg = 1,
+	},
+
+	[BUILD_OPT_LABEL] = {
+		.name = "label",
+		.has_arg = 1,
+	},
+
+	[BUILD_OPT_MACS] = {
+		.name = "macs",
+		.has_arg = 1,
+	},
+
+	[BUILD_OPT_DPL] = {
+		.name = "dpl",
+		.has_arg = 1,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_build_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * dprc pool command options
+ */
+enum dprc_pool_options {
+	POOL_OPT_HELP = 0,
+	POOL_OPT_DPIO,
+	POOL_OPT_DPCON,
+	POOL_OPT_DPBP,
+	POOL_OPT_DPNI,
+	POOL_OPT_PRIORITIES,
+	POOL_OPT_QUEUES,
+	POOL_OPT_TCS,
+	POOL_OPT_ADD,
+};
+
+static struct option dprc_pool_options[] = {
+	[POOL_OPT_HELP] = {
+		.name = "help",
+	},
+
+	[POOL_OPT_DPIO] = {
+		.name = "dpio",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_DPCON] = {
+		.name = "dpcon",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_DPBP] = {
+		.name = "dpbp",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_DPNI] = {
+		.name = "dpni",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_PRIORITIES] = {
+		.name = "priorities",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_QUEUES] = {
+		.name = "queues",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_TCS] = {
+		.name = "tcs",
+		.has_arg = 1,
+	},
+
+	[POOL_OPT_ADD] = {
+		.name = "add",
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dprc_pool_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+const struct flib_ops dprc_ops = {
 	.obj_open = dprc_open,
 	.obj_close = dprc_close,
 	.obj_get_irq_mask = dprc_get_irq_mask,
@@ -378,6 +643,17 @@ static int cmd_dprc_help(void)
 		"   disconnect   - removes the link between two objects. Either endpoint can\n"
 		"		   be specified as the target of the operation.\n"
 		"   generate-dpl - generate DPL syntax for the specified container\n"
+		"   diff-dpl     - lists the steps that turn the current layout into\n"
+		"		   the one of a DPL file, or runs them.\n"
+		"   watch        - streams object changes below a container as JSON lines.\n"
+		"   monitor-links - reports link up/down transitions of dpni, dpmac and\n"
+		"		   dpsw ports below a container.\n"
+		"   capacity     - reports free and used resources per pool type.\n"
+		"   apply        - runs a provisioning plan, undoing it if a step fails.\n"
+		"   build        - creates a container sized for a number of cores and\n"
+		"		   network interfaces.\n"
+		"   pool         - keeps ready objects for 'dprc build' in a holding\n"
+		"		   container.\n"
 		"\n"
 		"For command-specific help, use the --help option of each command.\n"
 		"\n";
@@ -423,12 +699,12 @@ static int cmd_dprc_sync(void)
 /**
  * Lists nested DPRCs inside a given DPRC, recursively
  */
-static int list_dprc(uint32_t dprc_id, uint16_t dprc_handle,
-		     int nesting_level, bool show_non_dprc_objects,
+static int list_dprc(struct dprc_walk_node *node, bool show_non_dprc_objects,
 		     char *full_path)
 {
 	char *updated_full_path = NULL;
-	int num_child_devices;
+	int nesting_level = node->nesting_level;
+	int child_index = 0;
 	int error = 0;
 	int full_path_len;
 
@@ -442,74 +718,36 @@ static int list_dprc(uint32_t dprc_id, uint16_t dprc_handle,
 			return -ENOMEM;
 		}
 		if (full_path_len != 0)
-			sprintf(updated_full_path, "%s/dprc.%d", full_path, dprc_id);
+			sprintf(updated_full_path, "%s/dprc.%d", full_path,
+				node->id);
 		else
-			sprintf(updated_full_path, "dprc.%d", dprc_id);
+			sprintf(updated_full_path, "dprc.%d", node->id);
 		printf("%s\n", updated_full_path);
 	} else {
 		for (int i = 0; i < nesting_level; i++)
 			printf("  ");
-		printf("dprc.%u\n", dprc_id);
-	}
-
-	error = dprc_get_obj_count(&restool.mc_io, 0,
-				   dprc_handle,
-				   &num_child_devices);
-	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
-		goto out;
+		printf("dprc.%u\n", node->id);
 	}
 
-	for (int i = 0; i < num_child_devices; i++) {
-		struct dprc_obj_desc obj_desc;
-		uint16_t child_dprc_handle;
-		int error2;
-
-		error = dprc_get_obj(
-				&restool.mc_io, 0,
-				dprc_handle,
-				i,
-				&obj_desc);
-		if (error < 0) {
-			DEBUG_PRINTF(
-				"dprc_get_object(%u) failed with error %d\n",
-				i, error);
-			goto out;
-		}
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *obj_desc = &node->objs[i];
 
-		if (strcmp(obj_desc.type, "dprc") != 0) {
+		if (strcmp(obj_desc->type, "dprc") != 0) {
 			if (show_non_dprc_objects) {
 				for (int i = 0; i < nesting_level + 1; i++)
 					printf("  ");
 
-				printf("%s.%u\n", obj_desc.type, obj_desc.id);
+				printf("%s.%u\n", obj_desc->type, obj_desc->id);
 			}
 
 			continue;
 		}
 
-		error = open_dprc(obj_desc.id, &child_dprc_handle);
-		if (error < 0)
-			goto out;
-
-		error = list_dprc(obj_desc.id,
-				  child_dprc_handle,
-				  nesting_level + 1,
+		error = list_dprc(node->children[child_index++],
 				  show_non_dprc_objects,
 				  updated_full_path);
-
-		error2 = dprc_close(&restool.mc_io, 0, child_dprc_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-
+		if (error < 0)
 			goto out;
-		}
 	}
 
 out:
@@ -530,7 +768,9 @@ static int cmd_dprc_list(void)
 		"   prints the dprc list in a full-path\n"
 		"   format like: dprc.1/dprc.2\n"
 		"\n";
+	struct dprc_walk_node *root;
 	bool full_path = false;
+	int error;
 
 	if (restool.cmd_option_mask & ONE_BIT_MASK(LIST_OPT_HELP)) {
 		puts(usage_msg);
@@ -551,10 +791,44 @@ static int cmd_dprc_list(void)
 		return -EINVAL;
 	}
 
-	return list_dprc(restool.root_dprc_id,
-			 restool.root_dprc_handle,
-			 0, false,
-			 full_path ? "" : NULL);
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		return error;
+
+	error = list_dprc(root, false, full_path ? "" : NULL);
+	dprc_walk_free(root);
+	return error;
+}
+
+/**
+ * Collects the ids of the res_count resources of the given type held
+ * by a container into an interval set
+ */
+static int get_res_idset(uint16_t dprc_handle, const char *mc_res_type,
+			 int res_count, struct idset *set)
+{
+	struct dprc_res_ids_range_desc range_desc;
+	int error;
+
+	memset(&range_desc, 0, sizeof(struct dprc_res_ids_range_desc));
+	do {
+		error = dprc_get_res_ids(&restool.mc_io, 0, dprc_handle,
+					 (char *)mc_res_type, &range_desc);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			return error;
+		}
+
+		error = idset_add_range(set, range_desc.base_id,
+					range_desc.last_id);
+		if (error < 0)
+			return error;
+	} while (idset_count(set) < (uint64_t)res_count &&
+		 range_desc.iter_status != DPRC_ITER_STATUS_LAST);
+
+	return 0;
 }
 
 static int show_one_resource_type(uint16_t dprc_handle,
@@ -582,8 +856,6 @@ static int show_one_resource_type(uint16_t dprc_handle,
 	memset(&range_desc, 0, sizeof(struct dprc_res_ids_range_desc));
 	res_discovered_count = 0;
 	do {
-		int id;
-
 		error = dprc_get_res_ids(&restool.mc_io, 0, dprc_handle,
 					 (char *)mc_res_type, &range_desc);
 		if (error < 0) {
@@ -600,9 +872,8 @@ static int show_one_resource_type(uint16_t dprc_handle,
 			       mc_res_type, range_desc.base_id,
 			       mc_res_type, range_desc.last_id);
 
-		for (id = range_desc.base_id; id <= range_desc.last_id; id++)
-			res_discovered_count++;
-
+		res_discovered_count += range_desc.last_id -
+					range_desc.base_id + 1;
 	} while (res_discovered_count < res_count &&
 		 range_desc.iter_status != DPRC_ITER_STATUS_LAST);
 out:
@@ -833,7 +1104,7 @@ out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -918,7 +1189,7 @@ out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1172,7 +1443,7 @@ out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1189,10 +1460,18 @@ static int cmd_dprc_destroy_child(void)
 {
 	static const char usage_msg[] =
 		"\n"
-		"Usage: restool dprc destroy <container>\n"
+		"Usage: restool dprc destroy <container> [--recursive]\n"
+		"\n"
+		"OPTIONS:\n"
+		"--recursive\n"
+		"   Destroy every object and container inside <container> as well,\n"
+		"   after disconnecting their endpoints. Independent subtrees are\n"
+		"   torn down concurrently when --portals is greater than 1.\n"
+		"   Nothing is destroyed if any of the objects is bound to a driver.\n"
 		"\n"
 		"NOTE:\n"
 		" -<container> cannot be the root container\n"
+		" -with --recursive, MC firmware 10.x or later is required\n"
 		"\n";
 
 	int error;
@@ -1232,6 +1511,13 @@ static int cmd_dprc_destroy_child(void)
 		goto out;
 	}
 
+	if ((restool.cmd_option_mask & ONE_BIT_MASK(DESTROY_OPT_RECURSIVE)) &&
+	    restool.mc_fw_version.major < MC_FW_VERSION_10) {
+		ERROR_PRINTF("--recursive needs MC firmware 10.x or later\n");
+		error = -EINVAL;
+		goto out;
+	}
+
 	memset(&child_obj_desc, 0, sizeof(struct dprc_obj_desc));
 	error = find_target_obj_desc(restool.root_dprc_id,
 				restool.root_dprc_handle, 0,
@@ -1253,9 +1539,21 @@ static int cmd_dprc_destroy_child(void)
 		if (error < 0)
 			goto out;
 	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(DESTROY_OPT_RECURSIVE)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(DESTROY_OPT_RECURSIVE);
+		error = dprc_destroy_recursive(child_dprc_id,
+					       parent_dprc_handle);
+		if (error < 0)
+			goto out;
+
+		goto close_parent;
+	}
+
 	/*
 	 * Destroy child container in the MC:
 	 */
+	(void)handle_cache_trim();
 	error = dprc_destroy_container(&restool.mc_io, 0, parent_dprc_handle,
 					child_dprc_id);
 	if (error < 0) {
@@ -1268,8 +1566,10 @@ static int cmd_dprc_destroy_child(void)
 
 	printf("dprc.%u is destroyed\n", child_dprc_id);
 
+close_parent:
+
 	if (parent_dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, parent_dprc_handle);
+		error = close_dprc(parent_dprc_handle);
 
 out:
 	return error;
@@ -1296,6 +1596,12 @@ static int lookup_obj_desc(uint32_t parent_dprc_id,
 		dprc_handle = restool.root_dprc_handle;
 	}
 
+	error = get_obj_desc_in_dprc(dprc_handle, obj_type, obj_id,
+				     obj_desc_out);
+	if (error == 0)
+		goto out;
+
+	/* Fall back to scanning the container */
 	error = dprc_get_obj_count(&restool.mc_io, 0,
 				   dprc_handle,
 				   &num_child_devices);
@@ -1337,7 +1643,7 @@ out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1444,13 +1750,19 @@ static int do_dprc_assign_or_unassign(const char *usage_msg, bool do_assign)
 		res_req.id_base_align = 0;
 	} else if (restool.cmd_option_mask & ONE_BIT_MASK(ASSIGN_OPT_OBJECT)) {
 		/* changing plugged state, moving object case */
+		const char *obj_name;
 		int n;
 		int state;
 
 		restool.cmd_option_mask &= ~ONE_BIT_MASK(ASSIGN_OPT_OBJECT);
 		assert(restool.cmd_option_args[ASSIGN_OPT_OBJECT] != NULL);
+		error = resolve_label_arg(
+				restool.cmd_option_args[ASSIGN_OPT_OBJECT],
+				&obj_name);
+		if (error < 0)
+			goto out;
 
-		n = sscanf(restool.cmd_option_args[ASSIGN_OPT_OBJECT],
+		n = sscanf(obj_name,
 			   "%" STRINGIFY(OBJ_TYPE_MAX_LENGTH) "[a-z].%d",
 			   res_req.type, &res_req.id_base_align);
 		if (n != 2) {
@@ -1482,8 +1794,7 @@ static int do_dprc_assign_or_unassign(const char *usage_msg, bool do_assign)
 				error = -EINVAL;
 				goto out;
 			}
-			if (in_use(restool.cmd_option_args[ASSIGN_OPT_OBJECT],
-			    "changed plugged state")) {
+			if (in_use(obj_name, "changed plugged state")) {
 				error = -EBUSY;
 				goto out;
 			}
@@ -1512,8 +1823,7 @@ static int do_dprc_assign_or_unassign(const char *usage_msg, bool do_assign)
 				error = -EINVAL;
 				goto out;
 			}
-			if (in_use(restool.cmd_option_args[ASSIGN_OPT_OBJECT],
-			    "moved"))  {
+			if (in_use(obj_name, "moved"))  {
 				error = -EBUSY;
 				goto out;
 			}
@@ -1531,7 +1841,7 @@ static int do_dprc_assign_or_unassign(const char *usage_msg, bool do_assign)
 				ERROR_PRINTF(
 				"%s cannot be moved because it is currently in plugged state\n"
 				"unplug it first\n",
-				restool.cmd_option_args[ASSIGN_OPT_OBJECT]);
+				obj_name);
 
 				error = -EBUSY;
 				goto out;
@@ -1565,11 +1875,15 @@ static int do_dprc_assign_or_unassign(const char *usage_msg, bool do_assign)
 				     mc_status_to_string(mc_status), mc_status);
 		}
 	}
+
+	if (error == 0)
+		error = txn_record_assign(do_assign, parent_dprc_id,
+					  child_dprc_id, &res_req);
 out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1764,14 +2078,16 @@ static int cmd_dprc_set_label(void)
 		goto out;
 	}
 
+	label_index_invalidate();
+	error = txn_record_set_label(target_parent_dprc_id, obj_type, obj_id,
+				     target_obj_desc.label);
 out:
 	DEBUG_PRINTF("target_parent_dprc_opened=%d\n",
 			(int)target_parent_dprc_opened);
 	if (target_parent_dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0,
-					target_parent_dprc_handle);
+		error2 = close_dprc(target_parent_dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -1786,11 +2102,15 @@ out:
 
 static int parse_endpoint(char *endpoint_str, struct dprc_endpoint *endpoint)
 {
+	const char *obj_name;
 	int n;
 
 	memset(endpoint, 0, sizeof(*endpoint));
 
-	n = sscanf(endpoint_str,
+	if (resolve_label_arg(endpoint_str, &obj_name) < 0)
+		return -EINVAL;
+
+	n = sscanf(obj_name,
 		   "%" STRINGIFY(OBJ_TYPE_MAX_LENGTH) "[a-z].%d.%hu",
 		   endpoint->type, &endpoint->id, &endpoint->if_id);
 
@@ -1958,12 +2278,14 @@ static int cmd_dprc_connect(void)
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
 			     mc_status_to_string(mc_status), mc_status);
+	} else {
+		error = txn_record_connect(parent_dprc_id, &endpoint1);
 	}
 out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -2001,6 +2323,8 @@ static int cmd_dprc_disconnect(void)
 	bool dprc_opened = false;
 	uint32_t parent_dprc_id;
 	struct dprc_endpoint endpoint;
+	struct dprc_endpoint peer;
+	int state;
 
 	if (restool.cmd_option_mask & ONE_BIT_MASK(DISCONNECT_OPT_HELP)) {
 		puts(usage_msg);
@@ -2049,20 +2373,29 @@ static int cmd_dprc_disconnect(void)
 		goto out;
 	}
 
-	error = dprc_disconnect(&restool.mc_io, 0,
-				dprc_handle,
-				&endpoint);
+	/* A transaction needs the peer to undo the disconnect */
+	if (txn_active())
+		error = dprc_get_connection(&restool.mc_io, 0, dprc_handle,
+					    &endpoint, &peer, &state);
+
+	if (error == 0)
+		error = dprc_disconnect(&restool.mc_io, 0,
+					dprc_handle,
+					&endpoint);
 
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
 			     mc_status_to_string(mc_status), mc_status);
+	} else {
+		error = txn_record_disconnect(parent_dprc_id, &endpoint,
+					      &peer);
 	}
 out:
 	if (dprc_opened) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error2 = close_dprc(dprc_handle);
 		if (error2 < 0) {
 			mc_status = flib_error_to_mc_status(error2);
 			ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -2077,13 +2410,19 @@ out:
 
 static int cmd_dpl_generate(void)
 {
+	enum dpl_format format = DPL_FORMAT_DTS;
 	int error;
 
 	static const char usage_msg[] =
 		"\n"
-		"Usage: restool dprc generate-dpl <container>\n"
+		"Usage: restool dprc generate-dpl <container> [--format=<fmt>]\n"
 		"   <container> specifies the name of the container\n"
 		"\n"
+		"OPTIONS:\n"
+		"--format=<fmt>\n"
+		"   dts (default) writes the DPL source, dtb writes the\n"
+		"   flattened device tree the MC boots from, no dtc needed.\n"
+		"\n"
 		"NOTES:\n"
 		"Generates the DPL syntax for the specified container to stdout,\n"
 		"including all child and decendant containers.\n"
@@ -2091,6 +2430,8 @@ static int cmd_dpl_generate(void)
 		"EXAMPLE:\n"
 		"Generate a DPL for dprc.1:\n"
 		"   $ restool dprc generate-dpl dprc.1\n"
+		"Generate a DPL blob for dprc.1:\n"
+		"   $ restool dprc generate-dpl dprc.1 --format=dtb > dpl.dtb\n"
 		"\n";
 
 	if (restool.cmd_option_mask & ONE_BIT_MASK(GENERATE_OPT_HELP)) {
@@ -2099,26 +2440,737 @@ static int cmd_dpl_generate(void)
 		return 0;
 	}
 
-	error = dpl_generate();
+	if (restool.cmd_option_mask & ONE_BIT_MASK(GENERATE_OPT_FORMAT)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(GENERATE_OPT_FORMAT);
+		error = dpl_format_parse(
+			restool.cmd_option_args[GENERATE_OPT_FORMAT], &format);
+		if (error) {
+			ERROR_PRINTF("Invalid format: %s\n",
+				     restool.cmd_option_args[GENERATE_OPT_FORMAT]);
+			puts(usage_msg);
+			return error;
+		}
+	}
+
+	error = dpl_generate(format);
 
 	return error;
 }
 
 /**
- * DPRC command table
+ * struct pool_capacity - resource accounting of one pool type
+ * @type: resource type
+ * @free: ids held by the container the accounting started from
+ * @used: ids held by its descendant containers
+ * @num_containers: number of descendant containers holding ids
  */
-struct object_command dprc_commands[] = {
-	{ .cmd_name = "help",
-	  .options = NULL,
-	  .cmd_func = cmd_dprc_help },
-
-	{ .cmd_name = "sync",
-	  .options = dprc_sync_options,
-	  .cmd_func = cmd_dprc_sync },
+struct pool_capacity {
+	char type[RES_TYPE_MAX_LENGTH + 1];
+	struct idset free;
+	struct idset used;
+	int num_containers;
+};
 
-	{ .cmd_name = "list",
-	  .options = dprc_list_options,
-	  .cmd_func = cmd_dprc_list },
+static int account_container_resources(struct dprc_walk_node *node,
+				       struct pool_capacity *pools,
+				       int num_pools)
+{
+	uint16_t dprc_handle;
+	bool dprc_opened = false;
+	int error = 0;
+
+	if (node->id != restool.root_dprc_id) {
+		error = open_dprc(node->id, &dprc_handle);
+		if (error < 0)
+			goto out;
+
+		dprc_opened = true;
+	} else {
+		dprc_handle = restool.root_dprc_handle;
+	}
+
+	for (int i = 0; i < num_pools; i++) {
+		struct pool_capacity *pool = &pools[i];
+		struct idset set;
+		int res_count;
+
+		error = dprc_get_res_count(&restool.mc_io, 0, dprc_handle,
+					   pool->type, &res_count);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			goto out;
+		}
+
+		if (res_count == 0)
+			continue;
+
+		if (node->nesting_level == 0) {
+			error = get_res_idset(dprc_handle, pool->type,
+					      res_count, &pool->free);
+			if (error < 0)
+				goto out;
+
+			continue;
+		}
+
+		idset_init(&set);
+		error = get_res_idset(dprc_handle, pool->type, res_count,
+				      &set);
+		if (error == 0)
+			error = idset_union(&pool->used, &set);
+		idset_free(&set);
+		if (error < 0)
+			goto out;
+
+		pool->num_containers++;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = account_container_resources(node->children[i],
+						    pools, num_pools);
+		if (error < 0)
+			goto out;
+	}
+
+out:
+	if (dprc_opened) {
+		int error2;
+
+		error2 = close_dprc(dprc_handle);
+		if (error2 < 0) {
+			mc_status = flib_error_to_mc_status(error2);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			if (error == 0)
+				error = error2;
+		}
+	}
+
+	return error;
+}
+
+static int show_capacity(uint32_t dprc_id)
+{
+	struct dprc_walk_node *root = NULL;
+	struct pool_capacity *pools = NULL;
+	int num_pools = 0;
+	int error;
+
+	error = dprc_walk(dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = dprc_get_pool_count(&restool.mc_io, 0,
+				    restool.root_dprc_handle, &num_pools);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		goto out;
+	}
+
+	if (num_pools == 0) {
+		printf("Don't have any resource pool.\n");
+		goto out;
+	}
+
+	pools = calloc(num_pools, sizeof(*pools));
+	if (!pools) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	for (int i = 0; i < num_pools; i++) {
+		error = dprc_get_pool(&restool.mc_io, 0,
+				      restool.root_dprc_handle, i,
+				      pools[i].type);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			goto out;
+		}
+	}
+
+	error = account_container_resources(root, pools, num_pools);
+	if (error < 0)
+		goto out;
+
+	printf("%-16s %10s %10s %10s %10s\n",
+	       "pool", "total", "free", "used", "containers");
+	for (int i = 0; i < num_pools; i++) {
+		struct pool_capacity *pool = &pools[i];
+		uint64_t num_free = idset_count(&pool->free);
+		uint64_t num_used = idset_count(&pool->used);
+
+		printf("%-16s %10llu %10llu %10llu %10d\n", pool->type,
+		       (unsigned long long)(num_free + num_used),
+		       (unsigned long long)num_free,
+		       (unsigned long long)num_used,
+		       pool->num_containers);
+
+		if (idset_overlap_count(&pool->free, &pool->used))
+			ERROR_PRINTF("%s: ids held by more than one container\n",
+				     pool->type);
+	}
+
+out:
+	if (pools) {
+		for (int i = 0; i < num_pools; i++) {
+			idset_free(&pools[i].free);
+			idset_free(&pools[i].used);
+		}
+		free(pools);
+	}
+	dprc_walk_free(root);
+	return error;
+}
+
+static int cmd_dprc_capacity(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc capacity [<container>]\n"
+		"   <container> specifies the container to account from.\n"
+		"	Defaults to the root container.\n"
+		"\n"
+		"NOTES:\n"
+		"For every resource pool type, reports the number of resource ids\n"
+		"still free in <container>, the number used by (assigned to) its\n"
+		"child and descendant containers, and how many of those\n"
+		"containers hold any. The whole tree is read in one pass.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Display the resource capacity of the system:\n"
+		"   $ restool dprc capacity\n"
+		"\n";
+
+	uint32_t dprc_id = restool.root_dprc_id;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(CAPACITY_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(CAPACITY_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc", &dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	return show_capacity(dprc_id);
+}
+
+static int cmd_dprc_apply(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc apply <plan-file>\n"
+		"   <plan-file> lists restool commands, one per line, without the\n"
+		"	leading \"restool\" and global options. Blank lines and text\n"
+		"	after '#' are ignored, words may be quoted.\n"
+		"\n"
+		"NOTES:\n"
+		"The steps run in order over a single MC session. Only object\n"
+		"creation and 'dprc' assign, unassign, connect, disconnect and\n"
+		"set-label are accepted, since those are journalled. If a step\n"
+		"fails, the journal is undone newest first: created objects are\n"
+		"destroyed, moves and plugged state changes are reverted,\n"
+		"connections removed or made again with default rates and labels\n"
+		"restored.\n"
+		"Inside a step, $<n> stands for the n-th object created by the\n"
+		"plan so far.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"   $ cat plan\n"
+		"   dprc create dprc.1 --label=vm7\n"
+		"   dpni create --container=$1\n"
+		"   dprc set-label $2 --label=vm7-eth0\n"
+		"   dprc connect dprc.1 --endpoint1=$2 --endpoint2=dpsw.0.1\n"
+		"   dprc assign $1 --object=$2 --plugged=1\n"
+		"   $ restool dprc apply plan\n"
+		"\n";
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(APPLY_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(APPLY_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name == NULL) {
+		ERROR_PRINTF("<plan-file> argument missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	if (txn_active()) {
+		ERROR_PRINTF("dprc apply cannot be used inside a plan\n");
+		return -EINVAL;
+	}
+
+	return dprc_apply(restool.obj_name);
+}
+
+static int cmd_dprc_diff_dpl(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc diff-dpl <dpl-file> [--apply]\n"
+		"   <dpl-file> is a DPL in source form, such as generate-dpl\n"
+		"	prints. Its top container stands for the root container.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--apply\n"
+		"   Run the steps instead of printing them.\n"
+		"\n"
+		"NOTES:\n"
+		"Prints, in the syntax of 'dprc apply', the steps that make the\n"
+		"layout below the root container match the DPL: connections it\n"
+		"does not have are removed, missing containers and objects are\n"
+		"created, objects in the wrong container are moved, labels are\n"
+		"set, missing connections are made and finally the containers and\n"
+		"objects it does not list are destroyed. Nothing else is touched.\n"
+		"Containers and objects are matched by id. New objects get the id\n"
+		"the MC gives them, so regenerate the DPL after applying it.\n"
+		"A DPL object without a label leaves the label unchanged.\n"
+		"Moved objects are unplugged, and plugged in their new container\n"
+		"only when their DPL node has 'plugged = <1>'.\n"
+		"With --apply every step but the destroys is undone if one fails.\n"
+		"The destroys run once all other steps succeeded, and stop at the\n"
+		"first one that fails.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"   $ restool dprc diff-dpl dpl.dts\n"
+		"   $ restool dprc diff-dpl dpl.dts --apply\n"
+		"\n";
+	bool apply = false;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(DIFF_DPL_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(DIFF_DPL_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name == NULL) {
+		ERROR_PRINTF("<dpl-file> argument missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(DIFF_DPL_OPT_APPLY)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(DIFF_DPL_OPT_APPLY);
+		apply = true;
+	}
+
+	if (txn_active()) {
+		ERROR_PRINTF("dprc diff-dpl cannot be used inside a plan\n");
+		return -EINVAL;
+	}
+
+	return dprc_diff_dpl(restool.obj_name, apply);
+}
+
+static int cmd_dprc_build(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc build [<parent-container>] --cores=<number>\n"
+		"	--ifaces=<number> [--priorities=<number>] [--label=<label>]\n"
+		"	[--macs=<dpmac>,...] [--dpl=<file>]\n"
+		"   <parent-container> is where the objects are taken from and the\n"
+		"	new container is created. Defaults to the root container.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--cores=<number>\n"
+		"   Number of cores the container serves, 1 to 64. It gets one\n"
+		"   DPIO and one DPCON per core, and each DPNI gets one queue per\n"
+		"   core, up to 8.\n"
+		"--ifaces=<number>\n"
+		"   Number of network interfaces, 0 to 16. Each is a DPNI with its\n"
+		"   own DPBP.\n"
+		"--priorities=<number>\n"
+		"   Scheduling priorities of the DPIOs and DPCONs, and traffic\n"
+		"   classes of the DPNIs, 1 to 8. Defaults to 2.\n"
+		"--label=<label>\n"
+		"   Label of the new container.\n"
+		"--macs=<dpmac>,...\n"
+		"   Connect the DPNIs to these DPMACs, one per interface, in order.\n"
+		"--dpl=<file>\n"
+		"   Write the DPL of the new container to <file> instead of the\n"
+		"   standard output.\n"
+		"\n"
+		"NOTES:\n"
+		"The free resources of <parent-container> are checked before\n"
+		"anything is created. Objects are then created, moved plugged into\n"
+		"the new container and connected in one session, and everything\n"
+		"is undone if a step fails, as with 'dprc apply'.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Build a container for a 4-core VM with two interfaces:\n"
+		"   $ restool dprc build --cores=4 --ifaces=2 --label=vm7 \\\n"
+		"	--macs=dpmac.3,dpmac.4 --dpl=vm7.dts\n"
+		"\n";
+
+	struct build_cfg cfg = {
+		.priorities = 2,
+	};
+	uint32_t parent_dprc_id = restool.root_dprc_id;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc",
+					  &parent_dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	if (!(restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_CORES)) ||
+	    !(restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_IFACES))) {
+		ERROR_PRINTF("--cores and --ifaces options are required\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_CORES);
+	error = get_option_value(BUILD_OPT_CORES, &cfg.cores,
+				 "Invalid cores value", 1, 64);
+	if (error < 0)
+		return error;
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_IFACES);
+	error = get_option_value(BUILD_OPT_IFACES, &cfg.ifaces,
+				 "Invalid ifaces value", 0, 16);
+	if (error < 0)
+		return error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_PRIORITIES)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_PRIORITIES);
+		error = get_option_value(BUILD_OPT_PRIORITIES, &cfg.priorities,
+					 "Invalid priorities value", 1, 8);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_LABEL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_LABEL);
+		cfg.label = restool.cmd_option_args[BUILD_OPT_LABEL];
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_MACS)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_MACS);
+		cfg.macs = restool.cmd_option_args[BUILD_OPT_MACS];
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(BUILD_OPT_DPL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(BUILD_OPT_DPL);
+		cfg.dpl_file = restool.cmd_option_args[BUILD_OPT_DPL];
+	}
+
+	if (txn_active()) {
+		ERROR_PRINTF("dprc build cannot be used inside a plan\n");
+		return -EINVAL;
+	}
+
+	return dprc_build(parent_dprc_id, &cfg);
+}
+
+static int cmd_dprc_pool(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc pool [<parent-container>] [--dpio=<number>]\n"
+		"	[--dpcon=<number>] [--dpbp=<number>] [--dpni=<number>]\n"
+		"	[--priorities=<number>] [--queues=<number>] [--tcs=<number>]\n"
+		"	[--add]\n"
+		"   <parent-container> is the container the pooled objects are\n"
+		"	created in and built containers are created under. Defaults\n"
+		"	to the root container.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--dpio=<number>, --dpcon=<number>, --dpbp=<number>, --dpni=<number>\n"
+		"   Number of ready objects of that type to keep in the pool, up\n"
+		"   to 1024. Without any of these options, the number of ready\n"
+		"   objects of each kind is printed.\n"
+		"--priorities=<number>\n"
+		"   Scheduling priorities of the pooled DPIOs and DPCONs, 1 to 8.\n"
+		"   Defaults to 2.\n"
+		"--queues=<number>\n"
+		"   Queues per traffic class of the pooled DPNIs, 1 to 8.\n"
+		"   Defaults to 8.\n"
+		"--tcs=<number>\n"
+		"   Traffic classes of the pooled DPNIs, 1 to 8. Defaults to 2.\n"
+		"--add\n"
+		"   Create the given numbers of objects instead of topping the\n"
+		"   pool up to them.\n"
+		"\n"
+		"NOTES:\n"
+		"Pooled objects wait unplugged in a child container labelled\n"
+		"'" OBJ_POOL_LABEL "'. 'dprc build' moves matching objects from there\n"
+		"instead of creating them, then refills the pool in the background.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Keep objects for two 4-core containers with two interfaces each:\n"
+		"   $ restool dprc pool --dpio=8 --dpcon=8 --dpbp=4 --dpni=4 \\\n"
+		"	--queues=4\n"
+		"\n";
+
+	static const struct {
+		int opt;
+		enum obj_pool_type type;
+	} count_opts[] = {
+		{ POOL_OPT_DPIO, OBJ_POOL_DPIO },
+		{ POOL_OPT_DPCON, OBJ_POOL_DPCON },
+		{ POOL_OPT_DPBP, OBJ_POOL_DPBP },
+		{ POOL_OPT_DPNI, OBJ_POOL_DPNI },
+	};
+	struct obj_pool_cfg cfg = {
+		.priorities = 2,
+		.queues = 8,
+		.tcs = 2,
+	};
+	uint32_t parent_dprc_id = restool.root_dprc_id;
+	bool have_counts = false;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(POOL_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(POOL_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc",
+					  &parent_dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(count_opts); i++) {
+		int opt = count_opts[i].opt;
+
+		if (!(restool.cmd_option_mask & ONE_BIT_MASK(opt)))
+			continue;
+
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(opt);
+		error = get_option_value(opt, &cfg.count[count_opts[i].type],
+					 "Invalid object count", 0, 1024);
+		if (error < 0)
+			return error;
+
+		have_counts = true;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(POOL_OPT_PRIORITIES)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(POOL_OPT_PRIORITIES);
+		error = get_option_value(POOL_OPT_PRIORITIES, &cfg.priorities,
+					 "Invalid priorities value", 1, 8);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(POOL_OPT_QUEUES)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(POOL_OPT_QUEUES);
+		error = get_option_value(POOL_OPT_QUEUES, &cfg.queues,
+					 "Invalid queues value", 1, 8);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(POOL_OPT_TCS)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(POOL_OPT_TCS);
+		error = get_option_value(POOL_OPT_TCS, &cfg.tcs,
+					 "Invalid tcs value", 1, 8);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(POOL_OPT_ADD)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(POOL_OPT_ADD);
+		cfg.add = true;
+	}
+
+	if (!have_counts)
+		return obj_pool_print(parent_dprc_id);
+
+	if (txn_active()) {
+		ERROR_PRINTF("dprc pool cannot be used inside a plan\n");
+		return -EINVAL;
+	}
+
+	return obj_pool_fill(parent_dprc_id, &cfg);
+}
+
+static int cmd_dprc_watch(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc watch [<container>] [--interval=<seconds>]\n"
+		"   <container> specifies the container to watch, including all\n"
+		"	child and descendant containers. Defaults to the root container.\n"
+		"\n"
+		"--interval=<seconds>\n"
+		"   Also check every container for changes at this interval, by\n"
+		"   reading its DPRC interrupt status and object count, for systems\n"
+		"   where no fsl-mc uevents are delivered. Defaults to 0, re-reading\n"
+		"   containers only when a fsl-mc uevent names them.\n"
+		"\n"
+		"NOTES:\n"
+		"Prints one JSON object per line for every object added to or\n"
+		"removed from a container, and for every label or plugged state\n"
+		"change, until interrupted. Label changes raise no event of their\n"
+		"own and are reported the next time their container is re-read. E.g.:\n"
+		"{\"event\":\"add\",\"object\":\"dpni.3\",\"container\":\"dprc.2\",\"label\":\"\",\"plugged\":false}\n"
+		"Event can be one of: add, remove, label-change, plug-state-change.\n"
+		"label-change records also carry \"old_label\".\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Watch dprc.2, checking it every 10 seconds:\n"
+		"   $ restool dprc watch dprc.2 --interval=10\n"
+		"\n";
+
+	uint32_t dprc_id = restool.root_dprc_id;
+	long interval = 0;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(WATCH_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(WATCH_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc", &dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(WATCH_OPT_INTERVAL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(WATCH_OPT_INTERVAL);
+		error = get_option_value(WATCH_OPT_INTERVAL, &interval,
+					 "Invalid interval value",
+					 0, INT_MAX / 1000);
+		if (error < 0)
+			return error;
+	}
+
+	return dprc_watch(dprc_id, interval);
+}
+
+static int cmd_dprc_monitor_links(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dprc monitor-links [<container>] [OPTIONS]\n"
+		"   <container> specifies the container whose dpni, dpmac and dpsw\n"
+		"	ports are monitored, including all child and descendant\n"
+		"	containers. Defaults to the root container.\n"
+		"\n"
+		"OPTIONS:\n"
+		"--interval=<ms>\n"
+		"   Polling period for all links, in milliseconds. Defaults to 1000.\n"
+		"   Links of ports backed by a network interface are also re-read\n"
+		"   as soon as the kernel reports a change on that interface.\n"
+		"--duration=<seconds>\n"
+		"   Stop after this many seconds. Defaults to running until\n"
+		"   interrupted.\n"
+		"--history=<number>\n"
+		"   Number of most recent transitions kept. Defaults to 64.\n"
+		"--quiet\n"
+		"   Do not print transitions as they happen, list the kept ones\n"
+		"   after the summary instead.\n"
+		"\n"
+		"NOTES:\n"
+		"When the monitor stops, a summary with the number of transitions,\n"
+		"flaps (up to down transitions), total and longest down time of\n"
+		"each link is printed.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Monitor the links in dprc.2 for one minute:\n"
+		"   $ restool dprc monitor-links dprc.2 --duration=60\n"
+		"\n";
+
+	struct link_monitor_cfg cfg = {
+		.interval = 1000,
+		.duration = 0,
+		.history = 64,
+		.quiet = false,
+	};
+	uint32_t dprc_id = restool.root_dprc_id;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(MONITOR_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(MONITOR_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc", &dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(MONITOR_OPT_INTERVAL)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(MONITOR_OPT_INTERVAL);
+		error = get_option_value(MONITOR_OPT_INTERVAL, &cfg.interval,
+					 "Invalid interval value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(MONITOR_OPT_DURATION)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(MONITOR_OPT_DURATION);
+		error = get_option_value(MONITOR_OPT_DURATION, &cfg.duration,
+					 "Invalid duration value",
+					 1, INT_MAX);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(MONITOR_OPT_HISTORY)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(MONITOR_OPT_HISTORY);
+		error = get_option_value(MONITOR_OPT_HISTORY, &cfg.history,
+					 "Invalid history value",
+					 1, 1 << 20);
+		if (error < 0)
+			return error;
+	}
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(MONITOR_OPT_QUIET)) {
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(MONITOR_OPT_QUIET);
+		cfg.quiet = true;
+	}
+
+	return dprc_monitor_links(dprc_id, &cfg);
+}
+
+/**
+ * DPRC command table
+ */
+struct object_command dprc_commands[] = {
+	{ .cmd_name = "help",
+	  .options = NULL,
+	  .cmd_func = cmd_dprc_help },
+
+	{ .cmd_name = "sync",
+	  .options = dprc_sync_options,
+	  .cmd_func = cmd_dprc_sync },
+
+	{ .cmd_name = "list",
+	  .options = dprc_list_options,
+	  .cmd_func = cmd_dprc_list },
 
 	{ .cmd_name = "show",
 	  .options = dprc_show_options,
@@ -2161,6 +3213,34 @@ struct object_command dprc_commands[] = {
 	  .options = dpl_generate_options,
 	  .cmd_func = cmd_dpl_generate },
 
+	{ .cmd_name = "diff-dpl",
+	  .options = dprc_diff_dpl_options,
+	  .cmd_func = cmd_dprc_diff_dpl },
+
+	{ .cmd_name = "watch",
+	  .options = dprc_watch_options,
+	  .cmd_func = cmd_dprc_watch },
+
+	{ .cmd_name = "monitor-links",
+	  .options = dprc_monitor_links_options,
+	  .cmd_func = cmd_dprc_monitor_links },
+
+	{ .cmd_name = "capacity",
+	  .options = dprc_capacity_options,
+	  .cmd_func = cmd_dprc_capacity },
+
+	{ .cmd_name = "apply",
+	  .options = dprc_apply_options,
+	  .cmd_func = cmd_dprc_apply },
+
+	{ .cmd_name = "build",
+	  .options = dprc_build_options,
+	  .cmd_func = cmd_dprc_build },
+
+	{ .cmd_name = "pool",
+	  .options = dprc_pool_options,
+	  .cmd_func = cmd_dprc_pool },
+
 	{ .cmd_name = NULL },
 };
 
@@ -0,0 +1,292 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+#include "restool.h"
+#include "utils.h"
+#include "transaction.h"
+#include "dprc_commands_apply.h"
+
+/**
+ * Maximum number of words in one plan step
+ */
+#define MAX_STEP_ARGS	64
+
+/**
+ * Splits a plan line into words, in place. Words are separated by
+ * blanks and may be quoted with '' or "". An unquoted '#' starts a
+ * comment.
+ */
+static int split_words(char *line, char *words[], int max_words)
+{
+	int num_words = 0;
+	char *src = line;
+
+	for (;;) {
+		char *dst;
+		char quote = '\0';
+
+		while (isspace((unsigned char)*src))
+			src++;
+
+		if (*src == '\0' || *src == '#')
+			break;
+
+		if (num_words == max_words) {
+			ERROR_PRINTF("too many words\n");
+			return -E2BIG;
+		}
+
+		words[num_words++] = dst = src;
+		while (*src != '\0' &&
+		       (quote || !isspace((unsigned char)*src))) {
+			if (quote && *src == quote) {
+				quote = '\0';
+				src++;
+			} else if (!quote && (*src == '"' || *src == '\'')) {
+				quote = *src++;
+			} else {
+				*dst++ = *src++;
+			}
+		}
+
+		if (quote) {
+			ERROR_PRINTF("unterminated quote\n");
+			return -EINVAL;
+		}
+
+		if (*src != '\0')
+			src++;
+		*dst = '\0';
+	}
+
+	return num_words;
+}
+
+/**
+ * Returns a copy of word with every "$<n>" replaced by the name of the
+ * n-th object created by the plan so far
+ */
+static char *expand_word(const char *word)
+{
+	size_t size = strlen(word) + 1;
+	char *out, *dst;
+
+	for (const char *p = strchr(word, '$'); p; p = strchr(p + 1, '$'))
+		size += OBJ_TYPE_MAX_LENGTH + 12;
+
+	out = malloc(size);
+	if (!out) {
+		ERROR_PRINTF("malloc failed\n");
+		return NULL;
+	}
+
+	dst = out;
+	while (*word != '\0') {
+		const char *obj_name;
+		char *end;
+		long n;
+
+		if (*word != '$' || !isdigit((unsigned char)word[1])) {
+			*dst++ = *word++;
+			continue;
+		}
+
+		n = strtol(word + 1, &end, 10);
+		obj_name = n > 0 && n <= INT32_MAX ?
+			   txn_created_obj((int)n - 1) : NULL;
+		if (!obj_name) {
+			ERROR_PRINTF("$%ld does not refer to a created object\n",
+				     n);
+			free(out);
+			return NULL;
+		}
+
+		strcpy(dst, obj_name);
+		dst += strlen(obj_name);
+		word = end;
+	}
+	*dst = '\0';
+
+	return out;
+}
+
+/*
+ * dprc commands whose MC changes are journalled, besides the create
+ * command of every object type
+ */
+static const char *const journalled_dprc_commands[] = {
+	"assign",
+	"unassign",
+	"connect",
+	"disconnect",
+	"set-label",
+};
+
+static bool is_journalled(const char *obj_type, const char *cmd_name)
+{
+	if (strcmp(cmd_name, "create") == 0)
+		return true;
+
+	if (strcmp(obj_type, "dprc") != 0)
+		return false;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(journalled_dprc_commands); i++)
+		if (strcmp(journalled_dprc_commands[i], cmd_name) == 0)
+			return true;
+
+	return false;
+}
+
+/**
+ * dprc_apply_step() - run one plan step
+ * @step: restool command line without the leading "restool", where
+ *	"$<n>" stands for the n-th object created in the transaction
+ *
+ * Inside a transaction, only steps whose changes can be undone are run.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int dprc_apply_step(const char *step)
+{
+	char *line;
+	char *words[MAX_STEP_ARGS];
+	char *argv[MAX_STEP_ARGS + 1];
+	int num_words;
+	int argc = 0;
+	int error;
+
+	line = strdup(step);
+	if (!line) {
+		ERROR_PRINTF("strdup failed\n");
+		return -ENOMEM;
+	}
+
+	num_words = split_words(line, words, MAX_STEP_ARGS);
+	if (num_words <= 0) {
+		error = num_words;
+		goto out;
+	}
+
+	if (num_words < 2) {
+		ERROR_PRINTF("Incomplete command line\n");
+		error = -EINVAL;
+		goto out;
+	}
+
+	if (txn_active() && !is_journalled(words[0], words[1])) {
+		ERROR_PRINTF("'%s %s' cannot be undone, it is not allowed in a plan\n",
+			     words[0], words[1]);
+		error = -EINVAL;
+		goto out;
+	}
+
+	for (int i = 1; i < num_words; i++) {
+		argv[argc] = expand_word(words[i]);
+		if (!argv[argc]) {
+			error = -EINVAL;
+			goto out;
+		}
+		argc++;
+	}
+	argv[argc] = NULL;
+
+	restool.obj_name = NULL;
+	error = parse_obj_command(words[0], argv[0], argc, argv);
+out:
+	for (int i = 0; i < argc; i++)
+		free(argv[i]);
+	free(line);
+
+	return error;
+}
+
+/**
+ * Runs the restool commands listed in a plan file, one per line, over
+ * the current MC session. Every MC change they make is journalled, and
+ * if a step fails the journal is undone in reverse order so that the
+ * plan takes effect either completely or not at all.
+ */
+int dprc_apply(const char *plan_file)
+{
+	FILE *plan;
+	char *line = NULL;
+	size_t line_size = 0;
+	int line_num = 0;
+	int error = 0;
+
+	plan = fopen(plan_file, "r");
+	if (!plan) {
+		error = -errno;
+		ERROR_PRINTF("cannot open %s: %s\n", plan_file,
+			     strerror(errno));
+		return error;
+	}
+
+	txn_begin();
+	while (getline(&line, &line_size, plan) != -1) {
+		line_num++;
+		line[strcspn(line, "\n")] = '\0';
+
+		error = dprc_apply_step(line);
+		if (error < 0) {
+			ERROR_PRINTF("%s:%d: step failed: %s\n", plan_file,
+				     line_num, line);
+			break;
+		}
+	}
+
+	/* Leftovers from a failed step must not be blamed on apply */
+	restool.cmd_option_mask = 0;
+
+	if (error == 0 && ferror(plan)) {
+		error = -EIO;
+		ERROR_PRINTF("error reading %s\n", plan_file);
+	}
+
+	if (error < 0) {
+		int error2 = txn_rollback();
+
+		if (error2 < 0)
+			ERROR_PRINTF("rollback incomplete, manual cleanup needed\n");
+	} else {
+		txn_end();
+	}
+
+	free(line);
+	fclose(plan);
+	return error;
+}
@@ -0,0 +1,463 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdarg.h>
+#include "restool.h"
+#include "utils.h"
+#include "transaction.h"
+#include "dprc_commands_apply.h"
+#include "dprc_commands_generate_dpl.h"
+#include "dprc_commands_build.h"
+#include "obj_pool.h"
+
+/**
+ * Largest number of Rx/Tx queues per traffic class a DPNI is created
+ * with by restool
+ */
+#define BUILD_MAX_DPNI_QUEUES	8
+
+/**
+ * Largest number of cores, and so of objects of one type, in a build
+ */
+#define BUILD_MAX_CORES		64
+
+/**
+ * Maximum length of one generated plan step
+ */
+#define BUILD_STEP_SIZE		256
+
+/**
+ * struct res_need - resource ids the build takes from the parent
+ * @type: resource pool type
+ * @count: number of ids needed
+ */
+struct res_need {
+	const char *type;
+	long count;
+};
+
+static bool is_pool_type(const char *type, int num_pools,
+			 char pool_types[][RES_TYPE_MAX_LENGTH + 1])
+{
+	for (int i = 0; i < num_pools; i++) {
+		if (strcmp(pool_types[i], type) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * Checks that the parent container holds enough free resource ids for
+ * the whole build, so that nothing is created when it cannot complete.
+ * Needs for resource types the MC has no pool of are not checked.
+ */
+static int check_free_resources(uint32_t parent_dprc_id,
+				const struct res_need *needs, int num_needs)
+{
+	char (*pool_types)[RES_TYPE_MAX_LENGTH + 1] = NULL;
+	enum mc_cmd_status mc_status;
+	uint16_t dprc_handle = restool.root_dprc_handle;
+	bool dprc_opened = false;
+	int num_short = 0;
+	int num_pools;
+	int error;
+
+	error = dprc_get_pool_count(&restool.mc_io, 0,
+				    restool.root_dprc_handle, &num_pools);
+	if (error < 0)
+		goto mc_error;
+
+	if (num_pools == 0)
+		return 0;
+
+	pool_types = calloc(num_pools, sizeof(*pool_types));
+	if (!pool_types) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < num_pools; i++) {
+		error = dprc_get_pool(&restool.mc_io, 0,
+				      restool.root_dprc_handle, i,
+				      pool_types[i]);
+		if (error < 0)
+			goto mc_error;
+	}
+
+	if (parent_dprc_id != restool.root_dprc_id) {
+		error = open_dprc(parent_dprc_id, &dprc_handle);
+		if (error < 0)
+			goto out;
+
+		dprc_opened = true;
+	}
+
+	for (int i = 0; i < num_needs; i++) {
+		int res_count;
+
+		if (needs[i].count == 0 ||
+		    !is_pool_type(needs[i].type, num_pools, pool_types))
+			continue;
+
+		error = dprc_get_res_count(&restool.mc_io, 0, dprc_handle,
+					   (char *)needs[i].type, &res_count);
+		if (error < 0)
+			goto mc_error;
+
+		if (res_count < needs[i].count) {
+			ERROR_PRINTF("dprc.%u has %d free %s ids, %ld needed\n",
+				     parent_dprc_id, res_count, needs[i].type,
+				     needs[i].count);
+			num_short++;
+		}
+	}
+
+	error = num_short ? -ENOSPC : 0;
+	goto out;
+
+mc_error:
+	mc_status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("MC error: %s (status %#x)\n",
+		     mc_status_to_string(mc_status), mc_status);
+out:
+	if (dprc_opened) {
+		int error2;
+
+		error2 = close_dprc(dprc_handle);
+		if (error2 < 0 && error == 0)
+			error = error2;
+	}
+
+	free(pool_types);
+	return error;
+}
+
+static int run_build_step(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+static int run_build_step(const char *fmt, ...)
+{
+	char step[BUILD_STEP_SIZE];
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(step, sizeof(step), fmt, args);
+	va_end(args);
+	if (n < 0 || n >= (int)sizeof(step)) {
+		ERROR_PRINTF("plan step too long\n");
+		return -E2BIG;
+	}
+
+	DEBUG_PRINTF("build step: %s\n", step);
+	n = dprc_apply_step(step);
+	if (n < 0)
+		ERROR_PRINTF("step failed: %s\n", step);
+
+	return n;
+}
+
+/**
+ * Gives the new container count objects of one kind: as many as the
+ * pool holds are moved from it, and the rest are created in the parent
+ * container and moved plugged into the new one. The ids of the
+ * objects are returned in ids, and how many came from the pool in
+ * taken.
+ */
+static int build_objs(const char *parent, uint32_t dprc_id,
+		      struct obj_pool *pool, enum obj_pool_type type,
+		      const struct obj_pool_cfg *pool_cfg, long count,
+		      int *ids, long *taken)
+{
+	const char *type_name = obj_pool_type_name(type);
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	char options[BUILD_STEP_SIZE];
+	long num_taken = 0;
+	int first;
+	int error;
+
+	if (pool) {
+		obj_pool_class_label(type, pool_cfg, label);
+		num_taken = obj_pool_take(pool, label, count, dprc_id, ids);
+		if (num_taken < 0)
+			return num_taken;
+	}
+
+	*taken = num_taken;
+	if (num_taken == count)
+		return 0;
+
+	first = txn_num_created();
+	error = run_build_step(
+		"%s create --container=%s%s --count=%ld --assign-to=dprc.%u --plugged",
+		type_name, parent,
+		obj_pool_create_options(type, pool_cfg, options,
+					sizeof(options)),
+		count - num_taken, dprc_id);
+	if (error < 0)
+		return error;
+
+	for (long i = num_taken; i < count; i++) {
+		uint32_t obj_id;
+
+		error = parse_object_name(txn_created_obj(first + i - num_taken),
+					  (char *)type_name, &obj_id);
+		if (error < 0)
+			return error;
+
+		ids[i] = obj_id;
+	}
+
+	return 0;
+}
+
+/**
+ * Creates the new container, which is always the first object created
+ * ($1), and gives it its objects, from the pool when there is one.
+ */
+static int run_build_steps(const char *parent, const struct build_cfg *cfg,
+			   struct obj_pool *pool,
+			   const struct obj_pool_cfg *pool_cfg,
+			   long taken[OBJ_POOL_NUM_TYPES])
+{
+	const long counts[OBJ_POOL_NUM_TYPES] = {
+		[OBJ_POOL_DPIO] = cfg->cores,
+		[OBJ_POOL_DPCON] = cfg->cores,
+		[OBJ_POOL_DPBP] = cfg->ifaces,
+		[OBJ_POOL_DPNI] = cfg->ifaces,
+	};
+	int ids[OBJ_POOL_NUM_TYPES][BUILD_MAX_CORES];
+	char macs[BUILD_STEP_SIZE];
+	char *mac, *saveptr = NULL;
+	uint32_t dprc_id;
+	int error;
+
+	if (cfg->label)
+		error = run_build_step("dprc create %s --label=%s", parent,
+				       cfg->label);
+	else
+		error = run_build_step("dprc create %s", parent);
+	if (error < 0)
+		return error;
+
+	error = parse_object_name(txn_created_obj(0), "dprc", &dprc_id);
+	if (error < 0)
+		return error;
+
+	error = run_build_step(
+		"dpmcp create --container=%s --assign-to=$1 --plugged",
+		parent);
+	if (error < 0)
+		return error;
+
+	for (int type = 0; type < OBJ_POOL_NUM_TYPES; type++) {
+		if (counts[type] == 0)
+			continue;
+
+		error = build_objs(parent, dprc_id, pool, type, pool_cfg,
+				   counts[type], ids[type], &taken[type]);
+		if (error < 0)
+			return error;
+	}
+
+	if (!cfg->macs)
+		return 0;
+
+	snprintf(macs, sizeof(macs), "%s", cfg->macs);
+	mac = strtok_r(macs, ",", &saveptr);
+	for (long i = 0; mac; i++) {
+		error = run_build_step(
+			"dprc connect %s --endpoint1=dpni.%d --endpoint2=%s",
+			parent, ids[OBJ_POOL_DPNI][i], mac);
+		if (error < 0)
+			return error;
+
+		mac = strtok_r(NULL, ",", &saveptr);
+	}
+
+	return 0;
+}
+
+static int write_build_dpl(const char *dprc_name, const char *dpl_file)
+{
+	uint32_t dprc_id;
+	FILE *fp = stdout;
+	int error;
+
+	error = parse_object_name(dprc_name, "dprc", &dprc_id);
+	if (error < 0)
+		return error;
+
+	if (dpl_file) {
+		fp = fopen(dpl_file, "w");
+		if (!fp) {
+			error = -errno;
+			ERROR_PRINTF("cannot open %s: %s\n", dpl_file,
+				     strerror(errno));
+			return error;
+		}
+	}
+
+	error = dpl_write(dprc_id, fp, DPL_FORMAT_DTS);
+	if (fp != stdout && fclose(fp) != 0 && error == 0) {
+		error = -errno;
+		ERROR_PRINTF("error writing %s\n", dpl_file);
+	}
+
+	return error;
+}
+
+static long count_macs(const char *macs)
+{
+	long count = 1;
+
+	for (const char *p = strchr(macs, ','); p; p = strchr(p + 1, ','))
+		count++;
+
+	return count;
+}
+
+/**
+ * dprc_build() - create a container sized for a dataplane
+ * @parent_dprc_id: container the new one is created under, and whose
+ *	free resources it is built from
+ * @cfg: build settings
+ *
+ * The container gets one DPMCP, one DPIO and one DPCON per core, and
+ * one DPBP and one DPNI per interface, each DPNI with a queue per core
+ * (up to the DPNI maximum) in each of its traffic classes. The
+ * parent's free resources are checked first; the objects are then
+ * created, assigned and connected in one session, and all of it is
+ * undone if any step fails. The DPL of the result is written last.
+ *
+ * When the parent has an object pool, matching objects are moved from
+ * it instead of being created, and the pool is refilled in the
+ * background afterwards.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int dprc_build(uint32_t parent_dprc_id, const struct build_cfg *cfg)
+{
+	char parent[OBJ_TYPE_MAX_LENGTH + 12];
+	char dprc_name[OBJ_TYPE_MAX_LENGTH + 12];
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	struct res_need needs[] = {
+		{ .type = "mcp", .count = 1 },
+		{ .type = "swp", .count = cfg->cores },
+		{ .type = "bp", .count = cfg->ifaces },
+	};
+	struct obj_pool_cfg pool_cfg = {
+		.priorities = cfg->priorities,
+		.tcs = cfg->priorities,
+		.add = true,
+	};
+	long taken[OBJ_POOL_NUM_TYPES] = { 0 };
+	struct obj_pool pool;
+	bool have_pool = false;
+	int error;
+
+	if (cfg->macs && count_macs(cfg->macs) != cfg->ifaces) {
+		ERROR_PRINTF("--macs must list one DPMAC per interface\n");
+		return -EINVAL;
+	}
+
+	pool_cfg.queues = cfg->cores < BUILD_MAX_DPNI_QUEUES ?
+			  cfg->cores : BUILD_MAX_DPNI_QUEUES;
+
+	error = obj_pool_open(parent_dprc_id, &pool);
+	if (error == 0)
+		have_pool = true;
+	else if (error != -ENOENT)
+		return error;
+
+	/* Pooled objects already hold their resource ids */
+	if (have_pool) {
+		long pooled;
+
+		obj_pool_class_label(OBJ_POOL_DPIO, &pool_cfg, label);
+		pooled = obj_pool_count(&pool, label);
+		needs[1].count -= pooled < cfg->cores ? pooled : cfg->cores;
+		obj_pool_class_label(OBJ_POOL_DPBP, &pool_cfg, label);
+		pooled = obj_pool_count(&pool, label);
+		needs[2].count -= pooled < cfg->ifaces ? pooled : cfg->ifaces;
+	}
+
+	error = check_free_resources(parent_dprc_id, needs,
+				     ARRAY_SIZE(needs));
+	if (error < 0) {
+		if (error == -ENOSPC)
+			ERROR_PRINTF("not enough free resources, nothing was created\n");
+		goto out;
+	}
+
+	snprintf(parent, sizeof(parent), "dprc.%u", parent_dprc_id);
+	if (!restool.script)
+		printf("Building under %s: 1 dpmcp, %ld dpio, %ld dpcon, %ld dpbp, %ld dpni (%ld queues, %ld TCs)\n",
+		       parent, cfg->cores, cfg->cores, cfg->ifaces,
+		       cfg->ifaces, pool_cfg.queues, cfg->priorities);
+
+	txn_begin();
+	error = run_build_steps(parent, cfg, have_pool ? &pool : NULL,
+				&pool_cfg, taken);
+
+	/* Leftovers from a failed step must not be blamed on build */
+	restool.cmd_option_mask = 0;
+
+	if (error < 0) {
+		int error2 = txn_rollback();
+
+		if (error2 < 0)
+			ERROR_PRINTF("rollback incomplete, manual cleanup needed\n");
+		goto out;
+	}
+
+	snprintf(dprc_name, sizeof(dprc_name), "%s", txn_created_obj(0));
+	txn_end();
+
+	if (have_pool) {
+		memcpy(pool_cfg.count, taken, sizeof(pool_cfg.count));
+		if (obj_pool_refill_async(parent_dprc_id, &pool_cfg) < 0)
+			ERROR_PRINTF("the pool of %s is not refilled\n", parent);
+	}
+
+	error = write_build_dpl(dprc_name, cfg->dpl_file);
+out:
+	if (have_pool)
+		obj_pool_close(&pool);
+
+	return error;
+}
@@ -0,0 +1,61 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DPRC_COMMANDS_BUILD_H_
+#define _DPRC_COMMANDS_BUILD_H_
+
+#include <stdint.h>
+
+/**
+ * struct build_cfg - dprc build settings
+ * @cores: number of cores the container is sized for
+ * @ifaces: number of network interfaces
+ * @priorities: number of scheduling priorities of the DPIOs and
+ *	DPCONs, and of traffic classes of the DPNIs
+ * @label: label of the new container, or NULL
+ * @macs: comma separated DPMACs the DPNIs are connected to, in order,
+ *	or NULL to leave them unconnected
+ * @dpl_file: file the DPL of the result is written to, or NULL for
+ *	standard output
+ */
+struct build_cfg {
+	long cores;
+	long ifaces;
+	long priorities;
+	const char *label;
+	const char *macs;
+	const char *dpl_file;
+};
+
+int dprc_build(uint32_t parent_dprc_id, const struct build_cfg *cfg);
+
+#endif /* _DPRC_COMMANDS_BUILD_H_ */
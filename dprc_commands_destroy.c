@@ -0,0 +1,642 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "handle_cache.h"
+#include "mc_v10/fsl_dpdmux.h"
+#include "mc_v10/fsl_dpsw.h"
+#include "dprc_commands_destroy.h"
+
+#define FSL_MC_DRIVERS_DIR	"/sys/bus/fsl-mc/drivers"
+
+/**
+ * struct bound_obj - object a kernel driver is bound to
+ * @name: object name, e.g. "dpni.3"
+ * @driver: name of the driver
+ */
+struct bound_obj {
+	char name[OBJ_TYPE_MAX_LENGTH + 12];
+	char driver[NAME_MAX + 1];
+};
+
+static struct bound_obj *bound_objs;
+static int num_bound_objs;
+static int max_bound_objs;
+
+/**
+ * struct destroy_job - one container to be emptied
+ * @node: container, as found by dprc_walk()
+ * @parent: index of the job of the parent container, -1 for the
+ *	container being destroyed
+ * @pending_children: child containers not destroyed yet; the job
+ *	becomes ready when this drops to 0
+ */
+struct destroy_job {
+	struct dprc_walk_node *node;
+	int parent;
+	int pending_children;
+};
+
+/**
+ * struct destroy_queue - state shared by the teardown workers
+ * @lock: protects all fields below, and the progress output
+ * @cond: signalled when a job becomes ready or the teardown ends
+ * @jobs: one job per container in the subtree
+ * @num_jobs: number of entries in @jobs
+ * @ready: indexes of the jobs whose child containers are all gone
+ * @num_ready: number of entries in @ready
+ * @remaining: number of jobs not completed yet
+ * @error: first error reported by a worker, stops the teardown
+ * @done: number of objects destroyed so far
+ * @total: number of objects to destroy, containers included
+ */
+struct destroy_queue {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct destroy_job *jobs;
+	int num_jobs;
+	int *ready;
+	int num_ready;
+	int remaining;
+	int error;
+	int done;
+	int total;
+};
+
+static flib_obj_destroy_t *find_destroy_op(enum obj_type type)
+{
+	const struct flib_ops *ops = obj_type_ops(type);
+
+	return ops ? ops->obj_destroy : NULL;
+}
+
+static int cmp_bound_obj(const void *a, const void *b)
+{
+	const struct bound_obj *obj_a = a;
+	const struct bound_obj *obj_b = b;
+
+	return strcmp(obj_a->name, obj_b->name);
+}
+
+static int add_bound_obj(const char *name, const char *driver)
+{
+	struct bound_obj *obj;
+
+	if (num_bound_objs == max_bound_objs) {
+		int max = max_bound_objs ? 2 * max_bound_objs : 32;
+
+		obj = realloc(bound_objs, max * sizeof(*obj));
+		if (!obj) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		bound_objs = obj;
+		max_bound_objs = max;
+	}
+
+	/* too long for "<type>.<id>", so not an object */
+	obj = &bound_objs[num_bound_objs];
+	if (snprintf(obj->name, sizeof(obj->name), "%s", name) >=
+	    (int)sizeof(obj->name))
+		return 0;
+
+	snprintf(obj->driver, sizeof(obj->driver), "%s", driver);
+	num_bound_objs++;
+	return 0;
+}
+
+/**
+ * Lists the objects bound to each fsl-mc driver in a single pass over
+ * sysfs, instead of resolving the driver link of every object.
+ */
+static int read_bound_objs(void)
+{
+	char path[PATH_MAX];
+	struct dirent *drv;
+	DIR *drivers;
+	int error = 0;
+
+	drivers = opendir(FSL_MC_DRIVERS_DIR);
+	if (!drivers) {
+		DEBUG_PRINTF("cannot open %s: %s\n", FSL_MC_DRIVERS_DIR,
+			     strerror(errno));
+		return 0;
+	}
+
+	while (error == 0 && (drv = readdir(drivers)) != NULL) {
+		struct dirent *ent;
+		DIR *dir;
+
+		if (drv->d_name[0] == '.')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", FSL_MC_DRIVERS_DIR,
+			 drv->d_name);
+		dir = opendir(path);
+		if (!dir)
+			continue;
+
+		while (error == 0 && (ent = readdir(dir)) != NULL) {
+			if (strncmp(ent->d_name, "dp", 2) != 0 ||
+			    !strchr(ent->d_name, '.'))
+				continue;
+
+			error = add_bound_obj(ent->d_name, drv->d_name);
+		}
+
+		closedir(dir);
+	}
+
+	closedir(drivers);
+	if (error == 0)
+		qsort(bound_objs, num_bound_objs, sizeof(*bound_objs),
+		      cmp_bound_obj);
+
+	return error;
+}
+
+static bool check_unbound(const char *type, uint32_t id)
+{
+	struct bound_obj key;
+	struct bound_obj *obj;
+
+	snprintf(key.name, sizeof(key.name), "%s.%u", type, id);
+	obj = bsearch(&key, bound_objs, num_bound_objs, sizeof(*bound_objs),
+		      cmp_bound_obj);
+	if (!obj)
+		return true;
+
+	ERROR_PRINTF("%s is bound to driver %s\n", obj->name, obj->driver);
+	return false;
+}
+
+/**
+ * Checks that nothing in the subtree is in use or of a type that
+ * cannot be destroyed, before anything is torn down. Reports every
+ * offending object, not just the first one.
+ */
+static int check_subtree(struct dprc_walk_node *node, int *num_errors)
+{
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+
+		if (!check_unbound(desc->type, desc->id))
+			(*num_errors)++;
+
+		if (node->obj_types[i] != OBJ_TYPE_DPRC &&
+		    !find_destroy_op(node->obj_types[i])) {
+			ERROR_PRINTF("%s.%u cannot be destroyed\n",
+				     desc->type, desc->id);
+			(*num_errors)++;
+		}
+	}
+
+	for (int i = 0; i < node->num_children; i++)
+		check_subtree(node->children[i], num_errors);
+
+	return *num_errors ? -EBUSY : 0;
+}
+
+static void report_destroyed(struct destroy_queue *queue, const char *type,
+			     uint32_t id)
+{
+	pthread_mutex_lock(&queue->lock);
+	queue->done++;
+	printf("[%d/%d] %s.%u is destroyed\n", queue->done, queue->total,
+	       type, id);
+	fflush(stdout);
+	pthread_mutex_unlock(&queue->lock);
+}
+
+static void endpoint_name(const struct dprc_endpoint *ep, bool multi_if,
+			  char *buf, size_t len)
+{
+	if (multi_if)
+		snprintf(buf, len, "%s.%d.%u", ep->type, ep->id, ep->if_id);
+	else
+		snprintf(buf, len, "%s.%d", ep->type, ep->id);
+}
+
+static int get_num_ifs(struct fsl_mc_io *mc_io, struct dprc_obj_desc *desc,
+		       uint16_t *num_ifs)
+{
+	enum mc_cmd_status mc_status;
+	uint16_t handle;
+	int error, error2;
+
+	if (strcmp(desc->type, "dpsw") == 0) {
+		struct dpsw_attr_v10 dpsw_attr;
+
+		error = dpsw_open_v10(mc_io, 0, desc->id, &handle);
+		if (error < 0)
+			goto out;
+
+		memset(&dpsw_attr, 0, sizeof(dpsw_attr));
+		error = dpsw_get_attributes_v10(mc_io, 0, handle, &dpsw_attr);
+		*num_ifs = dpsw_attr.num_ifs;
+		error2 = dpsw_close_v10(mc_io, 0, handle);
+	} else if (strcmp(desc->type, "dpdmux") == 0) {
+		struct dpdmux_attr_v10 dpdmux_attr;
+
+		error = dpdmux_open_v10(mc_io, 0, desc->id, &handle);
+		if (error < 0)
+			goto out;
+
+		memset(&dpdmux_attr, 0, sizeof(dpdmux_attr));
+		error = dpdmux_get_attributes_v10(mc_io, 0, handle,
+						  &dpdmux_attr);
+		/* Interface 0 is the uplink */
+		*num_ifs = dpdmux_attr.num_ifs + 1;
+		error2 = dpdmux_close_v10(mc_io, 0, handle);
+	} else {
+		*num_ifs = 1;
+		return 0;
+	}
+
+	if (error == 0)
+		error = error2;
+out:
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	return error;
+}
+
+/**
+ * Breaks every connection of an object's interfaces. The peer may be
+ * torn down concurrently by another worker, so a connection that goes
+ * away on its own is not an error.
+ */
+static int disconnect_obj(struct dprc_worker *worker,
+			  struct dprc_obj_desc *desc)
+{
+	struct destroy_queue *queue = worker->ctx;
+	struct dprc_endpoint endpoint1, endpoint2;
+	enum mc_cmd_status mc_status;
+	uint16_t num_ifs;
+	bool multi_if;
+	int state;
+	int error;
+
+	if (strcmp(desc->type, "dpni") != 0 &&
+	    strcmp(desc->type, "dpmac") != 0 &&
+	    strcmp(desc->type, "dpci") != 0 &&
+	    strcmp(desc->type, "dpsw") != 0 &&
+	    strcmp(desc->type, "dpdmux") != 0)
+		return 0;
+
+	error = get_num_ifs(worker->mc_io, desc, &num_ifs);
+	if (error < 0)
+		return error;
+
+	multi_if = strcmp(desc->type, "dpsw") == 0 ||
+		   strcmp(desc->type, "dpdmux") == 0;
+	memset(&endpoint1, 0, sizeof(endpoint1));
+	snprintf(endpoint1.type, sizeof(endpoint1.type), "%s", desc->type);
+	endpoint1.id = desc->id;
+	for (uint16_t k = 0; k < num_ifs; k++) {
+		char name1[OBJ_TYPE_MAX_LENGTH + 24];
+		char name2[OBJ_TYPE_MAX_LENGTH + 24];
+
+		endpoint1.if_id = k;
+		memset(&endpoint2, 0, sizeof(endpoint2));
+		error = dprc_get_connection(worker->mc_io, 0,
+					    worker->root_handle,
+					    &endpoint1, &endpoint2, &state);
+		if (error == -ENAVAIL || (error == 0 && state == -1))
+			continue;
+		if (error < 0)
+			goto mc_error;
+
+		error = dprc_disconnect(worker->mc_io, 0, worker->root_handle,
+					&endpoint1);
+		if (error < 0) {
+			int error2;
+
+			error2 = dprc_get_connection(worker->mc_io, 0,
+						     worker->root_handle,
+						     &endpoint1, &endpoint2,
+						     &state);
+			if (error2 == -ENAVAIL || (error2 == 0 && state == -1))
+				continue;
+
+			goto mc_error;
+		}
+
+		endpoint2.type[sizeof(endpoint2.type) - 1] = '\0';
+		endpoint_name(&endpoint1, multi_if, name1, sizeof(name1));
+		endpoint_name(&endpoint2,
+			      strcmp(endpoint2.type, "dpsw") == 0 ||
+			      strcmp(endpoint2.type, "dpdmux") == 0,
+			      name2, sizeof(name2));
+		pthread_mutex_lock(&queue->lock);
+		printf("%s is disconnected from %s\n", name1, name2);
+		fflush(stdout);
+		pthread_mutex_unlock(&queue->lock);
+	}
+
+	return 0;
+
+mc_error:
+	mc_status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("MC error: %s (status %#x)\n",
+		     mc_status_to_string(mc_status), mc_status);
+	return error;
+}
+
+/**
+ * Disconnects and destroys all objects in a container whose child
+ * containers are already empty, then destroys those child containers.
+ */
+static int empty_container(struct dprc_worker *worker,
+			   struct dprc_walk_node *node)
+{
+	struct fsl_mc_io *mc_io = worker->mc_io;
+	enum mc_cmd_status mc_status;
+	uint16_t dprc_handle;
+	int error, error2;
+
+	error = dprc_open(mc_io, 0, node->id, &dprc_handle);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		return error;
+	}
+
+	if (dprc_handle == 0) {
+		DEBUG_PRINTF(
+			"dprc_open() returned invalid handle (auth 0) for dprc.%u\n",
+			node->id);
+		error = -ENOENT;
+		goto out;
+	}
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->obj_types[i] == OBJ_TYPE_DPRC)
+			continue;
+
+		error = disconnect_obj(worker, &node->objs[i]);
+		if (error < 0)
+			goto out;
+	}
+
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+		flib_obj_destroy_t *destroy;
+
+		if (node->obj_types[i] == OBJ_TYPE_DPRC)
+			continue;
+
+		destroy = find_destroy_op(node->obj_types[i]);
+		assert(destroy);
+		error = destroy(mc_io, dprc_handle, 0, desc->id);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("%s.%u: MC error: %s (status %#x)\n",
+				     desc->type, desc->id,
+				     mc_status_to_string(mc_status), mc_status);
+			goto out;
+		}
+
+		report_destroyed(worker->ctx, desc->type, desc->id);
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		uint32_t child_id = node->children[i]->id;
+
+		error = dprc_destroy_container(mc_io, 0, dprc_handle,
+					       child_id);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("dprc.%u: MC error: %s (status %#x)\n",
+				     child_id, mc_status_to_string(mc_status),
+				     mc_status);
+			goto out;
+		}
+
+		report_destroyed(worker->ctx, "dprc", child_id);
+	}
+
+	error = 0;
+out:
+	error2 = dprc_close(mc_io, 0, dprc_handle);
+	if (error2 < 0) {
+		mc_status = flib_error_to_mc_status(error2);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+/**
+ * Runs ready jobs until all containers are emptied or an error occurs.
+ * A container becomes ready once all its child containers are gone, so
+ * independent subtrees are torn down concurrently, one worker per
+ * portal.
+ */
+static void *destroy_worker_run(void *arg)
+{
+	struct dprc_worker *worker = arg;
+	struct destroy_queue *queue = worker->ctx;
+
+	pthread_mutex_lock(&queue->lock);
+	for ( ; ; ) {
+		struct destroy_job *job;
+		int error;
+
+		while (queue->num_ready == 0 && queue->remaining != 0 &&
+		       queue->error == 0)
+			pthread_cond_wait(&queue->cond, &queue->lock);
+
+		if (queue->num_ready == 0 || queue->error != 0)
+			break;
+
+		job = &queue->jobs[queue->ready[--queue->num_ready]];
+		pthread_mutex_unlock(&queue->lock);
+
+		error = empty_container(worker, job->node);
+
+		pthread_mutex_lock(&queue->lock);
+		queue->remaining--;
+		if (error != 0) {
+			if (queue->error == 0)
+				queue->error = error;
+		} else if (job->parent >= 0 &&
+			   --queue->jobs[job->parent].pending_children == 0) {
+			queue->ready[queue->num_ready++] = job->parent;
+		}
+
+		pthread_cond_broadcast(&queue->cond);
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return NULL;
+}
+
+static void add_jobs(struct destroy_queue *queue, struct dprc_walk_node *node,
+		     int parent)
+{
+	int index = queue->num_jobs++;
+	struct destroy_job *job = &queue->jobs[index];
+
+	job->node = node;
+	job->parent = parent;
+	job->pending_children = node->num_children;
+	if (node->num_children == 0)
+		queue->ready[queue->num_ready++] = index;
+
+	/* Child containers are destroyed along with the other objects */
+	queue->total += node->num_objs;
+	for (int i = 0; i < node->num_children; i++)
+		add_jobs(queue, node->children[i], index);
+}
+
+static int count_containers(struct dprc_walk_node *node)
+{
+	int count = 1;
+
+	for (int i = 0; i < node->num_children; i++)
+		count += count_containers(node->children[i]);
+
+	return count;
+}
+
+/**
+ * dprc_destroy_recursive() - destroy a container and everything in it
+ * @dprc_id: container to destroy
+ * @parent_dprc_handle: handle of its parent container on the restool
+ *	portal
+ *
+ * Nothing is destroyed unless every object in the subtree is unbound
+ * from its driver. Each container is emptied by disconnecting and then
+ * destroying its objects, deepest containers first; with --portals=N,
+ * up to N containers are emptied at the same time.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int dprc_destroy_recursive(uint32_t dprc_id, uint16_t parent_dprc_handle)
+{
+	struct dprc_worker workers[MAX_WALK_PORTALS];
+	struct dprc_walk_node *root = NULL;
+	struct destroy_queue queue;
+	enum mc_cmd_status mc_status;
+	int num_containers;
+	int num_workers;
+	int num_errors = 0;
+	int error;
+
+	memset(&queue, 0, sizeof(queue));
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+
+	error = dprc_walk(dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = read_bound_objs();
+	if (error < 0)
+		goto out;
+
+	if (!check_unbound("dprc", dprc_id))
+		num_errors++;
+
+	error = check_subtree(root, &num_errors);
+	if (error < 0) {
+		ERROR_PRINTF("dprc.%u cannot be destroyed, nothing was changed\n",
+			     dprc_id);
+		goto out;
+	}
+
+	num_containers = count_containers(root);
+	queue.jobs = calloc(num_containers, sizeof(*queue.jobs));
+	queue.ready = calloc(num_containers, sizeof(*queue.ready));
+	if (!queue.jobs || !queue.ready) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	add_jobs(&queue, root, -1);
+	queue.remaining = queue.num_jobs;
+	queue.total++;
+
+	/* Cached handles of objects about to disappear become stale */
+	(void)handle_cache_trim();
+
+	num_workers = dprc_workers_open(workers, num_containers, &queue);
+	dprc_workers_run(workers, num_workers, destroy_worker_run);
+	dprc_workers_close(workers, num_workers);
+
+	error = queue.error;
+	if (error < 0)
+		goto out;
+
+	error = dprc_destroy_container(&restool.mc_io, 0, parent_dprc_handle,
+				       dprc_id);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		goto out;
+	}
+
+	report_destroyed(&queue, "dprc", dprc_id);
+out:
+	free(queue.ready);
+	free(queue.jobs);
+	pthread_cond_destroy(&queue.cond);
+	pthread_mutex_destroy(&queue.lock);
+	free(bound_objs);
+	bound_objs = NULL;
+	num_bound_objs = 0;
+	max_bound_objs = 0;
+	dprc_walk_free(root);
+	return error;
+}
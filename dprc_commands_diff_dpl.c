@@ -0,0 +1,1122 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include "restool.h"
+#include "utils.h"
+#include "dts.h"
+#include "transaction.h"
+#include "dprc_commands_apply.h"
+#include "dprc_commands_generate_dpl.h"
+#include "dprc_commands_diff_dpl.h"
+#include "mc_v10/fsl_dprc.h"
+
+/**
+ * Maximum length of one plan step
+ */
+#define DIFF_STEP_SIZE	512
+
+static const struct {
+	const char *name;
+	uint64_t flag;
+} dprc_opt_names[] = {
+	{ "DPRC_CFG_OPT_SPAWN_ALLOWED", DPRC_CFG_OPT_SPAWN_ALLOWED },
+	{ "DPRC_CFG_OPT_ALLOC_ALLOWED", DPRC_CFG_OPT_ALLOC_ALLOWED },
+	{ "DPRC_CFG_OPT_OBJ_CREATE_ALLOWED", DPRC_CFG_OPT_OBJ_CREATE_ALLOWED },
+	{ "DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED",
+	  DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED },
+	{ "DPRC_CFG_OPT_AIOP", DPRC_CFG_OPT_AIOP },
+	{ "DPRC_CFG_OPT_IRQ_CFG_ALLOWED", DPRC_CFG_OPT_IRQ_CFG_ALLOWED },
+};
+
+enum create_arg_value {
+	ARG_VALUES = 0,	/* the property values, comma separated */
+	ARG_COUNT,	/* how many values the property has */
+	ARG_OBJ_ID,	/* the id of the object */
+};
+
+/**
+ * struct create_arg - create command option taken from a DPL property
+ * @type: object type
+ * @prop: property of the object node in the objects section
+ * @option: create command option the property is passed as
+ * @value: what is passed
+ * @adjust: added to a single cell value
+ */
+struct create_arg {
+	const char *type;
+	const char *prop;
+	const char *option;
+	enum create_arg_value value;
+	int adjust;
+};
+
+static const struct create_arg create_args[] = {
+	{ "dpmac", NULL, "mac-id", ARG_OBJ_ID, 0 },
+	{ "dpio", "num_priorities", "num-priorities", ARG_VALUES, 0 },
+	{ "dpcon", "num_priorities", "num-priorities", ARG_VALUES, 0 },
+	{ "dpci", "num_of_priorities", "num-priorities", ARG_VALUES, 0 },
+	{ "dpni", "num_queues", "num-queues", ARG_VALUES, 0 },
+	{ "dpni", "num_tcs", "num-tcs", ARG_VALUES, 0 },
+	{ "dpni", "options", "options", ARG_VALUES, 0 },
+	{ "dpseci", "priorities", "num-queues", ARG_COUNT, 0 },
+	{ "dpseci", "priorities", "priorities", ARG_VALUES, 0 },
+	{ "dpdcei", "engine", "engine", ARG_VALUES, 0 },
+	{ "dpsw", "num_ifs", "num-ifs", ARG_VALUES, 0 },
+	{ "dpsw", "options", "options", ARG_VALUES, 0 },
+	/* The DPL counts the uplink, the create command does not */
+	{ "dpdmux", "num_ifs", "num-ifs", ARG_VALUES, -1 },
+	{ "dpdmux", "method", "method", ARG_VALUES, 0 },
+	{ "dpdmux", "manip", "manip", ARG_VALUES, 0 },
+	{ "dpdmux", "options", "options", ARG_VALUES, 0 },
+};
+
+/**
+ * struct plan_cont - container of the target layout
+ * @target: the container in the target layout
+ * @parent: plan entry of the parent, NULL for the top container
+ * @live_id: id of the matching live container, 0 for a new one
+ * @created: n of the $n naming the container once the plan created it,
+ *	0 for an existing container
+ */
+struct plan_cont {
+	struct container_list *target;
+	struct plan_cont *parent;
+	uint32_t live_id;
+	int created;
+};
+
+/**
+ * struct plan_obj - object of the target layout
+ * @target: the object in the target layout
+ * @cont: container the object belongs to
+ * @live: the matching live object, NULL for a new one
+ * @live_cont_id: container holding @live
+ * @created: n of the $n naming the object once the plan created it,
+ *	0 for an existing object
+ */
+struct plan_obj {
+	const struct obj_list *target;
+	struct plan_cont *cont;
+	const struct obj_list *live;
+	uint32_t live_cont_id;
+	int created;
+};
+
+/**
+ * struct plan - steps turning the live layout into the target one
+ * @steps: restool command lines, in "dprc apply" syntax
+ * @num_steps: number of entries in @steps
+ * @max_steps: allocated size of @steps
+ * @num_created: number of objects and containers created so far
+ * @num_undoable: number of leading steps a rollback can undo, the
+ *	destroys come after them
+ */
+struct plan {
+	char **steps;
+	int num_steps;
+	int max_steps;
+	int num_created;
+	int num_undoable;
+};
+
+/**
+ * struct diff_ctx - both layouts and what matches between them
+ */
+struct diff_ctx {
+	const struct dts_node *dpl;
+	struct dpl_layout live;
+	struct dpl_layout target;
+	struct plan_cont *conts;
+	int num_conts;
+	struct plan_obj *objs;
+	int num_objs;
+	struct plan plan;
+};
+
+static int add_step(struct plan *plan, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static int add_step(struct plan *plan, const char *fmt, ...)
+{
+	char step[DIFF_STEP_SIZE];
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(step, sizeof(step), fmt, args);
+	va_end(args);
+	if (n < 0 || n >= (int)sizeof(step)) {
+		ERROR_PRINTF("plan step too long\n");
+		return -E2BIG;
+	}
+
+	if (plan->num_steps == plan->max_steps) {
+		int max_steps = plan->max_steps ? 2 * plan->max_steps : 32;
+		char **steps;
+
+		steps = realloc(plan->steps, max_steps * sizeof(*steps));
+		if (!steps) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+		plan->steps = steps;
+		plan->max_steps = max_steps;
+	}
+
+	plan->steps[plan->num_steps] = strdup(step);
+	if (!plan->steps[plan->num_steps]) {
+		ERROR_PRINTF("strdup failed\n");
+		return -ENOMEM;
+	}
+	plan->num_steps++;
+
+	return 0;
+}
+
+static void free_plan(struct plan *plan)
+{
+	for (int i = 0; i < plan->num_steps; i++)
+		free(plan->steps[i]);
+	free(plan->steps);
+	memset(plan, 0, sizeof(*plan));
+}
+
+/**
+ * Splits a DPL object name of the form "<type>@<id>[/if@<if_id>]",
+ * if_id is -1 without an interface
+ */
+static int parse_dpl_name(const char *name, char *type, int *id, int *if_id)
+{
+	char tail;
+	int n;
+
+	*if_id = -1;
+	n = sscanf(name, "%15[a-z]@%d/if@%d%c", type, id, if_id, &tail);
+	if (n == 2 || n == 3)
+		return 0;
+
+	return -EINVAL;
+}
+
+static struct obj_list *find_list_obj(struct obj_list *head, const char *type,
+				      int id)
+{
+	for (; head; head = head->next) {
+		if (head->id == id && strcmp(head->type, type) == 0)
+			return head;
+	}
+
+	return NULL;
+}
+
+static int add_target_obj(struct diff_ctx *ctx, struct container_list *cont,
+			  const char *type, int id, const char *label,
+			  bool plugged)
+{
+	struct obj_list *objs[2];
+	int error;
+
+	if (label && strlen(label) > MC_OBJ_LABEL_MAX_LENGTH) {
+		ERROR_PRINTF("%s@%d: label longer than %d characters\n",
+			     type, id, MC_OBJ_LABEL_MAX_LENGTH);
+		return -EINVAL;
+	}
+
+	/* One copy for the container, one for the list of all objects */
+	for (int i = 0; i < 2; i++) {
+		objs[i] = calloc(1, sizeof(*objs[i]));
+		if (!objs[i]) {
+			ERROR_PRINTF("calloc failed\n");
+			return -ENOMEM;
+		}
+		snprintf(objs[i]->type, sizeof(objs[i]->type), "%s", type);
+		objs[i]->type_id = obj_type_lookup(type);
+		objs[i]->id = id;
+		if (label)
+			strcpy(objs[i]->label, label);
+		objs[i]->plugged = plugged;
+	}
+
+	error = compare_insert_obj(&ctx->target.objs, objs[0]);
+	if (error) {
+		free(objs[0]);
+		free(objs[1]);
+		return error;
+	}
+
+	return compare_insert_obj(&cont->obj, objs[1]);
+}
+
+/**
+ * Adds the objects listed in the "objects" node of a container, either
+ * as obj_set@<type> nodes (DPL version 10) or obj@<n> nodes (version 9)
+ */
+static int read_container_objs(struct diff_ctx *ctx,
+			       struct container_list *cont,
+			       const struct dts_node *node)
+{
+	const struct dts_node *objects = dts_child(node, "objects");
+	int error;
+
+	if (!objects)
+		return 0;
+
+	for (const struct dts_node *n = objects->children; n; n = n->next) {
+		const char *type = dts_string(n, "type");
+		const char *obj_name = dts_string(n, "obj_name");
+		const struct dts_prop *ids = dts_prop(n, "ids");
+		const struct dts_prop *plugged = dts_prop(n, "plugged");
+		bool plug = plugged && plugged->num_cells > 0 &&
+			    plugged->cells[0] != 0;
+		char obj_type[OBJ_TYPE_MAX_LENGTH + 1];
+		int id, if_id;
+
+		if (type && ids) {
+			for (int i = 0; i < ids->num_cells; i++) {
+				error = add_target_obj(ctx, cont, type,
+						       (int)ids->cells[i],
+						       NULL, plug);
+				if (error)
+					return error;
+			}
+		} else if (obj_name &&
+			   parse_dpl_name(obj_name, obj_type, &id,
+					  &if_id) == 0) {
+			error = add_target_obj(ctx, cont, obj_type, id,
+					       dts_string(n, "label"), plug);
+			if (error)
+				return error;
+		} else {
+			ERROR_PRINTF("dprc@%d: cannot read objects node %s\n",
+				     cont->id, n->name);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int read_container(struct diff_ctx *ctx, const struct dts_node *node,
+			  struct container_list ***tail)
+{
+	const struct dts_prop *options = dts_prop(node, "options");
+	const char *parent = dts_string(node, "parent");
+	struct container_list *cont;
+
+	cont = calloc(1, sizeof(*cont));
+	if (!cont) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+	**tail = cont;
+	*tail = &cont->next;
+	ctx->target.num_containers++;
+
+	if (sscanf(node->name, "dprc@%d", &cont->id) != 1) {
+		ERROR_PRINTF("invalid container node %s\n", node->name);
+		return -EINVAL;
+	}
+
+	if (!parent || strcmp(parent, "none") == 0)
+		cont->parent_id = 0;
+	else if (sscanf(parent, "dprc@%d", &cont->parent_id) != 1) {
+		ERROR_PRINTF("dprc@%d: invalid parent %s\n", cont->id, parent);
+		return -EINVAL;
+	}
+
+	for (int i = 0; options && i < options->num_strings; i++) {
+		int j;
+
+		for (j = 0; j < (int)ARRAY_SIZE(dprc_opt_names); j++) {
+			if (strcmp(options->strings[i],
+				   dprc_opt_names[j].name) == 0)
+				break;
+		}
+		if (j == (int)ARRAY_SIZE(dprc_opt_names)) {
+			ERROR_PRINTF("dprc@%d: unknown option %s\n", cont->id,
+				     options->strings[i]);
+			return -EINVAL;
+		}
+		cont->options |= dprc_opt_names[j].flag;
+	}
+
+	return read_container_objs(ctx, cont, node);
+}
+
+static int read_connection(struct diff_ctx *ctx, const struct dts_node *node)
+{
+	const char *ep1 = dts_string(node, "endpoint1");
+	const char *ep2 = dts_string(node, "endpoint2");
+	struct conn_list *conn;
+	int error;
+
+	conn = calloc(1, sizeof(*conn));
+	if (!conn) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	if (!ep1 || !ep2 ||
+	    parse_dpl_name(ep1, conn->type1, &conn->id1, &conn->if_id1) ||
+	    parse_dpl_name(ep2, conn->type2, &conn->id2, &conn->if_id2)) {
+		ERROR_PRINTF("%s: invalid endpoints\n", node->name);
+		free(conn);
+		return -EINVAL;
+	}
+
+	error = compare_insert_connection(&ctx->target.conns, conn);
+	if (error) {
+		ERROR_PRINTF("%s: endpoint already connected elsewhere\n",
+			     node->name);
+		free(conn);
+	}
+
+	return error;
+}
+
+/**
+ * Builds the target layout from the DPL, in the same form
+ * dpl_read_layout() gives the live one
+ */
+static int read_target(struct diff_ctx *ctx)
+{
+	struct container_list **tail = &ctx->target.containers;
+	const struct dts_node *containers, *objects, *connections;
+	int num_tops = 0;
+	int error;
+
+	containers = dts_child(ctx->dpl, "containers");
+	if (!containers) {
+		ERROR_PRINTF("the DPL has no containers node\n");
+		return -EINVAL;
+	}
+
+	for (const struct dts_node *n = containers->children; n; n = n->next) {
+		error = read_container(ctx, n, &tail);
+		if (error)
+			return error;
+	}
+
+	for (struct container_list *c = ctx->target.containers; c;
+	     c = c->next) {
+		if (c->parent_id == 0)
+			num_tops++;
+	}
+	if (num_tops != 1) {
+		ERROR_PRINTF("the DPL must have exactly one container without parent\n");
+		return -EINVAL;
+	}
+
+	/* Version 10 DPLs carry labels in the objects section */
+	objects = dts_child(ctx->dpl, "objects");
+	for (const struct dts_node *n = objects ? objects->children : NULL;
+	     n; n = n->next) {
+		const char *label = dts_string(n, "label");
+		char type[OBJ_TYPE_MAX_LENGTH + 1];
+		struct obj_list *obj;
+		int id, if_id;
+
+		if (!label || parse_dpl_name(n->name, type, &id, &if_id))
+			continue;
+
+		if (strlen(label) > MC_OBJ_LABEL_MAX_LENGTH) {
+			ERROR_PRINTF("%s: label longer than %d characters\n",
+				     n->name, MC_OBJ_LABEL_MAX_LENGTH);
+			return -EINVAL;
+		}
+
+		obj = find_list_obj(ctx->target.objs, type, id);
+		if (obj)
+			strcpy(obj->label, label);
+
+		for (struct container_list *c = ctx->target.containers; c;
+		     c = c->next) {
+			obj = find_list_obj(c->obj, type, id);
+			if (obj)
+				strcpy(obj->label, label);
+		}
+	}
+
+	connections = dts_child(ctx->dpl, "connections");
+	for (const struct dts_node *n = connections ? connections->children :
+	     NULL; n; n = n->next) {
+		error = read_connection(ctx, n);
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+static struct container_list *find_container(const struct dpl_layout *layout,
+					     int id)
+{
+	for (struct container_list *c = layout->containers; c; c = c->next) {
+		if (c->id == id)
+			return c;
+	}
+
+	return NULL;
+}
+
+static struct plan_cont *find_plan_cont(const struct diff_ctx *ctx, int id)
+{
+	for (int i = 0; i < ctx->num_conts; i++) {
+		if (ctx->conts[i].target->id == id)
+			return &ctx->conts[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * Pairs every target container with a live one. The top container of
+ * the DPL stands for the live root, any other matches the live
+ * container of the same id if that has the matching parent; the rest
+ * are new. Entries are ordered parents first.
+ */
+static int match_containers(struct diff_ctx *ctx)
+{
+	int num_left = ctx->target.num_containers;
+
+	ctx->conts = calloc(num_left, sizeof(*ctx->conts));
+	if (!ctx->conts) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	while (num_left > 0) {
+		int num_placed = 0;
+
+		for (struct container_list *c = ctx->target.containers; c;
+		     c = c->next) {
+			struct plan_cont *parent = NULL;
+			struct plan_cont *pc;
+			struct container_list *live;
+
+			if (find_plan_cont(ctx, c->id))
+				continue;
+
+			if (c->parent_id != 0) {
+				parent = find_plan_cont(ctx, c->parent_id);
+				if (!parent)
+					continue;
+			}
+
+			pc = &ctx->conts[ctx->num_conts++];
+			pc->target = c;
+			pc->parent = parent;
+			if (!parent) {
+				pc->live_id = restool.root_dprc_id;
+			} else if (parent->live_id != 0) {
+				live = find_container(&ctx->live, c->id);
+				if (live && live->parent_id == (int)parent->live_id)
+					pc->live_id = c->id;
+			}
+
+			num_placed++;
+			num_left--;
+		}
+
+		if (num_placed == 0) {
+			ERROR_PRINTF("the DPL containers do not form a tree\n");
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int match_objects(struct diff_ctx *ctx)
+{
+	int num_objs = 0;
+
+	for (struct container_list *c = ctx->target.containers; c; c = c->next)
+		for (struct obj_list *o = c->obj; o; o = o->next)
+			num_objs++;
+
+	ctx->objs = calloc(num_objs ? num_objs : 1, sizeof(*ctx->objs));
+	if (!ctx->objs) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < ctx->num_conts; i++) {
+		struct plan_cont *pc = &ctx->conts[i];
+
+		for (struct obj_list *o = pc->target->obj; o; o = o->next) {
+			struct plan_obj *po = &ctx->objs[ctx->num_objs++];
+
+			po->target = o;
+			po->cont = pc;
+			for (struct container_list *c = ctx->live.containers;
+			     c && !po->live; c = c->next) {
+				po->live = find_list_obj(c->obj, o->type, o->id);
+				if (po->live)
+					po->live_cont_id = c->id;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static struct plan_obj *find_plan_obj(const struct diff_ctx *ctx,
+				      const char *type, int id)
+{
+	for (int i = 0; i < ctx->num_objs; i++) {
+		const struct obj_list *o = ctx->objs[i].target;
+
+		if (o->id == id && strcmp(o->type, type) == 0)
+			return &ctx->objs[i];
+	}
+
+	return NULL;
+}
+
+static const char *cont_ref(const struct plan_cont *pc, char *buf)
+{
+	if (pc->created)
+		sprintf(buf, "$%d", pc->created);
+	else
+		sprintf(buf, "dprc.%u", pc->live_id);
+
+	return buf;
+}
+
+static const char *obj_ref(const struct plan_obj *po, char *buf)
+{
+	if (po->created)
+		sprintf(buf, "$%d", po->created);
+	else
+		sprintf(buf, "%s.%d", po->target->type, po->target->id);
+
+	return buf;
+}
+
+/**
+ * Names one end of a connection as restool expects it, "$<n>" standing
+ * for an object the plan creates
+ */
+static const char *endpoint_ref(const struct diff_ctx *ctx, const char *type,
+				int id, int if_id, char *buf)
+{
+	struct plan_obj *po = find_plan_obj(ctx, type, id);
+	char obj[OBJ_TYPE_MAX_LENGTH + 12];
+
+	if (po)
+		obj_ref(po, obj);
+	else
+		sprintf(obj, "%s.%d", type, id);
+
+	if (if_id < 0)
+		sprintf(buf, "%s", obj);
+	else
+		sprintf(buf, "%s.%d", obj, if_id);
+
+	return buf;
+}
+
+static bool same_endpoint(const char *type1, int id1, int if_id1,
+			  const char *type2, int id2, int if_id2)
+{
+	return strcmp(type1, type2) == 0 && id1 == id2 && if_id1 == if_id2;
+}
+
+static bool has_connection(const struct conn_list *head,
+			   const struct conn_list *conn)
+{
+	for (; head; head = head->next) {
+		if (same_endpoint(head->type1, head->id1, head->if_id1,
+				  conn->type1, conn->id1, conn->if_id1) &&
+		    same_endpoint(head->type2, head->id2, head->if_id2,
+				  conn->type2, conn->id2, conn->if_id2))
+			return true;
+		if (same_endpoint(head->type1, head->id1, head->if_id1,
+				  conn->type2, conn->id2, conn->if_id2) &&
+		    same_endpoint(head->type2, head->id2, head->if_id2,
+				  conn->type1, conn->id1, conn->if_id1))
+			return true;
+	}
+
+	return false;
+}
+
+/* The portal restool itself talks through is never part of a DPL */
+static bool is_own_portal(const struct obj_list *obj)
+{
+	return strcmp(obj->type, "dpmcp") == 0 && obj->id == 0;
+}
+
+static int plan_disconnects(struct diff_ctx *ctx)
+{
+	char ep[OBJ_TYPE_MAX_LENGTH + 24];
+	int error;
+
+	for (struct conn_list *c = ctx->live.conns; c; c = c->next) {
+		if (has_connection(ctx->target.conns, c))
+			continue;
+
+		error = add_step(&ctx->plan, "dprc disconnect dprc.%u --endpoint=%s",
+				 restool.root_dprc_id,
+				 endpoint_ref(ctx, c->type1, c->id1, c->if_id1,
+					      ep));
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+static int plan_containers(struct diff_ctx *ctx)
+{
+	char parent[16];
+	int error;
+
+	for (int i = 0; i < ctx->num_conts; i++) {
+		struct plan_cont *pc = &ctx->conts[i];
+		char options[DIFF_STEP_SIZE / 2] = "";
+
+		if (!pc->parent || pc->live_id != 0)
+			continue;
+
+		for (int j = 0; j < (int)ARRAY_SIZE(dprc_opt_names); j++) {
+			if (!(pc->target->options & dprc_opt_names[j].flag))
+				continue;
+			snprintf(options + strlen(options),
+				 sizeof(options) - strlen(options), "%s%s",
+				 options[0] ? "," : " --options=",
+				 dprc_opt_names[j].name);
+		}
+
+		error = add_step(&ctx->plan, "dprc create %s%s   # dprc@%d",
+				 cont_ref(pc->parent, parent), options,
+				 pc->target->id);
+		if (error)
+			return error;
+		pc->created = ++ctx->plan.num_created;
+	}
+
+	return 0;
+}
+
+/**
+ * Turns the properties of an object node into create command options
+ */
+static void create_options(const struct diff_ctx *ctx,
+			   const struct obj_list *obj, char *buf, size_t size)
+{
+	const struct dts_node *objects = dts_child(ctx->dpl, "objects");
+	const struct dts_node *node = NULL;
+	char name[OBJ_TYPE_MAX_LENGTH + 12];
+	size_t len = 0;
+
+	buf[0] = '\0';
+	snprintf(name, sizeof(name), "%s@%d", obj->type, obj->id);
+	if (objects)
+		node = dts_child(objects, name);
+
+	for (int i = 0; i < (int)ARRAY_SIZE(create_args); i++) {
+		const struct create_arg *arg = &create_args[i];
+		const struct dts_prop *prop = NULL;
+
+		if (strcmp(arg->type, obj->type) != 0)
+			continue;
+
+		if (arg->value == ARG_OBJ_ID) {
+			len += snprintf(buf + len, size - len, " --%s=%d",
+					arg->option, obj->id);
+			continue;
+		}
+
+		if (node)
+			prop = dts_prop(node, arg->prop);
+		if (!prop || (prop->num_strings == 0 && prop->num_cells == 0))
+			continue;
+
+		len += snprintf(buf + len, size - len, " --%s=", arg->option);
+		if (arg->value == ARG_COUNT) {
+			len += snprintf(buf + len, size - len, "%d",
+					prop->num_strings + prop->num_cells);
+			continue;
+		}
+
+		for (int j = 0; j < prop->num_strings; j++)
+			len += snprintf(buf + len, size - len, "%s%s",
+					j ? "," : "", prop->strings[j]);
+		for (int j = 0; j < prop->num_cells; j++)
+			len += snprintf(buf + len, size - len, "%s%lld",
+					j ? "," : "",
+					(long long)prop->cells[j] +
+					(prop->num_cells == 1 ? arg->adjust : 0));
+		if (len >= size)
+			len = size - 1;
+	}
+}
+
+static int plan_creates(struct diff_ctx *ctx)
+{
+	char options[DIFF_STEP_SIZE / 2];
+	char cont[16], obj[OBJ_TYPE_MAX_LENGTH + 12];
+	int error;
+
+	for (int i = 0; i < ctx->num_objs; i++) {
+		struct plan_obj *po = &ctx->objs[i];
+
+		if (po->live || is_own_portal(po->target))
+			continue;
+
+		create_options(ctx, po->target, options, sizeof(options));
+		error = add_step(&ctx->plan, "%s create --container=%s%s   # %s@%d",
+				 po->target->type, cont_ref(po->cont, cont),
+				 options, po->target->type, po->target->id);
+		if (error)
+			return error;
+		po->created = ++ctx->plan.num_created;
+
+		if (po->target->label[0] == '\0')
+			continue;
+
+		error = add_step(&ctx->plan, "dprc set-label %s --label=\"%s\"",
+				 obj_ref(po, obj), po->target->label);
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+/**
+ * Tells whether a live container is cont_id or one of its ancestors
+ */
+static bool live_holds(const struct diff_ctx *ctx, uint32_t ancestor_id,
+		       uint32_t cont_id)
+{
+	while (cont_id != 0) {
+		struct container_list *live;
+
+		if (cont_id == ancestor_id)
+			return true;
+
+		live = find_container(&ctx->live, cont_id);
+		if (!live)
+			break;
+		cont_id = live->parent_id;
+	}
+
+	return false;
+}
+
+/**
+ * Moves an object up from the live container to the closest container
+ * it shares with the target one, then down to the target container.
+ * A plugged object is unplugged first, since the MC cannot move it,
+ * and is only plugged again if the DPL asks for it.
+ */
+static int plan_move(struct diff_ctx *ctx, struct plan_obj *po)
+{
+	struct plan_cont *path[MAX_DPRC_NESTING + 1];
+	char obj[OBJ_TYPE_MAX_LENGTH + 12];
+	char parent[16], child[16];
+	struct plan_cont *common;
+	uint32_t cont_id;
+	int depth = 0;
+	int error;
+
+	obj_ref(po, obj);
+	for (common = po->cont; common; common = common->parent) {
+		if (common->live_id != 0 &&
+		    live_holds(ctx, common->live_id, po->live_cont_id))
+			break;
+
+		if (depth > MAX_DPRC_NESTING) {
+			ERROR_PRINTF("containers nested too deep\n");
+			return -EINVAL;
+		}
+		path[depth++] = common;
+	}
+
+	if (!common) {
+		ERROR_PRINTF("%s is outside the layout\n", obj);
+		return -EINVAL;
+	}
+
+	if (po->live->plugged) {
+		error = add_step(&ctx->plan,
+				 "dprc assign dprc.%u --object=%s --plugged=0",
+				 po->live_cont_id, obj);
+		if (error)
+			return error;
+	}
+
+	for (cont_id = po->live_cont_id; cont_id != common->live_id;) {
+		struct container_list *live = find_container(&ctx->live, cont_id);
+
+		error = add_step(&ctx->plan,
+				 "dprc unassign dprc.%d --child=dprc.%u --object=%s",
+				 live->parent_id, cont_id, obj);
+		if (error)
+			return error;
+		cont_id = live->parent_id;
+	}
+
+	while (depth-- > 0) {
+		error = add_step(&ctx->plan,
+				 "dprc assign %s --child=%s --object=%s%s",
+				 cont_ref(path[depth]->parent, parent),
+				 cont_ref(path[depth], child), obj,
+				 depth == 0 && po->target->plugged ?
+					" --plugged=1" : "");
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+static int plan_moves_and_labels(struct diff_ctx *ctx)
+{
+	char obj[OBJ_TYPE_MAX_LENGTH + 12];
+	int error;
+
+	for (int i = 0; i < ctx->num_objs; i++) {
+		struct plan_obj *po = &ctx->objs[i];
+
+		if (!po->live)
+			continue;
+
+		if (po->live_cont_id != po->cont->live_id) {
+			error = plan_move(ctx, po);
+			if (error)
+				return error;
+		}
+
+		/* A DPL without a label leaves the label alone */
+		if (po->target->label[0] == '\0' ||
+		    strcmp(po->target->label, po->live->label) == 0)
+			continue;
+
+		error = add_step(&ctx->plan, "dprc set-label %s --label=\"%s\"",
+				 obj_ref(po, obj), po->target->label);
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+static int plan_connects(struct diff_ctx *ctx)
+{
+	char ep1[OBJ_TYPE_MAX_LENGTH + 24], ep2[OBJ_TYPE_MAX_LENGTH + 24];
+	int error;
+
+	for (struct conn_list *c = ctx->target.conns; c; c = c->next) {
+		if (has_connection(ctx->live.conns, c))
+			continue;
+
+		error = add_step(&ctx->plan,
+				 "dprc connect dprc.%u --endpoint1=%s --endpoint2=%s",
+				 restool.root_dprc_id,
+				 endpoint_ref(ctx, c->type1, c->id1, c->if_id1,
+					      ep1),
+				 endpoint_ref(ctx, c->type2, c->id2, c->if_id2,
+					      ep2));
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
+/**
+ * Destroys what the DPL does not have, objects first and containers
+ * children first. This comes last since it cannot be rolled back.
+ */
+static int plan_destroys(struct diff_ctx *ctx)
+{
+	struct container_list **conts;
+	int num_conts = 0;
+	int error = 0;
+
+	ctx->plan.num_undoable = ctx->plan.num_steps;
+	for (struct obj_list *o = ctx->live.objs; o; o = o->next) {
+		if (is_own_portal(o) || find_plan_obj(ctx, o->type, o->id))
+			continue;
+
+		error = add_step(&ctx->plan, "%s destroy %s.%d", o->type,
+				 o->type, o->id);
+		if (error)
+			return error;
+	}
+
+	conts = calloc(ctx->live.num_containers, sizeof(*conts));
+	if (!conts) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	for (struct container_list *c = ctx->live.containers; c; c = c->next)
+		conts[num_conts++] = c;
+
+	while (num_conts-- > 0) {
+		bool kept = false;
+
+		for (int i = 0; i < ctx->num_conts; i++)
+			kept |= ctx->conts[i].live_id == (uint32_t)conts[num_conts]->id;
+		if (kept)
+			continue;
+
+		error = add_step(&ctx->plan, "dprc destroy dprc.%d",
+				 conts[num_conts]->id);
+		if (error)
+			break;
+	}
+
+	free(conts);
+	return error;
+}
+
+/**
+ * Runs the steps that can be undone in a transaction, rolled back if
+ * one fails, and then the destroys, which stop at the first failure
+ */
+static int run_plan(struct plan *plan)
+{
+	int error = 0;
+
+	txn_begin();
+	for (int i = 0; i < plan->num_steps; i++) {
+		if (i == plan->num_undoable)
+			txn_end();
+
+		DEBUG_PRINTF("diff-dpl step: %s\n", plan->steps[i]);
+		error = dprc_apply_step(plan->steps[i]);
+		if (error < 0) {
+			ERROR_PRINTF("step failed: %s\n", plan->steps[i]);
+			break;
+		}
+	}
+
+	/* Leftovers from a failed step must not be blamed on diff-dpl */
+	restool.cmd_option_mask = 0;
+
+	if (error < 0 && txn_active()) {
+		int error2 = txn_rollback();
+
+		if (error2 < 0)
+			ERROR_PRINTF("rollback incomplete, manual cleanup needed\n");
+	} else {
+		txn_end();
+	}
+
+	return error;
+}
+
+/**
+ * Works out the steps that turn the live layout below the root
+ * container into the one a DPL file describes, and prints them in the
+ * syntax of "dprc apply" or runs them.
+ *
+ * Containers and objects are matched by id, the top container of the
+ * DPL standing for the root container. Only what differs is touched:
+ * stale connections are removed, missing containers and objects
+ * created, objects in the wrong container moved, labels set and
+ * missing connections made, and at the end whatever the DPL does not
+ * have is destroyed.
+ */
+int dprc_diff_dpl(const char *dpl_file, bool apply)
+{
+	struct dts_node *dpl;
+	struct diff_ctx ctx;
+	int error;
+
+	memset(&ctx, 0, sizeof(ctx));
+	error = dts_read(dpl_file, &dpl);
+	if (error)
+		return error;
+	ctx.dpl = dpl;
+
+	error = read_target(&ctx);
+	if (error)
+		goto out;
+
+	error = dpl_read_layout(restool.root_dprc_id, &ctx.live);
+	if (error)
+		goto out;
+
+	error = match_containers(&ctx);
+	if (error)
+		goto out;
+
+	error = match_objects(&ctx);
+	if (error)
+		goto out;
+
+	error = plan_disconnects(&ctx);
+	if (error == 0)
+		error = plan_containers(&ctx);
+	if (error == 0)
+		error = plan_creates(&ctx);
+	if (error == 0)
+		error = plan_moves_and_labels(&ctx);
+	if (error == 0)
+		error = plan_connects(&ctx);
+	if (error == 0)
+		error = plan_destroys(&ctx);
+	if (error)
+		goto out;
+
+	if (!apply) {
+		for (int i = 0; i < ctx.plan.num_steps; i++)
+			printf("%s\n", ctx.plan.steps[i]);
+	} else if (ctx.plan.num_steps > 0) {
+		error = run_plan(&ctx.plan);
+	}
+
+	if (ctx.plan.num_steps == 0)
+		DEBUG_PRINTF("the layout already matches %s\n", dpl_file);
+
+out:
+	free_plan(&ctx.plan);
+	free(ctx.objs);
+	free(ctx.conts);
+	dpl_free_layout(&ctx.target);
+	dpl_free_layout(&ctx.live);
+	dts_free(dpl);
+	return error;
+}
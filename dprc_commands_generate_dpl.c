@@ -38,9 +38,12 @@
 #include <assert.h>
 #include <getopt.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "restool.h"
 #include "utils.h"
 #include "dprc_commands_generate_dpl.h"
+#include "dprc_walk.h"
+#include "dpl_emit.h"
 #include "mc_v9/fsl_dpaiop.h"
 #include "mc_v9/fsl_dpbp.h"
 #include "mc_v9/fsl_dpci.h"
@@ -59,6 +62,9 @@
 #include "mc_v9/fsl_dpsw.h"
 #include "mc_v10/fsl_dpni.h"
 
+/* Writer of the DPL being generated */
+static struct dpl_emitter *dpl_emit;
+
 /* dprc stuff */
 #define ALL_DPRC_OPTS_DPL (                     \
 	DPRC_CFG_OPT_SPAWN_ALLOWED |            \
@@ -126,56 +132,6 @@ struct dpni_config {
 /* dpl stuff */
 #define RESTOOL_DYNAMIC_DPL "./dynamic-dpl.dts"
 
-/**
- * struct obj_list - linked list node of all objects
- * @next: tracks next objects, the objects are sorted
- * @type: object type
- * @id: object id
- * @label: object label
- */
-struct obj_list {
-	struct obj_list *next;
-	char type[16];
-	int id;
-	char label[16];
-};
-
-/**
- * struct conn_list - linked list node of 2 connected endpoints
- * @next: tracks next connection, the connections are not sorted.
- * @type1: endpoint1's object type
- * @type2: endpoint2's object type
- * @id1: endpoint1's id
- * @id2: endpoint2's id
- * @if_id1: endpoint1's interface id, initialized as -1 if no interface
- * @if_id2: endpoint2's interface id, initialized as -1 if no interface
- */
-struct conn_list {
-	struct conn_list *next;
-	char type1[16];
-	char type2[16];
-	int id1;
-	int id2;
-	int if_id1;
-	int if_id2;
-};
-
-/**
- * struct container_list - linked list node of all containers
- * @next: tracks next container
- * @obj_list: tracks the objects in current container, sorted list
- * @id: current container's id
- * @parent_id: current container's parent id. 0 means no parent.
- * @options: configuration options of current container
- */
-struct container_list {
-	struct container_list *next;
-	struct obj_list *obj;
-	int id;
-	int parent_id;
-	uint64_t options;
-};
-
 static int container_count;
 static struct container_list *container_head;
 static struct obj_list *obj_head;
@@ -191,7 +147,7 @@ enum mc_cmd_status mc_status;
  *
  * Returns 0 on success, negative otherwise
  */
-static int compare_insert_obj(struct obj_list **head, struct obj_list *target)
+int compare_insert_obj(struct obj_list **head, struct obj_list *target)
 {
 	int error;
 	struct obj_list *prev;
@@ -256,22 +212,22 @@ static int compare_insert_obj(struct obj_list **head, struct obj_list *target)
 	return 0;
 }
 
-static int find_all_obj_desc(uint32_t dprc_id,
-			     uint16_t dprc_handle,
-			     int nesting_level,
-			     struct container_list **prev,
-			     uint32_t parent_id)
+/**
+ * find_all_obj_desc - build the container and object lists from a walk
+ * @node: container snapshot taken by dprc_walk()
+ * @tail: last container added so far, NULL for the first one
+ *
+ * Containers are appended in depth-first order, parent before children.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+static int find_all_obj_desc(struct dprc_walk_node *node,
+			     struct container_list **tail)
 {
-
-	int num_child_devices;
-	int error = 0;
-	enum mc_cmd_status mc_status;
-	struct container_list *prev_cont;
 	struct container_list *curr_cont;
-	struct dprc_attributes dprc_attr;
+	int child_index = 0;
+	int error = 0;
 
-	if (prev)
-		prev_cont = *prev;
 	curr_cont = malloc(sizeof(struct container_list));
 	if (curr_cont == NULL) {
 		ERROR_PRINTF("malloc failed\n");
@@ -279,93 +235,38 @@ static int find_all_obj_desc(uint32_t dprc_id,
 		goto out;
 	}
 
-	assert(nesting_level <= MAX_DPRC_NESTING);
-	if (parent_id == 0) {
+	assert(node->nesting_level <= MAX_DPRC_NESTING);
+	if (*tail == NULL) {
 		DEBUG_PRINTF("This is the main dprc.\n");
 		container_head = curr_cont;
 	} else {
 		DEBUG_PRINTF("This is child dprc.\n");
-		prev_cont->next = curr_cont;
+		(*tail)->next = curr_cont;
 	}
 
-	curr_cont->id = dprc_id;
-	curr_cont->parent_id = parent_id;
+	curr_cont->id = node->id;
+	curr_cont->parent_id = node->parent_id;
+	curr_cont->options = node->options;
 	curr_cont->obj = NULL;
 	curr_cont->next = NULL;
-	if (prev)
-		*prev = curr_cont;
-	prev_cont = curr_cont;
-
-	memset(&dprc_attr, 0, sizeof(dprc_attr));
-	error = dprc_get_attributes(&restool.mc_io, 0,
-				dprc_handle, &dprc_attr);
-	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
-		goto out;
-	}
-	curr_cont->options = dprc_attr.options;
+	*tail = curr_cont;
 	container_count++;
-	error = dprc_get_obj_count(&restool.mc_io, 0,
-				   dprc_handle,
-				   &num_child_devices);
-	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
-		goto out;
-	}
-
-	for (int i = 0; i < num_child_devices; i++) {
-		struct dprc_obj_desc obj_desc;
-		uint16_t child_dprc_handle;
-		int error2;
-
-		error = dprc_get_obj(
-				&restool.mc_io, 0,
-				dprc_handle,
-				i,
-				&obj_desc);
-		if (error < 0) {
-			DEBUG_PRINTF(
-				"dprc_get_object(%u) failed with error %d\n",
-				i, error);
-			goto out;
-		}
 
-		DEBUG_PRINTF("it is %s.%u\n", obj_desc.type, obj_desc.id);
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *obj_desc = &node->objs[i];
 
-		if (strcmp(obj_desc.type, "dprc") == 0) {
+		DEBUG_PRINTF("it is %s.%u\n", obj_desc->type, obj_desc->id);
 
-			error = open_dprc(obj_desc.id, &child_dprc_handle);
-			if (error < 0)
+		if (node->obj_types[i] == OBJ_TYPE_DPRC) {
+			DEBUG_PRINTF("entering %s.%u\n", obj_desc->type,
+					obj_desc->id);
+			error = find_all_obj_desc(node->children[child_index++],
+						  tail);
+			if (error)
 				goto out;
 
-			DEBUG_PRINTF("entering %s.%u\n", obj_desc.type,
-					obj_desc.id);
-			error = find_all_obj_desc(obj_desc.id,
-					child_dprc_handle,
-					nesting_level + 1,
-					&prev_cont,
-					dprc_id);
-			if (prev)
-				*prev = prev_cont;
-
-			error2 = dprc_close(&restool.mc_io, 0,
-						child_dprc_handle);
-			if (error2 < 0) {
-				mc_status = flib_error_to_mc_status(error2);
-				ERROR_PRINTF("MC error: %s (status %#x)\n",
-				mc_status_to_string(mc_status), mc_status);
-				if (error == 0)
-					error = error2;
-
-				goto out;
-			}
-
-			DEBUG_PRINTF("exiting %s.%u\n", obj_desc.type,
-					obj_desc.id);
+			DEBUG_PRINTF("exiting %s.%u\n", obj_desc->type,
+					obj_desc->id);
 		} else {
 			struct obj_list *curr_obj =
 				malloc(sizeof(struct obj_list));
@@ -376,22 +277,29 @@ static int find_all_obj_desc(uint32_t dprc_id,
 			}
 
 			curr_obj->next = NULL;
-			strncpy(curr_obj->type, obj_desc.type, 16);
-			curr_obj->id = obj_desc.id;
-			strncpy(curr_obj->label, obj_desc.label, 16);
+			strncpy(curr_obj->type, obj_desc->type, 16);
+			curr_obj->type_id = node->obj_types[i];
+			curr_obj->id = obj_desc->id;
+			strncpy(curr_obj->label, obj_desc->label, 16);
+			curr_obj->plugged = obj_desc->state &
+					     DPRC_OBJ_STATE_PLUGGED;
 
 			struct obj_list *curr_obj2 =
 				malloc(sizeof(struct obj_list));
 			if (curr_obj2 == NULL) {
+				free(curr_obj);
 				ERROR_PRINTF("malloc failed\n");
 				error = -errno;
 				goto out;
 			}
 
 			curr_obj2->next = NULL;
-			strncpy(curr_obj2->type, obj_desc.type, 16);
-			curr_obj2->id = obj_desc.id;
-			strncpy(curr_obj2->label, obj_desc.label, 16);
+			strncpy(curr_obj2->type, obj_desc->type, 16);
+			curr_obj2->type_id = node->obj_types[i];
+			curr_obj2->id = obj_desc->id;
+			strncpy(curr_obj2->label, obj_desc->label, 16);
+			curr_obj2->plugged = obj_desc->state &
+					     DPRC_OBJ_STATE_PLUGGED;
 
 			error = compare_insert_obj(&obj_head, curr_obj);
 			if (error)
@@ -408,105 +316,58 @@ out:
 
 static int parse_layout(uint32_t dprc_id)
 {
+	struct container_list *tail = NULL;
+	struct dprc_walk_node *root;
 	int error;
 
-	bool opened = false;
-
-	uint16_t dprc_handle;
-
 	/* if no dprc specified, use root dprc */
-	if (restool.obj_name == NULL || dprc_id == restool.root_dprc_id) {
+	if (restool.obj_name == NULL)
 		dprc_id = restool.root_dprc_id;
-		dprc_handle = restool.root_dprc_handle;
-	} else {
-		error = dprc_open(&restool.mc_io, 0, dprc_id, &dprc_handle);
-		if (error < 0) {
-			mc_status = flib_error_to_mc_status(error);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			goto out;
-		}
-		opened = true;
-	}
-
-	error = find_all_obj_desc(dprc_id, dprc_handle, 0, NULL, 0);
 
-	if (opened == true) {
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
-		if (error < 0) {
-			mc_status = flib_error_to_mc_status(error);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			goto out;
-		}
+	error = dprc_walk(dprc_id, &root);
+	if (error)
+		goto out;
 
-	}
+	error = find_all_obj_desc(root, &tail);
+	dprc_walk_free(root);
 
-	if (error) {
+out:
+	if (error)
 		ERROR_PRINTF("Parsing Data Path Layout failed\n");
-		return error;
-	}
 
-out:
-	return 0;
+	return error;
 }
 
-static void parse_dprc_options(FILE *fp, uint64_t options)
+static void parse_dprc_options(struct dpl_emitter *emit, uint64_t options)
 {
-	char buf[300];
-	int len;
+	const char *opts[6];
+	int num_opts = 0;
 
 	if ((options & ~ALL_DPRC_OPTS_DPL) != 0)
-		fprintf(fp, "\t\t\t/* Unrecognized options found... */\n");
-
-
-	snprintf(buf, 14, "\t\t\toptions = ");
-
-	if (options & DPRC_CFG_OPT_SPAWN_ALLOWED) {
-		len = strlen(buf);
-		snprintf(buf+len, 31, "\"DPRC_CFG_OPT_SPAWN_ALLOWED\", ");
-	}
-
-	if (options & DPRC_CFG_OPT_ALLOC_ALLOWED) {
-		len = strlen(buf);
-		snprintf(buf+len, 31, "\"DPRC_CFG_OPT_ALLOC_ALLOWED\", ");
-	}
-
-	if (options & DPRC_CFG_OPT_OBJ_CREATE_ALLOWED) {
-		len = strlen(buf);
-		snprintf(buf+len, 36, "\"DPRC_CFG_OPT_OBJ_CREATE_ALLOWED\", ");
-	}
-
-	if (options & DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED) {
-		len = strlen(buf);
-		snprintf(buf+len, 42,
-			"\"DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED\", ");
-	}
-
-	if (options & DPRC_CFG_OPT_AIOP) {
-		len = strlen(buf);
-		snprintf(buf+len, 22, "\"DPRC_CFG_OPT_AIOP\", ");
-	}
-
-	if (options & DPRC_CFG_OPT_IRQ_CFG_ALLOWED) {
-		len = strlen(buf);
-		snprintf(buf+len, 33, "\"DPRC_CFG_OPT_IRQ_CFG_ALLOWED\", ");
-	}
-
-	len = strlen(buf);
-	if (13 == len)
-		return;
-	buf[len-2] = ';';
-	buf[len-1] = '\0';
-
-	fprintf(fp, "%s\n", buf);
+		dpl_emit_comment(emit, "/* Unrecognized options found... */");
+
+	if (options & DPRC_CFG_OPT_SPAWN_ALLOWED)
+		opts[num_opts++] = "DPRC_CFG_OPT_SPAWN_ALLOWED";
+	if (options & DPRC_CFG_OPT_ALLOC_ALLOWED)
+		opts[num_opts++] = "DPRC_CFG_OPT_ALLOC_ALLOWED";
+	if (options & DPRC_CFG_OPT_OBJ_CREATE_ALLOWED)
+		opts[num_opts++] = "DPRC_CFG_OPT_OBJ_CREATE_ALLOWED";
+	if (options & DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED)
+		opts[num_opts++] = "DPRC_CFG_OPT_TOPOLOGY_CHANGES_ALLOWED";
+	if (options & DPRC_CFG_OPT_AIOP)
+		opts[num_opts++] = "DPRC_CFG_OPT_AIOP";
+	if (options & DPRC_CFG_OPT_IRQ_CFG_ALLOWED)
+		opts[num_opts++] = "DPRC_CFG_OPT_IRQ_CFG_ALLOWED";
+
+	if (num_opts)
+		dpl_emit_strings(emit, "options", opts, num_opts);
 }
 
-static void parse_obj_label(FILE *fp, char *label)
+static void parse_obj_label(struct dpl_emitter *emit, char *label)
 {
 	assert(strlen(label) <= MC_OBJ_LABEL_MAX_LENGTH);
 	if (strlen(label) > 0)
-		fprintf(fp, "\t\t\t\t\tlabel = \"%s\";\n", label);
+		dpl_emit_string(emit, "label", "%s", label);
 }
 
 static char *to_upper(char *string)
@@ -528,29 +389,51 @@ static char *to_upper(char *string)
 	return upper_string;
 }
 
-static int write_obj_set(char *obj_type, int start_index, int end_index)
+/**
+ * write_obj_set - write the ids of the objects of one type
+ * @obj_type: the type
+ * @first: first object of that type in a sorted object list
+ */
+static int write_obj_set(char *obj_type, struct obj_list *first)
 {
+	struct dpl_emitter *emit = dpl_emit;
 	char *obj_type_upper;
-	FILE *fp = stdout;
-	int i;
+	struct obj_list *obj;
+	uint32_t *ids;
+	int num_ids = 0;
 
-	obj_type_upper = to_upper(obj_type);
-	if (!obj_type_upper)
+	for (obj = first; obj && strcmp(obj->type, obj_type) == 0;
+	     obj = obj->next)
+		num_ids++;
+
+	ids = malloc((num_ids ? num_ids : 1) * sizeof(*ids));
+	if (!ids)
 		return -ENOMEM;
 
-	fprintf(fp, "\n");
-	fprintf(fp, "\t\t\t\t/* -------------- %ss --------------*/\n", obj_type_upper);
-	fprintf(fp, "\t\t\t\tobj_set@%s {\n", obj_type);
-	fprintf(fp, "\t\t\t\t\ttype = \"%s\";\n", obj_type);
-	fprintf(fp, "\t\t\t\t\tids = <");
+	obj_type_upper = to_upper(obj_type);
+	if (!obj_type_upper) {
+		free(ids);
+		return -ENOMEM;
+	}
 
-	for (i = start_index; i <= end_index; i++)
-		fprintf(fp, "%d ", i);
+	num_ids = 0;
+	for (obj = first; obj && strcmp(obj->type, obj_type) == 0;
+	     obj = obj->next) {
+		if (strcmp(obj->type, "dpmcp") == 0 && obj->id == 0)
+			continue;
+		ids[num_ids++] = obj->id;
+	}
 
-	fprintf(fp, ">;\n");
-	fprintf(fp, "\t\t\t\t};\n");
+	dpl_emit_blank(emit);
+	dpl_emit_comment(emit, "/* -------------- %ss --------------*/",
+			 obj_type_upper);
+	dpl_emit_begin_node(emit, "obj_set@%s", obj_type);
+	dpl_emit_string(emit, "type", "%s", obj_type);
+	dpl_emit_cells(emit, "ids", DPL_CELL_DEC, ids, num_ids);
+	dpl_emit_end_node(emit);
 
 	free(obj_type_upper);
+	free(ids);
 	return 0;
 }
 
@@ -560,40 +443,41 @@ static int write_containers(void)
 	struct obj_list *curr_obj;
 	struct obj_list *prev_obj;
 	char curr_obj_type[OBJ_TYPE_MAX_LENGTH];
-	int remain, obj_set_start, error;
-	int curr_obj_id;
+	struct obj_list *obj_set_first = NULL;
+	int remain, error;
 	int obj_num = 99;
 	int base = 100;
-	FILE *fp = stdout;
+	struct dpl_emitter *emit = dpl_emit;
 
-	fprintf(fp,
-		"\t/*****************************************************************\n");
-	fprintf(fp, "\t * Containers\n");
-	fprintf(fp,
-		"\t *****************************************************************/\n");
+	dpl_emit_comment(emit,
+		"/*****************************************************************");
+	dpl_emit_comment(emit, " * Containers");
+	dpl_emit_comment(emit,
+		" *****************************************************************/");
 
-	fprintf(fp, "\tcontainers {\n");
+	dpl_emit_begin_node(emit, "containers");
 
 	curr_cont = container_head;
 	while (curr_cont) {
 		obj_num = 99;
 		prev_obj = NULL;
 		curr_obj = curr_cont->obj;
+		obj_set_first = NULL;
 		memset(curr_obj_type, 0, OBJ_TYPE_MAX_LENGTH);
 
-		fprintf(fp, "\n");
-		fprintf(fp, "\t\tdprc@%d {\n", curr_cont->id);
-		fprintf(fp, "\t\t\tcompatible = \"fsl,dprc\";\n");
+		dpl_emit_blank(emit);
+		dpl_emit_begin_node(emit, "dprc@%d", curr_cont->id);
+		dpl_emit_string(emit, "compatible", "fsl,dprc");
 		if (curr_cont->parent_id == 0)
-			fprintf(fp, "\t\t\tparent = \"none\";\n");
+			dpl_emit_string(emit, "parent", "none");
 		else
-			fprintf(fp, "\t\t\tparent = \"dprc@%d\";\n",
-				curr_cont->parent_id);
-		parse_dprc_options(fp, curr_cont->options);
+			dpl_emit_string(emit, "parent", "dprc@%d",
+					curr_cont->parent_id);
+		parse_dprc_options(emit, curr_cont->options);
 
 
-		fprintf(fp, "\n");
-		fprintf(fp, "\t\t\tobjects {\n");
+		dpl_emit_blank(emit);
+		dpl_emit_begin_node(emit, "objects");
 
 		while (curr_obj) {
 			if (strcmp(curr_obj->type, "dpmcp") == 0 &&
@@ -608,29 +492,25 @@ static int write_containers(void)
 			}
 
 			if (restool.mc_fw_version.major <= MC_FW_VERSION_9) {
-				fprintf(fp, "\n");
-				fprintf(fp, "\t\t\t\tobj@%d {\n", obj_num);
-				fprintf(fp, "\t\t\t\t\tobj_name = \"%s@%d\";\n",
-					curr_obj->type, curr_obj->id);
-				parse_obj_label(fp, curr_obj->label);
-				fprintf(fp, "\t\t\t\t};\n");
+				dpl_emit_blank(emit);
+				dpl_emit_begin_node(emit, "obj@%d", obj_num);
+				dpl_emit_string(emit, "obj_name", "%s@%d",
+						curr_obj->type, curr_obj->id);
+				parse_obj_label(emit, curr_obj->label);
+				dpl_emit_end_node(emit);
 			} else if (restool.mc_fw_version.major == MC_FW_VERSION_10) {
 				if (curr_obj_type[0] == '\0') {
 					memcpy(curr_obj_type, curr_obj->type, OBJ_TYPE_MAX_LENGTH);
-					curr_obj_id = curr_obj->id;
-					obj_set_start = curr_obj->id;
+					obj_set_first = curr_obj;
 				} else if (strcmp(curr_obj_type, curr_obj->type)) {
-					error = write_obj_set(curr_obj_type, obj_set_start, curr_obj_id);
+					error = write_obj_set(curr_obj_type, obj_set_first);
 					if (error) {
 						ERROR_PRINTF("write_obj_set() failed with error = %d\n", error);
 						return error;
 					}
 
-					obj_set_start = curr_obj->id;
+					obj_set_first = curr_obj;
 					memcpy(curr_obj_type, curr_obj->type, OBJ_TYPE_MAX_LENGTH);
-					curr_obj_id = curr_obj->id;
-				} else {
-					curr_obj_id = curr_obj->id;
 				}
 			}
 
@@ -639,18 +519,18 @@ static int write_containers(void)
 			curr_obj = curr_obj->next;
 		}
 
-		error = write_obj_set(curr_obj_type, obj_set_start, curr_obj_id);
+		error = write_obj_set(curr_obj_type, obj_set_first);
 		if (error) {
 			ERROR_PRINTF("write_obj_set() failed with error = %d\n", error);
 			return error;
 		}
 
-		fprintf(fp, "\t\t\t};\n");
-		fprintf(fp, "\t\t};\n");
+		dpl_emit_end_node(emit);
+		dpl_emit_end_node(emit);
 		curr_cont = curr_cont->next;
 	}
 
-	fprintf(fp, "\t};\n");
+	dpl_emit_end_node(emit);
 
 	return 0;
 }
@@ -665,8 +545,8 @@ static int write_containers(void)
  *
  * Return 0 on success, negative otherwise
  */
-static int compare_insert_connection(struct conn_list **head,
-				     struct conn_list *target)
+int compare_insert_connection(struct conn_list **head,
+			      struct conn_list *target)
 {
 	struct conn_list *prev;
 	struct conn_list *curr;
@@ -713,63 +593,76 @@ static int compare_insert_connection(struct conn_list **head,
 	return 0;
 }
 
-/* objects don't Need to be parse and get attributes for now */
-static int parse_dpbp(FILE *fp, struct obj_list *curr)
-{
-	(void)fp;
-	(void)curr;
-	return 0;
-}
-
-static int parse_dpdbg(FILE *fp, struct obj_list *curr)
-{
-	(void)fp;
-	(void)curr;
-	return 0;
-}
-
-static int parse_dpmcp(FILE *fp, struct obj_list *curr)
-{
-	(void)fp;
-	(void)curr;
-	return 0;
-}
+/**
+ * struct obj_fetch - attributes of one object, read before any of the
+ *	DPL is formatted
+ * @obj: the object
+ * @fetched: @u holds the object's attributes; objects whose attributes
+ *	could not be read are written without them
+ * @conns: connections found on the object's endpoints, in interface order
+ * @u: attributes, according to @obj->type
+ */
+struct obj_fetch {
+	struct obj_list *obj;
+	bool fetched;
+	struct conn_list *conns;
+	union {
+		struct dpcon_attr dpcon;
+		struct dpdcei_attr dpdcei;
+		struct dpdmai_attr dpdmai;
+		struct dpio_attr dpio;
+		struct {
+			struct dpseci_attr attr;
+			uint8_t priorities[UINT8_MAX + 1];
+		} dpseci;
+		struct {
+			struct dpci_attr attr;
+			struct dpci_peer_attr peer;
+		} dpci;
+		struct {
+			struct dpni_attr_v9 attr;
+			struct dpni_extended_cfg ext;
+			uint8_t mac_addr[6];
+		} dpni_v9;
+		struct dpni_attr_v10 dpni_v10;
+		struct dpdmux_attr_v9 dpdmux;
+		struct dpsw_attr_v9 dpsw;
+	} u;
+};
 
-static int parse_dprc(FILE *fp, struct obj_list *curr)
-{
-	(void)fp;
-	(void)curr;
-	return 0;
-}
+/**
+ * struct fetch_ctx - attribute fetch shared by all workers
+ * @lock: protects @next
+ * @recs: one record per object, in obj_head order
+ * @num_recs: number of entries in @recs
+ * @next: index of the next record to fetch
+ */
+struct fetch_ctx {
+	pthread_mutex_t lock;
+	struct obj_fetch *recs;
+	int num_recs;
+	int next;
+};
 
-static int parse_dprtc(FILE *fp, struct obj_list *curr)
+static void print_mc_error(const struct obj_list *obj, int error)
 {
-	(void)fp;
-	(void)curr;
-	return 0;
-}
+	enum mc_cmd_status status;
 
-/* objects Need to be parsed and get attributes*/
-static int parse_dpaiop(FILE *fp, struct obj_list *curr)
-{
-	/* dpaiop_attr{} does not have field called aiop_container_id */
-	(void)fp;
-	(void)curr;
-	return 0;
+	status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("%s.%d: MC error: %s (status %#x)\n", obj->type, obj->id,
+		     mc_status_to_string(status), status);
 }
 
-static int parse_dpcon(FILE *fp, struct obj_list *curr)
+static int fetch_dpcon(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
 	uint16_t dpcon_handle;
 	int error;
-	struct dpcon_attr dpcon_attr;
 	bool dpcon_opened = false;
 
-	error = dpcon_open(&restool.mc_io, 0, curr->id, &dpcon_handle);
+	error = dpcon_open(worker->mc_io, 0, curr->id, &dpcon_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpcon_opened = true;
@@ -781,31 +674,23 @@ static int parse_dpcon(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpcon_attr, 0, sizeof(dpcon_attr));
-	error = dpcon_get_attributes(&restool.mc_io, 0, dpcon_handle,
-					&dpcon_attr);
+	memset(&rec->u.dpcon, 0, sizeof(rec->u.dpcon));
+	error = dpcon_get_attributes(worker->mc_io, 0, dpcon_handle,
+				     &rec->u.dpcon);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpcon_attr.id);
-
-	fprintf(fp, "\t\t\tnum_priorities = <%#x>;\n",
-		dpcon_attr.num_priorities);
-
-	error = 0;
+	assert(curr->id == rec->u.dpcon.id);
+	rec->fetched = true;
 
 out:
 	if (dpcon_opened) {
 		int error2;
 
-		error2 = dpcon_close(&restool.mc_io, 0, dpcon_handle);
+		error2 = dpcon_close(worker->mc_io, 0, dpcon_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -814,19 +699,22 @@ out:
 	return error;
 }
 
-static int parse_dpdcei(FILE *fp, struct obj_list *curr)
+static void write_dpcon(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	dpl_emit_cell(emit, "num_priorities", DPL_CELL_HEX,
+		      rec->u.dpcon.num_priorities);
+}
+
+static int fetch_dpdcei(struct dprc_worker *worker, struct obj_fetch *rec)
 {
-	/* dpdcei_attr{} does not have a field called priority */
+	struct obj_list *curr = rec->obj;
 	uint16_t dpdcei_handle;
 	int error;
-	struct dpdcei_attr dpdcei_attr;
 	bool dpdcei_opened = false;
 
-	error = dpdcei_open(&restool.mc_io, 0, curr->id, &dpdcei_handle);
+	error = dpdcei_open(worker->mc_io, 0, curr->id, &dpdcei_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpdcei_opened = true;
@@ -838,40 +726,23 @@ static int parse_dpdcei(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpdcei_attr, 0, sizeof(dpdcei_attr));
-	error = dpdcei_get_attributes(&restool.mc_io, 0, dpdcei_handle,
-					&dpdcei_attr);
+	memset(&rec->u.dpdcei, 0, sizeof(rec->u.dpdcei));
+	error = dpdcei_get_attributes(worker->mc_io, 0, dpdcei_handle,
+				      &rec->u.dpdcei);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpdcei_attr.id);
-
-	switch (dpdcei_attr.engine) {
-	case DPDCEI_ENGINE_COMPRESSION:
-		fprintf(fp, "\t\t\tengine = \"DPDCEI_ENGINE_COMPRESSION\";\n");
-		break;
-	case DPDCEI_ENGINE_DECOMPRESSION:
-		fprintf(fp, "\t\t\tengine = \"DPDCEI_ENGINE_DECOMPRESSION\";\n");
-		break;
-	default:
-		assert(false);
-		break;
-	}
-
-	error = 0;
+	assert(curr->id == rec->u.dpdcei.id);
+	rec->fetched = true;
 
 out:
 	if (dpdcei_opened) {
 		int error2;
 
-		error2 = dpdcei_close(&restool.mc_io, 0, dpdcei_handle);
+		error2 = dpdcei_close(worker->mc_io, 0, dpdcei_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -880,18 +751,32 @@ out:
 	return error;
 }
 
-static int parse_dpdmai(FILE *fp, struct obj_list *curr)
+/* dpdcei_attr{} does not have a field called priority */
+static void write_dpdcei(struct dpl_emitter *emit, struct obj_fetch *rec)
 {
+	switch (rec->u.dpdcei.engine) {
+	case DPDCEI_ENGINE_COMPRESSION:
+		dpl_emit_string(emit, "engine", "DPDCEI_ENGINE_COMPRESSION");
+		break;
+	case DPDCEI_ENGINE_DECOMPRESSION:
+		dpl_emit_string(emit, "engine", "DPDCEI_ENGINE_DECOMPRESSION");
+		break;
+	default:
+		assert(false);
+		break;
+	}
+}
+
+static int fetch_dpdmai(struct dprc_worker *worker, struct obj_fetch *rec)
+{
+	struct obj_list *curr = rec->obj;
 	uint16_t dpdmai_handle;
 	int error;
-	struct dpdmai_attr dpdmai_attr;
 	bool dpdmai_opened = false;
 
-	error = dpdmai_open(&restool.mc_io, 0, curr->id, &dpdmai_handle);
+	error = dpdmai_open(worker->mc_io, 0, curr->id, &dpdmai_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpdmai_opened = true;
@@ -903,31 +788,23 @@ static int parse_dpdmai(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpdmai_attr, 0, sizeof(dpdmai_attr));
-	error = dpdmai_get_attributes(&restool.mc_io, 0, dpdmai_handle,
-					&dpdmai_attr);
+	memset(&rec->u.dpdmai, 0, sizeof(rec->u.dpdmai));
+	error = dpdmai_get_attributes(worker->mc_io, 0, dpdmai_handle,
+				      &rec->u.dpdmai);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpdmai_attr.id);
-
-	fprintf(fp, "\t\t\tpriorities = <%#x>;\n",
-		dpdmai_attr.num_of_priorities);
-
-	error = 0;
+	assert(curr->id == rec->u.dpdmai.id);
+	rec->fetched = true;
 
 out:
 	if (dpdmai_opened) {
 		int error2;
 
-		error2 = dpdmai_close(&restool.mc_io, 0, dpdmai_handle);
+		error2 = dpdmai_close(worker->mc_io, 0, dpdmai_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -936,18 +813,22 @@ out:
 	return error;
 }
 
-static int parse_dpio(FILE *fp, struct obj_list *curr)
+static void write_dpdmai(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	dpl_emit_cell(emit, "priorities", DPL_CELL_HEX,
+		      rec->u.dpdmai.num_of_priorities);
+}
+
+static int fetch_dpio(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
 	uint16_t dpio_handle;
 	int error;
-	struct dpio_attr dpio_attr;
 	bool dpio_opened = false;
 
-	error = dpio_open(&restool.mc_io, 0, curr->id, &dpio_handle);
+	error = dpio_open(worker->mc_io, 0, curr->id, &dpio_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpio_opened = true;
@@ -959,34 +840,23 @@ static int parse_dpio(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpio_attr, 0, sizeof(dpio_attr));
-	error = dpio_get_attributes(&restool.mc_io, 0, dpio_handle, &dpio_attr);
+	memset(&rec->u.dpio, 0, sizeof(rec->u.dpio));
+	error = dpio_get_attributes(worker->mc_io, 0, dpio_handle,
+				    &rec->u.dpio);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpio_attr.id);
-
-	fprintf(fp, "\t\t\tchannel_mode = ");
-	dpio_attr.channel_mode == 0 ? fprintf(fp, "\"DPIO_NO_CHANNEL\";\n") :
-	dpio_attr.channel_mode == 1 ? fprintf(fp, "\"DPIO_LOCAL_CHANNEL\";\n") :
-	fprintf(fp, "\"wrong mode\"\n");
-	fprintf(fp, "\t\t\tnum_priorities = <%#x>;\n",
-	       (unsigned int)dpio_attr.num_priorities);
-
-	error = 0;
+	assert(curr->id == rec->u.dpio.id);
+	rec->fetched = true;
 
 out:
 	if (dpio_opened) {
 		int error2;
 
-		error2 = dpio_close(&restool.mc_io, 0, dpio_handle);
+		error2 = dpio_close(worker->mc_io, 0, dpio_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -995,20 +865,30 @@ out:
 	return error;
 }
 
-static int parse_dpseci(FILE *fp, struct obj_list *curr)
+static void write_dpio(struct dpl_emitter *emit, struct obj_fetch *rec)
 {
-	int error;
+	struct dpio_attr *dpio_attr = &rec->u.dpio;
+
+	dpl_emit_string(emit, "channel_mode", "%s",
+			dpio_attr->channel_mode == 0 ? "DPIO_NO_CHANNEL" :
+			dpio_attr->channel_mode == 1 ? "DPIO_LOCAL_CHANNEL" :
+			"wrong mode");
+	dpl_emit_cell(emit, "num_priorities", DPL_CELL_HEX,
+		      dpio_attr->num_priorities);
+}
+
+static int fetch_dpseci(struct dprc_worker *worker, struct obj_fetch *rec)
+{
+	struct obj_list *curr = rec->obj;
+	struct dpseci_attr *dpseci_attr = &rec->u.dpseci.attr;
+	struct dpseci_tx_queue_attr tx_attr;
 	uint16_t dpseci_handle;
 	bool dpseci_opened = false;
-	struct dpseci_attr dpseci_attr;
-	struct dpseci_tx_queue_attr tx_attr;
-	char *priorities;
+	int error;
 
-	error = dpseci_open(&restool.mc_io, 0, curr->id, &dpseci_handle);
+	error = dpseci_open(worker->mc_io, 0, curr->id, &dpseci_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpseci_opened = true;
@@ -1020,79 +900,92 @@ static int parse_dpseci(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 	memset(&tx_attr, 0, sizeof(tx_attr));
-	memset(&dpseci_attr, 0, sizeof(dpseci_attr));
+	memset(dpseci_attr, 0, sizeof(*dpseci_attr));
 
-	error = dpseci_get_attributes(&restool.mc_io, 0, dpseci_handle,
-					&dpseci_attr);
+	error = dpseci_get_attributes(worker->mc_io, 0, dpseci_handle,
+				      dpseci_attr);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 
-	priorities = malloc(dpseci_attr.num_tx_queues * sizeof(*priorities));
-	if (priorities == NULL) {
-		ERROR_PRINTF("malloc failed\n");
-		error = -errno;
-		goto out;
-	}
-
-	for (int i = 0; i < dpseci_attr.num_tx_queues; i++) {
-		error = dpseci_get_tx_queue(&restool.mc_io, 0, dpseci_handle,
+	for (int i = 0; i < dpseci_attr->num_tx_queues; i++) {
+		error = dpseci_get_tx_queue(worker->mc_io, 0, dpseci_handle,
 					    i, &tx_attr);
-
 		if (error < 0) {
-			mc_status = flib_error_to_mc_status(error);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			free(priorities);
+			print_mc_error(curr, error);
 			goto out;
 		}
 
-		priorities[i] = tx_attr.priority;
+		rec->u.dpseci.priorities[i] = tx_attr.priority;
 	}
-	fprintf(fp, "\t\t\tpriorities = <");
-	for (int i = 0; i < dpseci_attr.num_tx_queues-1; i++)
-		fprintf(fp, "%d ", priorities[i]);
-
-	fprintf(fp, "%d>;\n", priorities[dpseci_attr.num_tx_queues-1]);
-
-	free(priorities);
-
+	rec->fetched = true;
 
 out:
 	if (dpseci_opened) {
 		int error2;
 
-		error2 = dpseci_close(&restool.mc_io, 0, dpseci_handle);
+		error2 = dpseci_close(worker->mc_io, 0, dpseci_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
 	}
-	return 0;
+
+	return error;
+}
+
+static void write_dpseci(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	uint32_t priorities[UINT8_MAX + 1];
+	int num_tx_queues = rec->u.dpseci.attr.num_tx_queues;
+
+	for (int i = 0; i < num_tx_queues; i++)
+		priorities[i] = rec->u.dpseci.priorities[i];
+	dpl_emit_cells(emit, "priorities", DPL_CELL_DEC, priorities,
+		       num_tx_queues);
+}
+
+/**
+ * new_conn() - connection found while reading an object's attributes
+ * @rec: record of the object the connection was found on, gets it
+ *	appended to its @conns
+ *
+ * Returns the connection, with only @next set, or NULL
+ */
+static struct conn_list *new_conn(struct obj_fetch *rec)
+{
+	struct conn_list **tail = &rec->conns;
+	struct conn_list *conn;
+
+	conn = calloc(1, sizeof(*conn));
+	if (!conn) {
+		ERROR_PRINTF("calloc failed\n");
+		return NULL;
+	}
+
+	while (*tail)
+		tail = &(*tail)->next;
+	*tail = conn;
+
+	return conn;
 }
 
 /* following objects have possible connections*/
-static int parse_dpci(FILE *fp, struct obj_list *curr)
+static int fetch_dpci(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
+	struct dpci_attr *dpci_attr = &rec->u.dpci.attr;
+	struct dpci_peer_attr *dpci_peer_attr = &rec->u.dpci.peer;
 	uint16_t dpci_handle;
 	int error;
-	struct dpci_attr dpci_attr;
-	struct dpci_peer_attr dpci_peer_attr;
 	bool dpci_opened = false;
 	struct conn_list *curr_conn;
 
-
-	error = dpci_open(&restool.mc_io, 0, curr->id, &dpci_handle);
+	error = dpci_open(worker->mc_io, 0, curr->id, &dpci_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpci_opened = true;
@@ -1104,49 +997,37 @@ static int parse_dpci(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpci_attr, 0, sizeof(dpci_attr));
-	error = dpci_get_attributes(&restool.mc_io, 0, dpci_handle, &dpci_attr);
+	memset(dpci_attr, 0, sizeof(*dpci_attr));
+	error = dpci_get_attributes(worker->mc_io, 0, dpci_handle, dpci_attr);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpci_attr.id);
+	assert(curr->id == dpci_attr->id);
 
-	error = dpci_get_peer_attributes(&restool.mc_io, 0, dpci_handle,
-					 &dpci_peer_attr);
+	error = dpci_get_peer_attributes(worker->mc_io, 0, dpci_handle,
+					 dpci_peer_attr);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
+	rec->fetched = true;
 
-	fprintf(fp, "\t\t\tnum_of_priorities = <%#x>;\n",
-	       (unsigned int)dpci_attr.num_of_priorities);
-
-	if (-1 == dpci_peer_attr.peer_id) {
+	if (-1 == dpci_peer_attr->peer_id) {
 		DEBUG_PRINTF("no peer\n");
 	} else {
 		/* dpci has connection */
-		curr_conn = malloc(sizeof(struct conn_list));
+		curr_conn = new_conn(rec);
 		if (curr_conn == NULL) {
-			ERROR_PRINTF("malloc failed\n");
-			error = -errno;
+			error = -ENOMEM;
 			goto out;
 		}
-		curr_conn->next = NULL;
 		strcpy(curr_conn->type1, "dpci");
 		strcpy(curr_conn->type2, "dpci");
-		curr_conn->id1 = dpci_attr.id;
-		curr_conn->id2 = dpci_peer_attr.peer_id;
+		curr_conn->id1 = dpci_attr->id;
+		curr_conn->id2 = dpci_peer_attr->peer_id;
 		curr_conn->if_id1 = -1;	/* -1 means no interface */
 		curr_conn->if_id2 = -1;
-
-		error = compare_insert_connection(&conn_head, curr_conn);
-		if (error)
-			goto out;
 	}
 
 	error = 0;
@@ -1155,11 +1036,9 @@ out:
 	if (dpci_opened) {
 		int error2;
 
-		error2 = dpci_close(&restool.mc_io, 0, dpci_handle);
+		error2 = dpci_close(worker->mc_io, 0, dpci_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -1168,146 +1047,79 @@ out:
 	return error;
 }
 
-static int parse_dpmac(FILE *fp, struct obj_list *curr)
+static void write_dpci(struct dpl_emitter *emit, struct obj_fetch *rec)
 {
-	/* don't have anything in the dpl-example.dts */
-	(void)fp;
-	(void)curr;
-	return 0;
+	dpl_emit_cell(emit, "num_of_priorities", DPL_CELL_HEX,
+		      rec->u.dpci.attr.num_of_priorities);
 }
 
-static void parse_dpni_options(FILE *fp, uint32_t options)
+static void parse_dpni_options(struct dpl_emitter *emit, uint32_t options)
 {
-	char buf[500];
-	int len;
+	const char *opts[13];
+	int num_opts = 0;
 
 	if ((options & ~ALL_DPNI_OPTS) != 0)
-		fprintf(fp, "\t\t\t/* Unrecognized options found... */\n");
-
-	snprintf(buf, 14, "\t\t\toptions = ");
-
-	if (options & DPNI_OPT_ALLOW_DIST_KEY_PER_TC) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_ALLOW_DIST_KEY_PER_TC\", ");
-	}
-
-	if (options & DPNI_OPT_TX_CONF_DISABLED) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_TX_CONF_DISABLED\", ");
-	}
-
-	if (options & DPNI_OPT_PRIVATE_TX_CONF_ERROR_DISABLED) {
-		len = strlen(buf);
-		snprintf(buf+len, 50,
-			"\"DPNI_OPT_PRIVATE_TX_CONF_ERROR_DISABLED\", ");
-	}
-
-	if (options & DPNI_OPT_DIST_HASH) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_DIST_HASH\", ");
-	}
-
-	if (options & DPNI_OPT_DIST_FS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_DIST_FS\", ");
-	}
-
-	if (options & DPNI_OPT_UNICAST_FILTER) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_UNICAST_FILTER\", ");
-	}
-
-	if (options & DPNI_OPT_MULTICAST_FILTER) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_MULTICAST_FILTER\", ");
-	}
-
-	if (options & DPNI_OPT_VLAN_FILTER) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_VLAN_FILTER\", ");
-	}
-
-	if (options & DPNI_OPT_IPR) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_IPR\", ");
-	}
-
-	if (options & DPNI_OPT_IPF) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_IPF\", ");
-	}
-
-	if (options & DPNI_OPT_VLAN_MANIPULATION) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_VLAN_MANIPULATION\", ");
-	}
-
-	if (options & DPNI_OPT_QOS_MASK_SUPPORT) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_QOS_MASK_SUPPORT\", ");
-	}
-
-	if (options & DPNI_OPT_FS_MASK_SUPPORT) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_FS_MASK_SUPPORT\", ");
-	}
-
-	len = strlen(buf);
-	if (13 == len)
-		return;
-
-	buf[len-2] = ';';
-	buf[len-1] = '\0';
-
-	fprintf(fp, "%s\n", buf);
+		dpl_emit_comment(emit, "/* Unrecognized options found... */");
+
+	if (options & DPNI_OPT_ALLOW_DIST_KEY_PER_TC)
+		opts[num_opts++] = "DPNI_OPT_ALLOW_DIST_KEY_PER_TC";
+	if (options & DPNI_OPT_TX_CONF_DISABLED)
+		opts[num_opts++] = "DPNI_OPT_TX_CONF_DISABLED";
+	if (options & DPNI_OPT_PRIVATE_TX_CONF_ERROR_DISABLED)
+		opts[num_opts++] = "DPNI_OPT_PRIVATE_TX_CONF_ERROR_DISABLED";
+	if (options & DPNI_OPT_DIST_HASH)
+		opts[num_opts++] = "DPNI_OPT_DIST_HASH";
+	if (options & DPNI_OPT_DIST_FS)
+		opts[num_opts++] = "DPNI_OPT_DIST_FS";
+	if (options & DPNI_OPT_UNICAST_FILTER)
+		opts[num_opts++] = "DPNI_OPT_UNICAST_FILTER";
+	if (options & DPNI_OPT_MULTICAST_FILTER)
+		opts[num_opts++] = "DPNI_OPT_MULTICAST_FILTER";
+	if (options & DPNI_OPT_VLAN_FILTER)
+		opts[num_opts++] = "DPNI_OPT_VLAN_FILTER";
+	if (options & DPNI_OPT_IPR)
+		opts[num_opts++] = "DPNI_OPT_IPR";
+	if (options & DPNI_OPT_IPF)
+		opts[num_opts++] = "DPNI_OPT_IPF";
+	if (options & DPNI_OPT_VLAN_MANIPULATION)
+		opts[num_opts++] = "DPNI_OPT_VLAN_MANIPULATION";
+	if (options & DPNI_OPT_QOS_MASK_SUPPORT)
+		opts[num_opts++] = "DPNI_OPT_QOS_MASK_SUPPORT";
+	if (options & DPNI_OPT_FS_MASK_SUPPORT)
+		opts[num_opts++] = "DPNI_OPT_FS_MASK_SUPPORT";
+
+	if (num_opts)
+		dpl_emit_strings(emit, "options", opts, num_opts);
 }
 
-static void parse_dpni_options_v10(FILE *fp, uint32_t options)
+static void parse_dpni_options_v10(struct dpl_emitter *emit,
+				   uint32_t options)
 {
-	char buf[500];
-	int len;
+	const char *opts[5];
+	int num_opts = 0;
 
 	if ((options & ~ALL_DPNI_OPTS) != 0)
-		fprintf(fp, "\t\t\t/* Unrecognized options found... */\n");
-
-	snprintf(buf, 14, "\t\t\toptions = ");
-
-	if (options & DPNI_OPT_TX_FRM_RELEASE) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_TX_FRM_RELEASE\", ");
-	}
-
-	if (options & DPNI_OPT_HAS_POLICING) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_HAS_POLICING\", ");
-	}
-	if (options & DPNI_OPT_SHARED_CONGESTION) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_SHARED_CONGESTION\", ");
-	}
-
-	if (options & DPNI_OPT_HAS_KEY_MASKING) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_HAS_KEY_MASKING\", ");
-	}
-
-	if (options & DPNI_OPT_NO_FS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPNI_OPT_NO_FS\", ");
-	}
-
-	len = strlen(buf);
-	if (13 == len)
-		return;
-
-	buf[len-2] = ';';
-	buf[len-1] = '\0';
-
-	fprintf(fp, "%s\n", buf);
+		dpl_emit_comment(emit, "/* Unrecognized options found... */");
+
+	if (options & DPNI_OPT_TX_FRM_RELEASE)
+		opts[num_opts++] = "DPNI_OPT_TX_FRM_RELEASE";
+	if (options & DPNI_OPT_HAS_POLICING)
+		opts[num_opts++] = "DPNI_OPT_HAS_POLICING";
+	if (options & DPNI_OPT_SHARED_CONGESTION)
+		opts[num_opts++] = "DPNI_OPT_SHARED_CONGESTION";
+	if (options & DPNI_OPT_HAS_KEY_MASKING)
+		opts[num_opts++] = "DPNI_OPT_HAS_KEY_MASKING";
+	if (options & DPNI_OPT_NO_FS)
+		opts[num_opts++] = "DPNI_OPT_NO_FS";
+
+	if (num_opts)
+		dpl_emit_strings(emit, "options", opts, num_opts);
 }
 
-static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
+static int fetch_endpoints(struct dprc_worker *worker, struct obj_fetch *rec,
+			   uint16_t num_ifs)
 {
+	struct obj_list *curr_obj = rec->obj;
 	struct dprc_endpoint endpoint1;
 	struct dprc_endpoint endpoint2;
 	int state;
@@ -1328,8 +1140,8 @@ static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
 		endpoint1.id = curr_obj->id;
 		endpoint1.if_id = k;
 
-		error = dprc_get_connection(&restool.mc_io, 0,
-					restool.root_dprc_handle,
+		error = dprc_get_connection(worker->mc_io, 0,
+					worker->root_handle,
 					&endpoint1,
 					&endpoint2,
 					&state);
@@ -1345,13 +1157,9 @@ static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
 					k, endpoint2.type, endpoint2.id,
 					endpoint2.if_id);
 
-				curr_conn = malloc(sizeof(struct conn_list));
-				if (curr_conn == NULL) {
-					ERROR_PRINTF("malloc failed\n");
-					error = -errno;
-					return error;
-				}
-				curr_conn->next = NULL;
+				curr_conn = new_conn(rec);
+				if (curr_conn == NULL)
+					return -ENOMEM;
 				strncpy(curr_conn->type1, endpoint1.type,
 					EP_OBJ_TYPE_MAX_LEN);
 				strncpy(curr_conn->type2, endpoint2.type,
@@ -1360,29 +1168,20 @@ static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
 				curr_conn->type2[EP_OBJ_TYPE_MAX_LEN] = '\0';
 				curr_conn->id1 = endpoint1.id;
 				curr_conn->id2 = endpoint2.id;
-				if (strcmp(curr_obj->type, "dpni") == 0)
+				if (curr_obj->type_id == OBJ_TYPE_DPNI)
 					curr_conn->if_id1 = -1;
 					/* -1 means no interface */
 				else
 					curr_conn->if_id1 = endpoint1.if_id;
 
 				curr_conn->if_id2 = endpoint2.if_id;
-
-				error = compare_insert_connection(&conn_head,
-								  curr_conn);
-				if (error)
-					return error;
 			} else if (endpoint2.if_id == 0) {
 				DEBUG_PRINTF("\tinterface %d: %s.%d",
 					k, endpoint2.type, endpoint2.id);
 
-				curr_conn = malloc(sizeof(struct conn_list));
-				if (curr_conn == NULL) {
-					ERROR_PRINTF("malloc failed\n");
-					error = -errno;
-					return error;
-				}
-				curr_conn->next = NULL;
+				curr_conn = new_conn(rec);
+				if (curr_conn == NULL)
+					return -ENOMEM;
 				strncpy(curr_conn->type1, endpoint1.type,
 					EP_OBJ_TYPE_MAX_LEN);
 				strncpy(curr_conn->type2, endpoint2.type,
@@ -1391,18 +1190,13 @@ static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
 				curr_conn->type2[EP_OBJ_TYPE_MAX_LEN] = '\0';
 				curr_conn->id1 = endpoint1.id;
 				curr_conn->id2 = endpoint2.id;
-				if (strcmp(curr_obj->type, "dpni") == 0)
+				if (curr_obj->type_id == OBJ_TYPE_DPNI)
 					curr_conn->if_id1 = -1;
 					/* -1 means no interface */
 				else
 					curr_conn->if_id1 = endpoint1.if_id;
 
 				curr_conn->if_id2 = -1;
-
-				error = compare_insert_connection(&conn_head,
-								  curr_conn);
-				if (error)
-					return error;
 			}
 
 			if (state == 1)
@@ -1413,36 +1207,32 @@ static int parse_endpoint_dpl(struct obj_list *curr_obj, uint16_t num_ifs)
 				DEBUG_PRINTF(", link is in error state\n");
 
 		} else {
-			mc_status = flib_error_to_mc_status(error);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr_obj, error);
 			return error;
 		}
 
-		if (strcmp(curr_obj->type, "dpni") == 0)
+		if (curr_obj->type_id == OBJ_TYPE_DPNI)
 			break;
 	}
 
 	return 0;
 }
 
-static int parse_dpni_v9(FILE *fp, struct obj_list *curr)
+static int fetch_dpni_v9(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
+	struct dpni_attr_v9 *dpni_attr = &rec->u.dpni_v9.attr;
+	struct dpni_extended_cfg *dpni_extended_cfg = &rec->u.dpni_v9.ext;
 	uint16_t dpni_handle;
 	int error;
-	struct dpni_attr_v9 dpni_attr;
-	uint8_t mac_addr[6];
 	bool dpni_opened = false;
-	struct dpni_extended_cfg dpni_extended_cfg;
 
-	memset(&dpni_extended_cfg, 0, sizeof(dpni_extended_cfg));
-	memset(&dpni_attr, 0, sizeof(dpni_attr));
+	memset(dpni_extended_cfg, 0, sizeof(*dpni_extended_cfg));
+	memset(dpni_attr, 0, sizeof(*dpni_attr));
 
-	error = dpni_open(&restool.mc_io, 0, curr->id, &dpni_handle);
+	error = dpni_open(worker->mc_io, 0, curr->id, &dpni_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpni_opened = true;
@@ -1454,96 +1244,25 @@ static int parse_dpni_v9(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	error = dpni_get_attributes_v9(&restool.mc_io, 0, dpni_handle,
-				       &dpni_attr, &dpni_extended_cfg);
-
+	error = dpni_get_attributes_v9(worker->mc_io, 0, dpni_handle,
+				       dpni_attr, dpni_extended_cfg);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 
-	assert(curr->id == dpni_attr.id);
-	assert(DPNI_MAX_TC >= dpni_attr.max_tcs);
+	assert(curr->id == dpni_attr->id);
+	assert(DPNI_MAX_TC >= dpni_attr->max_tcs);
 
-	error = dpni_get_primary_mac_addr(&restool.mc_io, 0,
-					dpni_handle, mac_addr);
+	error = dpni_get_primary_mac_addr(worker->mc_io, 0, dpni_handle,
+					  rec->u.dpni_v9.mac_addr);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
+	rec->fetched = true;
 
-	parse_endpoint_dpl(curr, 1000);
-
-	fprintf(fp, "\t\t\tmac_addr = <");
-	for (int j = 0; j < 5; ++j)
-		fprintf(fp, "%#02x ", mac_addr[j]);
-	fprintf(fp, "%#02x>;\n", mac_addr[5]);
-
-	fprintf(fp, "\t\t\tmax_senders = <%#x>;\n",
-		(uint32_t)dpni_attr.max_senders);
-
-	parse_dpni_options(fp, dpni_attr.options);
-
-	fprintf(fp, "\t\t\tmax_tcs = <%#x>;\n", (uint32_t)dpni_attr.max_tcs);
-
-	fprintf(fp, "\t\t\tmax_dist_per_tc = <");
-	for (int k = 0; k < dpni_attr.max_tcs - 1; ++k)
-		fprintf(fp, "%#x ",
-			(uint32_t)dpni_extended_cfg.tc_cfg[k].max_dist);
-	fprintf(fp, "%#x>;\n",
-		(uint32_t)dpni_extended_cfg.
-		tc_cfg[dpni_attr.max_tcs].max_dist);
-
-	fprintf(fp, "\t\t\tmax_fs_entries = <");
-	for (int m = 0; m < dpni_attr.max_tcs - 1; ++m)
-		fprintf(fp, "%#x",
-			(uint32_t)dpni_extended_cfg.tc_cfg[m].max_fs_entries);
-	fprintf(fp, "%#x>;\n",
-		(uint32_t)dpni_extended_cfg.
-		tc_cfg[dpni_attr.max_tcs].max_fs_entries);
-
-	fprintf(fp, "\t\t\tmax_unicast_filters = <%#x>;\n",
-	       (uint32_t)dpni_attr.max_unicast_filters);
-
-	fprintf(fp, "\t\t\tmax_multicast_filters = <%#x>;\n",
-	       (uint32_t)dpni_attr.max_multicast_filters);
-
-	fprintf(fp, "\t\t\tmax_vlan_filters = <%#x>;\n",
-		(uint32_t)dpni_attr.max_vlan_filters);
-
-	fprintf(fp, "\t\t\tmax_qos_entries = <%#x>;\n",
-		(uint32_t)dpni_attr.max_qos_entries);
-
-	fprintf(fp, "\t\t\tmax_qos_key_size = <%#x>;\n",
-		(uint32_t)dpni_attr.max_qos_key_size);
-
-	fprintf(fp, "\t\t\tmax_dist_key_size = <%#x>;\n",
-	       (uint32_t)dpni_attr.max_dist_key_size);
-
-	fprintf(fp, "\t\t\tmax_policers = <%#x>;\n",
-		(uint32_t)dpni_attr.max_policers);
-
-	fprintf(fp, "\t\t\tmax_congestion_ctrl = <%#x>;\n",
-		(uint32_t)dpni_attr.max_congestion_ctrl);
-
-	fprintf(fp, "\t\t\tmax_reass_frm_size = <%#x>;\n",
-		(uint32_t)dpni_extended_cfg.ipr_cfg.max_reass_frm_size);
-
-	fprintf(fp, "\t\t\tmin_frag_size_ipv4 = <%#x>;\n",
-		(uint32_t)dpni_extended_cfg.ipr_cfg.min_frag_size_ipv4);
-
-	fprintf(fp, "\t\t\tmin_frag_size_ipv6 = <%#x>;\n",
-		(uint32_t)dpni_extended_cfg.ipr_cfg.min_frag_size_ipv6);
-
-	fprintf(fp, "\t\t\tmax_open_frames_ipv4 = <%#x>;\n",
-		(uint32_t)dpni_extended_cfg.ipr_cfg.max_open_frames_ipv4);
-
-	fprintf(fp, "\t\t\tmax_open_frames_ipv6 = <%#x>;\n",
-		(uint32_t)dpni_extended_cfg.ipr_cfg.max_open_frames_ipv6);
+	fetch_endpoints(worker, rec, 1000);
 
 	error = 0;
 
@@ -1551,11 +1270,9 @@ out:
 	if (dpni_opened) {
 		int error2;
 
-		error2 = dpni_close(&restool.mc_io, 0, dpni_handle);
+		error2 = dpni_close(worker->mc_io, 0, dpni_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -1564,19 +1281,73 @@ out:
 	return error;
 }
 
-static int parse_dpni_v10(FILE *fp, struct obj_list *curr)
+static void write_dpni_v9(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	struct dpni_attr_v9 *dpni_attr = &rec->u.dpni_v9.attr;
+	struct dpni_extended_cfg *dpni_extended_cfg = &rec->u.dpni_v9.ext;
+	uint32_t mac_cells[6];
+	uint32_t cells[DPNI_MAX_TC];
+
+	for (int j = 0; j < 6; ++j)
+		mac_cells[j] = rec->u.dpni_v9.mac_addr[j];
+	dpl_emit_cells(emit, "mac_addr", DPL_CELL_BYTE, mac_cells, 6);
+
+	dpl_emit_cell(emit, "max_senders", DPL_CELL_HEX,
+		      dpni_attr->max_senders);
+
+	parse_dpni_options(emit, dpni_attr->options);
+
+	dpl_emit_cell(emit, "max_tcs", DPL_CELL_HEX, dpni_attr->max_tcs);
+
+	for (int k = 0; k < dpni_attr->max_tcs; ++k)
+		cells[k] = dpni_extended_cfg->tc_cfg[k].max_dist;
+	dpl_emit_cells(emit, "max_dist_per_tc", DPL_CELL_HEX, cells,
+		       dpni_attr->max_tcs);
+
+	for (int m = 0; m < dpni_attr->max_tcs; ++m)
+		cells[m] = dpni_extended_cfg->tc_cfg[m].max_fs_entries;
+	dpl_emit_cells(emit, "max_fs_entries", DPL_CELL_HEX, cells,
+		       dpni_attr->max_tcs);
+
+	dpl_emit_cell(emit, "max_unicast_filters", DPL_CELL_HEX,
+		      dpni_attr->max_unicast_filters);
+	dpl_emit_cell(emit, "max_multicast_filters", DPL_CELL_HEX,
+		      dpni_attr->max_multicast_filters);
+	dpl_emit_cell(emit, "max_vlan_filters", DPL_CELL_HEX,
+		      dpni_attr->max_vlan_filters);
+	dpl_emit_cell(emit, "max_qos_entries", DPL_CELL_HEX,
+		      dpni_attr->max_qos_entries);
+	dpl_emit_cell(emit, "max_qos_key_size", DPL_CELL_HEX,
+		      dpni_attr->max_qos_key_size);
+	dpl_emit_cell(emit, "max_dist_key_size", DPL_CELL_HEX,
+		      dpni_attr->max_dist_key_size);
+	dpl_emit_cell(emit, "max_policers", DPL_CELL_HEX,
+		      dpni_attr->max_policers);
+	dpl_emit_cell(emit, "max_congestion_ctrl", DPL_CELL_HEX,
+		      dpni_attr->max_congestion_ctrl);
+	dpl_emit_cell(emit, "max_reass_frm_size", DPL_CELL_HEX,
+		      dpni_extended_cfg->ipr_cfg.max_reass_frm_size);
+	dpl_emit_cell(emit, "min_frag_size_ipv4", DPL_CELL_HEX,
+		      dpni_extended_cfg->ipr_cfg.min_frag_size_ipv4);
+	dpl_emit_cell(emit, "min_frag_size_ipv6", DPL_CELL_HEX,
+		      dpni_extended_cfg->ipr_cfg.min_frag_size_ipv6);
+	dpl_emit_cell(emit, "max_open_frames_ipv4", DPL_CELL_HEX,
+		      dpni_extended_cfg->ipr_cfg.max_open_frames_ipv4);
+	dpl_emit_cell(emit, "max_open_frames_ipv6", DPL_CELL_HEX,
+		      dpni_extended_cfg->ipr_cfg.max_open_frames_ipv6);
+}
+
+static int fetch_dpni_v10(struct dprc_worker *worker, struct obj_fetch *rec)
 {
-	struct dpni_attr_v10 dpni_attr;
+	struct obj_list *curr = rec->obj;
 	uint16_t dpni_handle;
 	bool dpni_opened = false;
 	int error = 0;
 	int error2;
 
-	error = dpni_open(&restool.mc_io, 0, curr->id, &dpni_handle);
+	error = dpni_open(worker->mc_io, 0, curr->id, &dpni_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpni_opened = true;
@@ -1588,37 +1359,23 @@ static int parse_dpni_v10(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpni_attr, 0, sizeof(dpni_attr));
-	error = dpni_get_attributes_v10(&restool.mc_io, 0,
-					dpni_handle, &dpni_attr);
+	memset(&rec->u.dpni_v10, 0, sizeof(rec->u.dpni_v10));
+	error = dpni_get_attributes_v10(worker->mc_io, 0,
+					dpni_handle, &rec->u.dpni_v10);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
+	rec->fetched = true;
 
-	parse_endpoint_dpl(curr, 1000);
-
-	fprintf(fp, "\t\t\ttype = \"DPNI_TYPE_NIC\";\n");
-
-	parse_dpni_options_v10(fp, dpni_attr.options);
-
-	fprintf(fp, "\t\t\tnum_queues = <%u>;\n", dpni_attr.num_queues);
-	fprintf(fp, "\t\t\tnum_tcs = <%u>;\n", dpni_attr.num_rx_tcs);
-	fprintf(fp, "\t\t\tmac_filter_entries = <%u>;\n", dpni_attr.mac_filter_entries);
-	fprintf(fp, "\t\t\tvlan_filter_entries = <%u>;\n", dpni_attr.vlan_filter_entries);
-	fprintf(fp, "\t\t\tfs_entries = <%u>;\n", dpni_attr.fs_entries);
-	fprintf(fp, "\t\t\tqos_entries = <%u>;\n", dpni_attr.qos_entries);
+	fetch_endpoints(worker, rec, 1000);
 
 out:
 	if (dpni_opened) {
 
-		error2 = dpni_close(&restool.mc_io, 0, dpni_handle);
+		error2 = dpni_close(worker->mc_io, 0, dpni_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -1627,54 +1384,63 @@ out:
 	return error;
 }
 
-static void parse_dpdmux_options(FILE *fp, uint64_t options)
+static void write_dpni_v10(struct dpl_emitter *emit, struct obj_fetch *rec)
 {
-	char buf[100];
-	int len;
-
-	if ((options & ~ALL_DPDMUX_OPTS) != 0)
-		fprintf(fp, "\t\t\t/* Unrecognized options found... */\n");
-
-	snprintf(buf, 14, "\t\t\toptions = ");
+	struct dpni_attr_v10 *dpni_attr = &rec->u.dpni_v10;
+
+	dpl_emit_string(emit, "type", "DPNI_TYPE_NIC");
+
+	parse_dpni_options_v10(emit, dpni_attr->options);
+
+	dpl_emit_cell(emit, "num_queues", DPL_CELL_DEC,
+		      dpni_attr->num_queues);
+	dpl_emit_cell(emit, "num_tcs", DPL_CELL_DEC, dpni_attr->num_rx_tcs);
+	dpl_emit_cell(emit, "mac_filter_entries", DPL_CELL_DEC,
+		      dpni_attr->mac_filter_entries);
+	dpl_emit_cell(emit, "vlan_filter_entries", DPL_CELL_DEC,
+		      dpni_attr->vlan_filter_entries);
+	dpl_emit_cell(emit, "fs_entries", DPL_CELL_DEC,
+		      dpni_attr->fs_entries);
+	dpl_emit_cell(emit, "qos_entries", DPL_CELL_DEC,
+		      dpni_attr->qos_entries);
+}
 
-	if (options & DPDMUX_OPT_BRIDGE_EN) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPDMUX_OPT_BRIDGE_EN\", ");
-	}
+static void parse_dpdmux_options(struct dpl_emitter *emit, uint64_t options)
+{
+	const char *opts[2];
+	int num_opts = 0;
 
-	if (options & DPDMUX_OPT_CLS_MASK_SUPPORT) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPDMUX_OPT_CLS_MASK_SUPPORT\", ");
-	}
+	if ((options & ~ALL_DPDMUX_OPTS) != 0)
+		dpl_emit_comment(emit, "/* Unrecognized options found... */");
 
-	len = strlen(buf);
-	if (13 == len)
-		return;
-	buf[len-2] = ';';
-	buf[len-1] = '\0';
+	if (options & DPDMUX_OPT_BRIDGE_EN)
+		opts[num_opts++] = "DPDMUX_OPT_BRIDGE_EN";
+	if (options & DPDMUX_OPT_CLS_MASK_SUPPORT)
+		opts[num_opts++] = "DPDMUX_OPT_CLS_MASK_SUPPORT";
 
-	fprintf(fp, "%s\n", buf);
+	if (num_opts)
+		dpl_emit_strings(emit, "options", opts, num_opts);
 }
 
-static void parse_dpdmux_method(FILE *fp, enum dpdmux_method method)
+static void parse_dpdmux_method(struct dpl_emitter *emit,
+				enum dpdmux_method method)
 {
-	fprintf(fp, "\t\t\tmethod = ");
 	switch (method) {
 	case DPDMUX_METHOD_NONE:
-		fprintf(fp, "\"DPDMUX_METHOD_NONE\";\n");
+		dpl_emit_string(emit, "method", "DPDMUX_METHOD_NONE");
 		break;
 	case DPDMUX_METHOD_C_VLAN_MAC:
-		fprintf(fp, "\"DPDMUX_METHOD_C_VLAN_MAC\";\n");
+		dpl_emit_string(emit, "method", "DPDMUX_METHOD_C_VLAN_MAC");
 		break;
 	case DPDMUX_METHOD_MAC:
-		fprintf(fp, "\"DPDMUX_METHOD_MAC\";\n");
+		dpl_emit_string(emit, "method", "DPDMUX_METHOD_MAC");
 		break;
 	case DPDMUX_METHOD_C_VLAN:
-		fprintf(fp, "\"DPDMUX_METHOD_C_VLAN\";\n");
+		dpl_emit_string(emit, "method", "DPDMUX_METHOD_C_VLAN");
 		break;
 #if 0 /* TODO: Enable when MC support added */
 	case DPDMUX_METHOD_S_VLAN:
-		fprintf(fp, "DPDMUX_METHOD_S_VLAN\n");
+		dpl_emit_string(emit, "method", "DPDMUX_METHOD_S_VLAN");
 		break;
 #endif
 	default:
@@ -1683,16 +1449,17 @@ static void parse_dpdmux_method(FILE *fp, enum dpdmux_method method)
 	}
 }
 
-static void parse_dpdmux_manip(FILE *fp, enum dpdmux_manip manip)
+static void parse_dpdmux_manip(struct dpl_emitter *emit,
+			       enum dpdmux_manip manip)
 {
-	fprintf(fp, "\t\t\tmanip = ");
 	switch (manip) {
 	case DPDMUX_MANIP_NONE:
-		fprintf(fp, "\"DPDMUX_MANIP_NONE\";\n");
+		dpl_emit_string(emit, "manip", "DPDMUX_MANIP_NONE");
 		break;
 #if 0 /* TODO: Enable when MC support added */
 	case DPDMUX_MANIP_ADD_REMOVE_S_VLAN:
-		fprintf(fp, "DPDMUX_MANIP_ADD_REMOVE_S_VLAN\n");
+		dpl_emit_string(emit, "manip",
+				"DPDMUX_MANIP_ADD_REMOVE_S_VLAN");
 		break;
 #endif
 	default:
@@ -1701,18 +1468,16 @@ static void parse_dpdmux_manip(FILE *fp, enum dpdmux_manip manip)
 	}
 }
 
-static int parse_dpdmux_v9(FILE *fp, struct obj_list *curr)
+static int fetch_dpdmux_v9(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
 	uint16_t dpdmux_handle;
 	int error;
-	struct dpdmux_attr_v9 dpdmux_attr;
 	bool dpdmux_opened = false;
 
-	error = dpdmux_open(&restool.mc_io, 0, curr->id, &dpdmux_handle);
+	error = dpdmux_open(worker->mc_io, 0, curr->id, &dpdmux_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpdmux_opened = true;
@@ -1724,23 +1489,17 @@ static int parse_dpdmux_v9(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpdmux_attr, 0, sizeof(dpdmux_attr));
-	error = dpdmux_get_attributes_v9(&restool.mc_io, 0, dpdmux_handle,
-					&dpdmux_attr);
+	memset(&rec->u.dpdmux, 0, sizeof(rec->u.dpdmux));
+	error = dpdmux_get_attributes_v9(worker->mc_io, 0, dpdmux_handle,
+					 &rec->u.dpdmux);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpdmux_attr.id);
+	assert(curr->id == rec->u.dpdmux.id);
+	rec->fetched = true;
 
-	parse_endpoint_dpl(curr, dpdmux_attr.num_ifs + 1);
-	parse_dpdmux_options(fp, dpdmux_attr.options);
-	parse_dpdmux_method(fp, dpdmux_attr.method);
-	parse_dpdmux_manip(fp, dpdmux_attr.manip);
-	fprintf(fp, "\t\t\tnum_ifs = <%#x>;\n",
-		(uint32_t)dpdmux_attr.num_ifs + 1);
+	fetch_endpoints(worker, rec, rec->u.dpdmux.num_ifs + 1);
 
 	error = 0;
 
@@ -1748,77 +1507,60 @@ out:
 	if (dpdmux_opened) {
 		int error2;
 
-		error2 = dpdmux_close(&restool.mc_io, 0, dpdmux_handle);
+		error2 = dpdmux_close(worker->mc_io, 0, dpdmux_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
 	}
 
 	return error;
-
 }
 
-static void parse_dpsw_options(FILE *fp, uint64_t options)
+static void write_dpdmux_v9(struct dpl_emitter *emit, struct obj_fetch *rec)
 {
-	char buf[300];
-	int len;
+	struct dpdmux_attr_v9 *dpdmux_attr = &rec->u.dpdmux;
 
-	if ((options & ~ALL_DPSW_OPTS) != 0)
-		fprintf(fp, "\t\t\t/* Unrecognized options found... */\n");
-
-	snprintf(buf, 14, "\t\t\toptions = ");
-
-	if (options & DPSW_OPT_FLOODING_DIS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPSW_OPT_FLOODING_DIS\", ");
-	}
-
-	if (options & DPSW_OPT_MULTICAST_DIS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPSW_OPT_MULTICAST_DIS\", ");
-	}
-
-	if (options & DPSW_OPT_CTRL_IF_DIS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPSW_OPT_CTRL_IF_DIS\", ");
-	}
-
-	if (options & DPSW_OPT_FLOODING_METERING_DIS) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPSW_OPT_FLOODING_METERING_DIS\", ");
-	}
-
-	if (options & DPSW_OPT_METERING_EN) {
-		len = strlen(buf);
-		snprintf(buf+len, 50, "\"DPSW_OPT_METERING_EN\", ");
-	}
-
-	len = strlen(buf);
-	if (13 == len)
-		return;
-	buf[len-2] = ';';
-	buf[len-1] = '\0';
+	parse_dpdmux_options(emit, dpdmux_attr->options);
+	parse_dpdmux_method(emit, dpdmux_attr->method);
+	parse_dpdmux_manip(emit, dpdmux_attr->manip);
+	dpl_emit_cell(emit, "num_ifs", DPL_CELL_HEX, dpdmux_attr->num_ifs + 1);
+}
 
-	fprintf(fp, "%s\n", buf);
+static void parse_dpsw_options(struct dpl_emitter *emit, uint64_t options)
+{
+	const char *opts[5];
+	int num_opts = 0;
 
+	if ((options & ~ALL_DPSW_OPTS) != 0)
+		dpl_emit_comment(emit, "/* Unrecognized options found... */");
+
+	if (options & DPSW_OPT_FLOODING_DIS)
+		opts[num_opts++] = "DPSW_OPT_FLOODING_DIS";
+	if (options & DPSW_OPT_MULTICAST_DIS)
+		opts[num_opts++] = "DPSW_OPT_MULTICAST_DIS";
+	if (options & DPSW_OPT_CTRL_IF_DIS)
+		opts[num_opts++] = "DPSW_OPT_CTRL_IF_DIS";
+	if (options & DPSW_OPT_FLOODING_METERING_DIS)
+		opts[num_opts++] = "DPSW_OPT_FLOODING_METERING_DIS";
+	if (options & DPSW_OPT_METERING_EN)
+		opts[num_opts++] = "DPSW_OPT_METERING_EN";
+
+	if (num_opts)
+		dpl_emit_strings(emit, "options", opts, num_opts);
 }
 
-static int parse_dpsw_v9(FILE *fp, struct obj_list *curr)
+static int fetch_dpsw_v9(struct dprc_worker *worker, struct obj_fetch *rec)
 {
+	struct obj_list *curr = rec->obj;
 	uint16_t dpsw_handle;
 	int error;
-	struct dpsw_attr_v9 dpsw_attr;
 	bool dpsw_opened = false;
 
-	error = dpsw_open(&restool.mc_io, 0, curr->id, &dpsw_handle);
+	error = dpsw_open(worker->mc_io, 0, curr->id, &dpsw_handle);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
 	dpsw_opened = true;
@@ -1830,34 +1572,17 @@ static int parse_dpsw_v9(FILE *fp, struct obj_list *curr)
 		goto out;
 	}
 
-	memset(&dpsw_attr, 0, sizeof(dpsw_attr));
-	error = dpsw_get_attributes_v9(&restool.mc_io, 0, dpsw_handle,
-				       &dpsw_attr);
+	memset(&rec->u.dpsw, 0, sizeof(rec->u.dpsw));
+	error = dpsw_get_attributes_v9(worker->mc_io, 0, dpsw_handle,
+				       &rec->u.dpsw);
 	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			     mc_status_to_string(mc_status), mc_status);
+		print_mc_error(curr, error);
 		goto out;
 	}
-	assert(curr->id == dpsw_attr.id);
+	assert(curr->id == rec->u.dpsw.id);
+	rec->fetched = true;
 
-	parse_endpoint_dpl(curr, dpsw_attr.num_ifs);
-	parse_dpsw_options(fp, dpsw_attr.options);
-	fprintf(fp, "\t\t\tmax_vlans = <%#x>;\n",
-		(uint32_t)dpsw_attr.max_vlans);
-	fprintf(fp, "\t\t\tmax_fdbs = <%#x>;\n", (uint32_t)dpsw_attr.max_fdbs);
-	/* it should be num_fdb_entries,
-	 * but dpsw_attr {} call it max_fdb_entries (typo)
-	 */
-	fprintf(fp, "\t\t\tnum_fdb_entries = <%#x>;\n",
-		(uint32_t)dpsw_attr.max_fdb_entries);
-	fprintf(fp, "\t\t\tfdb_aging_time = <%#x>;\n",
-		(uint32_t)dpsw_attr.fdb_aging_time);
-	fprintf(fp, "\t\t\tnum_ifs = <%#x>;\n", (uint32_t)dpsw_attr.num_ifs);
-	fprintf(fp, "\t\t\tmax_fdb_mc_groups = <%#x>;\n",
-		(uint32_t)dpsw_attr.max_fdb_mc_groups);
-	fprintf(fp, "\t\t\tmax_meters_per_if = <%#x>;\n",
-		(uint32_t)dpsw_attr.max_meters_per_if);
+	fetch_endpoints(worker, rec, rec->u.dpsw.num_ifs);
 
 	error = 0;
 
@@ -1865,11 +1590,9 @@ out:
 	if (dpsw_opened) {
 		int error2;
 
-		error2 = dpsw_close(&restool.mc_io, 0, dpsw_handle);
+		error2 = dpsw_close(worker->mc_io, 0, dpsw_handle);
 		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
+			print_mc_error(curr, error2);
 			if (error == 0)
 				error = error2;
 		}
@@ -1878,96 +1601,236 @@ out:
 	return error;
 }
 
+static void write_dpsw_v9(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	struct dpsw_attr_v9 *dpsw_attr = &rec->u.dpsw;
+
+	parse_dpsw_options(emit, dpsw_attr->options);
+	dpl_emit_cell(emit, "max_vlans", DPL_CELL_HEX, dpsw_attr->max_vlans);
+	dpl_emit_cell(emit, "max_fdbs", DPL_CELL_HEX, dpsw_attr->max_fdbs);
+	/* it should be num_fdb_entries,
+	 * but dpsw_attr {} call it max_fdb_entries (typo)
+	 */
+	dpl_emit_cell(emit, "num_fdb_entries", DPL_CELL_HEX,
+		      dpsw_attr->max_fdb_entries);
+	dpl_emit_cell(emit, "fdb_aging_time", DPL_CELL_HEX,
+		      dpsw_attr->fdb_aging_time);
+	dpl_emit_cell(emit, "num_ifs", DPL_CELL_HEX, dpsw_attr->num_ifs);
+	dpl_emit_cell(emit, "max_fdb_mc_groups", DPL_CELL_HEX,
+		      dpsw_attr->max_fdb_mc_groups);
+	dpl_emit_cell(emit, "max_meters_per_if", DPL_CELL_HEX,
+		      dpsw_attr->max_meters_per_if);
+}
+
+/*
+ * dpbp, dpdbg, dpmcp, dprc, dprtc and dpmac have nothing to read yet;
+ * dpaiop_attr{} does not have a field called aiop_container_id. The
+ * following objects have possible connections and interfaces: dpci,
+ * dpni, dpdmux and dpsw.
+ */
+typedef int dpl_fetch_t(struct dprc_worker *worker, struct obj_fetch *rec);
+typedef void dpl_write_t(struct dpl_emitter *emit, struct obj_fetch *rec);
+
+/**
+ * struct dpl_type_ops - how the attributes of one object type get into
+ *	the DPL
+ * @fetch: reads the attributes from the MC, on a fetch worker's portal
+ * @write: formats what @fetch read, NULL where @fetch is
+ */
+struct dpl_type_ops {
+	dpl_fetch_t *fetch;
+	dpl_write_t *write;
+};
+
+static const struct dpl_type_ops dpl_type_ops_v9[NUM_OBJ_TYPES] = {
+	[OBJ_TYPE_DPCON] = { fetch_dpcon, write_dpcon },
+	[OBJ_TYPE_DPDCEI] = { fetch_dpdcei, write_dpdcei },
+	[OBJ_TYPE_DPDMAI] = { fetch_dpdmai, write_dpdmai },
+	[OBJ_TYPE_DPIO] = { fetch_dpio, write_dpio },
+	[OBJ_TYPE_DPSECI] = { fetch_dpseci, write_dpseci },
+	[OBJ_TYPE_DPCI] = { fetch_dpci, write_dpci },
+	[OBJ_TYPE_DPNI] = { fetch_dpni_v9, write_dpni_v9 },
+	[OBJ_TYPE_DPDMUX] = { fetch_dpdmux_v9, write_dpdmux_v9 },
+	[OBJ_TYPE_DPSW] = { fetch_dpsw_v9, write_dpsw_v9 },
+};
+
+static const struct dpl_type_ops dpl_type_ops_v10[NUM_OBJ_TYPES] = {
+	[OBJ_TYPE_DPCON] = { fetch_dpcon, write_dpcon },
+	[OBJ_TYPE_DPDCEI] = { fetch_dpdcei, write_dpdcei },
+	[OBJ_TYPE_DPDMAI] = { fetch_dpdmai, write_dpdmai },
+	[OBJ_TYPE_DPIO] = { fetch_dpio, write_dpio },
+	[OBJ_TYPE_DPSECI] = { fetch_dpseci, write_dpseci },
+	[OBJ_TYPE_DPCI] = { fetch_dpci, write_dpci },
+	[OBJ_TYPE_DPNI] = { fetch_dpni_v10, write_dpni_v10 },
+	[OBJ_TYPE_DPDMUX] = { fetch_dpdmux_v9, write_dpdmux_v9 },
+	[OBJ_TYPE_DPSW] = { fetch_dpsw_v9, write_dpsw_v9 },
+};
+
+static const struct dpl_type_ops *find_dpl_type_ops(enum obj_type type)
+{
+	static const struct dpl_type_ops none;
+	const struct dpl_type_ops *table;
+
+	if (type == OBJ_TYPE_INVALID)
+		return &none;
+
+	if (restool.mc_fw_version.major == 9)
+		table = dpl_type_ops_v9;
+	else
+		table = dpl_type_ops_v10;
+
+	return &table[type];
+}
+
+static int fetch_obj(struct dprc_worker *worker, struct obj_fetch *rec)
+{
+	const struct dpl_type_ops *ops = find_dpl_type_ops(rec->obj->type_id);
+
+	if (!ops->fetch)
+		return 0;
+
+	return ops->fetch(worker, rec);
+}
+
+static void write_obj_attrs(struct dpl_emitter *emit, struct obj_fetch *rec)
+{
+	const struct dpl_type_ops *ops = find_dpl_type_ops(rec->obj->type_id);
+
+	if (!rec->fetched || !ops->write)
+		return;
+
+	ops->write(emit, rec);
+}
+
+/*
+ * Fetches records from the shared context until all are taken. Any
+ * number of workers may run this concurrently, each one through its own
+ * portal. Read errors only leave a record without attributes, as they
+ * did when objects were read one by one while writing.
+ */
+static void *fetch_worker_run(void *arg)
+{
+	struct dprc_worker *worker = arg;
+	struct fetch_ctx *ctx = worker->ctx;
+
+	pthread_mutex_lock(&ctx->lock);
+	while (ctx->next < ctx->num_recs) {
+		struct obj_fetch *rec = &ctx->recs[ctx->next++];
+
+		pthread_mutex_unlock(&ctx->lock);
+		(void)fetch_obj(worker, rec);
+		pthread_mutex_lock(&ctx->lock);
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
+	return NULL;
+}
+
+/**
+ * fetch_all_objs() - read the attributes of all objects in obj_head
+ * @recs: one record per object, @obj set
+ * @num_recs: number of entries in @recs
+ *
+ * Reading is the slow part of generating a DPL: each object costs an
+ * open, one or more attribute reads, a connection lookup per interface
+ * and a close, all round trips to the MC. With --portals=N the records
+ * are spread over up to N portal sessions, one thread each, so that
+ * many objects are in flight at once.
+ */
+static void fetch_all_objs(struct obj_fetch *recs, int num_recs)
+{
+	struct dprc_worker workers[MAX_WALK_PORTALS];
+	struct fetch_ctx ctx;
+	int num_workers;
+
+	memset(&ctx, 0, sizeof(ctx));
+	pthread_mutex_init(&ctx.lock, NULL);
+	ctx.recs = recs;
+	ctx.num_recs = num_recs;
+
+	num_workers = dprc_workers_open(workers, num_recs, &ctx);
+	dprc_workers_run(workers, num_workers, fetch_worker_run);
+	dprc_workers_close(workers, num_workers);
+
+	pthread_mutex_destroy(&ctx.lock);
+}
+
+/**
+ * add_conns() - move the connections found on an object to conn_head
+ * @rec: the object's record
+ *
+ * Records are added in object order, so the connection list comes out
+ * the same however the fetch was spread over portals.
+ */
+static void add_conns(struct obj_fetch *rec)
+{
+	struct conn_list *conn = rec->conns;
+
+	while (conn) {
+		struct conn_list *next = conn->next;
+
+		conn->next = NULL;
+		if (compare_insert_connection(&conn_head, conn) != 0)
+			free(conn);
+		conn = next;
+	}
+	rec->conns = NULL;
+}
+
 static int write_objects(void)
 {
+	struct dpl_emitter *emit = dpl_emit;
+	struct obj_fetch *recs;
 	struct obj_list *curr_obj;
-	FILE *fp = stdout;
+	int num_recs = 0;
+	int i;
 
-	fprintf(fp, "\n");
-	fprintf(fp,
-		"\t/*****************************************************************\n");
-	fprintf(fp, "\t * Objects\n");
-	fprintf(fp,
-		"\t *****************************************************************/\n");
+	/* fetch: the attributes of every object, before writing any */
+	for (curr_obj = obj_head; curr_obj; curr_obj = curr_obj->next) {
+		if (curr_obj->type_id == OBJ_TYPE_DPMCP && 0 == curr_obj->id)
+			continue;
+		num_recs++;
+	}
 
+	recs = calloc(num_recs ? num_recs : 1, sizeof(*recs));
+	if (!recs) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
 
-	fprintf(fp, "\tobjects {\n");
-	curr_obj = obj_head;
-	while (curr_obj) {
-		if (strcmp(curr_obj->type, "dpmcp") == 0 && 0 == curr_obj->id) {
-			curr_obj = curr_obj->next;
+	i = 0;
+	for (curr_obj = obj_head; curr_obj; curr_obj = curr_obj->next) {
+		if (curr_obj->type_id == OBJ_TYPE_DPMCP && 0 == curr_obj->id)
 			continue;
-		}
+		recs[i++].obj = curr_obj;
+	}
 
-		fprintf(fp, "\n");
-		fprintf(fp, "\t\t%s@%d {\n", curr_obj->type, curr_obj->id);
-		fprintf(fp, "\t\t\tcompatible = \"fsl,%s\";\n", curr_obj->type);
-
-		/* objects don't need to be parsed and get attributes for now */
-		if (strcmp(curr_obj->type, "dpbp") == 0)
-			parse_dpbp(fp, curr_obj);
-		if (strcmp(curr_obj->type, "dpdbg") == 0)
-			parse_dpdbg(fp, curr_obj);
-		if (strcmp(curr_obj->type, "dpmcp") == 0)
-			parse_dpmcp(fp, curr_obj);
-		if (strcmp(curr_obj->type, "dprc") == 0)
-			parse_dprc(fp, curr_obj);
-		if (strcmp(curr_obj->type, "dprtc") == 0)
-			parse_dprtc(fp, curr_obj);
-
-		/* objects need to be parsed and get attributes */
-		if (strcmp(curr_obj->type, "dpaiop") == 0)
-			parse_dpaiop(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpcon") == 0)
-			parse_dpcon(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpdcei") == 0)
-			parse_dpdcei(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpdmai") == 0)
-			parse_dpdmai(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpio") == 0)
-			parse_dpio(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpseci") == 0)
-			parse_dpseci(fp, curr_obj);
-
-		/* following objects have possible connections */
-		if (strcmp(curr_obj->type, "dpci") == 0)
-			parse_dpci(fp, curr_obj);
-
-		if (strcmp(curr_obj->type, "dpmac") == 0)
-			parse_dpmac(fp, curr_obj);
-			/* dpmac do not need to be parsed now */
-
-		if (strcmp(curr_obj->type, "dpni") == 0) {
-			if (restool.mc_fw_version.major == 9)
-				parse_dpni_v9(fp, curr_obj);
-			else if (restool.mc_fw_version.major == 10)
-				parse_dpni_v10(fp, curr_obj);
-		}
+	fetch_all_objs(recs, num_recs);
 
+	/* format: the records, in sorted object order */
+	dpl_emit_blank(emit);
+	dpl_emit_comment(emit,
+		"/*****************************************************************");
+	dpl_emit_comment(emit, " * Objects");
+	dpl_emit_comment(emit,
+		" *****************************************************************/");
 
-		/* following objects have possible connections and interface*/
-		if (strcmp(curr_obj->type, "dpdmux") == 0) {
-			if (restool.mc_fw_version.major == 9 ||
-			    restool.mc_fw_version.major == 10)
-				parse_dpdmux_v9(fp, curr_obj);
-		}
 
-		if (strcmp(curr_obj->type, "dpsw") == 0) {
-			if (restool.mc_fw_version.major == 9 ||
-			    restool.mc_fw_version.major == 10)
-				parse_dpsw_v9(fp, curr_obj);
-		}
+	dpl_emit_begin_node(emit, "objects");
+	for (i = 0; i < num_recs; i++) {
+		curr_obj = recs[i].obj;
 
-		fprintf(fp, "\t\t};\n");
-		curr_obj = curr_obj->next;
+		dpl_emit_blank(emit);
+		dpl_emit_begin_node(emit, "%s@%d", curr_obj->type, curr_obj->id);
+		dpl_emit_string(emit, "compatible", "fsl,%s", curr_obj->type);
+		write_obj_attrs(emit, &recs[i]);
+		dpl_emit_end_node(emit);
+
+		add_conns(&recs[i]);
 	}
-	fprintf(fp, "\t};\n");
+	dpl_emit_end_node(emit);
 
+	free(recs);
 	return 0;
 }
 
@@ -1975,45 +1838,49 @@ static int write_connections(void)
 {
 	struct conn_list *curr_conn;
 	int conn_num = 1;
-	FILE *fp = stdout;
+	struct dpl_emitter *emit = dpl_emit;
 
-	fprintf(fp, "\n");
-	fprintf(fp,
-		"\t/*****************************************************************\n");
-	fprintf(fp, "\t * Connections\n");
-	fprintf(fp,
-		"\t *****************************************************************/\n");
+	dpl_emit_blank(emit);
+	dpl_emit_comment(emit,
+		"/*****************************************************************");
+	dpl_emit_comment(emit, " * Connections");
+	dpl_emit_comment(emit,
+		" *****************************************************************/");
 
-	fprintf(fp, "\tconnections {\n");
+	dpl_emit_begin_node(emit, "connections");
 	curr_conn = conn_head;
 	while (curr_conn) {
-		fprintf(fp, "\n");
-		fprintf(fp, "\t\tconnection@%d{\n", conn_num);
+		dpl_emit_blank(emit);
+		dpl_emit_begin_node(emit, "connection@%d", conn_num);
 		if (curr_conn->if_id1 < 0)
-			fprintf(fp, "\t\t\tendpoint1 = \"%s@%d\";\n",
-				curr_conn->type1, curr_conn->id1);
+			dpl_emit_string(emit, "endpoint1", "%s@%d",
+					curr_conn->type1, curr_conn->id1);
 		else
-			fprintf(fp, "\t\t\tendpoint1 = \"%s@%d/if@%d\";\n",
-				curr_conn->type1, curr_conn->id1,
-				curr_conn->if_id1);
+			dpl_emit_string(emit, "endpoint1", "%s@%d/if@%d",
+					curr_conn->type1, curr_conn->id1,
+					curr_conn->if_id1);
 		if (curr_conn->if_id2 < 0)
-			fprintf(fp, "\t\t\tendpoint2 = \"%s@%d\";\n",
-				curr_conn->type2, curr_conn->id2);
+			dpl_emit_string(emit, "endpoint2", "%s@%d",
+					curr_conn->type2, curr_conn->id2);
 		else
-			fprintf(fp, "\t\t\tendpoint2 = \"%s@%d/if@%d\";\n",
-				curr_conn->type2, curr_conn->id2,
-				curr_conn->if_id2);
+			dpl_emit_string(emit, "endpoint2", "%s@%d/if@%d",
+					curr_conn->type2, curr_conn->id2,
+					curr_conn->if_id2);
 
-		fprintf(fp, "\t\t};\n");
+		dpl_emit_end_node(emit);
 		curr_conn = curr_conn->next;
 		conn_num++;
 	}
-	fprintf(fp, "\t};\n");
+	dpl_emit_end_node(emit);
 
 	return 0;
 }
 
-static void delete_all_list(void)
+/**
+ * dpl_free_layout() - free the lists of a layout
+ * @layout: layout filled by dpl_read_layout() or built by hand
+ */
+void dpl_free_layout(struct dpl_layout *layout)
 {
 	struct container_list *curr_cont;
 	struct container_list *tmp_cont;
@@ -2022,27 +1889,27 @@ static void delete_all_list(void)
 	struct conn_list *curr_conn;
 	struct conn_list *tmp_conn;
 
-	curr_cont = container_head;
-	curr_obj = obj_head;
-	curr_conn = conn_head;
+	curr_cont = layout->containers;
+	curr_obj = layout->objs;
+	curr_conn = layout->conns;
 
-	/* delete global object lists */
+	/* delete the object list */
 	while (curr_obj) {
 		tmp_obj = curr_obj;
 		curr_obj = curr_obj->next;
 		free(tmp_obj);
 	}
-	obj_head = NULL;
+	layout->objs = NULL;
 
-	/* delete global connection lists */
+	/* delete the connection list */
 	while (curr_conn) {
 		tmp_conn = curr_conn;
 		curr_conn = curr_conn->next;
 		free(tmp_conn);
 	}
-	conn_head = NULL;
+	layout->conns = NULL;
 
-	/* delete global container lists */
+	/* delete the container list */
 	while (curr_cont) {
 		tmp_cont = curr_cont;
 		curr_cont = curr_cont->next;
@@ -2058,53 +1925,138 @@ static void delete_all_list(void)
 
 		free(tmp_cont);
 	}
+	layout->containers = NULL;
+	layout->num_containers = 0;
+}
+
+static void delete_all_list(void)
+{
+	struct dpl_layout layout = {
+		.containers = container_head,
+		.objs = obj_head,
+		.conns = conn_head,
+		.num_containers = container_count,
+	};
+
+	dpl_free_layout(&layout);
 	container_head = NULL;
+	obj_head = NULL;
+	conn_head = NULL;
+	container_count = 0;
 }
 
-int dpl_generate(void)
+/**
+ * dpl_read_layout() - read the layout of a container and its descendants
+ * @dprc_id: container to read
+ * @layout: filled with the containers, objects and connections found,
+ *	to be freed with dpl_free_layout()
+ *
+ * This is the model dpl_write() describes. Connections are only found
+ * while the object attributes are read, so the object pass is run with
+ * an emitter that writes nothing.
+ *
+ * Returns 0 on success, non-zero otherwise
+ */
+int dpl_read_layout(uint32_t dprc_id, struct dpl_layout *layout)
 {
 	int error;
-	uint32_t dprc_id = 0;
 
-	if (restool.obj_name != NULL) {
-		error = parse_object_name(restool.obj_name, "dprc", &dprc_id);
-		if (error < 0)
-			return error;
+	dpl_emit = dpl_emit_open(DPL_FORMAT_NONE, NULL);
+	if (!dpl_emit)
+		return -ENOMEM;
+
+	error = parse_layout(dprc_id);
+	if (error == 0)
+		error = write_objects();
+
+	dpl_emit_discard(dpl_emit);
+	dpl_emit = NULL;
+
+	if (error) {
+		delete_all_list();
+		return error;
 	}
 
-	FILE *fp = stdout;
+	layout->containers = container_head;
+	layout->objs = obj_head;
+	layout->conns = conn_head;
+	layout->num_containers = container_count;
+	container_head = NULL;
+	obj_head = NULL;
+	conn_head = NULL;
+	container_count = 0;
+
+	return 0;
+}
+
+/**
+ * dpl_write() - write the DPL of a container and its descendants
+ * @dprc_id: container to describe, 0 for the root container
+ * @fp: stream the DPL is written to
+ * @format: DPL_FORMAT_DTS for source text, DPL_FORMAT_DTB for a blob
+ *
+ * Returns 0 on success, non-zero otherwise
+ */
+int dpl_write(uint32_t dprc_id, FILE *fp, enum dpl_format format)
+{
+	int error;
+
+	dpl_emit = dpl_emit_open(format, fp);
+	if (!dpl_emit)
+		return -ENOMEM;
 
-	fprintf(fp, "/dts-v1/;\n");
-	fprintf(fp, "/ {\n");
-	fprintf(fp, "\tdpl-version = <%d>;\n", restool.mc_fw_version.major);
+	dpl_emit_begin_node(dpl_emit, "/");
+	dpl_emit_cell(dpl_emit, "dpl-version", DPL_CELL_DEC,
+		      restool.mc_fw_version.major);
 
 	error = parse_layout(dprc_id);
 	if (error) {
 		ERROR_PRINTF("parse_layout() failed, error=%d\n", error);
-		return error;
+		goto out;
 	}
 
 	error = write_containers();
 	if (error) {
 		ERROR_PRINTF("write_containers() failed, error=%d\n", error);
-		return error;
+		goto out;
 	}
 
 	error = write_objects();
 	if (error) {
 		ERROR_PRINTF("write_objects() failed, error=%d\n", error);
-		return error;
+		goto out;
 	}
 
 	error = write_connections();
 	if (error) {
 		ERROR_PRINTF("write_connections() failed, error=%d\n", error);
-		return error;
+		goto out;
 	}
 
-	fprintf(fp, "};\n");
+out:
+	if (error) {
+		dpl_emit_discard(dpl_emit);
+	} else {
+		dpl_emit_end_node(dpl_emit);
+		error = dpl_emit_close(dpl_emit);
+	}
+	dpl_emit = NULL;
 
 	delete_all_list();
 
-	return 0;
+	return error;
+}
+
+int dpl_generate(enum dpl_format format)
+{
+	int error;
+	uint32_t dprc_id = 0;
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc", &dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	return dpl_write(dprc_id, stdout, format);
 }
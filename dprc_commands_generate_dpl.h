@@ -30,8 +30,98 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifndef _DPRC_COMMANDS_GENERATE_DPL_H_
+#define _DPRC_COMMANDS_GENERATE_DPL_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "restool.h"
+#include "dpl_emit.h"
+
+/**
+ * struct obj_list - linked list node of all objects
+ * @next: tracks next objects, the objects are sorted
+ * @type: object type
+ * @type_id: @type, as returned by obj_type_lookup()
+ * @id: object id
+ * @label: object label
+ * @plugged: the object is plugged, or a DPL asks for it with
+ *	"plugged = <1>"
+ */
+struct obj_list {
+	struct obj_list *next;
+	char type[16];
+	enum obj_type type_id;
+	int id;
+	char label[16];
+	bool plugged;
+};
+
+/**
+ * struct conn_list - linked list node of 2 connected endpoints
+ * @next: tracks next connection, the connections are not sorted.
+ * @type1: endpoint1's object type
+ * @type2: endpoint2's object type
+ * @id1: endpoint1's id
+ * @id2: endpoint2's id
+ * @if_id1: endpoint1's interface id, initialized as -1 if no interface
+ * @if_id2: endpoint2's interface id, initialized as -1 if no interface
+ */
+struct conn_list {
+	struct conn_list *next;
+	char type1[16];
+	char type2[16];
+	int id1;
+	int id2;
+	int if_id1;
+	int if_id2;
+};
+
+/**
+ * struct container_list - linked list node of all containers
+ * @next: tracks next container
+ * @obj_list: tracks the objects in current container, sorted list
+ * @id: current container's id
+ * @parent_id: current container's parent id. 0 means no parent.
+ * @options: configuration options of current container
+ */
+struct container_list {
+	struct container_list *next;
+	struct obj_list *obj;
+	int id;
+	int parent_id;
+	uint64_t options;
+};
+
+/**
+ * struct dpl_layout - containers, objects and connections of a layout
+ * @containers: containers, each parent before its children
+ * @objs: all objects of all containers, sorted
+ * @conns: connections between the objects, unsorted
+ * @num_containers: number of nodes in @containers
+ */
+struct dpl_layout {
+	struct container_list *containers;
+	struct obj_list *objs;
+	struct conn_list *conns;
+	int num_containers;
+};
+
 /**
  * dpl generate command options
  */
 
-int dpl_generate(void);
+int dpl_generate(enum dpl_format format);
+
+int dpl_write(uint32_t dprc_id, FILE *fp, enum dpl_format format);
+
+int dpl_read_layout(uint32_t dprc_id, struct dpl_layout *layout);
+
+void dpl_free_layout(struct dpl_layout *layout);
+
+int compare_insert_obj(struct obj_list **head, struct obj_list *target);
+
+int compare_insert_connection(struct conn_list **head,
+			      struct conn_list *target);
+
+#endif /* _DPRC_COMMANDS_GENERATE_DPL_H_ */
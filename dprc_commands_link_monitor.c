@@ -0,0 +1,639 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <libgen.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "mc_v9/fsl_dpsw.h"
+#include "mc_v10/fsl_dpsw.h"
+#include "dprc_commands_link_monitor.h"
+
+#define RTNL_BUFFER_SIZE	8192
+
+/**
+ * struct link_endpoint - one end of a monitored link
+ * @type: object type, NULL terminated
+ * @id: object id
+ * @if_id: interface id, only meaningful for dpsw and dpdmux
+ */
+struct link_endpoint {
+	char type[EP_OBJ_TYPE_MAX_LEN + 1];
+	int id;
+	int if_id;
+};
+
+/**
+ * struct monitored_link - state and statistics of one link
+ * @local: endpoint found in the monitored container
+ * @peer: endpoint it is connected to
+ * @up: last link state read, 1 for up and 0 for down
+ * @check: link must be read again before the next poll
+ * @changes: number of transitions seen
+ * @flaps: number of up to down transitions seen
+ * @down_since: when the link last went down, valid while !@up
+ * @down_time: accumulated time spent down, in nanoseconds
+ * @longest_down: longest single down period, in nanoseconds
+ */
+struct monitored_link {
+	struct link_endpoint local;
+	struct link_endpoint peer;
+	int up;
+	bool check;
+	unsigned int changes;
+	unsigned int flaps;
+	struct timespec down_since;
+	uint64_t down_time;
+	uint64_t longest_down;
+};
+
+/**
+ * struct link_event - one transition kept in the history ring
+ * @when: wall clock time of the transition
+ * @link: index of the link in the links array
+ * @up: new link state
+ */
+struct link_event {
+	struct timespec when;
+	int link;
+	int up;
+};
+
+static struct monitored_link *links;
+static int num_links;
+static int max_links;
+
+static struct link_event *history;
+static long history_size;
+static unsigned long history_count;
+
+static volatile sig_atomic_t monitor_stop;
+
+static void monitor_signal_handler(int sig)
+{
+	(void)sig;
+	monitor_stop = 1;
+}
+
+static uint64_t timespec_diff_ns(const struct timespec *end,
+				 const struct timespec *start)
+{
+	return (uint64_t)(end->tv_sec - start->tv_sec) * 1000000000ULL +
+	       end->tv_nsec - start->tv_nsec;
+}
+
+static void endpoint_name(const struct link_endpoint *ep, char *buf,
+			  size_t size)
+{
+	if (strcmp(ep->type, "dpsw") == 0 || strcmp(ep->type, "dpdmux") == 0)
+		snprintf(buf, size, "%s.%d.%d", ep->type, ep->id, ep->if_id);
+	else
+		snprintf(buf, size, "%s.%d", ep->type, ep->id);
+}
+
+static void link_name(const struct monitored_link *link, char *buf,
+		      size_t size)
+{
+	char local[32], peer[32];
+
+	endpoint_name(&link->local, local, sizeof(local));
+	endpoint_name(&link->peer, peer, sizeof(peer));
+	snprintf(buf, size, "%s <-> %s", local, peer);
+}
+
+static void print_timestamp(const struct timespec *when)
+{
+	struct tm tm;
+	char buf[32];
+
+	localtime_r(&when->tv_sec, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%06ld", buf, when->tv_nsec / 1000);
+}
+
+static bool same_endpoint(const struct link_endpoint *a,
+			  const struct link_endpoint *b)
+{
+	return a->id == b->id && a->if_id == b->if_id &&
+	       strcmp(a->type, b->type) == 0;
+}
+
+/**
+ * Reads the state of the link behind one endpoint. Returns -ENOTCONN
+ * for an endpoint that is not connected, which the MC reports either
+ * through a -1 state or a "no resource" error depending on version.
+ */
+static int read_link_state(const struct link_endpoint *local,
+			   struct link_endpoint *peer, int *up)
+{
+	struct dprc_endpoint endpoint1, endpoint2;
+	int state;
+	int error;
+
+	memset(&endpoint1, 0, sizeof(endpoint1));
+	memset(&endpoint2, 0, sizeof(endpoint2));
+	strcpy(endpoint1.type, local->type);
+	endpoint1.id = local->id;
+	endpoint1.if_id = local->if_id;
+
+	error = dprc_get_connection(&restool.mc_io, 0,
+				    restool.root_dprc_handle,
+				    &endpoint1, &endpoint2, &state);
+	if (error == -ENAVAIL || (error == 0 && state == -1))
+		return -ENOTCONN;
+	if (error < 0)
+		return error;
+
+	if (peer) {
+		memset(peer, 0, sizeof(*peer));
+		snprintf(peer->type, sizeof(peer->type), "%s", endpoint2.type);
+		peer->id = endpoint2.id;
+		peer->if_id = endpoint2.if_id;
+	}
+
+	*up = state == 1;
+	return 0;
+}
+
+static int add_link(const struct link_endpoint *local)
+{
+	struct monitored_link *link;
+	struct link_endpoint peer;
+	int up;
+	int error;
+
+	error = read_link_state(local, &peer, &up);
+	if (error == -ENOTCONN)
+		return 0;
+	if (error < 0) {
+		enum mc_cmd_status mc_status = flib_error_to_mc_status(error);
+
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		return error;
+	}
+
+	/* Both ends may live in the monitored container, keep one link */
+	for (int i = 0; i < num_links; i++) {
+		if (same_endpoint(&links[i].local, &peer) &&
+		    same_endpoint(&links[i].peer, local))
+			return 0;
+	}
+
+	if (num_links == max_links) {
+		struct monitored_link *new_links;
+		int max = max_links ? 2 * max_links : 16;
+
+		new_links = realloc(links, max * sizeof(*new_links));
+		if (!new_links) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		links = new_links;
+		max_links = max;
+	}
+
+	link = &links[num_links++];
+	memset(link, 0, sizeof(*link));
+	link->local = *local;
+	link->peer = peer;
+	link->up = up;
+	if (!up)
+		clock_gettime(CLOCK_MONOTONIC, &link->down_since);
+
+	return 0;
+}
+
+static int get_dpsw_num_ifs(uint32_t dpsw_id, uint16_t *num_ifs)
+{
+	enum mc_cmd_status mc_status;
+	uint16_t dpsw_handle;
+	int error, error2;
+
+	if (restool.mc_fw_version.major == MC_FW_VERSION_9)
+		error = dpsw_open(&restool.mc_io, 0, dpsw_id, &dpsw_handle);
+	else
+		error = dpsw_open_v10(&restool.mc_io, 0, dpsw_id,
+				      &dpsw_handle);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		return error;
+	}
+
+	if (restool.mc_fw_version.major == MC_FW_VERSION_9) {
+		struct dpsw_attr_v9 dpsw_attr;
+
+		memset(&dpsw_attr, 0, sizeof(dpsw_attr));
+		error = dpsw_get_attributes_v9(&restool.mc_io, 0, dpsw_handle,
+					       &dpsw_attr);
+		*num_ifs = dpsw_attr.num_ifs;
+	} else {
+		struct dpsw_attr_v10 dpsw_attr;
+
+		memset(&dpsw_attr, 0, sizeof(dpsw_attr));
+		error = dpsw_get_attributes_v10(&restool.mc_io, 0, dpsw_handle,
+						&dpsw_attr);
+		*num_ifs = dpsw_attr.num_ifs;
+	}
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	error2 = dpsw_close(&restool.mc_io, 0, dpsw_handle);
+	if (error2 < 0) {
+		mc_status = flib_error_to_mc_status(error2);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+/**
+ * Collects the connected DPNI, DPMAC and DPSW ports of a container and
+ * all its descendants
+ */
+static int add_node_links(struct dprc_walk_node *node)
+{
+	int error;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+		struct link_endpoint local;
+		uint16_t num_ifs = 1;
+
+		if (strcmp(desc->type, "dpsw") == 0) {
+			error = get_dpsw_num_ifs(desc->id, &num_ifs);
+			if (error < 0)
+				return error;
+		} else if (strcmp(desc->type, "dpni") != 0 &&
+			   strcmp(desc->type, "dpmac") != 0) {
+			continue;
+		}
+
+		memset(&local, 0, sizeof(local));
+		snprintf(local.type, sizeof(local.type), "%s", desc->type);
+		local.id = desc->id;
+		for (uint16_t k = 0; k < num_ifs; k++) {
+			local.if_id = k;
+			error = add_link(&local);
+			if (error < 0)
+				return error;
+		}
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_node_links(node->children[i]);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static void record_transition(int index, int up)
+{
+	struct monitored_link *link = &links[index];
+	struct link_event *event;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (up) {
+		uint64_t down = timespec_diff_ns(&now, &link->down_since);
+
+		link->down_time += down;
+		if (down > link->longest_down)
+			link->longest_down = down;
+	} else {
+		link->down_since = now;
+		link->flaps++;
+	}
+	link->up = up;
+	link->changes++;
+
+	event = &history[history_count++ % history_size];
+	clock_gettime(CLOCK_REALTIME, &event->when);
+	event->link = index;
+	event->up = up;
+}
+
+static void print_event(const struct link_event *event)
+{
+	char name[80];
+
+	link_name(&links[event->link], name, sizeof(name));
+	print_timestamp(&event->when);
+	printf(" %s: %s\n", name, event->up ? "up" : "down");
+}
+
+static void check_link(int index, bool quiet)
+{
+	struct monitored_link *link = &links[index];
+	int up;
+	int error;
+
+	link->check = false;
+	error = read_link_state(&link->local, NULL, &up);
+	if (error == -ENOTCONN) {
+		up = 0;
+	} else if (error < 0) {
+		DEBUG_PRINTF("dprc_get_connection() failed with error %d\n",
+			     error);
+		return;
+	}
+
+	if (up == link->up)
+		return;
+
+	record_transition(index, up);
+	if (!quiet) {
+		print_event(&history[(history_count - 1) % history_size]);
+		fflush(stdout);
+	}
+}
+
+static int open_rtnl_socket(void)
+{
+	struct sockaddr_nl addr;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return -errno;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = RTMGRP_LINK;
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		int error = -errno;
+
+		close(fd);
+		return error;
+	}
+
+	return fd;
+}
+
+/**
+ * Flags the links of the fsl-mc object backing a network interface.
+ * The interface's device symlink resolves to .../dprc.N/<type>.<id>.
+ */
+static void mark_interface_links(int ifindex)
+{
+	char ifname[IF_NAMESIZE];
+	char path[PATH_MAX];
+	char resolved[PATH_MAX];
+	char type[EP_OBJ_TYPE_MAX_LEN + 1];
+	int id;
+
+	if (!if_indextoname(ifindex, ifname))
+		return;
+
+	snprintf(path, sizeof(path), "/sys/class/net/%s/device", ifname);
+	if (!realpath(path, resolved))
+		return;
+
+	if (sscanf(basename(resolved), "%15[a-z].%d", type, &id) != 2)
+		return;
+
+	for (int i = 0; i < num_links; i++) {
+		struct monitored_link *link = &links[i];
+
+		if ((link->local.id == id &&
+		     strcmp(link->local.type, type) == 0) ||
+		    (link->peer.id == id &&
+		     strcmp(link->peer.type, type) == 0))
+			link->check = true;
+	}
+}
+
+static void drain_rtnl(int fd)
+{
+	char buf[RTNL_BUFFER_SIZE];
+	ssize_t len;
+
+	while ((len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+		struct nlmsghdr *nlh;
+
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len);
+		     nlh = NLMSG_NEXT(nlh, len)) {
+			struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+
+			if (nlh->nlmsg_type != RTM_NEWLINK &&
+			    nlh->nlmsg_type != RTM_DELLINK)
+				continue;
+
+			mark_interface_links(ifi->ifi_index);
+		}
+	}
+}
+
+static void print_summary(const struct timespec *end, bool print_history)
+{
+	unsigned long first;
+
+	printf("%-32s %-5s %8s %6s %14s %17s\n", "link", "state", "changes",
+	       "flaps", "down time (s)", "longest down (s)");
+	for (int i = 0; i < num_links; i++) {
+		struct monitored_link *link = &links[i];
+		uint64_t down_time = link->down_time;
+		uint64_t longest = link->longest_down;
+		char name[80];
+
+		if (!link->up) {
+			uint64_t down = timespec_diff_ns(end,
+							 &link->down_since);
+
+			down_time += down;
+			if (down > longest)
+				longest = down;
+		}
+
+		link_name(link, name, sizeof(name));
+		printf("%-32s %-5s %8u %6u %14.3f %17.3f\n", name,
+		       link->up ? "up" : "down", link->changes, link->flaps,
+		       down_time / 1e9, longest / 1e9);
+	}
+
+	if (!print_history || history_count == 0)
+		return;
+
+	first = history_count > (unsigned long)history_size ?
+		history_count - history_size : 0;
+	printf("\nlast %lu transitions:\n", history_count - first);
+	for (unsigned long i = first; i < history_count; i++)
+		print_event(&history[i % history_size]);
+}
+
+/**
+ * Monitors the links of every connected DPNI, DPMAC and DPSW port in a
+ * container and its descendants. Link states are re-read as soon as
+ * the kernel reports a change on a network interface backed by one of
+ * the ports, and all of them are polled every cfg->interval
+ * milliseconds to catch ports without a network interface. A
+ * per-link summary is printed when the monitor stops.
+ */
+int dprc_monitor_links(uint32_t dprc_id, const struct link_monitor_cfg *cfg)
+{
+	struct dprc_walk_node *root = NULL;
+	struct sigaction sa, old_int, old_term;
+	struct timespec start, now, next_poll;
+	struct pollfd pfd;
+	int error;
+
+	history_size = cfg->history;
+	history_count = 0;
+	history = calloc(history_size, sizeof(*history));
+	if (!history) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	error = dprc_walk(dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = add_node_links(root);
+	dprc_walk_free(root);
+	if (error < 0)
+		goto out;
+
+	if (num_links == 0) {
+		printf("no connected dpni, dpmac or dpsw ports in dprc.%u\n",
+		       dprc_id);
+		goto out;
+	}
+
+	pfd.fd = open_rtnl_socket();
+	pfd.events = POLLIN;
+	if (pfd.fd < 0)
+		DEBUG_PRINTF("rtnetlink socket unavailable (error %d)\n",
+			     pfd.fd);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = monitor_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	(void)sigaction(SIGINT, &sa, &old_int);
+	(void)sigaction(SIGTERM, &sa, &old_term);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	next_poll = start;
+	while (!monitor_stop) {
+		int64_t timeout;
+		int n;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (cfg->duration && timespec_diff_ns(&now, &start) >=
+				     (uint64_t)cfg->duration * 1000000000ULL)
+			break;
+
+		if (now.tv_sec > next_poll.tv_sec ||
+		    (now.tv_sec == next_poll.tv_sec &&
+		     now.tv_nsec >= next_poll.tv_nsec)) {
+			for (int i = 0; i < num_links; i++)
+				check_link(i, cfg->quiet);
+
+			next_poll.tv_sec += cfg->interval / 1000;
+			next_poll.tv_nsec += (cfg->interval % 1000) * 1000000;
+			if (next_poll.tv_nsec >= 1000000000) {
+				next_poll.tv_sec++;
+				next_poll.tv_nsec -= 1000000000;
+			}
+			continue;
+		}
+
+		timeout = timespec_diff_ns(&next_poll, &now) / 1000000 + 1;
+		if (cfg->duration) {
+			struct timespec end = start;
+			int64_t left;
+
+			end.tv_sec += cfg->duration;
+			left = timespec_diff_ns(&end, &now) / 1000000 + 1;
+			if (left < timeout)
+				timeout = left;
+		}
+
+		n = poll(&pfd, 1, (int)timeout);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			error = -errno;
+			ERROR_PRINTF("poll() failed with error %d\n", error);
+			break;
+		}
+
+		if (n > 0) {
+			drain_rtnl(pfd.fd);
+			for (int i = 0; i < num_links; i++) {
+				if (links[i].check)
+					check_link(i, cfg->quiet);
+			}
+		}
+	}
+
+	(void)sigaction(SIGINT, &old_int, NULL);
+	(void)sigaction(SIGTERM, &old_term, NULL);
+	if (pfd.fd >= 0)
+		close(pfd.fd);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!cfg->quiet && history_count)
+		printf("\n");
+	print_summary(&now, cfg->quiet);
+out:
+	free(links);
+	links = NULL;
+	num_links = 0;
+	max_links = 0;
+	free(history);
+	history = NULL;
+	return error;
+}
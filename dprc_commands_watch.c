@@ -0,0 +1,612 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "handle_cache.h"
+#include "dprc_commands_watch.h"
+
+/**
+ * Poll interval, in seconds, used when no uevent socket is available
+ */
+#define WATCH_DEFAULT_INTERVAL	5
+
+#define UEVENT_BUFFER_SIZE	8192
+
+/**
+ * struct watch_container - last known contents of one watched container
+ * @id: container id
+ * @parent_id: id of the parent container, 0 for the watched root
+ * @irq_status: DPRC interrupt status seen on the last sweep
+ * @irq_status_valid: @irq_status has been read at least once
+ * @dirty: container must be re-read before the next sweep
+ * @num_objs: number of entries in @objs
+ * @objs: object descriptors, in MC index order
+ */
+struct watch_container {
+	uint32_t id;
+	uint32_t parent_id;
+	uint32_t irq_status;
+	bool irq_status_valid;
+	bool dirty;
+	int num_objs;
+	struct dprc_obj_desc *objs;
+};
+
+static struct watch_container **containers;
+static int num_containers;
+static int max_containers;
+
+static volatile sig_atomic_t watch_stop;
+
+static void watch_signal_handler(int sig)
+{
+	(void)sig;
+	watch_stop = 1;
+}
+
+static struct watch_container *find_container(uint32_t id)
+{
+	for (int i = 0; i < num_containers; i++) {
+		if (containers[i]->id == id)
+			return containers[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * Starts tracking a container. Takes ownership of @objs.
+ */
+static struct watch_container *add_container(uint32_t id, uint32_t parent_id,
+					     struct dprc_obj_desc *objs,
+					     int num_objs)
+{
+	struct watch_container *container;
+
+	if (num_containers == max_containers) {
+		struct watch_container **new_containers;
+		int max = max_containers ? 2 * max_containers : 16;
+
+		new_containers = realloc(containers,
+					 max * sizeof(*new_containers));
+		if (!new_containers) {
+			ERROR_PRINTF("realloc failed\n");
+			return NULL;
+		}
+
+		containers = new_containers;
+		max_containers = max;
+	}
+
+	container = calloc(1, sizeof(*container));
+	if (!container) {
+		ERROR_PRINTF("calloc failed\n");
+		return NULL;
+	}
+
+	container->id = id;
+	container->parent_id = parent_id;
+	container->objs = objs;
+	container->num_objs = num_objs;
+	containers[num_containers++] = container;
+	return container;
+}
+
+/**
+ * Emits one change record as a single line of JSON
+ */
+static void print_event(const char *event, const struct dprc_obj_desc *desc,
+			uint32_t container_id, const char *old_label)
+{
+	printf("{\"event\":\"%s\",\"object\":\"%s.%d\",\"container\":\"dprc.%u\"",
+	       event, desc->type, desc->id, container_id);
+	printf(",\"label\":");
+	print_json_string(desc->label, sizeof(desc->label));
+	if (old_label) {
+		printf(",\"old_label\":");
+		print_json_string(old_label, sizeof(desc->label));
+	}
+	printf(",\"plugged\":%s}\n",
+	       (desc->state & DPRC_OBJ_STATE_PLUGGED) ? "true" : "false");
+	fflush(stdout);
+}
+
+/**
+ * Stops tracking a container and all containers below it, emitting a
+ * remove record for every object they held.
+ */
+static void remove_container(uint32_t id)
+{
+	struct watch_container *container = NULL;
+	int i;
+
+	for (i = 0; i < num_containers; i++) {
+		if (containers[i]->id == id) {
+			container = containers[i];
+			break;
+		}
+	}
+
+	if (!container)
+		return;
+
+	containers[i] = containers[--num_containers];
+
+	for (i = 0; i < container->num_objs; i++) {
+		struct dprc_obj_desc *desc = &container->objs[i];
+
+		if (strcmp(desc->type, "dprc") == 0)
+			remove_container(desc->id);
+
+		print_event("remove", desc, id, NULL);
+	}
+
+	(void)handle_cache_evict("dprc", id);
+	free(container->objs);
+	free(container);
+}
+
+static int get_container_handle(uint32_t id, uint16_t *dprc_handle)
+{
+	if (id == restool.root_dprc_id) {
+		*dprc_handle = restool.root_dprc_handle;
+		return 0;
+	}
+
+	return handle_cache_open("dprc", id, dprc_open, dprc_close,
+				 dprc_handle);
+}
+
+static void put_container_handle(uint32_t id, uint16_t dprc_handle)
+{
+	if (id != restool.root_dprc_id)
+		(void)handle_cache_release(dprc_handle);
+}
+
+/**
+ * Reads the current object list of a container. A container that
+ * cannot be opened is reported with -ENOENT, its parent is expected to
+ * notice it is gone.
+ */
+static int read_container(uint32_t id, struct dprc_obj_desc **objs,
+			  int *num_objs)
+{
+	uint16_t dprc_handle;
+	int error;
+
+	*objs = NULL;
+	*num_objs = 0;
+
+	error = get_container_handle(id, &dprc_handle);
+	if (error < 0 || dprc_handle == 0) {
+		DEBUG_PRINTF("dprc.%u cannot be opened (error %d)\n",
+			     id, error);
+		if (error == 0)
+			put_container_handle(id, dprc_handle);
+		(void)handle_cache_evict("dprc", id);
+		return -ENOENT;
+	}
+
+	error = dprc_get_obj_count(&restool.mc_io, 0, dprc_handle, num_objs);
+	if (error < 0) {
+		DEBUG_PRINTF("dprc_get_obj_count(dprc.%u) failed with error %d\n",
+			     id, error);
+		error = -ENOENT;
+		goto out;
+	}
+
+	if (*num_objs == 0)
+		goto out;
+
+	*objs = calloc(*num_objs, sizeof(**objs));
+	if (!*objs) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	for (int i = 0; i < *num_objs; i++) {
+		error = dprc_get_obj(&restool.mc_io, 0, dprc_handle, i,
+				     &(*objs)[i]);
+		if (error < 0) {
+			DEBUG_PRINTF(
+				"dprc_get_object(%u) failed with error %d\n",
+				i, error);
+			error = -ENOENT;
+			goto out;
+		}
+	}
+
+	error = 0;
+out:
+	if (error < 0) {
+		free(*objs);
+		*objs = NULL;
+		*num_objs = 0;
+	}
+
+	put_container_handle(id, dprc_handle);
+	return error;
+}
+
+static struct dprc_obj_desc *find_desc(struct dprc_obj_desc *objs,
+				       int num_objs,
+				       const struct dprc_obj_desc *desc)
+{
+	for (int i = 0; i < num_objs; i++) {
+		if (objs[i].id == desc->id &&
+		    strcmp(objs[i].type, desc->type) == 0)
+			return &objs[i];
+	}
+
+	return NULL;
+}
+
+static void mark_dirty(uint32_t id)
+{
+	struct watch_container *container = find_container(id);
+
+	if (container)
+		container->dirty = true;
+}
+
+/**
+ * Re-reads one container and emits a record for every difference
+ * against its last known contents. Newly appeared child containers are
+ * read in full, vanished ones are dropped together with their subtree.
+ */
+static int rescan_container(struct watch_container *container)
+{
+	struct dprc_obj_desc *objs, *old_objs;
+	int num_objs, num_old_objs;
+	uint32_t id = container->id;
+	int error;
+
+	container->dirty = false;
+	error = read_container(id, &objs, &num_objs);
+	if (error == -ENOENT) {
+		mark_dirty(container->parent_id);
+		return 0;
+	}
+	if (error < 0)
+		return error;
+
+	old_objs = container->objs;
+	num_old_objs = container->num_objs;
+	container->objs = objs;
+	container->num_objs = num_objs;
+
+	for (int i = 0; i < num_old_objs; i++) {
+		struct dprc_obj_desc *desc = &old_objs[i];
+
+		if (find_desc(objs, num_objs, desc))
+			continue;
+
+		if (strcmp(desc->type, "dprc") == 0)
+			remove_container(desc->id);
+
+		print_event("remove", desc, id, NULL);
+	}
+
+	for (int i = 0; i < num_objs; i++) {
+		struct dprc_obj_desc *desc = &objs[i];
+		struct dprc_obj_desc *old_desc;
+
+		old_desc = find_desc(old_objs, num_old_objs, desc);
+		if (!old_desc) {
+			print_event("add", desc, id, NULL);
+			if (strcmp(desc->type, "dprc") == 0 &&
+			    !find_container(desc->id)) {
+				struct watch_container *child;
+
+				child = add_container(desc->id, id, NULL, 0);
+				if (!child) {
+					error = -ENOMEM;
+					goto out;
+				}
+				child->dirty = true;
+			}
+			continue;
+		}
+
+		if (strncmp(old_desc->label, desc->label,
+			    sizeof(desc->label)) != 0)
+			print_event("label-change", desc, id, old_desc->label);
+
+		if ((old_desc->state ^ desc->state) & DPRC_OBJ_STATE_PLUGGED)
+			print_event("plug-state-change", desc, id, NULL);
+	}
+
+	error = 0;
+out:
+	free(old_objs);
+	return error;
+}
+
+static int rescan_dirty_containers(void)
+{
+	int error;
+
+	for (;;) {
+		struct watch_container *container = NULL;
+
+		for (int i = 0; i < num_containers; i++) {
+			if (containers[i]->dirty) {
+				container = containers[i];
+				break;
+			}
+		}
+
+		if (!container)
+			return 0;
+
+		error = rescan_container(container);
+		if (error < 0)
+			return error;
+	}
+}
+
+/**
+ * Takes one DPRC interrupt status and object count reading per
+ * container and marks those that changed since the last sweep. The
+ * status is only read: arming and acknowledging DPRC interrupts is
+ * left to the kernel dprc driver that owns them.
+ */
+static void sweep_containers(void)
+{
+	for (int i = 0; i < num_containers; i++) {
+		struct watch_container *container = containers[i];
+		uint32_t irq_status = 0;
+		uint16_t dprc_handle;
+		int num_objs;
+		int error;
+
+		error = get_container_handle(container->id, &dprc_handle);
+		if (error < 0 || dprc_handle == 0) {
+			if (error == 0)
+				put_container_handle(container->id,
+						     dprc_handle);
+			mark_dirty(container->parent_id);
+			container->dirty = true;
+			continue;
+		}
+
+		error = dprc_get_irq_status(&restool.mc_io, 0, dprc_handle,
+					    DPRC_IRQ_INDEX, &irq_status);
+		if (error == 0) {
+			if (container->irq_status_valid &&
+			    irq_status != container->irq_status)
+				container->dirty = true;
+			container->irq_status = irq_status;
+			container->irq_status_valid = true;
+		}
+
+		error = dprc_get_obj_count(&restool.mc_io, 0, dprc_handle,
+					   &num_objs);
+		if (error < 0 || num_objs != container->num_objs)
+			container->dirty = true;
+
+		put_container_handle(container->id, dprc_handle);
+	}
+}
+
+static int open_uevent_socket(void)
+{
+	struct sockaddr_nl addr;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC,
+		    NETLINK_KOBJECT_UEVENT);
+	if (fd < 0)
+		return -errno;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1;
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		int error = -errno;
+
+		close(fd);
+		return error;
+	}
+
+	return fd;
+}
+
+/**
+ * Marks the container holding the object named by a fsl-mc uevent.
+ * DEVPATH ends in .../dprc.<parent>/<type>.<id>.
+ */
+static void handle_uevent(char *buf, ssize_t len)
+{
+	const char *devpath = NULL;
+	bool fsl_mc = false;
+	const char *slash, *parent;
+	uint32_t parent_id;
+
+	for (ssize_t off = 0; off < len; off += strlen(buf + off) + 1) {
+		if (strcmp(buf + off, "SUBSYSTEM=fsl-mc") == 0)
+			fsl_mc = true;
+		else if (strncmp(buf + off, "DEVPATH=", 8) == 0)
+			devpath = buf + off + 8;
+	}
+
+	if (!fsl_mc || !devpath)
+		return;
+
+	slash = strrchr(devpath, '/');
+	if (!slash || slash == devpath)
+		return;
+
+	parent = slash - 1;
+	while (parent > devpath && *parent != '/')
+		parent--;
+	if (*parent == '/')
+		parent++;
+
+	if (sscanf(parent, "dprc.%u/", &parent_id) != 1)
+		return;
+
+	DEBUG_PRINTF("uevent for %s\n", devpath);
+	mark_dirty(parent_id);
+}
+
+static void drain_uevents(int fd)
+{
+	char buf[UEVENT_BUFFER_SIZE];
+	ssize_t len;
+
+	while ((len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT)) > 0) {
+		buf[len] = '\0';
+		handle_uevent(buf, len);
+	}
+}
+
+static int add_walk_node(struct dprc_walk_node *node)
+{
+	struct watch_container *container;
+	struct dprc_obj_desc *objs = NULL;
+
+	if (node->num_objs) {
+		objs = malloc(node->num_objs * sizeof(*objs));
+		if (!objs) {
+			ERROR_PRINTF("malloc failed\n");
+			return -ENOMEM;
+		}
+		memcpy(objs, node->objs, node->num_objs * sizeof(*objs));
+	}
+
+	container = add_container(node->id, node->parent_id, objs,
+				  node->num_objs);
+	if (!container) {
+		free(objs);
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		int error = add_walk_node(node->children[i]);
+
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+/**
+ * Streams JSON-lines change records for the given container and all
+ * its descendants until interrupted. Containers are re-read only when
+ * a fsl-mc uevent names them or, every @interval seconds if non-zero,
+ * when their DPRC interrupt status or object count moved.
+ */
+int dprc_watch(uint32_t dprc_id, long interval)
+{
+	struct dprc_walk_node *root = NULL;
+	struct sigaction sa, old_int, old_term;
+	struct pollfd pfd;
+	int timeout;
+	int error;
+
+	error = dprc_walk(dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = add_walk_node(root);
+	dprc_walk_free(root);
+	if (error < 0)
+		goto out;
+
+	pfd.fd = open_uevent_socket();
+	pfd.events = POLLIN;
+	if (pfd.fd < 0) {
+		DEBUG_PRINTF("uevent socket unavailable (error %d)\n", pfd.fd);
+		if (interval == 0)
+			interval = WATCH_DEFAULT_INTERVAL;
+	}
+
+	timeout = interval ? (int)(interval * 1000) : -1;
+	if (interval)
+		sweep_containers();
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = watch_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	(void)sigaction(SIGINT, &sa, &old_int);
+	(void)sigaction(SIGTERM, &sa, &old_term);
+
+	while (!watch_stop) {
+		int n = poll(&pfd, 1, timeout);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			error = -errno;
+			ERROR_PRINTF("poll() failed with error %d\n", error);
+			break;
+		}
+
+		if (n > 0)
+			drain_uevents(pfd.fd);
+		else
+			sweep_containers();
+
+		error = rescan_dirty_containers();
+		if (error < 0)
+			break;
+	}
+
+	(void)sigaction(SIGINT, &old_int, NULL);
+	(void)sigaction(SIGTERM, &old_term, NULL);
+	if (pfd.fd >= 0)
+		close(pfd.fd);
+out:
+	while (num_containers > 0) {
+		struct watch_container *container = containers[--num_containers];
+
+		free(container->objs);
+		free(container);
+	}
+	free(containers);
+	containers = NULL;
+	max_containers = 0;
+	return error;
+}
@@ -0,0 +1,450 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <pthread.h>
+#include "restool.h"
+#include "utils.h"
+#include "fsl_mc_trace.h"
+#include "dprc_walk.h"
+
+/**
+ * struct walk_queue - containers waiting to be scanned
+ * @lock: protects all fields below
+ * @cond: signalled when work is queued or the walk completes
+ * @pending: stack of nodes whose contents have not been read yet
+ * @num_pending: number of entries in @pending
+ * @max_pending: allocated size of @pending
+ * @busy: number of nodes currently being scanned by a worker
+ * @error: first error reported by a worker, stops the walk
+ */
+struct walk_queue {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct dprc_walk_node **pending;
+	int num_pending;
+	int max_pending;
+	int busy;
+	int error;
+};
+
+static struct dprc_walk_node *alloc_node(uint32_t id, uint32_t parent_id,
+					 int nesting_level)
+{
+	struct dprc_walk_node *node;
+
+	node = calloc(1, sizeof(*node));
+	if (!node) {
+		ERROR_PRINTF("calloc failed\n");
+		return NULL;
+	}
+
+	node->id = id;
+	node->parent_id = parent_id;
+	node->nesting_level = nesting_level;
+	return node;
+}
+
+void dprc_walk_free(struct dprc_walk_node *node)
+{
+	if (!node)
+		return;
+
+	for (int i = 0; i < node->num_children; i++)
+		dprc_walk_free(node->children[i]);
+
+	free(node->children);
+	free(node->objs);
+	free(node->obj_types);
+	free(node);
+}
+
+/* Must be called with queue->lock held */
+static int push_pending(struct walk_queue *queue, struct dprc_walk_node *node)
+{
+	if (queue->num_pending == queue->max_pending) {
+		struct dprc_walk_node **pending;
+		int max = queue->max_pending ? 2 * queue->max_pending : 16;
+
+		pending = realloc(queue->pending, max * sizeof(*pending));
+		if (!pending) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		queue->pending = pending;
+		queue->max_pending = max;
+	}
+
+	queue->pending[queue->num_pending++] = node;
+	return 0;
+}
+
+/**
+ * Reads the attributes and the object list of one container through
+ * the given portal, creating (but not scanning) a node for each child
+ * container found.
+ */
+static int scan_container(struct fsl_mc_io *mc_io, struct dprc_walk_node *node)
+{
+	struct dprc_attributes dprc_attr;
+	enum mc_cmd_status mc_status;
+	uint16_t dprc_handle;
+	bool dprc_opened = false;
+	int num_children = 0;
+	int error;
+
+	if (mc_io == &restool.mc_io && node->id == restool.root_dprc_id) {
+		dprc_handle = restool.root_dprc_handle;
+	} else {
+		error = dprc_open(mc_io, 0, node->id, &dprc_handle);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			goto out;
+		}
+		dprc_opened = true;
+
+		if (dprc_handle == 0) {
+			DEBUG_PRINTF(
+				"dprc_open() returned invalid handle (auth 0) for dprc.%u\n",
+				node->id);
+			error = -ENOENT;
+			goto out;
+		}
+	}
+
+	memset(&dprc_attr, 0, sizeof(dprc_attr));
+	error = dprc_get_attributes(mc_io, 0, dprc_handle, &dprc_attr);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		goto out;
+	}
+	node->options = dprc_attr.options;
+
+	error = dprc_get_obj_count(mc_io, 0, dprc_handle, &node->num_objs);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+		goto out;
+	}
+
+	if (node->num_objs == 0)
+		goto out;
+
+	node->objs = calloc(node->num_objs, sizeof(*node->objs));
+	node->obj_types = calloc(node->num_objs, sizeof(*node->obj_types));
+	if (!node->objs || !node->obj_types) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	for (int i = 0; i < node->num_objs; i++) {
+		error = dprc_get_obj(mc_io, 0, dprc_handle, i, &node->objs[i]);
+		if (error < 0) {
+			DEBUG_PRINTF(
+				"dprc_get_object(%u) failed with error %d\n",
+				i, error);
+			goto out;
+		}
+
+		node->obj_types[i] = obj_type_lookup(node->objs[i].type);
+		if (node->obj_types[i] == OBJ_TYPE_DPRC)
+			num_children++;
+	}
+
+	if (num_children == 0)
+		goto out;
+
+	if (node->nesting_level >= MAX_DPRC_NESTING) {
+		ERROR_PRINTF("dprc.%u: containers nested too deep\n",
+			     node->id);
+		error = -ELOOP;
+		goto out;
+	}
+
+	node->children = calloc(num_children, sizeof(*node->children));
+	if (!node->children) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_walk_node *child;
+
+		if (node->obj_types[i] != OBJ_TYPE_DPRC)
+			continue;
+
+		child = alloc_node(node->objs[i].id, node->id,
+				   node->nesting_level + 1);
+		if (!child) {
+			error = -ENOMEM;
+			goto out;
+		}
+
+		node->children[node->num_children++] = child;
+	}
+
+	error = 0;
+out:
+	if (dprc_opened) {
+		int error2;
+
+		error2 = dprc_close(mc_io, 0, dprc_handle);
+		if (error2 < 0) {
+			mc_status = flib_error_to_mc_status(error2);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			if (error == 0)
+				error = error2;
+		}
+	}
+
+	return error;
+}
+
+/**
+ * Scans containers from the queue until it is drained or an error
+ * occurs. Any number of workers may run this concurrently, each one
+ * through its own portal.
+ */
+static void *walk_worker_run(void *arg)
+{
+	struct dprc_worker *worker = arg;
+	struct walk_queue *queue = worker->ctx;
+
+	pthread_mutex_lock(&queue->lock);
+	for ( ; ; ) {
+		struct dprc_walk_node *node;
+		int error;
+
+		while (queue->num_pending == 0 && queue->busy != 0 &&
+		       queue->error == 0)
+			pthread_cond_wait(&queue->cond, &queue->lock);
+
+		if (queue->num_pending == 0 || queue->error != 0)
+			break;
+
+		node = queue->pending[--queue->num_pending];
+		queue->busy++;
+		pthread_mutex_unlock(&queue->lock);
+
+		error = scan_container(worker->mc_io, node);
+
+		pthread_mutex_lock(&queue->lock);
+		queue->busy--;
+		for (int i = 0; error == 0 && i < node->num_children; i++)
+			error = push_pending(queue, node->children[i]);
+
+		if (error != 0 && queue->error == 0)
+			queue->error = error;
+
+		pthread_cond_broadcast(&queue->cond);
+	}
+	pthread_mutex_unlock(&queue->lock);
+
+	return NULL;
+}
+
+/**
+ * dprc_walk_num_portals() - number of portal sessions a parallel
+ *	operation on the container tree may use
+ */
+unsigned int dprc_walk_num_portals(void)
+{
+	/*
+	 * Traces are strictly ordered, so recording or replaying one
+	 * always uses the single restool portal.
+	 */
+	if (mc_trace_is_recording() || mc_trace_is_replaying())
+		return 1;
+
+	if (restool.num_portals == 0)
+		return 1;
+
+	return restool.num_portals;
+}
+
+/**
+ * dprc_workers_open() - set up the portal sessions of a parallel operation
+ * @workers: array of at least MAX_WALK_PORTALS workers
+ * @max_workers: the operation has no use for more workers than this
+ * @ctx: state shared by the workers, stored in each of them
+ *
+ * Worker 0 is the calling thread, using the restool portal. Up to
+ * dprc_walk_num_portals() - 1 more workers get a portal session of
+ * their own with the root container open on it; the operation goes
+ * on with fewer if a session cannot be set up.
+ *
+ * Returns the number of workers set up, at least 1
+ */
+int dprc_workers_open(struct dprc_worker *workers, int max_workers,
+		      void *ctx)
+{
+	unsigned int num_portals = dprc_walk_num_portals();
+	int num_workers = 1;
+
+	assert(num_portals >= 1 && num_portals <= MAX_WALK_PORTALS);
+	workers[0].mc_io = &restool.mc_io;
+	workers[0].root_handle = restool.root_dprc_handle;
+	workers[0].ctx = ctx;
+	while (num_workers < (int)num_portals && num_workers < max_workers) {
+		struct dprc_worker *worker = &workers[num_workers];
+		int error;
+
+		worker->mc_io = &worker->portal;
+		worker->ctx = ctx;
+		error = mc_io_init(worker->mc_io);
+		if (error < 0) {
+			DEBUG_PRINTF("continuing with %d portals\n",
+				     num_workers);
+			break;
+		}
+
+		error = dprc_open(worker->mc_io, 0, restool.root_dprc_id,
+				  &worker->root_handle);
+		if (error < 0) {
+			DEBUG_PRINTF("dprc_open() failed: %d\n", error);
+			mc_io_cleanup(worker->mc_io);
+			break;
+		}
+
+		num_workers++;
+	}
+
+	return num_workers;
+}
+
+/**
+ * dprc_workers_run() - run a function on several workers at once
+ * @workers: workers set up by dprc_workers_open()
+ * @num_workers: how many of them to use
+ * @run: function run by each worker, given its struct dprc_worker
+ *
+ * The calling thread runs @run as worker 0, the others get a thread
+ * each. Returns once all of them are done. The workers are expected to
+ * share their work through @ctx, so a thread that cannot be started
+ * only leaves its part to the others.
+ */
+void dprc_workers_run(struct dprc_worker *workers, int num_workers,
+		      void *(*run)(void *))
+{
+	int num_threads = 1;
+
+	while (num_threads < num_workers) {
+		int error = pthread_create(&workers[num_threads].thread, NULL,
+					   run, &workers[num_threads]);
+
+		if (error != 0) {
+			DEBUG_PRINTF("pthread_create() failed: %d\n", error);
+			break;
+		}
+
+		num_threads++;
+	}
+
+	(void)run(&workers[0]);
+
+	for (int i = 1; i < num_threads; i++)
+		pthread_join(workers[i].thread, NULL);
+}
+
+/**
+ * dprc_workers_close() - release the portal sessions of the workers
+ * @workers: workers set up by dprc_workers_open()
+ * @num_workers: number returned by dprc_workers_open()
+ */
+void dprc_workers_close(struct dprc_worker *workers, int num_workers)
+{
+	for (int i = 1; i < num_workers; i++) {
+		(void)dprc_close(workers[i].mc_io, 0, workers[i].root_handle);
+		mc_io_cleanup(workers[i].mc_io);
+	}
+}
+
+/**
+ * dprc_walk() - take a snapshot of a container and all its descendants
+ * @dprc_id: container to start from
+ * @root: returns the tree of nodes, to be released with dprc_walk_free()
+ *
+ * The tree is the same regardless of how many portals are used, since
+ * each node keeps its children in MC index order; only the order in
+ * which containers are read from the MC varies. With --portals=N, up
+ * to N-1 extra portal sessions are opened and containers are scanned
+ * concurrently by one thread per portal.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int dprc_walk(uint32_t dprc_id, struct dprc_walk_node **root)
+{
+	struct dprc_worker workers[MAX_WALK_PORTALS];
+	struct walk_queue queue;
+	int num_workers;
+	int error;
+
+	*root = alloc_node(dprc_id, 0, 0);
+	if (!*root)
+		return -ENOMEM;
+
+	memset(&queue, 0, sizeof(queue));
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+	error = push_pending(&queue, *root);
+	if (error < 0)
+		goto out;
+
+	num_workers = dprc_workers_open(workers, MAX_WALK_PORTALS, &queue);
+	dprc_workers_run(workers, num_workers, walk_worker_run);
+	dprc_workers_close(workers, num_workers);
+
+	error = queue.error;
+out:
+	free(queue.pending);
+	pthread_cond_destroy(&queue.cond);
+	pthread_mutex_destroy(&queue.lock);
+	if (error < 0) {
+		dprc_walk_free(*root);
+		*root = NULL;
+	}
+
+	return error;
+}
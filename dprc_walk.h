@@ -0,0 +1,106 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DPRC_WALK_H_
+#define _DPRC_WALK_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "mc_v10/fsl_dprc.h"
+#include "restool.h"
+
+/**
+ * Maximum number of MC portals a container walk may use concurrently
+ */
+#define MAX_WALK_PORTALS	16
+
+/**
+ * struct dprc_walk_node - snapshot of one container taken by dprc_walk()
+ * @id: container id
+ * @parent_id: id of the parent container, 0 for the container the walk
+ *	started from
+ * @nesting_level: depth below the container the walk started from
+ * @options: container configuration options, as returned by
+ *	dprc_get_attributes()
+ * @num_objs: number of entries in @objs
+ * @objs: descriptors of all objects in the container, including child
+ *	containers, in MC index order
+ * @obj_types: type of each entry of @objs, OBJ_TYPE_INVALID for types
+ *	restool does not know
+ * @num_children: number of entries in @children
+ * @children: child container nodes, in the same order as they appear
+ *	in @objs
+ */
+struct dprc_walk_node {
+	uint32_t id;
+	uint32_t parent_id;
+	int nesting_level;
+	uint64_t options;
+	int num_objs;
+	struct dprc_obj_desc *objs;
+	enum obj_type *obj_types;
+	int num_children;
+	struct dprc_walk_node **children;
+};
+
+/**
+ * struct dprc_worker - one MC portal session of a parallel operation
+ * @thread: worker thread, unused for the calling thread's own portal
+ * @mc_io: portal the worker sends its commands through
+ * @portal: portal session opened for this worker, unless it reuses
+ *	the restool one
+ * @root_handle: root container handle on @mc_io
+ * @ctx: state shared by all workers of the operation
+ */
+struct dprc_worker {
+	pthread_t thread;
+	struct fsl_mc_io *mc_io;
+	struct fsl_mc_io portal;
+	uint16_t root_handle;
+	void *ctx;
+};
+
+int dprc_workers_open(struct dprc_worker *workers, int max_workers,
+		      void *ctx);
+
+void dprc_workers_run(struct dprc_worker *workers, int num_workers,
+		      void *(*run)(void *));
+
+void dprc_workers_close(struct dprc_worker *workers, int num_workers);
+
+int dprc_walk(uint32_t dprc_id, struct dprc_walk_node **root);
+
+void dprc_walk_free(struct dprc_walk_node *node);
+
+unsigned int dprc_walk_num_portals(void);
+
+#endif /* _DPRC_WALK_H_ */
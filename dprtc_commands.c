@@ -39,6 +39,7 @@
 #include <getopt.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dprtc.h"
 #include "mc_v10/fsl_dprtc.h"
 
@@ -78,6 +79,9 @@ C_ASSERT(ARRAY_SIZE(dprtc_info_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 enum dprtc_create_options {
 	CREATE_OPT_HELP = 0,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dprtc_create_options[] = {
@@ -95,6 +99,27 @@ static struct option dprtc_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -120,11 +145,12 @@ static struct option dprtc_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dprtc_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dprtc_ops = {
+const struct flib_ops dprtc_ops = {
 	.obj_open = dprtc_open,
 	.obj_close = dprtc_close,
 	.obj_get_irq_mask = dprtc_get_irq_mask,
 	.obj_get_irq_status = dprtc_get_irq_status,
+	.obj_destroy = dprtc_destroy_v10,
 };
 
 static int cmd_dprtc_help(void)
@@ -152,7 +178,8 @@ static int print_dprtc_attr_v9(uint32_t dprtc_id,
 	struct dprtc_attr dprtc_attr;
 	bool dprtc_opened = false;
 
-	error = dprtc_open(&restool.mc_io, 0, dprtc_id, &dprtc_handle);
+	error = handle_cache_open("dprtc", dprtc_id, dprtc_open,
+				  dprtc_close, &dprtc_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -188,18 +215,8 @@ static int print_dprtc_attr_v9(uint32_t dprtc_id,
 
 	error = 0;
 out:
-	if (dprtc_opened) {
-		int error2;
-
-		error2 = dprtc_close(&restool.mc_io, 0, dprtc_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dprtc_opened)
+		(void)handle_cache_release(dprtc_handle);
 
 	return error;
 }
@@ -213,7 +230,8 @@ static int print_dprtc_attr_v10(uint32_t dprtc_id,
 	uint16_t dprtc_handle;
 	int error;
 
-	error = dprtc_open_v10(&restool.mc_io, 0, dprtc_id, &dprtc_handle);
+	error = handle_cache_open("dprtc", dprtc_id, dprtc_open_v10,
+				  dprtc_close_v10, &dprtc_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -257,18 +275,8 @@ static int print_dprtc_attr_v10(uint32_t dprtc_id,
 
 	error = 0;
 out:
-	if (dprtc_opened) {
-		int error2;
-
-		error2 = dprtc_close_v10(&restool.mc_io, 0, dprtc_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dprtc_opened)
+		(void)handle_cache_release(dprtc_handle);
 
 	return error;
 }
@@ -431,7 +439,7 @@ static int create_dprtc_v10(struct dprtc_cfg *dprtc_cfg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dprtc", dprtc_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -501,6 +509,7 @@ static int destroy_dprtc_v9(uint32_t dprtc_id)
 	uint16_t dprtc_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dprtc", dprtc_id);
 	error = dprtc_open(&restool.mc_io, 0, dprtc_id, &dprtc_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -560,6 +569,7 @@ static int destroy_dprtc_v10(uint32_t dprtc_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dprtc", dprtc_id);
 	error = dprtc_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dprtc_id);
 	if (error < 0) {
@@ -572,7 +582,7 @@ static int destroy_dprtc_v10(uint32_t dprtc_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
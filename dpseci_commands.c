@@ -36,10 +36,13 @@
 #include <stdint.h>
 #include <errno.h>
 #include <assert.h>
+#include <limits.h>
 #include <getopt.h>
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
+#include "dprc_walk.h"
 #include "mc_v9/fsl_dpseci.h"
 #include "mc_v10/fsl_dpseci.h"
 
@@ -82,6 +85,9 @@ enum dpseci_create_options {
 	CREATE_OPT_PRIORITIES,
 	CREATE_OPT_PARENT_DPRC,
 	CREATE_OPT_OPTIONS,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpseci_create_options[] = {
@@ -120,6 +126,27 @@ static struct option dpseci_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -145,11 +172,32 @@ static struct option dpseci_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpseci_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpseci_ops = {
+/**
+ * dpseci queues command options
+ */
+enum dpseci_queues_options {
+	QUEUES_OPT_HELP = 0,
+};
+
+static struct option dpseci_queues_options[] = {
+	[QUEUES_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(dpseci_queues_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+const struct flib_ops dpseci_ops = {
 	.obj_open = dpseci_open,
 	.obj_close = dpseci_close,
 	.obj_get_irq_mask = dpseci_get_irq_mask,
 	.obj_get_irq_status = dpseci_get_irq_status,
+	.obj_destroy = dpseci_destroy_v10,
 };
 
 static struct option_entry options_map_v10_1[] = {
@@ -176,6 +224,24 @@ static int cmd_dpseci_help(void)
 	return 0;
 }
 
+static int cmd_dpseci_help_v10(void)
+{
+	static const char help_msg[] =
+		"\n"
+		"Usage: restool dpseci <command> [--help] [ARGS...]\n"
+		"Where <command> can be:\n"
+		"   info - displays detailed information about a DPSECI object.\n"
+		"   create - creates a new child DPSECI under the root DPRC.\n"
+		"   destroy - destroys a child DPSECI under the root DPRC.\n"
+		"   queues - shows the rx/tx queues of all DPSECIs and where they land.\n"
+		"\n"
+		"For command-specific help, use the --help option of each command.\n"
+		"\n";
+
+	printf(help_msg);
+	return 0;
+}
+
 static int print_dpseci_attr_v9(uint32_t dpseci_id,
 			struct dprc_obj_desc *target_obj_desc)
 {
@@ -186,7 +252,8 @@ static int print_dpseci_attr_v9(uint32_t dpseci_id,
 	struct dpseci_tx_queue_attr tx_attr;
 	uint8_t *priorities;
 
-	error = dpseci_open(&restool.mc_io, 0, dpseci_id, &dpseci_handle);
+	error = handle_cache_open("dpseci", dpseci_id, dpseci_open,
+				  dpseci_close, &dpseci_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -255,18 +322,8 @@ static int print_dpseci_attr_v9(uint32_t dpseci_id,
 	error = 0;
 
 out:
-	if (dpseci_opened) {
-		int error2;
-
-		error2 = dpseci_close(&restool.mc_io, 0, dpseci_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpseci_opened)
+		(void)handle_cache_release(dpseci_handle);
 
 	return error;
 }
@@ -282,7 +339,8 @@ static int print_dpseci_attr_v10(uint32_t dpseci_id,
 	uint8_t *priorities;
 	int error;
 
-	error = dpseci_open_v10(&restool.mc_io, 0, dpseci_id, &dpseci_handle);
+	error = handle_cache_open("dpseci", dpseci_id, dpseci_open_v10,
+				  dpseci_close_v10, &dpseci_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -359,18 +417,8 @@ static int print_dpseci_attr_v10(uint32_t dpseci_id,
 	error = 0;
 
 out:
-	if (dpseci_opened) {
-		int error2;
-
-		error2 = dpseci_close_v10(&restool.mc_io, 0, dpseci_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpseci_opened)
+		(void)handle_cache_release(dpseci_handle);
 
 	return error;
 }
@@ -673,7 +721,7 @@ static int create_dpseci_v10(const char *usage_msg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpseci", dpseci_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -766,6 +814,7 @@ static int destroy_dpseci_v9(uint32_t dpseci_id)
 	uint16_t dpseci_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpseci", dpseci_id);
 	error = dpseci_open(&restool.mc_io, 0, dpseci_id, &dpseci_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -824,6 +873,7 @@ static int destroy_dpseci_v10(uint32_t dpseci_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpseci", dpseci_id);
 	error = dpseci_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpseci_id);
 	if (error < 0) {
@@ -836,7 +886,7 @@ static int destroy_dpseci_v10(uint32_t dpseci_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -900,6 +950,417 @@ static int cmd_dpseci_destroy_v10(void)
 	return destroy_dpseci(MC_FW_VERSION_10);
 }
 
+/**
+ * struct dpseci_queues - queues of one DPSECI read by dpseci queues
+ * @id: dpseci id
+ * @container: id of the container holding the dpseci
+ * @error: error of the read, 0 when the fields below are valid
+ * @num_rx: number of entries in @rx
+ * @num_tx: number of entries in @tx
+ * @rx: receive queues, in queue index order
+ * @tx: transmit queues, in queue index order
+ */
+struct dpseci_queues {
+	uint32_t id;
+	uint32_t container;
+	int error;
+	int num_rx;
+	int num_tx;
+	struct dpseci_rx_queue_attr_v10 rx[DPSECI_PRIO_NUM];
+	struct dpseci_tx_queue_attr_v10 tx[DPSECI_PRIO_NUM];
+};
+
+/**
+ * struct queue_dest - rx queues landing on one DPIO or DPCON
+ * @type: destination type
+ * @id: dpio or dpcon id, unused for DPSECI_DEST_NONE
+ * @num_queues: number of rx queues with this destination
+ */
+struct queue_dest {
+	enum dpseci_dest_v10 type;
+	int id;
+	int num_queues;
+};
+
+/**
+ * struct queue_map - everything dpseci queues found in one walk
+ */
+struct queue_map {
+	struct dpseci_queues *seci;
+	int num_seci;
+	int max_seci;
+	struct queue_dest *dests;
+	int num_dests;
+	int max_dests;
+};
+
+static struct queue_dest *find_queue_dest(struct queue_map *map,
+					  enum dpseci_dest_v10 type, int id)
+{
+	struct queue_dest *dest;
+
+	if (type == DPSECI_DEST_NONE)
+		id = 0;
+
+	for (int i = 0; i < map->num_dests; i++)
+		if (map->dests[i].type == type && map->dests[i].id == id)
+			return &map->dests[i];
+
+	if (map->num_dests == map->max_dests) {
+		int new_max = map->max_dests ? map->max_dests * 2 : 16;
+		struct queue_dest *new_dests;
+
+		new_dests = realloc(map->dests, new_max * sizeof(*new_dests));
+		if (!new_dests) {
+			ERROR_PRINTF("realloc failed\n");
+			return NULL;
+		}
+		map->dests = new_dests;
+		map->max_dests = new_max;
+	}
+
+	dest = &map->dests[map->num_dests++];
+	dest->type = type;
+	dest->id = id;
+	dest->num_queues = 0;
+	return dest;
+}
+
+/**
+ * Collects the dpsecis to read and every dpio of the walk, so that idle
+ * dpios show up in the placement table too
+ */
+static int add_queue_map_objs(struct dprc_walk_node *node,
+			      struct queue_map *map, int dpseci_id)
+{
+	struct dpseci_queues *seci;
+	int error;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->obj_types[i] == OBJ_TYPE_DPIO) {
+			if (!find_queue_dest(map, DPSECI_DEST_DPIO,
+					     node->objs[i].id))
+				return -ENOMEM;
+			continue;
+		}
+
+		if (node->obj_types[i] != OBJ_TYPE_DPSECI ||
+		    (dpseci_id >= 0 && node->objs[i].id != dpseci_id))
+			continue;
+
+		if (map->num_seci == map->max_seci) {
+			int new_max = map->max_seci ? map->max_seci * 2 : 8;
+			struct dpseci_queues *new_seci;
+
+			new_seci = realloc(map->seci,
+					   new_max * sizeof(*new_seci));
+			if (!new_seci) {
+				ERROR_PRINTF("realloc failed\n");
+				return -ENOMEM;
+			}
+			map->seci = new_seci;
+			map->max_seci = new_max;
+		}
+
+		seci = &map->seci[map->num_seci++];
+		memset(seci, 0, sizeof(*seci));
+		seci->id = node->objs[i].id;
+		seci->container = node->id;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_queue_map_objs(node->children[i], map, dpseci_id);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+/**
+ * Reads all rx and tx queues of one dpseci with a single open
+ */
+static int read_dpseci_queues(struct dpseci_queues *seci)
+{
+	struct dpseci_attr_v10 dpseci_attr;
+	uint16_t dpseci_handle;
+	int error;
+	int error2;
+
+	error = dpseci_open_v10(&restool.mc_io, 0, seci->id, &dpseci_handle);
+	if (error < 0)
+		goto out;
+
+	memset(&dpseci_attr, 0, sizeof(dpseci_attr));
+	error = dpseci_get_attributes_v10(&restool.mc_io, 0, dpseci_handle,
+					  &dpseci_attr);
+	if (error < 0)
+		goto out_close;
+
+	seci->num_rx = dpseci_attr.num_rx_queues;
+	if (seci->num_rx > DPSECI_PRIO_NUM)
+		seci->num_rx = DPSECI_PRIO_NUM;
+	seci->num_tx = dpseci_attr.num_tx_queues;
+	if (seci->num_tx > DPSECI_PRIO_NUM)
+		seci->num_tx = DPSECI_PRIO_NUM;
+
+	for (int i = 0; i < seci->num_rx; i++) {
+		error = dpseci_get_rx_queue_v10(&restool.mc_io, 0,
+						dpseci_handle, i,
+						&seci->rx[i]);
+		if (error < 0)
+			goto out_close;
+	}
+
+	for (int i = 0; i < seci->num_tx; i++) {
+		error = dpseci_get_tx_queue_v10(&restool.mc_io, 0,
+						dpseci_handle, i,
+						&seci->tx[i]);
+		if (error < 0)
+			goto out_close;
+	}
+
+out_close:
+	error2 = dpseci_close_v10(&restool.mc_io, 0, dpseci_handle);
+	if (error2 < 0 && error == 0)
+		error = error2;
+out:
+	seci->error = error;
+	return error;
+}
+
+static void queue_dest_name(enum dpseci_dest_v10 type, int id, char *buf,
+			    size_t size)
+{
+	if (type == DPSECI_DEST_DPIO)
+		snprintf(buf, size, "dpio.%d", id);
+	else if (type == DPSECI_DEST_DPCON)
+		snprintf(buf, size, "dpcon.%d", id);
+	else
+		snprintf(buf, size, "none");
+}
+
+static int cmp_queue_dest(const void *a, const void *b)
+{
+	const struct queue_dest *dest_a = a;
+	const struct queue_dest *dest_b = b;
+
+	if (dest_a->type != dest_b->type)
+		return (int)dest_a->type - (int)dest_b->type;
+
+	return dest_a->id - dest_b->id;
+}
+
+static void print_dpseci_queues(const struct dpseci_queues *seci)
+{
+	const struct dpseci_dest_cfg_v10 *dest;
+	char dest_name[32];
+
+	printf("dpseci.%u (dprc.%u)\n", seci->id, seci->container);
+	if (seci->error) {
+		mc_status = flib_error_to_mc_status(seci->error);
+		printf("  MC error: %s (status %#x)\n",
+		       mc_status_to_string(mc_status), mc_status);
+		return;
+	}
+
+	printf("  %-6s  %-10s  %-8s  %s\n", "queue", "fqid", "priority",
+	       "destination");
+	for (int i = 0; i < seci->num_rx; i++) {
+		dest = &seci->rx[i].dest_cfg;
+		queue_dest_name(dest->dest_type, dest->dest_id, dest_name,
+				sizeof(dest_name));
+		printf("  rx.%-3d  %#-10x  %-8u  %s\n", i, seci->rx[i].fqid,
+		       dest->priority, dest_name);
+	}
+
+	for (int i = 0; i < seci->num_tx; i++)
+		printf("  tx.%-3d  %#-10x  %-8u  %s\n", i, seci->tx[i].fqid,
+		       seci->tx[i].priority, "SEC");
+}
+
+/**
+ * Prints how rx queues spread over dpios and dpcons and how tx queues
+ * spread over SEC priorities
+ */
+static void print_queue_placement(struct queue_map *map)
+{
+	unsigned int tx_per_priority[256] = { 0 };
+	int min_dpio = INT_MAX;
+	int max_dpio = 0;
+	int num_dpios = 0;
+	char dest_name[32];
+	bool first;
+
+	qsort(map->dests, map->num_dests, sizeof(*map->dests),
+	      cmp_queue_dest);
+
+	printf("\nrx queues per destination:\n");
+	printf("  %-12s  %-6s  %s\n", "destination", "queues", "used by");
+	for (int i = 0; i < map->num_dests; i++) {
+		const struct queue_dest *dest = &map->dests[i];
+
+		queue_dest_name(dest->type, dest->id, dest_name,
+				sizeof(dest_name));
+		printf("  %-12s  %-6d  ", dest_name, dest->num_queues);
+
+		first = true;
+		for (int j = 0; j < map->num_seci; j++) {
+			const struct dpseci_queues *seci = &map->seci[j];
+
+			if (seci->error)
+				continue;
+
+			for (int k = 0; k < seci->num_rx; k++) {
+				const struct dpseci_dest_cfg_v10 *cfg =
+					&seci->rx[k].dest_cfg;
+
+				if (cfg->dest_type != dest->type ||
+				    (dest->type != DPSECI_DEST_NONE &&
+				     cfg->dest_id != dest->id))
+					continue;
+
+				printf("%sdpseci.%u rx.%d", first ? "" : ", ",
+				       seci->id, k);
+				first = false;
+			}
+		}
+		printf("%s\n", first ? "-" : "");
+
+		if (dest->type == DPSECI_DEST_DPIO) {
+			num_dpios++;
+			if (dest->num_queues < min_dpio)
+				min_dpio = dest->num_queues;
+			if (dest->num_queues > max_dpio)
+				max_dpio = dest->num_queues;
+		}
+	}
+
+	if (num_dpios > 1)
+		printf("  rx queues per dpio: %d to %d%s\n", min_dpio, max_dpio,
+		       max_dpio - min_dpio > 1 ? " (imbalanced)" : "");
+
+	for (int i = 0; i < map->num_seci; i++) {
+		const struct dpseci_queues *seci = &map->seci[i];
+
+		if (seci->error)
+			continue;
+
+		for (int j = 0; j < seci->num_tx; j++)
+			tx_per_priority[seci->tx[j].priority]++;
+	}
+
+	printf("\ntx queues per SEC priority:");
+	first = true;
+	for (unsigned int i = 0; i < ARRAY_SIZE(tx_per_priority); i++) {
+		if (tx_per_priority[i] == 0)
+			continue;
+
+		printf("%s %u: %u", first ? "" : ",", i, tx_per_priority[i]);
+		first = false;
+	}
+	printf("%s\n", first ? " -" : "");
+}
+
+static int cmd_dpseci_queues(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool dpseci queues [<dpseci-object>]\n"
+		"   Shows the FQID and priority of every rx and tx queue of\n"
+		"   all DPSECIs in the root container and the containers below\n"
+		"   it, or only of the given DPSECI. The DPIO or DPCON each rx\n"
+		"   queue is placed on is shown too. A summary then counts rx\n"
+		"   queues per DPIO and DPCON, idle DPIOs included, and tx\n"
+		"   queues per SEC priority, to spot an unbalanced spread.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Show the queues of all DPSECIs:\n"
+		"   $ restool dpseci queues\n"
+		"\n";
+
+	struct dprc_walk_node *root = NULL;
+	struct queue_map map;
+	uint32_t dpseci_id;
+	int filter = -1;
+	int read_error = 0;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(QUEUES_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(QUEUES_OPT_HELP);
+		return 0;
+	}
+
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dpseci",
+					  &dpseci_id);
+		if (error < 0)
+			return error;
+		filter = dpseci_id;
+	}
+
+	memset(&map, 0, sizeof(map));
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	error = add_queue_map_objs(root, &map, filter);
+	if (error < 0)
+		goto out;
+
+	if (map.num_seci == 0) {
+		if (filter >= 0) {
+			ERROR_PRINTF("dpseci.%d not found under dprc.%u\n",
+				     filter, restool.root_dprc_id);
+			error = -ENOENT;
+		} else {
+			printf("no dpseci objects in dprc.%u\n",
+			       restool.root_dprc_id);
+		}
+		goto out;
+	}
+
+	for (int i = 0; i < map.num_seci; i++) {
+		struct dpseci_queues *seci = &map.seci[i];
+		struct queue_dest *dest;
+
+		if (read_dpseci_queues(seci) < 0) {
+			if (read_error == 0)
+				read_error = seci->error;
+			continue;
+		}
+
+		for (int j = 0; j < seci->num_rx; j++) {
+			dest = find_queue_dest(&map,
+					       seci->rx[j].dest_cfg.dest_type,
+					       seci->rx[j].dest_cfg.dest_id);
+			if (!dest) {
+				error = -ENOMEM;
+				goto out;
+			}
+			dest->num_queues++;
+		}
+	}
+
+	for (int i = 0; i < map.num_seci; i++) {
+		if (i > 0)
+			printf("\n");
+		print_dpseci_queues(&map.seci[i]);
+	}
+
+	print_queue_placement(&map);
+
+	/* Every DPSECI is shown, but a failed read still fails the command */
+	error = read_error;
+out:
+	free(map.seci);
+	free(map.dests);
+	if (root)
+		dprc_walk_free(root);
+	return error;
+}
+
 struct object_command dpseci_commands_v9[] = {
 	{ .cmd_name = "help",
 	  .options = NULL,
@@ -923,7 +1384,7 @@ struct object_command dpseci_commands_v9[] = {
 struct object_command dpseci_commands_v10[] = {
 	{ .cmd_name = "help",
 	  .options = NULL,
-	  .cmd_func = cmd_dpseci_help },
+	  .cmd_func = cmd_dpseci_help_v10 },
 
 	{ .cmd_name = "info",
 	  .options = dpseci_info_options,
@@ -937,6 +1398,10 @@ struct object_command dpseci_commands_v10[] = {
 	  .options = dpseci_destroy_options,
 	  .cmd_func = cmd_dpseci_destroy_v10 },
 
+	{ .cmd_name = "queues",
+	  .options = dpseci_queues_options,
+	  .cmd_func = cmd_dpseci_queues },
+
 	{ .cmd_name = NULL },
 };
 
@@ -40,6 +40,7 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "handle_cache.h"
 #include "mc_v9/fsl_dpsw.h"
 #include "mc_v10/fsl_dpsw.h"
 
@@ -93,6 +94,9 @@ enum dpsw_create_options {
 	CREATE_OPT_FDB_AGING_TIME,
 	CREATE_OPT_MAX_FDB_MC_GROUPS,
 	CREATE_OPT_PARENT_DPRC,
+	CREATE_OPT_COUNT,
+	CREATE_OPT_ASSIGN_TO,
+	CREATE_OPT_PLUGGED,
 };
 
 static struct option dpsw_create_options[] = {
@@ -159,6 +163,27 @@ static struct option dpsw_create_options[] = {
 		.val = 0,
 	},
 
+	[CREATE_OPT_COUNT] = {
+		.name = "count",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_ASSIGN_TO] = {
+		.name = "assign-to",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[CREATE_OPT_PLUGGED] = {
+		.name = "plugged",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
 	{ 0 },
 };
 
@@ -184,11 +209,12 @@ static struct option dpsw_destroy_options[] = {
 
 C_ASSERT(ARRAY_SIZE(dpsw_destroy_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
 
-static const struct flib_ops dpsw_ops = {
+const struct flib_ops dpsw_ops = {
 	.obj_open = dpsw_open,
 	.obj_close = dpsw_close,
 	.obj_get_irq_mask = dpsw_get_irq_mask,
 	.obj_get_irq_status = dpsw_get_irq_status,
+	.obj_destroy = dpsw_destroy_v10,
 };
 
 static struct option_entry options_map[] = {
@@ -301,7 +327,8 @@ static int print_dpsw_attr_v9(uint32_t dpsw_id,
 	struct dpsw_attr_v9 dpsw_attr;
 	bool dpsw_opened = false;
 
-	error = dpsw_open(&restool.mc_io, 0, dpsw_id, &dpsw_handle);
+	error = handle_cache_open("dpsw", dpsw_id, dpsw_open,
+				  dpsw_close, &dpsw_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -349,18 +376,8 @@ static int print_dpsw_attr_v9(uint32_t dpsw_id,
 	error = 0;
 
 out:
-	if (dpsw_opened) {
-		int error2;
-
-		error2 = dpsw_close(&restool.mc_io, 0, dpsw_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpsw_opened)
+		(void)handle_cache_release(dpsw_handle);
 
 	return error;
 }
@@ -374,7 +391,8 @@ static int print_dpsw_attr_v10(uint32_t dpsw_id,
 	uint16_t dpsw_handle;
 	int error;
 
-	error = dpsw_open_v10(&restool.mc_io, 0, dpsw_id, &dpsw_handle);
+	error = handle_cache_open("dpsw", dpsw_id, dpsw_open_v10,
+				  dpsw_close_v10, &dpsw_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -429,18 +447,8 @@ static int print_dpsw_attr_v10(uint32_t dpsw_id,
 	error = 0;
 
 out:
-	if (dpsw_opened) {
-		int error2;
-
-		error2 = dpsw_close_v10(&restool.mc_io, 0, dpsw_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				     mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
+	if (dpsw_opened)
+		(void)handle_cache_release(dpsw_handle);
 
 	return error;
 }
@@ -857,7 +865,7 @@ static int create_dpsw_v10(const char *usage_msg)
 	}
 
 	if (dprc_opened) {
-		(void)dprc_close(&restool.mc_io, 0, dprc_handle);
+		(void)close_dprc(dprc_handle);
 		print_new_obj("dpsw", dpsw_id,
 			      restool.cmd_option_args[CREATE_OPT_PARENT_DPRC]);
 	} else {
@@ -912,6 +920,7 @@ static int destroy_dpsw_v9(uint32_t dpsw_id)
 	uint16_t dpsw_handle;
 	int error, error2;
 
+	(void)handle_cache_evict("dpsw", dpsw_id);
 	error = dpsw_open(&restool.mc_io, 0, dpsw_id, &dpsw_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
@@ -971,6 +980,7 @@ static int destroy_dpsw_v10(uint32_t dpsw_id)
 			return error;
 	}
 
+	(void)handle_cache_evict("dpsw", dpsw_id);
 	error = dpsw_destroy_v10(&restool.mc_io, dprc_handle,
 				 0, dpsw_id);
 	if (error < 0) {
@@ -983,7 +993,7 @@ static int destroy_dpsw_v10(uint32_t dpsw_id)
 
 out:
 	if (dprc_id != restool.root_dprc_id)
-		error = dprc_close(&restool.mc_io, 0, dprc_handle);
+		error = close_dprc(dprc_handle);
 
 	return error;
 }
@@ -0,0 +1,524 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+#include "restool.h"
+#include "utils.h"
+#include "dts.h"
+
+/*
+ * Reader for the subset of the device tree source syntax used by DPL
+ * files: nodes, properties holding strings and <...> cell lists,
+ * C and C++ comments and the /dts-v1/ tag. Labels, references,
+ * includes and byte strings are not supported.
+ */
+
+enum dts_token {
+	DTS_TOK_EOF = 0,
+	DTS_TOK_WORD,
+	DTS_TOK_STRING,
+	DTS_TOK_CHAR,
+};
+
+/**
+ * struct dts_lexer - tokenizer state
+ * @file: file name, for error messages
+ * @pos: next character to read
+ * @line: line of @pos
+ * @token: kind of the current token
+ * @text: text of the current token, for words and strings
+ * @text_size: allocated size of @text
+ * @c: the current token, for single character tokens
+ */
+struct dts_lexer {
+	const char *file;
+	const char *pos;
+	int line;
+	enum dts_token token;
+	char *text;
+	size_t text_size;
+	char c;
+};
+
+static bool is_word_char(char c)
+{
+	return c != '\0' &&
+	       (isalnum((unsigned char)c) || strchr("_@,.-+#/?", c));
+}
+
+static int lex_error(struct dts_lexer *lex, const char *what)
+{
+	ERROR_PRINTF("%s:%d: %s\n", lex->file, lex->line, what);
+	return -EINVAL;
+}
+
+static int lex_append(struct dts_lexer *lex, size_t len, char c)
+{
+	if (len + 1 >= lex->text_size) {
+		size_t size = lex->text_size ? 2 * lex->text_size : 64;
+		char *text = realloc(lex->text, size);
+
+		if (!text) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+		lex->text = text;
+		lex->text_size = size;
+	}
+
+	lex->text[len] = c;
+	lex->text[len + 1] = '\0';
+	return 0;
+}
+
+static int skip_blanks(struct dts_lexer *lex)
+{
+	for (;;) {
+		const char *p = lex->pos;
+
+		if (*p == '\n') {
+			lex->line++;
+			lex->pos++;
+		} else if (isspace((unsigned char)*p)) {
+			lex->pos++;
+		} else if (p[0] == '/' && p[1] == '/') {
+			lex->pos += strcspn(p, "\n");
+		} else if (p[0] == '/' && p[1] == '*') {
+			for (p += 2; *p && !(p[0] == '*' && p[1] == '/'); p++) {
+				if (*p == '\n')
+					lex->line++;
+			}
+			if (*p == '\0')
+				return lex_error(lex, "unterminated comment");
+			lex->pos = p + 2;
+		} else {
+			return 0;
+		}
+	}
+}
+
+/**
+ * Reads the next token
+ */
+static int lex_next(struct dts_lexer *lex)
+{
+	size_t len = 0;
+	int error;
+
+	error = skip_blanks(lex);
+	if (error)
+		return error;
+
+	if (*lex->pos == '\0') {
+		lex->token = DTS_TOK_EOF;
+		return 0;
+	}
+
+	if (*lex->pos == '"') {
+		lex->token = DTS_TOK_STRING;
+		error = lex_append(lex, 0, '\0');
+		if (error)
+			return error;
+		for (lex->pos++; *lex->pos != '"'; lex->pos++) {
+			char c = *lex->pos;
+
+			if (c == '\0' || c == '\n')
+				return lex_error(lex, "unterminated string");
+			if (c == '\\' && lex->pos[1] != '\0')
+				c = *++lex->pos;
+			error = lex_append(lex, len++, c);
+			if (error)
+				return error;
+		}
+		lex->pos++;
+		return 0;
+	}
+
+	/* A ',' inside a name is part of it, anywhere else it separates values */
+	if (is_word_char(*lex->pos) && *lex->pos != ',') {
+		lex->token = DTS_TOK_WORD;
+		while (is_word_char(*lex->pos)) {
+			error = lex_append(lex, len++, *lex->pos++);
+			if (error)
+				return error;
+		}
+		return 0;
+	}
+
+	lex->token = DTS_TOK_CHAR;
+	lex->c = *lex->pos++;
+	return 0;
+}
+
+static bool lex_is(const struct dts_lexer *lex, char c)
+{
+	return lex->token == DTS_TOK_CHAR && lex->c == c;
+}
+
+static int lex_expect(struct dts_lexer *lex, char c)
+{
+	char msg[32];
+
+	if (!lex_is(lex, c)) {
+		snprintf(msg, sizeof(msg), "'%c' expected", c);
+		return lex_error(lex, msg);
+	}
+
+	return lex_next(lex);
+}
+
+static void free_prop(struct dts_prop *prop)
+{
+	for (int i = 0; i < prop->num_strings; i++)
+		free(prop->strings[i]);
+	free(prop->strings);
+	free(prop->cells);
+	free(prop->name);
+	free(prop);
+}
+
+static int add_string(struct dts_prop *prop, const char *str)
+{
+	char **strings;
+
+	strings = realloc(prop->strings,
+			  (prop->num_strings + 1) * sizeof(*strings));
+	if (!strings) {
+		ERROR_PRINTF("realloc failed\n");
+		return -ENOMEM;
+	}
+	prop->strings = strings;
+
+	strings[prop->num_strings] = strdup(str);
+	if (!strings[prop->num_strings]) {
+		ERROR_PRINTF("strdup failed\n");
+		return -ENOMEM;
+	}
+	prop->num_strings++;
+
+	return 0;
+}
+
+static int add_cell(struct dts_lexer *lex, struct dts_prop *prop)
+{
+	uint64_t *cells;
+	char *end;
+
+	cells = realloc(prop->cells, (prop->num_cells + 1) * sizeof(*cells));
+	if (!cells) {
+		ERROR_PRINTF("realloc failed\n");
+		return -ENOMEM;
+	}
+	prop->cells = cells;
+
+	errno = 0;
+	cells[prop->num_cells] = strtoull(lex->text, &end, 0);
+	if (errno || *end != '\0')
+		return lex_error(lex, "invalid cell value");
+	prop->num_cells++;
+
+	return 0;
+}
+
+/**
+ * Parses the values of a property, after the '=', up to and including
+ * the ';'
+ */
+static int parse_values(struct dts_lexer *lex, struct dts_prop *prop)
+{
+	int error;
+
+	for (;;) {
+		if (lex->token == DTS_TOK_STRING) {
+			error = add_string(prop, lex->text);
+			if (error)
+				return error;
+			error = lex_next(lex);
+		} else if (lex_is(lex, '<')) {
+			error = lex_next(lex);
+			while (error == 0 && lex->token == DTS_TOK_WORD) {
+				error = add_cell(lex, prop);
+				if (error == 0)
+					error = lex_next(lex);
+			}
+			if (error == 0)
+				error = lex_expect(lex, '>');
+		} else {
+			return lex_error(lex, "property value expected");
+		}
+		if (error)
+			return error;
+
+		if (!lex_is(lex, ','))
+			break;
+		error = lex_next(lex);
+		if (error)
+			return error;
+	}
+
+	return lex_expect(lex, ';');
+}
+
+/**
+ * Parses the body of a node, after the '{', up to and including the
+ * closing "};"
+ */
+static int parse_node_body(struct dts_lexer *lex, struct dts_node *node)
+{
+	struct dts_node **child_tail = &node->children;
+	struct dts_prop **prop_tail = &node->props;
+	int error;
+
+	for (;;) {
+		char *name;
+
+		if (lex_is(lex, '}')) {
+			error = lex_next(lex);
+			if (error)
+				return error;
+			return lex_expect(lex, ';');
+		}
+
+		if (lex->token != DTS_TOK_WORD)
+			return lex_error(lex, "property or node name expected");
+
+		name = strdup(lex->text);
+		if (!name) {
+			ERROR_PRINTF("strdup failed\n");
+			return -ENOMEM;
+		}
+
+		error = lex_next(lex);
+		if (error) {
+			free(name);
+			return error;
+		}
+
+		if (lex_is(lex, '{')) {
+			struct dts_node *child = calloc(1, sizeof(*child));
+
+			if (!child) {
+				free(name);
+				ERROR_PRINTF("calloc failed\n");
+				return -ENOMEM;
+			}
+			child->name = name;
+			*child_tail = child;
+			child_tail = &child->next;
+
+			error = lex_next(lex);
+			if (error == 0)
+				error = parse_node_body(lex, child);
+		} else {
+			struct dts_prop *prop = calloc(1, sizeof(*prop));
+
+			if (!prop) {
+				free(name);
+				ERROR_PRINTF("calloc failed\n");
+				return -ENOMEM;
+			}
+			prop->name = name;
+			*prop_tail = prop;
+			prop_tail = &prop->next;
+
+			if (lex_is(lex, '=')) {
+				error = lex_next(lex);
+				if (error == 0)
+					error = parse_values(lex, prop);
+			} else {
+				error = lex_expect(lex, ';');
+			}
+		}
+		if (error)
+			return error;
+	}
+}
+
+/**
+ * dts_read() - read a device tree source file
+ * @file: file to read
+ * @root: set to the "/" node, to be freed with dts_free()
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int dts_read(const char *file, struct dts_node **root)
+{
+	struct dts_lexer lex = { .file = file, .line = 1 };
+	struct dts_node *node;
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *fp;
+	int error;
+
+	*root = NULL;
+	fp = fopen(file, "r");
+	if (!fp) {
+		error = -errno;
+		ERROR_PRINTF("cannot open %s: %s\n", file, strerror(errno));
+		return error;
+	}
+
+	error = getdelim(&buf, &size, '\0', fp) < 0 && ferror(fp) ? -EIO : 0;
+	fclose(fp);
+	if (error) {
+		ERROR_PRINTF("error reading %s\n", file);
+		goto out;
+	}
+
+	node = calloc(1, sizeof(*node));
+	if (!node) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+	*root = node;
+
+	lex.pos = buf ? buf : "";
+	error = lex_next(&lex);
+	while (error == 0 && lex.token != DTS_TOK_EOF) {
+		if (lex.token != DTS_TOK_WORD) {
+			error = lex_error(&lex, "node expected");
+			break;
+		}
+
+		/* The version tag is the only directive DPL files use */
+		if (strcmp(lex.text, "/dts-v1/") == 0) {
+			error = lex_next(&lex);
+			if (error == 0)
+				error = lex_expect(&lex, ';');
+			continue;
+		}
+
+		if (strcmp(lex.text, "/") != 0) {
+			error = lex_error(&lex, "only the / node may be at top level");
+			break;
+		}
+
+		/* Several / blocks add to the same node */
+		error = lex_next(&lex);
+		if (error == 0)
+			error = lex_expect(&lex, '{');
+		if (error == 0) {
+			struct dts_node block = { 0 };
+			struct dts_node **child_tail = &node->children;
+			struct dts_prop **prop_tail = &node->props;
+
+			error = parse_node_body(&lex, &block);
+			while (*child_tail)
+				child_tail = &(*child_tail)->next;
+			while (*prop_tail)
+				prop_tail = &(*prop_tail)->next;
+			*child_tail = block.children;
+			*prop_tail = block.props;
+		}
+	}
+
+	if (error == 0 && !node->name) {
+		node->name = strdup("/");
+		if (!node->name) {
+			ERROR_PRINTF("strdup failed\n");
+			error = -ENOMEM;
+		}
+	}
+
+out:
+	if (error) {
+		dts_free(*root);
+		*root = NULL;
+	}
+	free(lex.text);
+	free(buf);
+	return error;
+}
+
+void dts_free(struct dts_node *node)
+{
+	while (node) {
+		struct dts_node *next = node->next;
+
+		while (node->props) {
+			struct dts_prop *prop = node->props;
+
+			node->props = prop->next;
+			free_prop(prop);
+		}
+		dts_free(node->children);
+		free(node->name);
+		free(node);
+		node = next;
+	}
+}
+
+/**
+ * Returns the first child of node with the given name, or NULL
+ */
+struct dts_node *dts_child(const struct dts_node *node, const char *name)
+{
+	for (struct dts_node *child = node->children; child;
+	     child = child->next) {
+		if (strcmp(child->name, name) == 0)
+			return child;
+	}
+
+	return NULL;
+}
+
+const struct dts_prop *dts_prop(const struct dts_node *node,
+				const char *name)
+{
+	for (const struct dts_prop *prop = node->props; prop;
+	     prop = prop->next) {
+		if (strcmp(prop->name, name) == 0)
+			return prop;
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the first string of a property, or NULL if the node does not
+ * have it or it holds no string
+ */
+const char *dts_string(const struct dts_node *node, const char *name)
+{
+	const struct dts_prop *prop = dts_prop(node, name);
+
+	if (!prop || prop->num_strings == 0)
+		return NULL;
+
+	return prop->strings[0];
+}
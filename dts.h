@@ -0,0 +1,81 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _DTS_H_
+#define _DTS_H_
+
+#include <stdint.h>
+
+/**
+ * struct dts_prop - property of a device tree source node
+ * @next: next property of the same node, in file order
+ * @name: property name
+ * @strings: the string values, in file order
+ * @num_strings: number of entries in @strings
+ * @cells: the values of all <...> lists, in file order
+ * @num_cells: number of entries in @cells
+ */
+struct dts_prop {
+	struct dts_prop *next;
+	char *name;
+	char **strings;
+	int num_strings;
+	uint64_t *cells;
+	int num_cells;
+};
+
+/**
+ * struct dts_node - node of a device tree source
+ * @next: next sibling, in file order
+ * @name: node name, including the "@<unit>" part if any
+ * @props: properties of the node
+ * @children: first child node
+ */
+struct dts_node {
+	struct dts_node *next;
+	char *name;
+	struct dts_prop *props;
+	struct dts_node *children;
+};
+
+int dts_read(const char *file, struct dts_node **root);
+
+void dts_free(struct dts_node *node);
+
+struct dts_node *dts_child(const struct dts_node *node, const char *name);
+
+const struct dts_prop *dts_prop(const struct dts_node *node,
+				const char *name);
+
+const char *dts_string(const struct dts_node *node, const char *name);
+
+#endif /* _DTS_H_ */
@@ -0,0 +1,278 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include "restool.h"
+#include "utils.h"
+#include "handle_cache.h"
+
+/**
+ * struct handle_cache_entry - object handle kept open on the restool portal
+ * @type: object type
+ * @id: object id
+ * @token: authentication token returned by the object's open command
+ * @obj_close: flib function closing @token
+ * @refcount: number of callers currently using @token
+ * @last_use: value of use_clock when the entry was last handed out
+ * @valid: entry is in use
+ */
+struct handle_cache_entry {
+	char type[OBJ_TYPE_MAX_LENGTH + 1];
+	uint32_t id;
+	uint16_t token;
+	flib_obj_close_t *obj_close;
+	int refcount;
+	unsigned long last_use;
+	bool valid;
+};
+
+static struct handle_cache_entry handle_cache[HANDLE_CACHE_SIZE];
+static unsigned long use_clock;
+
+static int close_entry(struct handle_cache_entry *entry)
+{
+	enum mc_cmd_status mc_status;
+	int error;
+
+	assert(entry->valid && entry->refcount == 0);
+	DEBUG_PRINTF("closing %s.%u (token %#x)\n",
+		     entry->type, entry->id, entry->token);
+	entry->valid = false;
+	error = entry->obj_close(&restool.mc_io, 0, entry->token);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	return error;
+}
+
+/**
+ * Closes the least recently used handle nobody holds.
+ * Returns 0 if one was closed, -ENOENT if all cached handles are in use.
+ */
+static int evict_lru(void)
+{
+	struct handle_cache_entry *lru = NULL;
+
+	for (int i = 0; i < HANDLE_CACHE_SIZE; i++) {
+		struct handle_cache_entry *entry = &handle_cache[i];
+
+		if (!entry->valid || entry->refcount != 0)
+			continue;
+
+		if (!lru || entry->last_use < lru->last_use)
+			lru = entry;
+	}
+
+	if (!lru)
+		return -ENOENT;
+
+	(void)close_entry(lru);
+	return 0;
+}
+
+static struct handle_cache_entry *find_entry(const char *type, uint32_t id)
+{
+	for (int i = 0; i < HANDLE_CACHE_SIZE; i++) {
+		struct handle_cache_entry *entry = &handle_cache[i];
+
+		if (entry->valid && entry->id == id &&
+		    strcmp(entry->type, type) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * handle_cache_open() - get an open handle for an object
+ * @type: object type
+ * @id: object id
+ * @obj_open: flib open function for @type
+ * @obj_close: flib close function for @type
+ * @token: returns the authentication token
+ *
+ * Objects are opened on the restool portal at most once per run; later
+ * callers get the same token back. Every successful call must be paired
+ * with handle_cache_release(). Handles stay open until
+ * handle_cache_flush(), or until the MC runs out of room for new ones,
+ * in which case the least recently used idle handle is closed first.
+ *
+ * Returns 0 on success, negative MC error otherwise (not printed)
+ */
+int handle_cache_open(const char *type, uint32_t id,
+		      flib_obj_open_t *obj_open,
+		      flib_obj_close_t *obj_close,
+		      uint16_t *token)
+{
+	struct handle_cache_entry *entry;
+	int error;
+
+	assert(strlen(type) <= OBJ_TYPE_MAX_LENGTH);
+	entry = find_entry(type, id);
+	if (entry) {
+		entry->refcount++;
+		entry->last_use = ++use_clock;
+		*token = entry->token;
+		return 0;
+	}
+
+	for (int i = 0; i < HANDLE_CACHE_SIZE && !entry; i++)
+		if (!handle_cache[i].valid)
+			entry = &handle_cache[i];
+
+	if (!entry) {
+		if (evict_lru() < 0) {
+			ERROR_PRINTF("too many objects open at once\n");
+			return -ENOSPC;
+		}
+
+		return handle_cache_open(type, id, obj_open, obj_close, token);
+	}
+
+	for ( ; ; ) {
+		error = obj_open(&restool.mc_io, 0, id, token);
+		if (error != -ENAVAIL && error != -EBUSY)
+			break;
+
+		DEBUG_PRINTF("MC handle limit reached opening %s.%u\n",
+			     type, id);
+		if (evict_lru() < 0)
+			break;
+	}
+
+	if (error < 0)
+		return error;
+
+	strcpy(entry->type, type);
+	entry->id = id;
+	entry->token = *token;
+	entry->obj_close = obj_close;
+	entry->refcount = 1;
+	entry->last_use = ++use_clock;
+	entry->valid = true;
+	return 0;
+}
+
+/**
+ * handle_cache_release() - drop a reference taken by handle_cache_open()
+ * @token: token returned by handle_cache_open()
+ *
+ * The handle itself stays open for later users.
+ */
+int handle_cache_release(uint16_t token)
+{
+	for (int i = 0; i < HANDLE_CACHE_SIZE; i++) {
+		struct handle_cache_entry *entry = &handle_cache[i];
+
+		if (entry->valid && entry->token == token) {
+			assert(entry->refcount > 0);
+			entry->refcount--;
+			return 0;
+		}
+	}
+
+	DEBUG_PRINTF("token %#x is not cached\n", token);
+	return -ENOENT;
+}
+
+/**
+ * handle_cache_evict() - close the cached handle of an object, if idle
+ * @type: object type
+ * @id: object id
+ *
+ * To be called before an object is destroyed.
+ */
+int handle_cache_evict(const char *type, uint32_t id)
+{
+	struct handle_cache_entry *entry = find_entry(type, id);
+
+	if (!entry || entry->refcount != 0)
+		return 0;
+
+	return close_entry(entry);
+}
+
+/**
+ * handle_cache_trim() - close all cached handles nobody holds
+ *
+ * Destroying a container invalidates the handles of everything inside
+ * it, so this is called before a container is destroyed.
+ */
+int handle_cache_trim(void)
+{
+	int error = 0;
+
+	for (int i = 0; i < HANDLE_CACHE_SIZE; i++) {
+		struct handle_cache_entry *entry = &handle_cache[i];
+		int error2;
+
+		if (!entry->valid || entry->refcount != 0)
+			continue;
+
+		error2 = close_entry(entry);
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+/**
+ * handle_cache_flush() - close all cached handles
+ *
+ * Returns the first close error, if any
+ */
+int handle_cache_flush(void)
+{
+	int error = 0;
+
+	for (int i = 0; i < HANDLE_CACHE_SIZE; i++) {
+		struct handle_cache_entry *entry = &handle_cache[i];
+		int error2;
+
+		if (!entry->valid)
+			continue;
+
+		entry->refcount = 0;
+		error2 = close_entry(entry);
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
@@ -0,0 +1,166 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "restool.h"
+#include "utils.h"
+#include "idset.h"
+
+void idset_init(struct idset *set)
+{
+	memset(set, 0, sizeof(*set));
+}
+
+void idset_free(struct idset *set)
+{
+	free(set->ranges);
+	idset_init(set);
+}
+
+/**
+ * Adds the ids first..last to a set, merging the new range with any
+ * range it overlaps or touches
+ */
+int idset_add_range(struct idset *set, int first, int last)
+{
+	int lo, hi;
+
+	if (first > last)
+		return -EINVAL;
+
+	/* First range that ends at or after first - 1 */
+	lo = 0;
+	hi = set->num_ranges;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if ((int64_t)set->ranges[mid].last + 1 < first)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* Ranges lo..hi-1 overlap or touch first..last */
+	for (hi = lo; hi < set->num_ranges; hi++) {
+		if (set->ranges[hi].first > (int64_t)last + 1)
+			break;
+	}
+
+	if (hi > lo) {
+		if (set->ranges[lo].first < first)
+			first = set->ranges[lo].first;
+		if (set->ranges[hi - 1].last > last)
+			last = set->ranges[hi - 1].last;
+
+		set->ranges[lo].first = first;
+		set->ranges[lo].last = last;
+		memmove(&set->ranges[lo + 1], &set->ranges[hi],
+			(set->num_ranges - hi) * sizeof(*set->ranges));
+		set->num_ranges -= hi - lo - 1;
+		return 0;
+	}
+
+	if (set->num_ranges == set->max_ranges) {
+		struct id_range *ranges;
+		int max = set->max_ranges ? 2 * set->max_ranges : 8;
+
+		ranges = realloc(set->ranges, max * sizeof(*ranges));
+		if (!ranges) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		set->ranges = ranges;
+		set->max_ranges = max;
+	}
+
+	memmove(&set->ranges[lo + 1], &set->ranges[lo],
+		(set->num_ranges - lo) * sizeof(*set->ranges));
+	set->ranges[lo].first = first;
+	set->ranges[lo].last = last;
+	set->num_ranges++;
+	return 0;
+}
+
+int idset_union(struct idset *dst, const struct idset *src)
+{
+	for (int i = 0; i < src->num_ranges; i++) {
+		int error = idset_add_range(dst, src->ranges[i].first,
+					    src->ranges[i].last);
+
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+uint64_t idset_count(const struct idset *set)
+{
+	uint64_t count = 0;
+
+	for (int i = 0; i < set->num_ranges; i++)
+		count += (int64_t)set->ranges[i].last -
+			 set->ranges[i].first + 1;
+
+	return count;
+}
+
+/**
+ * Number of ids present in both sets, in one merge pass over the two
+ * range lists
+ */
+uint64_t idset_overlap_count(const struct idset *a, const struct idset *b)
+{
+	uint64_t count = 0;
+	int i = 0, j = 0;
+
+	while (i < a->num_ranges && j < b->num_ranges) {
+		int first = a->ranges[i].first > b->ranges[j].first ?
+			    a->ranges[i].first : b->ranges[j].first;
+		int last = a->ranges[i].last < b->ranges[j].last ?
+			   a->ranges[i].last : b->ranges[j].last;
+
+		if (first <= last)
+			count += (int64_t)last - first + 1;
+
+		if (a->ranges[i].last < b->ranges[j].last)
+			i++;
+		else
+			j++;
+	}
+
+	return count;
+}
@@ -0,0 +1,71 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _IDSET_H_
+#define _IDSET_H_
+
+#include <stdint.h>
+
+/**
+ * struct id_range - inclusive range of resource ids
+ */
+struct id_range {
+	int first;
+	int last;
+};
+
+/**
+ * struct idset - set of resource ids kept as sorted, disjoint and
+ *	non-adjacent ranges
+ * @ranges: the ranges, in ascending order
+ * @num_ranges: number of entries in @ranges
+ * @max_ranges: allocated size of @ranges
+ */
+struct idset {
+	struct id_range *ranges;
+	int num_ranges;
+	int max_ranges;
+};
+
+void idset_init(struct idset *set);
+
+void idset_free(struct idset *set);
+
+int idset_add_range(struct idset *set, int first, int last);
+
+int idset_union(struct idset *dst, const struct idset *src);
+
+uint64_t idset_count(const struct idset *set);
+
+uint64_t idset_overlap_count(const struct idset *a, const struct idset *b);
+
+#endif /* _IDSET_H_ */
@@ -0,0 +1,278 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "label_index.h"
+
+/**
+ * struct label_entry - one slot of the label hash table
+ * @label: object label, empty for a free slot
+ * @obj_name: name of the labelled object, e.g. "dpni.3"
+ * @ambiguous: more than one object carries @label
+ */
+struct label_entry {
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	char obj_name[OBJ_TYPE_MAX_LENGTH + 12];
+	bool ambiguous;
+};
+
+static struct label_entry *label_table;
+static uint32_t label_table_size;
+static bool label_index_built;
+static bool label_index_stale;
+
+/*
+ * Tables replaced by a rebuild. Names returned by label_index_lookup()
+ * point into them, so they are only freed by label_index_free().
+ */
+static struct label_entry **retired_tables;
+static int num_retired_tables;
+
+/* FNV-1a */
+static uint32_t label_hash(const char *label)
+{
+	uint32_t hash = 2166136261u;
+
+	for (; *label != '\0'; label++) {
+		hash ^= (unsigned char)*label;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static struct label_entry *find_slot(const char *label)
+{
+	uint32_t mask = label_table_size - 1;
+	uint32_t i = label_hash(label) & mask;
+
+	while (label_table[i].label[0] != '\0' &&
+	       strcmp(label_table[i].label, label) != 0)
+		i = (i + 1) & mask;
+
+	return &label_table[i];
+}
+
+static int count_labels(struct dprc_walk_node *node)
+{
+	int count = 0;
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->objs[i].label[0] != '\0')
+			count++;
+	}
+
+	for (int i = 0; i < node->num_children; i++)
+		count += count_labels(node->children[i]);
+
+	return count;
+}
+
+static void insert_labels(struct dprc_walk_node *node)
+{
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+		char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+		struct label_entry *entry;
+
+		if (desc->label[0] == '\0')
+			continue;
+
+		strncpy(label, desc->label, MC_OBJ_LABEL_MAX_LENGTH);
+		label[MC_OBJ_LABEL_MAX_LENGTH] = '\0';
+		entry = find_slot(label);
+		if (entry->label[0] != '\0') {
+			entry->ambiguous = true;
+			continue;
+		}
+
+		strcpy(entry->label, label);
+		snprintf(entry->obj_name, sizeof(entry->obj_name), "%s.%d",
+			 desc->type, desc->id);
+	}
+
+	for (int i = 0; i < node->num_children; i++)
+		insert_labels(node->children[i]);
+}
+
+/**
+ * Indexes the labels of all objects below the root container, using a
+ * single container walk
+ */
+static int build_label_index(void)
+{
+	struct dprc_walk_node *root = NULL;
+	uint32_t size = 16;
+	int num_labels;
+	int error;
+
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	num_labels = count_labels(root);
+	while (size < 2 * (uint32_t)num_labels)
+		size *= 2;
+
+	label_table = calloc(size, sizeof(*label_table));
+	if (!label_table) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+	label_table_size = size;
+
+	insert_labels(root);
+	label_index_built = true;
+	DEBUG_PRINTF("indexed %d labels\n", num_labels);
+out:
+	dprc_walk_free(root);
+	return error;
+}
+
+static int rebuild_label_index(void)
+{
+	struct label_entry **tables;
+
+	if (label_table) {
+		tables = realloc(retired_tables, (num_retired_tables + 1) *
+				 sizeof(*tables));
+		if (!tables) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		retired_tables = tables;
+		retired_tables[num_retired_tables++] = label_table;
+		label_table = NULL;
+		label_table_size = 0;
+	}
+
+	label_index_built = false;
+	label_index_stale = false;
+	return build_label_index();
+}
+
+/**
+ * Finds the object carrying a label. On success *obj_name points to
+ * its "<type>.<id>" name, which stays valid until label_index_free().
+ * A label missing from an index built earlier in the session is looked
+ * up again in a fresh one, in case it was set since.
+ */
+int label_index_lookup(const char *label, const char **obj_name)
+{
+	struct label_entry *entry;
+	bool fresh = false;
+	int error;
+
+	if (!label_index_built || label_index_stale) {
+		error = rebuild_label_index();
+		if (error < 0)
+			return error;
+
+		fresh = true;
+	}
+
+	entry = find_slot(label);
+	if (entry->label[0] == '\0' && label[0] != '\0' && !fresh) {
+		error = rebuild_label_index();
+		if (error < 0)
+			return error;
+
+		entry = find_slot(label);
+	}
+
+	if (entry->label[0] == '\0' || label[0] == '\0') {
+		ERROR_PRINTF("No object labelled \'%s\'\n", label);
+		return -ENOENT;
+	}
+
+	if (entry->ambiguous) {
+		ERROR_PRINTF("More than one object labelled \'%s\'\n", label);
+		return -ENOTUNIQ;
+	}
+
+	*obj_name = entry->obj_name;
+	return 0;
+}
+
+/**
+ * Resolves a command line argument of the form "@<label>" to the name
+ * of the object carrying that label. Other arguments resolve to
+ * themselves.
+ */
+int resolve_label_arg(const char *arg, const char **obj_name)
+{
+	int error;
+
+	if (arg == NULL || arg[0] != LABEL_PREFIX) {
+		*obj_name = arg;
+		return 0;
+	}
+
+	error = label_index_lookup(arg + 1, obj_name);
+	if (error < 0)
+		return error;
+
+	DEBUG_PRINTF("%s is %s\n", arg, *obj_name);
+	return 0;
+}
+
+/**
+ * Marks the index out of date after a command created, destroyed or
+ * relabelled objects. It is rebuilt by the next lookup.
+ */
+void label_index_invalidate(void)
+{
+	label_index_stale = label_index_built;
+}
+
+void label_index_free(void)
+{
+	for (int i = 0; i < num_retired_tables; i++)
+		free(retired_tables[i]);
+
+	free(retired_tables);
+	retired_tables = NULL;
+	num_retired_tables = 0;
+	free(label_table);
+	label_table = NULL;
+	label_table_size = 0;
+	label_index_built = false;
+	label_index_stale = false;
+}
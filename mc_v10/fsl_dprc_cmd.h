@@ -63,6 +63,7 @@
 #define DPRC_CMDID_GET_RES_COUNT                DPRC_CMD(0x15B)
 #define DPRC_CMDID_GET_RES_IDS                  DPRC_CMD(0x15C)
 #define DPRC_CMDID_SET_OBJ_LABEL                DPRC_CMD(0x161)
+#define DPRC_CMDID_GET_OBJ_DESC                 DPRC_CMD(0x162)
 
 #define DPRC_CMDID_CONNECT                      DPRC_CMD(0x167)
 #define DPRC_CMDID_DISCONNECT                   DPRC_CMD(0x168)
@@ -164,6 +165,12 @@ struct dprc_rsp_get_obj {
 	uint8_t label[16];
 };
 
+struct dprc_cmd_get_obj_desc {
+	uint32_t obj_id;
+	uint32_t pad;
+	uint8_t type[16];
+};
+
 struct dprc_cmd_get_res_count {
 	uint64_t pad;
 	uint8_t type[16];
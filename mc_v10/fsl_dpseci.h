@@ -145,6 +145,56 @@ int dpseci_get_tx_queue_v10(struct fsl_mc_io *mc_io,
 			    uint8_t queue,
 			    struct dpseci_tx_queue_attr_v10 *attr);
 
+/**
+ * enum dpseci_dest_v10 - DPSECI destination types
+ * @DPSECI_DEST_NONE: Unassigned destination; The queue is set in parked mode
+ *		and does not generate FQDAN notifications
+ * @DPSECI_DEST_DPIO: The queue is affiliated with DPIO
+ * @DPSECI_DEST_DPCON: The queue is set in schedule mode and is affiliated
+ *		with a DPCON object
+ */
+enum dpseci_dest_v10 {
+	DPSECI_DEST_NONE = 0,
+	DPSECI_DEST_DPIO,
+	DPSECI_DEST_DPCON
+};
+
+/**
+ * struct dpseci_dest_cfg_v10 - Structure representing DPSECI destination
+ *	parameters
+ * @dest_type: Destination type
+ * @dest_id: Either DPIO ID or DPCON ID, depending on the destination type
+ * @priority: Priority selection within the DPIO or DPCON channel
+ */
+struct dpseci_dest_cfg_v10 {
+	enum dpseci_dest_v10 dest_type;
+	int dest_id;
+	uint8_t priority;
+};
+
+/**
+ * struct dpseci_rx_queue_attr_v10 - Structure representing attributes of
+ *	Rx queues
+ * @user_ctx: User context value provided in the frame descriptor of each
+ *	dequeued frame
+ * @order_preservation_en: Status of the order preservation configuration
+ *	on the queue
+ * @dest_cfg: Queue destination configuration
+ * @fqid: Virtual FQID value to be used for dequeue operations
+ */
+struct dpseci_rx_queue_attr_v10 {
+	uint64_t user_ctx;
+	int order_preservation_en;
+	struct dpseci_dest_cfg_v10 dest_cfg;
+	uint32_t fqid;
+};
+
+int dpseci_get_rx_queue_v10(struct fsl_mc_io *mc_io,
+			    uint32_t cmd_flags,
+			    uint16_t token,
+			    uint8_t queue,
+			    struct dpseci_rx_queue_attr_v10 *attr);
+
 int dpseci_get_api_version_v10(struct fsl_mc_io *mc_io,
 			       uint32_t cmd_flags,
 			       uint16_t *major_ver,
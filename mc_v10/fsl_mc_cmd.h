@@ -114,7 +114,10 @@ static inline uint64_t mc_encode_cmd_header(uint16_t cmd_id,
 	hdr->cmd_id = cpu_to_le16(cmd_id);
 	hdr->token = cpu_to_le16(token);
 	hdr->status = MC_CMD_STATUS_READY;
-	hdr->word[0] |= cpu_to_le32(cmd_flags & MC_CMD_HDR_FLAGS_MASK);
+	if (cmd_flags & MC_CMD_FLAG_PRI)
+		hdr->flags_hw = MC_CMD_FLAG_PRI;
+	if (cmd_flags & MC_CMD_FLAG_INTR_DIS)
+		hdr->flags_sw = MC_CMD_FLAG_INTR_DIS;
 
 	return header;
 }
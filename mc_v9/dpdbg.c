@@ -216,7 +216,7 @@ int dpdbg_get_dpci_fqid(struct fsl_mc_io	*mc_io,
 	int err;
 
 	/* prepare command */
-	cmd.header = mc_encode_cmd_header(DPDBG_CMDID_GET_DPBP_INFO,
+	cmd.header = mc_encode_cmd_header(DPDBG_CMDID_GET_DPCI_FQID,
 					  cmd_flags,
 					  token);
 	DPDBG_CMD_GET_DPCI_FQID(cmd, dpci_id, priority);
@@ -0,0 +1,321 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <dirent.h>
+#include <net/if.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "obj_list.h"
+
+#define FSL_MC_DEVICES_DIR	"/sys/bus/fsl-mc/devices"
+
+/**
+ * Longest container path, "dprc.<id>/" per nesting level
+ */
+#define LIST_PATH_SIZE		(MAX_DPRC_NESTING * 16)
+
+/**
+ * struct list_row - one listed object
+ * @obj: object name
+ * @container: path of the container holding the object, from the root
+ * @label: object label
+ * @endpoint: object at the other end of the link, empty if none
+ * @state: link state as returned by dprc_get_connection()
+ * @netdev: Linux network interface of the object, or of the DPNI at
+ *	the other end of the link, empty if none
+ */
+struct list_row {
+	char obj[OBJ_TYPE_MAX_LENGTH + 12];
+	char container[LIST_PATH_SIZE];
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	char endpoint[OBJ_TYPE_MAX_LENGTH + 24];
+	int state;
+	char netdev[IF_NAMESIZE];
+};
+
+struct list_rows {
+	struct list_row *rows;
+	int num_rows;
+	int max_rows;
+};
+
+static const char *link_state_name(int state)
+{
+	switch (state) {
+	case 1:
+		return "up";
+	case 0:
+		return "down";
+	default:
+		return "error";
+	}
+}
+
+/**
+ * Reads the name of the network interface the kernel created for an
+ * object, if any
+ */
+static void get_netdev(const char *obj, char *netdev)
+{
+	char path[PATH_MAX];
+	struct dirent *ent;
+	DIR *dir;
+
+	netdev[0] = '\0';
+	snprintf(path, sizeof(path), FSL_MC_DEVICES_DIR "/%s/net", obj);
+	dir = opendir(path);
+	if (!dir)
+		return;
+
+	while ((ent = readdir(dir)) != NULL) {
+		if (ent->d_name[0] == '.')
+			continue;
+
+		strncpy(netdev, ent->d_name, IF_NAMESIZE - 1);
+		netdev[IF_NAMESIZE - 1] = '\0';
+		break;
+	}
+
+	closedir(dir);
+}
+
+static int get_endpoint(struct list_row *row, const struct dprc_obj_desc *desc)
+{
+	struct dprc_endpoint endpoint1, endpoint2;
+	enum mc_cmd_status mc_status;
+	int error;
+
+	memset(&endpoint1, 0, sizeof(endpoint1));
+	memset(&endpoint2, 0, sizeof(endpoint2));
+	snprintf(endpoint1.type, sizeof(endpoint1.type), "%s", desc->type);
+	endpoint1.id = desc->id;
+	row->state = -1;
+	error = dprc_get_connection(&restool.mc_io, 0, restool.root_dprc_handle,
+				    &endpoint1, &endpoint2, &row->state);
+	if (error == -ENAVAIL || (error == 0 && row->state == -1)) {
+		row->state = -1;
+		return 0;
+	}
+
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("%s: MC error: %s (status %#x)\n", row->obj,
+			     mc_status_to_string(mc_status), mc_status);
+		return error;
+	}
+
+	endpoint2.type[EP_OBJ_TYPE_MAX_LEN] = '\0';
+	if (strcmp(endpoint2.type, "dpsw") == 0 ||
+	    strcmp(endpoint2.type, "dpdmux") == 0)
+		snprintf(row->endpoint, sizeof(row->endpoint), "%s.%d.%d",
+			 endpoint2.type, endpoint2.id, endpoint2.if_id);
+	else
+		snprintf(row->endpoint, sizeof(row->endpoint), "%s.%d",
+			 endpoint2.type, endpoint2.id);
+
+	return 0;
+}
+
+static int add_row(struct list_rows *list, const char *path,
+		   const struct dprc_obj_desc *desc)
+{
+	struct list_row *row;
+	int error;
+
+	if (list->num_rows == list->max_rows) {
+		int max = list->max_rows ? 2 * list->max_rows : 32;
+
+		row = realloc(list->rows, max * sizeof(*row));
+		if (!row) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		list->rows = row;
+		list->max_rows = max;
+	}
+
+	row = &list->rows[list->num_rows++];
+	memset(row, 0, sizeof(*row));
+	snprintf(row->obj, sizeof(row->obj), "%s.%d", desc->type, desc->id);
+	snprintf(row->container, sizeof(row->container), "%s", path);
+	snprintf(row->label, sizeof(row->label), "%s", desc->label);
+	error = get_endpoint(row, desc);
+	if (error < 0)
+		return error;
+
+	if (strcmp(desc->type, "dpni") == 0)
+		get_netdev(row->obj, row->netdev);
+	else if (strncmp(row->endpoint, "dpni.", 5) == 0)
+		get_netdev(row->endpoint, row->netdev);
+
+	return 0;
+}
+
+static int add_rows(struct list_rows *list, struct dprc_walk_node *node,
+		    const char *obj_type, const char *parent_path)
+{
+	char path[LIST_PATH_SIZE];
+	int error;
+
+	if (parent_path)
+		snprintf(path, sizeof(path), "%s/dprc.%u", parent_path,
+			 node->id);
+	else
+		snprintf(path, sizeof(path), "dprc.%u", node->id);
+
+	for (int i = 0; i < node->num_objs; i++) {
+		if (strcmp(node->objs[i].type, obj_type) != 0)
+			continue;
+
+		error = add_row(list, path, &node->objs[i]);
+		if (error < 0)
+			return error;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_rows(list, node->children[i], obj_type, path);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static void print_json_field(const char *name, const char *value, bool last)
+{
+	printf("\"%s\":", name);
+	if (value[0] == '\0')
+		printf("null");
+	else
+		print_json_string(value, strlen(value));
+	printf(last ? "}" : ",");
+}
+
+static void print_json(const struct list_rows *list)
+{
+	printf("[");
+	for (int i = 0; i < list->num_rows; i++) {
+		const struct list_row *row = &list->rows[i];
+
+		printf(i ? ",\n {" : "{");
+		print_json_field("object", row->obj, false);
+		print_json_field("container", row->container, false);
+		print_json_field("label", row->label, false);
+		print_json_field("endpoint", row->endpoint, false);
+		print_json_field("link", row->state == -1 ? "" :
+				 link_state_name(row->state), false);
+		print_json_field("interface", row->netdev, true);
+	}
+	printf("]\n");
+}
+
+static int max_width(const struct list_rows *list, size_t offset, int width)
+{
+	for (int i = 0; i < list->num_rows; i++) {
+		int len = strlen((const char *)&list->rows[i] + offset);
+
+		if (len > width)
+			width = len;
+	}
+
+	return width;
+}
+
+static void print_table(const struct list_rows *list)
+{
+	int obj_width = max_width(list, offsetof(struct list_row, obj), 6);
+	int path_width = max_width(list, offsetof(struct list_row, container),
+				   9);
+	int label_width = max_width(list, offsetof(struct list_row, label), 5);
+	int endpoint_width = max_width(list,
+				       offsetof(struct list_row, endpoint), 8);
+
+	if (!restool.script)
+		printf("%-*s  %-*s  %-*s  %-*s  %-5s  %s\n",
+		       obj_width, "object", path_width, "container",
+		       label_width, "label", endpoint_width, "endpoint",
+		       "link", "interface");
+
+	for (int i = 0; i < list->num_rows; i++) {
+		const struct list_row *row = &list->rows[i];
+
+		printf("%-*s  %-*s  %-*s  %-*s  %-5s  %s\n",
+		       obj_width, row->obj, path_width, row->container,
+		       label_width, row->label[0] ? row->label : "-",
+		       endpoint_width, row->endpoint[0] ? row->endpoint : "-",
+		       row->state == -1 ? "-" : link_state_name(row->state),
+		       row->netdev[0] ? row->netdev : "-");
+	}
+}
+
+/**
+ * list_linked_objs() - list all objects of a type below the root
+ *	container with their links
+ * @obj_type: type of the objects to list
+ * @json: print a JSON array instead of a table
+ *
+ * Everything is gathered in one walk of the container tree: the
+ * container path and label of each object come from the walk, the
+ * endpoint and link state from one MC command per object, and the
+ * Linux interface from sysfs.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int list_linked_objs(const char *obj_type, bool json)
+{
+	struct dprc_walk_node *root = NULL;
+	struct list_rows list = { 0 };
+	int error;
+
+	error = dprc_walk(restool.root_dprc_id, &root);
+	if (error < 0)
+		return error;
+
+	error = add_rows(&list, root, obj_type, NULL);
+	if (error == 0) {
+		if (json)
+			print_json(&list);
+		else
+			print_table(&list);
+	}
+
+	free(list.rows);
+	dprc_walk_free(root);
+	return error;
+}
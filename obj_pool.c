@@ -0,0 +1,609 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include "restool.h"
+#include "utils.h"
+#include "fsl_mc_trace.h"
+#include "transaction.h"
+#include "dprc_commands_apply.h"
+#include "label_index.h"
+#include "obj_pool.h"
+
+extern char **environ;
+
+/**
+ * Maximum length of one generated fill step or refill argument
+ */
+#define POOL_STEP_SIZE		256
+
+static const char *const pool_type_names[OBJ_POOL_NUM_TYPES] = {
+	[OBJ_POOL_DPIO] = "dpio",
+	[OBJ_POOL_DPCON] = "dpcon",
+	[OBJ_POOL_DPBP] = "dpbp",
+	[OBJ_POOL_DPNI] = "dpni",
+};
+
+const char *obj_pool_type_name(enum obj_pool_type type)
+{
+	return pool_type_names[type];
+}
+
+/**
+ * obj_pool_class_label() - label marking pooled objects of one kind
+ * @type: object type
+ * @cfg: settings the objects are created with
+ * @label: returns the label
+ *
+ * Only objects created with the same settings are interchangeable, so
+ * the settings that matter for each type are part of the label.
+ */
+void obj_pool_class_label(enum obj_pool_type type,
+			  const struct obj_pool_cfg *cfg,
+			  char label[MC_OBJ_LABEL_MAX_LENGTH + 1])
+{
+	switch (type) {
+	case OBJ_POOL_DPIO:
+	case OBJ_POOL_DPCON:
+		snprintf(label, MC_OBJ_LABEL_MAX_LENGTH + 1, "pool:%s/p%ld",
+			 pool_type_names[type], cfg->priorities);
+		break;
+	case OBJ_POOL_DPNI:
+		snprintf(label, MC_OBJ_LABEL_MAX_LENGTH + 1, "pool:dpni/q%ldt%ld",
+			 cfg->queues, cfg->tcs);
+		break;
+	default:
+		snprintf(label, MC_OBJ_LABEL_MAX_LENGTH + 1, "pool:%s",
+			 pool_type_names[type]);
+		break;
+	}
+}
+
+/**
+ * obj_pool_create_options() - create command options of one kind of
+ *	pooled objects
+ * @type: object type
+ * @cfg: settings the objects are created with
+ * @buf: returns the options, each preceded by a space
+ * @size: size of @buf
+ *
+ * Returns @buf
+ */
+const char *obj_pool_create_options(enum obj_pool_type type,
+				    const struct obj_pool_cfg *cfg,
+				    char *buf, size_t size)
+{
+	switch (type) {
+	case OBJ_POOL_DPIO:
+	case OBJ_POOL_DPCON:
+		snprintf(buf, size, " --num-priorities=%ld", cfg->priorities);
+		break;
+	case OBJ_POOL_DPNI:
+		snprintf(buf, size, " --num-queues=%ld --num-tcs=%ld",
+			 cfg->queues, cfg->tcs);
+		break;
+	default:
+		buf[0] = '\0';
+		break;
+	}
+
+	return buf;
+}
+
+static int get_dprc_objs(uint32_t dprc_id, int *num_objs,
+			 struct dprc_obj_desc **objs)
+{
+	enum mc_cmd_status mc_status;
+	uint16_t dprc_handle = restool.root_dprc_handle;
+	bool dprc_opened = false;
+	int error;
+
+	*objs = NULL;
+	if (dprc_id != restool.root_dprc_id) {
+		error = open_dprc(dprc_id, &dprc_handle);
+		if (error < 0)
+			return error;
+
+		dprc_opened = true;
+	}
+
+	error = dprc_get_obj_count(&restool.mc_io, 0, dprc_handle, num_objs);
+	if (error < 0)
+		goto mc_error;
+
+	if (*num_objs == 0)
+		goto out;
+
+	*objs = calloc(*num_objs, sizeof(**objs));
+	if (!*objs) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	for (int i = 0; i < *num_objs; i++) {
+		error = dprc_get_obj(&restool.mc_io, 0, dprc_handle, i,
+				     &(*objs)[i]);
+		if (error < 0)
+			goto mc_error;
+	}
+
+	goto out;
+
+mc_error:
+	mc_status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("MC error: %s (status %#x)\n",
+		     mc_status_to_string(mc_status), mc_status);
+out:
+	if (dprc_opened) {
+		int error2 = close_dprc(dprc_handle);
+
+		if (error == 0)
+			error = error2;
+	}
+
+	if (error < 0) {
+		free(*objs);
+		*objs = NULL;
+	}
+
+	return error;
+}
+
+/**
+ * obj_pool_open() - find the pool under a container and list its objects
+ * @parent_dprc_id: container the pool belongs to
+ * @pool: returns the pool, to be released with obj_pool_close()
+ *
+ * Returns 0 on success, -ENOENT if the container has no pool, another
+ * negative error otherwise
+ */
+int obj_pool_open(uint32_t parent_dprc_id, struct obj_pool *pool)
+{
+	struct dprc_obj_desc *objs;
+	int num_objs;
+	int error;
+
+	memset(pool, 0, sizeof(*pool));
+	pool->parent_dprc_id = parent_dprc_id;
+	error = get_dprc_objs(parent_dprc_id, &num_objs, &objs);
+	if (error < 0)
+		return error;
+
+	error = -ENOENT;
+	for (int i = 0; i < num_objs; i++) {
+		if (strcmp(objs[i].type, "dprc") == 0 &&
+		    strcmp(objs[i].label, OBJ_POOL_LABEL) == 0) {
+			pool->dprc_id = objs[i].id;
+			error = 0;
+			break;
+		}
+	}
+	free(objs);
+	if (error < 0)
+		return error;
+
+	return get_dprc_objs(pool->dprc_id, &pool->num_objs, &pool->objs);
+}
+
+void obj_pool_close(struct obj_pool *pool)
+{
+	free(pool->objs);
+	pool->objs = NULL;
+	pool->num_objs = 0;
+}
+
+/**
+ * obj_pool_count() - number of ready objects of one kind in a pool
+ */
+long obj_pool_count(const struct obj_pool *pool, const char *label)
+{
+	long count = 0;
+
+	for (int i = 0; i < pool->num_objs; i++) {
+		if (strcmp(pool->objs[i].label, label) == 0)
+			count++;
+	}
+
+	return count;
+}
+
+/**
+ * obj_pool_print() - print the number of ready objects of each kind
+ * @parent_dprc_id: container the pool belongs to
+ *
+ * Returns 0 on success, -ENOENT if the container has no pool, another
+ * negative error otherwise
+ */
+int obj_pool_print(uint32_t parent_dprc_id)
+{
+	struct obj_pool pool;
+	int error;
+
+	error = obj_pool_open(parent_dprc_id, &pool);
+	if (error == -ENOENT)
+		printf("dprc.%u has no object pool\n", parent_dprc_id);
+	if (error < 0)
+		return error;
+
+	printf("pool: dprc.%u\n", pool.dprc_id);
+	for (int i = 0; i < pool.num_objs; i++) {
+		const char *label = pool.objs[i].label;
+		bool seen = false;
+
+		if (strncmp(label, "pool:", 5) != 0)
+			continue;
+
+		for (int j = 0; j < i && !seen; j++)
+			seen = strcmp(pool.objs[j].label, label) == 0;
+		if (!seen)
+			printf("%s: %ld\n", label + 5,
+			       obj_pool_count(&pool, label));
+	}
+
+	obj_pool_close(&pool);
+	return 0;
+}
+
+static int take_obj(struct obj_pool *pool, uint16_t parent_dprc_handle,
+		    struct dprc_obj_desc *obj, uint32_t target_dprc_id)
+{
+	enum mc_cmd_status mc_status;
+	struct dprc_res_req res_req;
+	int error;
+
+	memset(&res_req, 0, sizeof(res_req));
+	strcpy(res_req.type, obj->type);
+	res_req.num = 1;
+	res_req.options = DPRC_RES_REQ_OPT_EXPLICIT;
+	res_req.id_base_align = obj->id;
+
+	error = dprc_unassign(&restool.mc_io, 0, parent_dprc_handle,
+			      pool->dprc_id, &res_req);
+	if (error < 0)
+		goto mc_error;
+
+	error = txn_record_assign(false, pool->parent_dprc_id, pool->dprc_id,
+				  &res_req);
+	if (error < 0)
+		return error;
+
+	error = dprc_set_obj_label(&restool.mc_io, 0, parent_dprc_handle,
+				   obj->type, obj->id, "");
+	if (error < 0)
+		goto mc_error;
+
+	label_index_invalidate();
+
+	error = txn_record_set_label(pool->parent_dprc_id, obj->type, obj->id,
+				     obj->label);
+	if (error < 0)
+		return error;
+
+	res_req.options |= DPRC_RES_REQ_OPT_PLUGGED;
+	error = dprc_assign(&restool.mc_io, 0, parent_dprc_handle,
+			    target_dprc_id, &res_req);
+	if (error < 0)
+		goto mc_error;
+
+	return txn_record_assign(true, pool->parent_dprc_id, target_dprc_id,
+				 &res_req);
+
+mc_error:
+	mc_status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("%s.%d: MC error: %s (status %#x)\n", obj->type, obj->id,
+		     mc_status_to_string(mc_status), mc_status);
+	return error;
+}
+
+/**
+ * obj_pool_take() - move ready objects from a pool to a container
+ * @pool: pool to take from
+ * @label: kind of objects to take, see obj_pool_class_label()
+ * @max: maximum number of objects to take
+ * @target_dprc_id: child of the pool's parent the objects are moved
+ *	to, plugged
+ * @ids: returns the ids of the objects taken
+ *
+ * Each object costs three MC commands instead of a creation. All of
+ * them are journalled, so rolling back a transaction puts the objects
+ * back in the pool.
+ *
+ * Returns the number of objects taken, negative on error
+ */
+long obj_pool_take(struct obj_pool *pool, const char *label, long max,
+		   uint32_t target_dprc_id, int *ids)
+{
+	uint16_t parent_dprc_handle = restool.root_dprc_handle;
+	long taken = 0;
+	int error = 0;
+
+	if (pool->parent_dprc_id != restool.root_dprc_id) {
+		error = open_dprc(pool->parent_dprc_id, &parent_dprc_handle);
+		if (error < 0)
+			return error;
+	}
+
+	for (int i = 0; i < pool->num_objs && taken < max; i++) {
+		struct dprc_obj_desc *obj = &pool->objs[i];
+
+		if (strcmp(obj->label, label) != 0)
+			continue;
+
+		error = take_obj(pool, parent_dprc_handle, obj,
+				 target_dprc_id);
+		if (error < 0)
+			break;
+
+		if (!restool.script)
+			printf("%s.%d is taken from the pool and assigned to dprc.%u\n",
+			       obj->type, obj->id, target_dprc_id);
+		obj->label[0] = '\0';
+		ids[taken++] = obj->id;
+	}
+
+	if (pool->parent_dprc_id != restool.root_dprc_id) {
+		int error2 = close_dprc(parent_dprc_handle);
+
+		if (error == 0)
+			error = error2;
+	}
+
+	return error < 0 ? error : taken;
+}
+
+static int run_pool_step(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+static int run_pool_step(const char *fmt, ...)
+{
+	char step[POOL_STEP_SIZE];
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(step, sizeof(step), fmt, args);
+	va_end(args);
+	if (n < 0 || n >= (int)sizeof(step)) {
+		ERROR_PRINTF("pool step too long\n");
+		return -E2BIG;
+	}
+
+	n = dprc_apply_step(step);
+	if (n < 0)
+		ERROR_PRINTF("step failed: %s\n", step);
+
+	return n;
+}
+
+/**
+ * Creates the missing objects of one kind in the pool's parent, moves
+ * them unplugged into the holding container and labels them there
+ */
+static int fill_type(struct obj_pool *pool, uint16_t pool_dprc_handle,
+		     enum obj_pool_type type, const struct obj_pool_cfg *cfg)
+{
+	const char *type_name = pool_type_names[type];
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	char options[POOL_STEP_SIZE];
+	enum mc_cmd_status mc_status;
+	long count;
+	int first;
+	int error;
+
+	obj_pool_class_label(type, cfg, label);
+	count = cfg->count[type];
+	if (!cfg->add)
+		count -= obj_pool_count(pool, label);
+	if (count <= 0)
+		return 0;
+
+	first = txn_num_created();
+	error = run_pool_step("%s create --container=dprc.%u%s --count=%ld --assign-to=dprc.%u",
+			      type_name, pool->parent_dprc_id,
+			      obj_pool_create_options(type, cfg, options,
+						      sizeof(options)),
+			      count, pool->dprc_id);
+	if (error < 0)
+		return error;
+
+	for (long i = 0; i < count; i++) {
+		const char *obj_name = txn_created_obj(first + i);
+		uint32_t obj_id;
+
+		error = parse_object_name(obj_name, (char *)type_name, &obj_id);
+		if (error < 0)
+			return error;
+
+		error = dprc_set_obj_label(&restool.mc_io, 0, pool_dprc_handle,
+					   (char *)type_name, obj_id, label);
+		if (error < 0) {
+			mc_status = flib_error_to_mc_status(error);
+			ERROR_PRINTF("MC error: %s (status %#x)\n",
+				     mc_status_to_string(mc_status), mc_status);
+			return error;
+		}
+
+		label_index_invalidate();
+		error = txn_record_set_label(pool->dprc_id, type_name, obj_id,
+					     "");
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+/**
+ * obj_pool_fill() - create ready objects in the pool of a container
+ * @parent_dprc_id: container the pool belongs to
+ * @cfg: objects to keep in the pool
+ *
+ * The holding container is created if the pool does not exist yet.
+ * Either all missing objects are added, or none: a failure undoes the
+ * whole fill.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int obj_pool_fill(uint32_t parent_dprc_id, const struct obj_pool_cfg *cfg)
+{
+	struct obj_pool pool;
+	uint16_t pool_dprc_handle;
+	int error;
+
+	txn_begin();
+	error = obj_pool_open(parent_dprc_id, &pool);
+	if (error == -ENOENT) {
+		error = run_pool_step("dprc create dprc.%u --label=%s",
+				      parent_dprc_id, OBJ_POOL_LABEL);
+		if (error == 0)
+			error = parse_object_name(txn_created_obj(0), "dprc",
+						  &pool.dprc_id);
+	}
+	if (error < 0)
+		goto out;
+
+	error = open_dprc(pool.dprc_id, &pool_dprc_handle);
+	if (error < 0)
+		goto out;
+
+	for (int i = 0; i < OBJ_POOL_NUM_TYPES; i++) {
+		error = fill_type(&pool, pool_dprc_handle, i, cfg);
+		if (error < 0)
+			break;
+	}
+
+	if (close_dprc(pool_dprc_handle) < 0 && error == 0)
+		error = -EIO;
+out:
+	/* Leftovers from a failed step must not be blamed on the caller */
+	restool.cmd_option_mask = 0;
+	obj_pool_close(&pool);
+	if (error < 0) {
+		if (txn_rollback() < 0)
+			ERROR_PRINTF("rollback incomplete, manual cleanup needed\n");
+	} else {
+		txn_end();
+	}
+
+	return error;
+}
+
+/**
+ * obj_pool_refill_async() - add objects to a pool in the background
+ * @parent_dprc_id: container the pool belongs to
+ * @cfg: objects to add, with @cfg->add set
+ *
+ * Starts a detached restool process running "dprc pool --add", so that
+ * objects taken from the pool are replaced off the caller's critical
+ * path. Nothing is started while an MC trace is recorded or replayed.
+ *
+ * Returns 0 on success, negative otherwise
+ */
+int obj_pool_refill_async(uint32_t parent_dprc_id,
+			  const struct obj_pool_cfg *cfg)
+{
+	char args[OBJ_POOL_NUM_TYPES + 5][POOL_STEP_SIZE];
+	char *argv[OBJ_POOL_NUM_TYPES + 12];
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t attr;
+	bool empty = true;
+	int num_args = 0;
+	int argc = 0;
+	pid_t pid;
+	int error;
+
+	if (mc_trace_is_recording() || mc_trace_is_replaying())
+		return 0;
+
+	for (int i = 0; i < OBJ_POOL_NUM_TYPES; i++)
+		empty = empty && cfg->count[i] == 0;
+	if (empty)
+		return 0;
+
+	argv[argc++] = "restool";
+	if (restool.specified_dev_file[0] != '\0') {
+		snprintf(args[num_args], POOL_STEP_SIZE, "--root=%s",
+			 restool.specified_dev_file);
+		argv[argc++] = args[num_args++];
+	}
+	argv[argc++] = "dprc";
+	argv[argc++] = "pool";
+	snprintf(args[num_args], POOL_STEP_SIZE, "dprc.%u", parent_dprc_id);
+	argv[argc++] = args[num_args++];
+	argv[argc++] = "--add";
+	for (int i = 0; i < OBJ_POOL_NUM_TYPES; i++) {
+		if (cfg->count[i] == 0)
+			continue;
+
+		snprintf(args[num_args], POOL_STEP_SIZE, "--%s=%ld",
+			 pool_type_names[i], cfg->count[i]);
+		argv[argc++] = args[num_args++];
+	}
+	snprintf(args[num_args], POOL_STEP_SIZE, "--priorities=%ld",
+		 cfg->priorities);
+	argv[argc++] = args[num_args++];
+	snprintf(args[num_args], POOL_STEP_SIZE, "--queues=%ld", cfg->queues);
+	argv[argc++] = args[num_args++];
+	snprintf(args[num_args], POOL_STEP_SIZE, "--tcs=%ld", cfg->tcs);
+	argv[argc++] = args[num_args++];
+	argv[argc] = NULL;
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+					 O_RDONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+					 O_WRONLY, 0);
+	posix_spawnattr_init(&attr);
+#ifdef POSIX_SPAWN_SETSID
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+#endif
+
+	error = posix_spawn(&pid, "/proc/self/exe", &actions, &attr, argv,
+			    environ);
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+	if (error != 0) {
+		ERROR_PRINTF("cannot start pool refill: %s\n", strerror(error));
+		return -error;
+	}
+
+	DEBUG_PRINTF("pool refill running as pid %d\n", (int)pid);
+	return 0;
+}
@@ -0,0 +1,117 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OBJ_POOL_H_
+#define _OBJ_POOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "restool.h"
+#include "mc_v10/fsl_dprc.h"
+
+/**
+ * Label of the holding container of a warm object pool. A pool lives
+ * in the container of that label directly under the container its
+ * objects are created in.
+ */
+#define OBJ_POOL_LABEL		"restool-pool"
+
+/**
+ * Object types kept in a warm pool
+ */
+enum obj_pool_type {
+	OBJ_POOL_DPIO = 0,
+	OBJ_POOL_DPCON,
+	OBJ_POOL_DPBP,
+	OBJ_POOL_DPNI,
+	OBJ_POOL_NUM_TYPES,
+};
+
+/**
+ * struct obj_pool_cfg - objects a pool is filled with
+ * @count: number of objects of each type
+ * @priorities: scheduling priorities of the pooled DPIOs and DPCONs
+ * @queues: queues per traffic class of the pooled DPNIs
+ * @tcs: traffic classes of the pooled DPNIs
+ * @add: create @count more objects instead of topping up to @count
+ */
+struct obj_pool_cfg {
+	long count[OBJ_POOL_NUM_TYPES];
+	long priorities;
+	long queues;
+	long tcs;
+	bool add;
+};
+
+/**
+ * struct obj_pool - ready objects found in a pool
+ * @parent_dprc_id: container the pooled objects are moved through
+ * @dprc_id: holding container
+ * @num_objs: number of entries in @objs
+ * @objs: objects in the holding container; an object taken from the
+ *	pool gets an empty label here
+ */
+struct obj_pool {
+	uint32_t parent_dprc_id;
+	uint32_t dprc_id;
+	int num_objs;
+	struct dprc_obj_desc *objs;
+};
+
+const char *obj_pool_type_name(enum obj_pool_type type);
+
+void obj_pool_class_label(enum obj_pool_type type,
+			  const struct obj_pool_cfg *cfg,
+			  char label[MC_OBJ_LABEL_MAX_LENGTH + 1]);
+
+const char *obj_pool_create_options(enum obj_pool_type type,
+				    const struct obj_pool_cfg *cfg,
+				    char *buf, size_t size);
+
+int obj_pool_open(uint32_t parent_dprc_id, struct obj_pool *pool);
+
+void obj_pool_close(struct obj_pool *pool);
+
+int obj_pool_print(uint32_t parent_dprc_id);
+
+long obj_pool_count(const struct obj_pool *pool, const char *label);
+
+long obj_pool_take(struct obj_pool *pool, const char *label, long max,
+		   uint32_t target_dprc_id, int *ids);
+
+int obj_pool_fill(uint32_t parent_dprc_id, const struct obj_pool_cfg *cfg);
+
+int obj_pool_refill_async(uint32_t parent_dprc_id,
+			  const struct obj_pool_cfg *cfg);
+
+#endif /* _OBJ_POOL_H_ */
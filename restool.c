@@ -41,6 +41,12 @@
 #include <sys/ioctl.h>
 #include "restool.h"
 #include "utils.h"
+#include "fsl_mc_trace.h"
+#include "fsl_mc_lane.h"
+#include "dprc_walk.h"
+#include "handle_cache.h"
+#include "label_index.h"
+#include "transaction.h"
 
 static struct option global_options[] = {
 	[GLOBAL_OPT_HELP] = {
@@ -74,6 +80,41 @@ static struct option global_options[] = {
 		.has_arg = optional_argument,
 	},
 
+	[GLOBAL_OPT_RECORD] = {
+		.name = "record",
+		.val = 'R',
+		.has_arg = required_argument,
+	},
+
+	[GLOBAL_OPT_REPLAY] = {
+		.name = "replay",
+		.val = 'p',
+		.has_arg = required_argument,
+	},
+
+	[GLOBAL_OPT_PORTALS] = {
+		.name = "portals",
+		.val = 'P',
+		.has_arg = required_argument,
+	},
+
+	[GLOBAL_OPT_AUTHORITATIVE] = {
+		.name = "authoritative",
+		.val = 'A',
+	},
+
+	[GLOBAL_OPT_PRIORITY] = {
+		.name = "priority",
+		.val = 'Q',
+		.has_arg = required_argument,
+	},
+
+	[GLOBAL_OPT_PACE] = {
+		.name = "pace",
+		.val = 'W',
+		.has_arg = required_argument,
+	},
+
 	{ 0 },
 };
 
@@ -159,24 +200,11 @@ static const struct obj_command_versions dpdmai_command_versions[] = {
 	{ .version = 0, .obj_commands = NULL },
 };
 
-static const struct object_cmd_parser object_cmd_parsers[] = {
-	{ .obj_type = "dprc",   .obj_commands_versions = dprc_command_versions   },
-	{ .obj_type = "dpni",   .obj_commands_versions = dpni_command_versions   },
-	{ .obj_type = "dpio",   .obj_commands_versions = dpio_command_versions   },
-	{ .obj_type = "dpbp",   .obj_commands_versions = dpbp_command_versions   },
-	{ .obj_type = "dpsw",   .obj_commands_versions = dpsw_command_versions   },
-	{ .obj_type = "dpci",   .obj_commands_versions = dpci_command_versions   },
-	{ .obj_type = "dpcon",  .obj_commands_versions = dpcon_command_versions  },
-	{ .obj_type = "dpseci", .obj_commands_versions = dpseci_command_versions },
-	{ .obj_type = "dpdmux", .obj_commands_versions = dpdmux_command_versions },
-	{ .obj_type = "dpmcp",  .obj_commands_versions = dpmcp_command_versions  },
-	{ .obj_type = "dpmac",  .obj_commands_versions = dpmac_command_versions  },
-	{ .obj_type = "dpdcei", .obj_commands_versions = dpdcei_command_versions },
-	{ .obj_type = "dpaiop", .obj_commands_versions = dpaiop_command_versions },
-	{ .obj_type = "dpdbg",  .obj_commands_versions = dpdbg_command_versions },
-	{ .obj_type = "dprtc",  .obj_commands_versions = dprtc_command_versions },
-	{ .obj_type = "dpdmai", .obj_commands_versions = dpdmai_command_versions },
+static const struct obj_command_versions snapshot_command_versions[] = {
+	{ .version = 1, .obj_commands = snapshot_commands },
+	{ .version = 0, .obj_commands = NULL },
 };
+
 /**
  * Individual object structs to hold the mapping of the MC Version
  * (major part only) to a corresponding object version(major part
@@ -265,28 +293,119 @@ struct version_table dprtc_version_table[] = {
 	{ .mc_major_version = 10, .object_version = 2 },
 	{ .mc_major_version = 0 }
 };
+struct version_table snapshot_version_table[] = {
+	{ .mc_major_version = 10, .object_version = 1 },
+	{ .mc_major_version = 0 }
+};
 
 /**
- * Lookup table used to map a specific MC Version to its corresponding
- * supported object version
+ * Per object type descriptors: command tables, lookup table used to map a
+ * specific MC Version to its corresponding supported object version, and
+ * generic flib operations
  */
-struct lut_entry version_lut[] = {
-	{ .object = "dpaiop", .versions_table = dpaiop_version_table },
-	{ .object = "dpbp",   .versions_table = dpbp_version_table   },
-	{ .object = "dpci",   .versions_table = dpci_version_table   },
-	{ .object = "dpcon",  .versions_table = dpcon_version_table  },
-	{ .object = "dpdcei", .versions_table = dpdcei_version_table  },
-	{ .object = "dpdmai", .versions_table = dpdmai_version_table },
-	{ .object = "dpdmux", .versions_table = dpdmux_version_table },
-	{ .object = "dpio",   .versions_table = dpio_version_table   },
-	{ .object = "dpmac",  .versions_table = dpmac_version_table  },
-	{ .object = "dpmcp",  .versions_table = dpmcp_version_table  },
-	{ .object = "dpni",   .versions_table = dpni_version_table   },
-	{ .object = "dprc",   .versions_table = dprc_version_table   },
-	{ .object = "dpseci", .versions_table = dpseci_version_table },
-	{ .object = "dpsw",   .versions_table = dpsw_version_table   },
-	{ .object = "dpdbg",  .versions_table = dpdbg_version_table  },
-	{ .object = "dprtc",  .versions_table = dprtc_version_table  },
+static const struct obj_type_desc obj_types[NUM_OBJ_TYPES] = {
+	[OBJ_TYPE_DPRC] = {
+		.obj_type = "dprc",
+		.obj_commands_versions = dprc_command_versions,
+		.versions_table = dprc_version_table,
+		.ops = &dprc_ops,
+	},
+	[OBJ_TYPE_DPNI] = {
+		.obj_type = "dpni",
+		.obj_commands_versions = dpni_command_versions,
+		.versions_table = dpni_version_table,
+		.ops = &dpni_ops,
+	},
+	[OBJ_TYPE_DPIO] = {
+		.obj_type = "dpio",
+		.obj_commands_versions = dpio_command_versions,
+		.versions_table = dpio_version_table,
+		.ops = &dpio_ops,
+	},
+	[OBJ_TYPE_DPBP] = {
+		.obj_type = "dpbp",
+		.obj_commands_versions = dpbp_command_versions,
+		.versions_table = dpbp_version_table,
+		.ops = &dpbp_ops,
+	},
+	[OBJ_TYPE_DPSW] = {
+		.obj_type = "dpsw",
+		.obj_commands_versions = dpsw_command_versions,
+		.versions_table = dpsw_version_table,
+		.ops = &dpsw_ops,
+	},
+	[OBJ_TYPE_DPCI] = {
+		.obj_type = "dpci",
+		.obj_commands_versions = dpci_command_versions,
+		.versions_table = dpci_version_table,
+		.ops = &dpci_ops,
+	},
+	[OBJ_TYPE_DPCON] = {
+		.obj_type = "dpcon",
+		.obj_commands_versions = dpcon_command_versions,
+		.versions_table = dpcon_version_table,
+		.ops = &dpcon_ops,
+	},
+	[OBJ_TYPE_DPSECI] = {
+		.obj_type = "dpseci",
+		.obj_commands_versions = dpseci_command_versions,
+		.versions_table = dpseci_version_table,
+		.ops = &dpseci_ops,
+	},
+	[OBJ_TYPE_DPDMUX] = {
+		.obj_type = "dpdmux",
+		.obj_commands_versions = dpdmux_command_versions,
+		.versions_table = dpdmux_version_table,
+		.ops = &dpdmux_ops_v9,
+	},
+	[OBJ_TYPE_DPMCP] = {
+		.obj_type = "dpmcp",
+		.obj_commands_versions = dpmcp_command_versions,
+		.versions_table = dpmcp_version_table,
+		.ops = &dpmcp_ops,
+	},
+	[OBJ_TYPE_DPMAC] = {
+		.obj_type = "dpmac",
+		.obj_commands_versions = dpmac_command_versions,
+		.versions_table = dpmac_version_table,
+		.ops = &dpmac_ops,
+	},
+	[OBJ_TYPE_DPDCEI] = {
+		.obj_type = "dpdcei",
+		.obj_commands_versions = dpdcei_command_versions,
+		.versions_table = dpdcei_version_table,
+		.ops = &dpdcei_ops,
+	},
+	[OBJ_TYPE_DPAIOP] = {
+		.obj_type = "dpaiop",
+		.obj_commands_versions = dpaiop_command_versions,
+		.versions_table = dpaiop_version_table,
+		.ops = &dpaiop_ops,
+	},
+	[OBJ_TYPE_DPDBG] = {
+		.obj_type = "dpdbg",
+		.obj_commands_versions = dpdbg_command_versions,
+		.versions_table = dpdbg_version_table,
+		.ops = NULL,
+	},
+	[OBJ_TYPE_DPRTC] = {
+		.obj_type = "dprtc",
+		.obj_commands_versions = dprtc_command_versions,
+		.versions_table = dprtc_version_table,
+		.ops = &dprtc_ops,
+	},
+	[OBJ_TYPE_DPDMAI] = {
+		.obj_type = "dpdmai",
+		.obj_commands_versions = dpdmai_command_versions,
+		.versions_table = dpdmai_version_table,
+		.ops = &dpdmai_ops,
+	},
+	[OBJ_TYPE_SNAPSHOT] = {
+		.obj_type = "snapshot",
+		.obj_commands_versions = snapshot_command_versions,
+		.versions_table = snapshot_version_table,
+		.ops = NULL,
+	},
 };
 
 struct restool restool;
@@ -348,6 +467,137 @@ const char *mc_status_to_string(enum mc_cmd_status status)
 	return status_strings[status];
 }
 
+/**
+ * Looks up an object in a given container with a single MC command,
+ * instead of scanning all of the container's object indexes.
+ * Returns 0 if the object is in the container, negative otherwise;
+ * no error is printed, so callers may fall back to an index scan.
+ */
+int get_obj_desc_in_dprc(uint16_t dprc_handle, const char *obj_type,
+			 uint32_t obj_id, struct dprc_obj_desc *obj_desc)
+{
+	struct dprc_obj_desc desc;
+	char type[16] = { 0 };
+	int error;
+
+	strncpy(type, obj_type, sizeof(type) - 1);
+	memset(&desc, 0, sizeof(desc));
+	error = dprc_get_obj_desc(&restool.mc_io, 0, dprc_handle,
+				  type, obj_id, &desc);
+	if (error < 0) {
+		DEBUG_PRINTF("dprc_get_obj_desc(%s.%u) failed with error %d\n",
+			     obj_type, obj_id, error);
+		return error;
+	}
+
+	if (strcmp(desc.type, obj_type) != 0 || (uint32_t)desc.id != obj_id)
+		return -ENOENT;
+
+	*obj_desc = desc;
+	return 0;
+}
+
+/**
+ * Resolves the parent container of an object from the fsl-mc bus view in
+ * sysfs, where each device sits in the directory of its container.
+ * Only objects inside containers the kernel has scanned are visible.
+ * Returns 0 on success, -ENOENT if the kernel does not know the object.
+ */
+int sysfs_get_parent_dprc_id(const char *obj_type, uint32_t obj_id,
+			     uint32_t *parent_dprc_id)
+{
+	char path[PATH_MAX];
+	char resolved[PATH_MAX];
+	char *parent;
+	char *end;
+	unsigned long id;
+
+	snprintf(path, PATH_MAX, "/sys/bus/fsl-mc/devices/%s.%u",
+		 obj_type, obj_id);
+	if (!realpath(path, resolved))
+		return -ENOENT;
+
+	/* resolved is .../dprc.<parent>/<obj_type>.<obj_id> */
+	end = strrchr(resolved, '/');
+	if (!end)
+		return -ENOENT;
+
+	*end = '\0';
+	parent = strrchr(resolved, '/');
+	if (!parent || strncmp(parent + 1, "dprc.", 5) != 0)
+		return -ENOENT;
+
+	errno = 0;
+	id = strtoul(parent + 6, &end, 10);
+	if (errno != 0 || end == parent + 6 || *end != '\0')
+		return -ENOENT;
+
+	DEBUG_PRINTF("sysfs: %s.%u is in dprc.%lu\n", obj_type, obj_id, id);
+	*parent_dprc_id = id;
+	return 0;
+}
+
+/**
+ * Tells whether sysfs places an object below the root container, which
+ * is not the top of the fsl-mc bus when --root is given
+ */
+static bool sysfs_is_below_root(const char *obj_type, uint32_t obj_id)
+{
+	char path[PATH_MAX];
+	char resolved[PATH_MAX];
+	char root[24];
+
+	snprintf(path, PATH_MAX, "/sys/bus/fsl-mc/devices/%s.%u",
+		 obj_type, obj_id);
+	if (!realpath(path, resolved))
+		return false;
+
+	snprintf(root, sizeof(root), "/dprc.%u/", restool.root_dprc_id);
+	return strstr(resolved, root) != NULL;
+}
+
+/**
+ * Finds an object in the container sysfs places it in, as long as that
+ * is the root container or one of its descendants. Any failure,
+ * including a stale sysfs view, is silent so that the caller can fall
+ * back to asking the MC.
+ */
+static int find_obj_desc_from_sysfs(uint32_t obj_id, char *obj_type,
+				    struct dprc_obj_desc *obj_desc,
+				    uint32_t *parent_dprc_id)
+{
+	uint16_t dprc_handle;
+	uint32_t dprc_id;
+	int error;
+
+	error = sysfs_get_parent_dprc_id(obj_type, obj_id, &dprc_id);
+	if (error < 0)
+		return error;
+
+	if (!sysfs_is_below_root(obj_type, obj_id))
+		return -ENOENT;
+
+	if (dprc_id == restool.root_dprc_id) {
+		error = get_obj_desc_in_dprc(restool.root_dprc_handle,
+					     obj_type, obj_id, obj_desc);
+	} else {
+		error = handle_cache_open("dprc", dprc_id, dprc_open,
+					  dprc_close, &dprc_handle);
+		if (error < 0)
+			return error;
+
+		error = get_obj_desc_in_dprc(dprc_handle, obj_type, obj_id,
+					     obj_desc);
+		(void)handle_cache_release(dprc_handle);
+	}
+
+	if (error < 0)
+		return error;
+
+	*parent_dprc_id = dprc_id;
+	return 0;
+}
+
 int find_target_obj_desc(uint32_t dprc_id, uint16_t dprc_handle,
 			int nesting_level,
 			uint32_t target_id, char *target_type,
@@ -368,6 +618,21 @@ int find_target_obj_desc(uint32_t dprc_id, uint16_t dprc_handle,
 		return 0;
 	}
 
+	if (nesting_level == 0 && !restool.authoritative &&
+	    find_obj_desc_from_sysfs(target_id, target_type, target_obj_desc,
+				     target_parent_dprc_id) == 0) {
+		*found = true;
+		return 0;
+	}
+
+	if (get_obj_desc_in_dprc(dprc_handle, target_type, target_id,
+				 target_obj_desc) == 0) {
+		*target_parent_dprc_id = dprc_id;
+		DEBUG_PRINTF("target_parent_dprc_id: dprc.%d\n", dprc_id);
+		*found = true;
+		return 0;
+	}
+
 	error = dprc_get_obj_count(&restool.mc_io, 0,
 				   dprc_handle,
 				   &num_child_devices);
@@ -424,8 +689,7 @@ int find_target_obj_desc(uint32_t dprc_id, uint16_t dprc_handle,
 					target_parent_dprc_id,
 					&found2);
 
-			error2 = dprc_close(&restool.mc_io, 0,
-						child_dprc_handle);
+			error2 = close_dprc(child_dprc_handle);
 			if (error2 < 0) {
 				mc_status = flib_error_to_mc_status(error2);
 				ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -482,6 +746,26 @@ void print_obj_label(struct dprc_obj_desc *target_obj_desc)
 		printf("object label: %s\n", target_obj_desc->label);
 }
 
+/**
+ * Prints a string as a quoted JSON string, reading at most max_len
+ * characters
+ */
+void print_json_string(const char *str, size_t max_len)
+{
+	putchar('"');
+	for (size_t i = 0; i < max_len && str[i] != '\0'; i++) {
+		unsigned char c = str[i];
+
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+	putchar('"');
+}
+
 int print_obj_verbose(struct dprc_obj_desc *target_obj_desc,
 			const struct flib_ops *ops)
 {
@@ -521,8 +805,8 @@ int print_obj_verbose(struct dprc_obj_desc *target_obj_desc,
 		target_obj_desc->region_count);
 	printf("number of interrupts: %u\n", target_obj_desc->irq_count);
 
-	error = ops->obj_open(&restool.mc_io, 0, target_obj_desc->id,
-				&obj_handle);
+	error = handle_cache_open(target_obj_desc->type, target_obj_desc->id,
+				  ops->obj_open, ops->obj_close, &obj_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -539,14 +823,7 @@ int print_obj_verbose(struct dprc_obj_desc *target_obj_desc,
 		printf("interrupt[%d] status: %#x\n", j, irq_status);
 	}
 
-	error = ops->obj_close(&restool.mc_io, 0, obj_handle);
-	if (error < 0) {
-		mc_status = flib_error_to_mc_status(error);
-		ERROR_PRINTF("MC error: %s (status %#x)\n",
-			mc_status_to_string(mc_status), mc_status);
-	}
-
-	return error;
+	return handle_cache_release(obj_handle);
 }
 
 int check_resource_type(char *res_type)
@@ -609,8 +886,32 @@ bool in_use(const char *obj, const char *situation)
 	return false;
 }
 
+/**
+ * Upper bound for the --count option of create commands
+ */
+#define MAX_CREATE_COUNT	1024
+
+/**
+ * Object most recently reported by print_new_obj(), which create
+ * commands run with --assign-to or --plugged act on
+ */
+static struct {
+	char type[OBJ_TYPE_MAX_LENGTH + 1];
+	int id;
+	const char *parent;
+	bool valid;
+} new_obj;
+
 void print_new_obj(char *type, int id, const char *parent)
 {
+	/* Every create command reports its new object through here */
+	(void)txn_record_create(type, id);
+	label_index_invalidate();
+	snprintf(new_obj.type, sizeof(new_obj.type), "%s", type);
+	new_obj.id = id;
+	new_obj.parent = parent;
+	new_obj.valid = true;
+
 	if (restool.script) {
 		printf("%s.%d\n", type, id);
 		return;
@@ -701,6 +1002,23 @@ static void print_usage(void)
 		"   -h,-?,--help     Displays general help info\n"
 		"   -s, --script     Display script friendly output\n"
 		"   --root=[dprc]    Specifies root container name\n"
+		"   --record=<file>  Appends every MC command and response to a binary trace\n"
+		"   --replay=<file>  Answers MC commands from a trace instead of the MC\n"
+		"   --portals=<n>    Walks container trees through up to <n> MC portals\n"
+		"                    in parallel (default 1)\n"
+		"   --authoritative  Always ask the MC where objects are, instead of\n"
+		"                    trusting the fsl-mc bus view in sysfs\n"
+		"   --priority=<lane>[,<command>=<lane>...]\n"
+		"                    Sends MC commands as <lane>, 'normal' or 'high'.\n"
+		"                    By default connect, disconnect, destroy, assign,\n"
+		"                    unassign, pool, build and restore, and the undo\n"
+		"                    of a failed plan, are sent with the MC high\n"
+		"                    priority flag and everything else at normal\n"
+		"                    priority. A bare <lane> applies to all commands,\n"
+		"                    <command>=<lane> to one command, given as e.g.\n"
+		"                    'destroy' or 'dprc.connect'\n"
+		"   --pace=<us>      Waits <us> microseconds before each MC command\n"
+		"                    sent at normal priority\n"
 		"\n"
 		"  Valid <object-type> values: <dprc|dpni|dpio|dpsw|dpbp|dpci|dpcon|dpseci|dpdmux|\n"
 		"                               dpmcp|dpmac|dpdcei|dpaiop|dpdmai>\n"
@@ -712,7 +1030,8 @@ static void print_usage(void)
 		"    create\n"
 		"    destroy\n"
 		"\n"
-		"  <object-name> is a string containing object type and ID (e.g. dpni.7)\n"
+		"  <object-name> is a string containing object type and ID (e.g. dpni.7),\n"
+		"    or '@' followed by the label of the object (e.g. @vm7-eth0)\n"
 		"\n";
 
 	puts(usage_msg);
@@ -745,6 +1064,23 @@ static void print_usage_v9(void)
 		"   -h,-?,--help     Displays general help info\n"
 		"   -s, --script     Display script friendly output\n"
 		"   --root=[dprc]    Specifies root container name\n"
+		"   --record=<file>  Appends every MC command and response to a binary trace\n"
+		"   --replay=<file>  Answers MC commands from a trace instead of the MC\n"
+		"   --portals=<n>    Walks container trees through up to <n> MC portals\n"
+		"                    in parallel (default 1)\n"
+		"   --authoritative  Always ask the MC where objects are, instead of\n"
+		"                    trusting the fsl-mc bus view in sysfs\n"
+		"   --priority=<lane>[,<command>=<lane>...]\n"
+		"                    Sends MC commands as <lane>, 'normal' or 'high'.\n"
+		"                    By default connect, disconnect, destroy, assign,\n"
+		"                    unassign, pool, build and restore, and the undo\n"
+		"                    of a failed plan, are sent with the MC high\n"
+		"                    priority flag and everything else at normal\n"
+		"                    priority. A bare <lane> applies to all commands,\n"
+		"                    <command>=<lane> to one command, given as e.g.\n"
+		"                    'destroy' or 'dprc.connect'\n"
+		"   --pace=<us>      Waits <us> microseconds before each MC command\n"
+		"                    sent at normal priority\n"
 		"\n"
 		"  Valid <object-type> values: <dprc|dpni|dpio|dpsw|dpbp|dpci|dpcon|dpseci|dpdmux|\n"
 		"                               dpmcp|dpmac|dpdcei|dpaiop|dprtc|dpdmai>\n"
@@ -756,10 +1092,14 @@ static void print_usage_v9(void)
 		"    create\n"
 		"    destroy\n"
 		"\n"
-		"  <object-name> is a string containing object type and ID (e.g. dpni.7)\n"
+		"  <object-name> is a string containing object type and ID (e.g. dpni.7),\n"
+		"    or '@' followed by the label of the object (e.g. @vm7-eth0)\n"
 		"\n";
 
 	puts(usage_msg);
+	if (restool.mc_fw_version.major == 10)
+		puts("  'restool snapshot save|restore' saves and recreates container\n"
+		     "  layouts.\n");
 	restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_HELP);
 }
 
@@ -791,6 +1131,13 @@ int parse_object_name(const char *obj_name, char *expected_obj_type,
 	char obj_type[OBJ_TYPE_MAX_LENGTH + 1];
 
 	assert(expected_obj_type != NULL);
+	if (obj_name[0] == LABEL_PREFIX) {
+		int error = label_index_lookup(obj_name + 1, &obj_name);
+
+		if (error < 0)
+			return error;
+	}
+
 	n = sscanf(obj_name, "%" STRINGIFY(OBJ_TYPE_MAX_LENGTH) "[a-z].%u",
 		   obj_type, obj_id);
 	if (n != 2) {
@@ -812,9 +1159,8 @@ int open_dprc(uint32_t dprc_id, uint16_t *dprc_handle)
 	int error;
 	enum mc_cmd_status mc_status;
 
-	error = dprc_open(&restool.mc_io, 0,
-			  dprc_id,
-			  dprc_handle);
+	error = handle_cache_open("dprc", dprc_id, dprc_open, dprc_close,
+				  dprc_handle);
 	if (error < 0) {
 		mc_status = flib_error_to_mc_status(error);
 		ERROR_PRINTF("MC error: %s (status %#x)\n",
@@ -827,7 +1173,8 @@ int open_dprc(uint32_t dprc_id, uint16_t *dprc_handle)
 			"dprc_open() returned invalid handle (auth 0) for dprc.%u\n",
 			dprc_id);
 
-		(void)dprc_close(&restool.mc_io, 0, *dprc_handle);
+		(void)handle_cache_release(*dprc_handle);
+		(void)handle_cache_evict("dprc", dprc_id);
 		error = -ENOENT;
 		goto out;
 	}
@@ -837,6 +1184,15 @@ out:
 	return error;
 }
 
+/**
+ * Releases a handle obtained from open_dprc(). The container stays open
+ * in the handle cache until restool exits.
+ */
+int close_dprc(uint16_t dprc_handle)
+{
+	return handle_cache_release(dprc_handle);
+}
+
 static int check_arg(char *optarg)
 {
 	int str_len = 0;
@@ -920,6 +1276,30 @@ static int parse_global_options(int argc, char *argv[],
 
 			break;
 
+		case 'R':
+			opt_index = GLOBAL_OPT_RECORD;
+			break;
+
+		case 'p':
+			opt_index = GLOBAL_OPT_REPLAY;
+			break;
+
+		case 'P':
+			opt_index = GLOBAL_OPT_PORTALS;
+			break;
+
+		case 'A':
+			opt_index = GLOBAL_OPT_AUTHORITATIVE;
+			break;
+
+		case 'Q':
+			opt_index = GLOBAL_OPT_PRIORITY;
+			break;
+
+		case 'W':
+			opt_index = GLOBAL_OPT_PACE;
+			break;
+
 		default:
 			DEBUG_PRINTF("\n");
 			assert(false);
@@ -960,7 +1340,12 @@ static int parse_cmd_options(int argc, char *argv[],
 	optind = 1;
 	optarg = NULL;
 
+	/*
+	 * Several commands may run in one session, so stale arguments of
+	 * a previous one must not look like options given to this one:
+	 */
 	restool.cmd_option_mask = 0;
+	memset(restool.cmd_option_args, 0, sizeof(restool.cmd_option_args));
 	assert(options != NULL);
 
 	for ( ; ; ) {
@@ -994,35 +1379,45 @@ static int parse_cmd_options(int argc, char *argv[],
 error:
 	return error;
 }
+enum obj_type obj_type_lookup(const char *obj_type)
+{
+	for (int i = 0; i < NUM_OBJ_TYPES; i++) {
+		if (strcmp(obj_type, obj_types[i].obj_type) == 0)
+			return i;
+	}
+
+	return OBJ_TYPE_INVALID;
+}
+
+const char *obj_type_name(enum obj_type type)
+{
+	assert(type >= 0 && type < NUM_OBJ_TYPES);
+	return obj_types[type].obj_type;
+}
+
+const struct flib_ops *obj_type_ops(enum obj_type type)
+{
+	if (type < 0 || type >= NUM_OBJ_TYPES)
+		return NULL;
+
+	return obj_types[type].ops;
+}
+
 /*
  * This function can be used to get the supported obj version(major) for a
  * specific object and your current MC Firmware Version
  */
-static uint16_t get_obj_version(const char *obj_type)
+static uint16_t get_obj_version(enum obj_type type)
 {
 	unsigned int i;
 	uint16_t obj_version = 0;
 	uint32_t mc_major_version = restool.mc_fw_version.major;
-	struct lut_entry *lut_obj_entry = NULL;
 	struct version_table *versions_table;
 
-	/*
-	 * get the specific object version lookup table
-	 */
-	for (i = 0; i < ARRAY_SIZE(version_lut); i++) {
-		if (strcmp(obj_type, version_lut[i].object) == 0)
-			lut_obj_entry = &version_lut[i];
-	}
-
-	if (lut_obj_entry == NULL) {
-		ERROR_PRINTF("error: invalid object type \'%s\'\n", obj_type);
-		goto out;
-	}
-
 	/*
 	 * find the supported object version number from the MC Version
 	 */
-	versions_table = lut_obj_entry->versions_table;
+	versions_table = obj_types[type].versions_table;
 	for (i = 0; versions_table[i].mc_major_version != 0; i++) {
 		if (mc_major_version == versions_table[i].mc_major_version)
 			obj_version = versions_table[i].object_version;
@@ -1030,7 +1425,7 @@ static uint16_t get_obj_version(const char *obj_type)
 
 	if (obj_version == 0) {
 		ERROR_PRINTF("error: invalid MC firmware version %d for object type \'%s\'\n",
-			     mc_major_version, obj_type);
+			     mc_major_version, obj_types[type].obj_type);
 		goto out;
 	}
 
@@ -1042,23 +1437,17 @@ static struct object_command *get_obj_cmd(const char *obj_type,
 					  const char *cmd_name)
 {
 	unsigned int i;
-	const struct object_cmd_parser *obj_cmd_parser = NULL;
+	enum obj_type type;
 	const struct obj_command_versions *obj_cmd_versions;
-	struct object_command *obj_commands;
+	struct object_command *obj_commands = NULL;
 	struct object_command *obj_cmd = NULL;
 	uint16_t obj_version;
 
 	/*
-	 * Lookup object command parser:
+	 * Lookup object type:
 	 */
-	for (i = 0; i < ARRAY_SIZE(object_cmd_parsers); i++) {
-		if (strcmp(obj_type, object_cmd_parsers[i].obj_type) == 0) {
-			obj_cmd_parser = &object_cmd_parsers[i];
-			break;
-		}
-	}
-
-	if (obj_cmd_parser == NULL) {
+	type = obj_type_lookup(obj_type);
+	if (type == OBJ_TYPE_INVALID) {
 		ERROR_PRINTF("error: invalid object type \'%s\'\n", obj_type);
 		print_try_help();
 		goto out;
@@ -1067,14 +1456,14 @@ static struct object_command *get_obj_cmd(const char *obj_type,
 	/*
 	 * lookup object version number supported by MC firmware version
 	 */
-	obj_version = get_obj_version(obj_type);
+	obj_version = get_obj_version(type);
 	if (obj_version == 0)
 		goto out;
 
 	/*
 	 * Find the right object_command struct assosiates with version
 	 */
-	obj_cmd_versions = obj_cmd_parser->obj_commands_versions;
+	obj_cmd_versions = obj_types[type].obj_commands_versions;
 	for (i = 0; obj_cmd_versions[i].obj_commands != NULL; i++) {
 		if (obj_version ==  obj_cmd_versions[i].version)
 			obj_commands = obj_cmd_versions[i].obj_commands;
@@ -1107,10 +1496,333 @@ out:
 	return obj_cmd;
 }
 
-static int parse_obj_command(const char *obj_type,
-			     const char *cmd_name,
-			     int argc,
-			     char *argv[])
+static int find_cmd_option(const struct option *options, const char *name)
+{
+	for (int i = 0; options != NULL && options[i].name != NULL; i++) {
+		if (strcmp(options[i].name, name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/**
+ * Consumes a command option by name. Returns true if the command
+ * supports the option and it was given, with its index in *index.
+ */
+static bool take_cmd_option(const struct option *options, const char *name,
+			    int *index)
+{
+	*index = find_cmd_option(options, name);
+	if (*index < 0 || !(restool.cmd_option_mask & ONE_BIT_MASK(*index)))
+		return false;
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(*index);
+	return true;
+}
+
+/**
+ * Moves the object just created to another container and/or plugs it,
+ * with a single dprc_assign() on the container it was created in.
+ */
+static int assign_new_obj(bool assign_to, uint32_t target_dprc_id,
+			  bool plugged)
+{
+	enum mc_cmd_status mc_status;
+	struct dprc_res_req res_req;
+	uint32_t parent_dprc_id = restool.root_dprc_id;
+	uint16_t parent_dprc_handle = restool.root_dprc_handle;
+	int error;
+
+	if (new_obj.parent != NULL) {
+		error = parse_object_name(new_obj.parent, "dprc",
+					  &parent_dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	if (!assign_to)
+		target_dprc_id = parent_dprc_id;
+
+	if (target_dprc_id == parent_dprc_id && !plugged)
+		return 0;
+
+	if (parent_dprc_id != restool.root_dprc_id) {
+		error = open_dprc(parent_dprc_id, &parent_dprc_handle);
+		if (error < 0)
+			return error;
+	}
+
+	memset(&res_req, 0, sizeof(res_req));
+	strcpy(res_req.type, new_obj.type);
+	res_req.num = 1;
+	res_req.options = DPRC_RES_REQ_OPT_EXPLICIT;
+	if (plugged)
+		res_req.options |= DPRC_RES_REQ_OPT_PLUGGED;
+	res_req.id_base_align = new_obj.id;
+
+	error = dprc_assign(&restool.mc_io, 0, parent_dprc_handle,
+			    target_dprc_id, &res_req);
+	if (error < 0) {
+		mc_status = flib_error_to_mc_status(error);
+		ERROR_PRINTF("%s.%d: MC error: %s (status %#x)\n",
+			     new_obj.type, new_obj.id,
+			     mc_status_to_string(mc_status), mc_status);
+		goto out;
+	}
+
+	error = txn_record_assign(true, parent_dprc_id, target_dprc_id,
+				  &res_req);
+	if (error < 0)
+		goto out;
+
+	if (!restool.script) {
+		if (target_dprc_id != parent_dprc_id)
+			printf("%s.%d is assigned to dprc.%u%s\n",
+			       new_obj.type, new_obj.id, target_dprc_id,
+			       plugged ? " and plugged" : "");
+		else
+			printf("%s.%d is plugged\n", new_obj.type, new_obj.id);
+	}
+out:
+	if (parent_dprc_id != restool.root_dprc_id) {
+		int error2;
+
+		error2 = close_dprc(parent_dprc_handle);
+		if (error2 < 0 && error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+static void print_create_common_usage(const struct option *options)
+{
+	if (find_cmd_option(options, "count") >= 0)
+		printf("--count=<number>\n"
+		       "   Create <number> objects with the same settings,\n"
+		       "   1 by default.\n");
+
+	if (find_cmd_option(options, "assign-to") >= 0)
+		printf("--assign-to=<container>\n"
+		       "   Move each new object to <container>, which must be a\n"
+		       "   child of the container the object is created in.\n");
+
+	if (find_cmd_option(options, "plugged") >= 0)
+		printf("--plugged\n"
+		       "   Leave each new object in plugged state.\n");
+
+	printf("\n");
+}
+
+/**
+ * Runs a create command, handling the --count, --assign-to and
+ * --plugged options shared by all create commands: the objects are
+ * created and assigned back to back within this one restool session.
+ */
+static int run_create_command(struct object_command *obj_cmd)
+{
+	const struct option *options = obj_cmd->options;
+	uint32_t target_dprc_id = 0;
+	uint32_t option_mask;
+	bool assign_to, plugged;
+	long count = 1;
+	long created = 0;
+	int index;
+	int error = 0;
+
+	index = find_cmd_option(options, "help");
+	if (index >= 0 && (restool.cmd_option_mask & ONE_BIT_MASK(index))) {
+		error = obj_cmd->cmd_func();
+		print_create_common_usage(options);
+		return error;
+	}
+
+	if (take_cmd_option(options, "count", &index)) {
+		error = get_option_value(index, &count, "Invalid --count value",
+					 1, MAX_CREATE_COUNT);
+		if (error < 0)
+			return error;
+	}
+
+	assign_to = take_cmd_option(options, "assign-to", &index);
+	if (assign_to) {
+		error = parse_object_name(restool.cmd_option_args[index],
+					  "dprc", &target_dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	plugged = take_cmd_option(options, "plugged", &index);
+
+	option_mask = restool.cmd_option_mask;
+	for (long i = 0; i < count; i++) {
+		restool.cmd_option_mask = option_mask;
+		new_obj.valid = false;
+		error = obj_cmd->cmd_func();
+		if (error < 0 || restool.cmd_option_mask != 0 ||
+		    !new_obj.valid)
+			break;
+
+		created++;
+		if (assign_to || plugged) {
+			error = assign_new_obj(assign_to, target_dprc_id,
+					       plugged);
+			if (error < 0)
+				break;
+		}
+	}
+
+	if (error < 0 && count > 1)
+		ERROR_PRINTF("stopped after creating %ld of %ld objects\n",
+			     created, count);
+
+	return error;
+}
+
+/**
+ * Maximum number of <command>=<lane> entries given to --priority
+ */
+#define MAX_LANE_OVERRIDES	16
+
+/**
+ * Maximum --pace value, in microseconds
+ */
+#define MAX_MC_PACE_US		1000000
+
+/**
+ * struct lane_override - lane given to one command with --priority
+ * @command: command name, optionally prefixed by the object type and a
+ *	dot, e.g. "destroy" or "dprc.connect"
+ * @lane: lane for that command
+ */
+struct lane_override {
+	char command[OBJ_TYPE_MAX_LENGTH + 32];
+	enum mc_lane lane;
+};
+
+/*
+ * Commands whose MC commands go out with the priority flag unless
+ * --priority says otherwise: they change the wiring dataplane drivers
+ * wait on, or move objects between containers through the pool, a
+ * build or a snapshot restore, while everything else only reads.
+ */
+static const char *const priority_commands[] = {
+	"connect",
+	"disconnect",
+	"destroy",
+	"assign",
+	"unassign",
+	"pool",
+	"build",
+	"restore",
+};
+
+static struct lane_override lane_overrides[MAX_LANE_OVERRIDES];
+static int num_lane_overrides;
+static bool lane_forced;
+static enum mc_lane forced_lane;
+
+static int parse_lane(const char *str, size_t len, enum mc_lane *lane)
+{
+	if (len == strlen("normal") && strncmp(str, "normal", len) == 0)
+		*lane = MC_LANE_NORMAL;
+	else if (len == strlen("high") && strncmp(str, "high", len) == 0)
+		*lane = MC_LANE_PRIORITY;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * Parses the --priority argument: a comma separated list of a lane,
+ * applying to all commands, and of <command>=<lane> entries
+ */
+static int parse_priority_option(const char *spec)
+{
+	struct lane_override *override;
+	const char *entry = spec;
+	const char *end;
+	const char *eq;
+	size_t len;
+
+	for (;;) {
+		end = strchr(entry, ',');
+		len = end ? (size_t)(end - entry) : strlen(entry);
+		eq = memchr(entry, '=', len);
+
+		if (eq == NULL) {
+			if (parse_lane(entry, len, &forced_lane) < 0)
+				goto invalid;
+			lane_forced = true;
+		} else {
+			if (num_lane_overrides == MAX_LANE_OVERRIDES) {
+				ERROR_PRINTF("Too many --priority entries, at most %d\n",
+					     MAX_LANE_OVERRIDES);
+				return -EINVAL;
+			}
+
+			override = &lane_overrides[num_lane_overrides];
+			if (eq == entry ||
+			    (size_t)(eq - entry) >= sizeof(override->command) ||
+			    parse_lane(eq + 1, len - (eq - entry) - 1,
+				       &override->lane) < 0)
+				goto invalid;
+
+			memcpy(override->command, entry, eq - entry);
+			override->command[eq - entry] = '\0';
+			num_lane_overrides++;
+		}
+
+		if (end == NULL)
+			return 0;
+		entry = end + 1;
+	}
+
+invalid:
+	ERROR_PRINTF("Invalid --priority value: %s\n", spec);
+	return -EINVAL;
+}
+
+/**
+ * Picks the lane of one restool command: an <object>.<command> entry of
+ * --priority wins over a <command> entry, which wins over a bare lane,
+ * which wins over the built-in default
+ */
+static enum mc_lane select_mc_lane(const char *obj_type, const char *cmd_name)
+{
+	const struct lane_override *command_match = NULL;
+	size_t type_len = strlen(obj_type);
+
+	for (int i = 0; i < num_lane_overrides; i++) {
+		const char *command = lane_overrides[i].command;
+
+		if (strncmp(command, obj_type, type_len) == 0 &&
+		    command[type_len] == '.' &&
+		    strcmp(&command[type_len + 1], cmd_name) == 0)
+			return lane_overrides[i].lane;
+
+		if (strcmp(command, cmd_name) == 0)
+			command_match = &lane_overrides[i];
+	}
+
+	if (command_match)
+		return command_match->lane;
+	if (lane_forced)
+		return forced_lane;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(priority_commands); i++)
+		if (strcmp(priority_commands[i], cmd_name) == 0)
+			return MC_LANE_PRIORITY;
+
+	return MC_LANE_NORMAL;
+}
+
+int parse_obj_command(const char *obj_type,
+		      const char *cmd_name,
+		      int argc,
+		      char *argv[])
 {
 	int error;
 	int next_argv_index;
@@ -1118,6 +1830,7 @@ static int parse_obj_command(const char *obj_type,
 	struct timespec start_time = { 0 };
 	struct timespec end_time = { 0 };
 	struct timespec latency = { 0 };
+	enum mc_lane lane = mc_lane_get();
 
 	assert(argv[0] == cmd_name);
 	obj_cmd = get_obj_cmd(obj_type, cmd_name);
@@ -1160,12 +1873,26 @@ static int parse_obj_command(const char *obj_type,
 		}
 	}
 
+	error = resolve_label_arg(restool.obj_name, &restool.obj_name);
+	if (error < 0)
+		goto out;
+
 	/*
 	 * Execute object-level command:
 	 */
+	mc_lane_set(select_mc_lane(obj_type, cmd_name));
+	DEBUG_PRINTF("MC command lane: %s\n",
+		     mc_lane_get() == MC_LANE_PRIORITY ? "high" : "normal");
+
 	clock_gettime(CLOCK_REALTIME, &start_time);
 
-	error = obj_cmd->cmd_func();
+	if (strcmp(cmd_name, "create") == 0)
+		error = run_create_command(obj_cmd);
+	else
+		error = obj_cmd->cmd_func();
+
+	if (strcmp(cmd_name, "destroy") == 0)
+		label_index_invalidate();
 
 	clock_gettime(CLOCK_REALTIME, &end_time);
 	diff_time(&start_time, &end_time, &latency);
@@ -1180,6 +1907,8 @@ static int parse_obj_command(const char *obj_type,
 		error = -EINVAL;
 	}
 out:
+	/* A plan step must not leave its lane to the next one */
+	mc_lane_set(lane);
 	return error;
 }
 
@@ -1266,13 +1995,9 @@ static int open_root_container(void)
 
 	if (strcmp(restool.device_file, "/dev/mc_restool") == 0) {
 		DEBUG_PRINTF("calling ioctl(RESTOOL_GET_ROOT_DPRC_INFO)\n");
-		error = ioctl(restool.mc_io.fd,
-			      RESTOOL_GET_ROOT_DPRC_INFO,
-			      &root_dprc_id);
-		if (error == -1) {
-			error = -errno;
+		error = mc_get_root_dprc_id(&restool.mc_io, &root_dprc_id);
+		if (error < 0)
 			return error;
-		}
 
 		DEBUG_PRINTF("ioctl returned MC-bus's root_dprc_id: %#x\n",
 			     root_dprc_id);
@@ -1317,9 +2042,80 @@ int main(int argc, char *argv[])
 	if (error < 0)
 		goto out;
 
-	error = get_device_file();
-	if (error < 0)
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_RECORD) &&
+	    restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_REPLAY)) {
+		ERROR_PRINTF("--record and --replay are mutually exclusive\n");
+		error = -EINVAL;
 		goto out;
+	}
+
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_REPLAY)) {
+		restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_REPLAY);
+		error = mc_trace_replay_start(
+				restool.global_option_args[GLOBAL_OPT_REPLAY]);
+		if (error < 0)
+			goto out;
+
+		strcpy(restool.device_file, mc_trace_device_file());
+	} else {
+		error = get_device_file();
+		if (error < 0)
+			goto out;
+	}
+
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_RECORD)) {
+		restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_RECORD);
+		error = mc_trace_record_start(
+				restool.global_option_args[GLOBAL_OPT_RECORD]);
+		if (error < 0)
+			goto out;
+	}
+
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_PORTALS)) {
+		const char *str = restool.global_option_args[GLOBAL_OPT_PORTALS];
+		char *endptr;
+		long val;
+
+		restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_PORTALS);
+		errno = 0;
+		val = strtol(str, &endptr, 0);
+		if (STRTOL_ERROR(str, endptr, val, errno) ||
+		    val < 1 || val > MAX_WALK_PORTALS) {
+			ERROR_PRINTF("Invalid --portals value, must be between 1 and %d\n",
+				     MAX_WALK_PORTALS);
+			error = -EINVAL;
+			goto out;
+		}
+
+		restool.num_portals = val;
+	}
+
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_PRIORITY)) {
+		restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_PRIORITY);
+		error = parse_priority_option(
+				restool.global_option_args[GLOBAL_OPT_PRIORITY]);
+		if (error < 0)
+			goto out;
+	}
+
+	if (restool.global_option_mask & ONE_BIT_MASK(GLOBAL_OPT_PACE)) {
+		const char *str = restool.global_option_args[GLOBAL_OPT_PACE];
+		char *endptr;
+		long val;
+
+		restool.global_option_mask &= ~ONE_BIT_MASK(GLOBAL_OPT_PACE);
+		errno = 0;
+		val = strtol(str, &endptr, 0);
+		if (STRTOL_ERROR(str, endptr, val, errno) ||
+		    val < 0 || val > MAX_MC_PACE_US) {
+			ERROR_PRINTF("Invalid --pace value, must be between 0 and %d\n",
+				     MAX_MC_PACE_US);
+			error = -EINVAL;
+			goto out;
+		}
+
+		mc_lane_set_pace(val);
+	}
 
 	DEBUG_PRINTF("restool built on " __DATE__ " " __TIME__ "\n");
 	error = mc_io_init(&restool.mc_io);
@@ -1430,6 +2226,15 @@ int main(int argc, char *argv[])
 			goto out;
 		}
 
+		if (restool.global_option_mask &
+		    ONE_BIT_MASK(GLOBAL_OPT_AUTHORITATIVE)) {
+			restool.global_option_mask &=
+				~ONE_BIT_MASK(GLOBAL_OPT_AUTHORITATIVE);
+			print_try_help();
+			error = -EINVAL;
+			goto out;
+		}
+
 		if (restool.global_option_mask != 0) {
 			print_unexpected_options_error(
 				restool.global_option_mask,
@@ -1451,6 +2256,13 @@ int main(int argc, char *argv[])
 			restool.script = true;
 		}
 
+		if (restool.global_option_mask &
+		    ONE_BIT_MASK(GLOBAL_OPT_AUTHORITATIVE)) {
+			restool.global_option_mask &=
+				~ONE_BIT_MASK(GLOBAL_OPT_AUTHORITATIVE);
+			restool.authoritative = true;
+		}
+
 		if (restool.global_option_mask &
 		    ONE_BIT_MASK(GLOBAL_OPT_ROOT)) {
 			restool.global_option_mask &=
@@ -1487,6 +2299,9 @@ int main(int argc, char *argv[])
 			goto out;
 	}
 
+	if (mc_trace_is_replaying())
+		goto out;
+
 	DEBUG_PRINTF("calling sytem()\n");
 	error = system("echo 1 > /sys/bus/fsl-mc/rescan");
 	if (error == -1) {
@@ -1497,22 +2312,22 @@ int main(int argc, char *argv[])
 	}
 
 out:
-	if (root_dprc_opened) {
+	if (root_dprc_opened)
+		(void)close_dprc(restool.root_dprc_handle);
+
+	if (mc_io_initialized) {
 		int error2;
 
-		error2 = dprc_close(&restool.mc_io, 0,
-					restool.root_dprc_handle);
-		if (error2 < 0) {
-			mc_status = flib_error_to_mc_status(error2);
-			ERROR_PRINTF("MC error: %s (status %#x)\n",
-				mc_status_to_string(mc_status), mc_status);
-			if (error == 0)
-				error = error2;
-		}
-	}
-	if (mc_io_initialized)
+		error2 = handle_cache_flush();
+		if (error == 0)
+			error = error2;
+
+		label_index_free();
+
 		mc_io_cleanup(&restool.mc_io);
+	}
 
+	mc_trace_stop();
 	return error;
 }
 
@@ -104,7 +104,7 @@
  * original definition is too long
  * to be an appropriate pass-in parameter for each flib API
  */
-#define PRINTR (MC_CMD_FLAG_PRI | INTR MC_CMD_FLAG_INTR_DIS)
+#define PRINTR (MC_CMD_FLAG_PRI | MC_CMD_FLAG_INTR_DIS)
 
 /*
  * TODO: Obtain the following constants from the fsl-mc bus driver via an ioctl
@@ -154,11 +154,41 @@ struct obj_command_versions {
 };
 
 /**
- * Object command parser structure
+ * Object types known to restool. Type strings are turned into one of
+ * these once, with obj_type_lookup(), and every later per-type dispatch
+ * is an index in a table.
  */
-struct object_cmd_parser {
+enum obj_type {
+	OBJ_TYPE_DPRC,
+	OBJ_TYPE_DPNI,
+	OBJ_TYPE_DPIO,
+	OBJ_TYPE_DPBP,
+	OBJ_TYPE_DPSW,
+	OBJ_TYPE_DPCI,
+	OBJ_TYPE_DPCON,
+	OBJ_TYPE_DPSECI,
+	OBJ_TYPE_DPDMUX,
+	OBJ_TYPE_DPMCP,
+	OBJ_TYPE_DPMAC,
+	OBJ_TYPE_DPDCEI,
+	OBJ_TYPE_DPAIOP,
+	OBJ_TYPE_DPDBG,
+	OBJ_TYPE_DPRTC,
+	OBJ_TYPE_DPDMAI,
+	/* command-line only, no MC object has this type */
+	OBJ_TYPE_SNAPSHOT,
+	NUM_OBJ_TYPES,
+	OBJ_TYPE_INVALID = -1
+};
+
+struct flib_ops;
+
+/**
+ * Per object type descriptor, indexed by enum obj_type
+ */
+struct obj_type_desc {
 	/**
-	 * object-type found in the command line
+	 * object-type found in the command line and in object descriptors
 	 */
 	const char *obj_type;
 
@@ -166,22 +196,18 @@ struct object_cmd_parser {
 	 * Pointer to array of command/version mappings for the object type
 	 */
 	const struct obj_command_versions *obj_commands_versions;
-};
 
-/**
- * look up table entry for each object version numbers
- */
-struct lut_entry {
 	/**
-	 * Name of object type trying to look up
+	 * array of the different MC Versions this object is found in
 	 */
-	const char *object;
+	struct version_table *versions_table;
 
 	/**
-	 * array of the different MC Versions this object is found in
+	 * generic flib operations, NULL for types without an MC object
 	 */
-	struct version_table *versions_table;
+	const struct flib_ops *ops;
 };
+
 /**
  * holds the MC version as well as the corresponding object version
  */
@@ -265,6 +291,12 @@ struct restool {
 	 */
 	bool script;
 
+	/**
+	 * global flag to always query the MC instead of trusting
+	 * the fsl-mc bus view in sysfs
+	 */
+	bool authoritative;
+
 	/**
 	 * device file used by restool
 	 */
@@ -275,6 +307,11 @@ struct restool {
 	 */
 	char specified_dev_file[USR_DEV_FILE_SIZE];
 
+	/**
+	 * number of MC portal sessions container walks may use
+	 * concurrently, 0 or 1 meaning the single restool portal
+	 */
+	unsigned int num_portals;
 };
 
 /**
@@ -286,7 +323,13 @@ enum global_options {
 	GLOBAL_OPT_MC_VERSION,
 	GLOBAL_OPT_DEBUG,
 	GLOBAL_OPT_SCRIPT,
-	GLOBAL_OPT_ROOT
+	GLOBAL_OPT_ROOT,
+	GLOBAL_OPT_RECORD,
+	GLOBAL_OPT_REPLAY,
+	GLOBAL_OPT_PORTALS,
+	GLOBAL_OPT_AUTHORITATIVE,
+	GLOBAL_OPT_PRIORITY,
+	GLOBAL_OPT_PACE
 };
 
 /* object option map entry */
@@ -319,13 +362,45 @@ typedef int flib_obj_get_irq_status_t(struct fsl_mc_io	*mc_io,
 					uint8_t		irq_index,
 					uint32_t	*status);
 
+typedef int flib_obj_destroy_t(struct fsl_mc_io	*mc_io,
+				uint16_t	dprc_token,
+				uint32_t	cmd_flags,
+				uint32_t	obj_id);
+
+/**
+ * obj_destroy acts on behalf of the container the object is in, and is
+ * NULL for the types a container cannot destroy
+ */
 struct flib_ops {
 	flib_obj_open_t *obj_open;
 	flib_obj_close_t *obj_close;
 	flib_obj_get_irq_mask_t *obj_get_irq_mask;
 	flib_obj_get_irq_status_t *obj_get_irq_status;
+	flib_obj_destroy_t *obj_destroy;
 };
 
+extern const struct flib_ops dpaiop_ops;
+extern const struct flib_ops dpbp_ops;
+extern const struct flib_ops dpci_ops;
+extern const struct flib_ops dpcon_ops;
+extern const struct flib_ops dpdcei_ops;
+extern const struct flib_ops dpdmai_ops;
+extern const struct flib_ops dpdmux_ops_v9;
+extern const struct flib_ops dpio_ops;
+extern const struct flib_ops dpmac_ops;
+extern const struct flib_ops dpmcp_ops;
+extern const struct flib_ops dpni_ops;
+extern const struct flib_ops dprc_ops;
+extern const struct flib_ops dprtc_ops;
+extern const struct flib_ops dpseci_ops;
+extern const struct flib_ops dpsw_ops;
+
+enum obj_type obj_type_lookup(const char *obj_type);
+
+const char *obj_type_name(enum obj_type type);
+
+const struct flib_ops *obj_type_ops(enum obj_type type);
+
 /* functions used for parsing user command line argumments */
 int parse_object_name(const char *obj_name,
 		      char *expected_obj_type,
@@ -350,6 +425,8 @@ void print_unexpected_options_error(uint32_t option_mask,
 
 void print_obj_label(struct dprc_obj_desc *target_obj_desc);
 
+void print_json_string(const char *str, size_t max_len);
+
 int print_obj_verbose(struct dprc_obj_desc *target_obj_desc,
 		      const struct flib_ops *ops);
 
@@ -358,6 +435,11 @@ void print_new_obj(char *type, int id, const char *parent);
 /* functions used to handle generic object handling */
 int open_dprc(uint32_t dprc_id, uint16_t *dprc_handle);
 
+int close_dprc(uint16_t dprc_handle);
+
+int get_obj_desc_in_dprc(uint16_t dprc_handle, const char *obj_type,
+			 uint32_t obj_id, struct dprc_obj_desc *obj_desc);
+
 int find_target_obj_desc(uint32_t dprc_id, uint16_t dprc_handle,
 			int nesting_level,
 			uint32_t target_id, char *target_type,
@@ -370,9 +452,18 @@ int check_resource_type(char *res_type);
 
 bool in_use(const char *obj, const char *situation);
 
+int sysfs_get_parent_dprc_id(const char *obj_type, uint32_t obj_id,
+			     uint32_t *parent_dprc_id);
+
 int get_parent_dprc_id(uint32_t obj_id, char *obj_type,
 		       uint32_t *parent_dprc_id);
 
+/* runs one "<object-type> <command> [<object-name>] [ARGS...]" command */
+int parse_obj_command(const char *obj_type,
+		      const char *cmd_name,
+		      int argc,
+		      char *argv[]);
+
 extern struct restool restool;
 
 /* command maps for all MC objects */
@@ -408,6 +499,8 @@ extern struct object_command dpmcp_commands_v10[];
 
 extern struct object_command dprc_commands[];
 
+extern struct object_command snapshot_commands[];
+
 extern struct object_command dprtc_commands_v9[];
 extern struct object_command dprtc_commands_v10[];
 
@@ -0,0 +1,1781 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <assert.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "restool.h"
+#include "utils.h"
+#include "dprc_walk.h"
+#include "transaction.h"
+#include "label_index.h"
+#include "mc_v10/fsl_dpbp.h"
+#include "mc_v10/fsl_dpci.h"
+#include "mc_v10/fsl_dpcon.h"
+#include "mc_v10/fsl_dpdcei.h"
+#include "mc_v10/fsl_dpdmai.h"
+#include "mc_v10/fsl_dpdmux.h"
+#include "mc_v10/fsl_dpio.h"
+#include "mc_v10/fsl_dpmac.h"
+#include "mc_v10/fsl_dpmcp.h"
+#include "mc_v10/fsl_dpni.h"
+#include "mc_v10/fsl_dprtc.h"
+#include "mc_v10/fsl_dpseci.h"
+#include "mc_v10/fsl_dpsw.h"
+
+/*
+ * Snapshot file layout, version 1. Integers are unsigned LEB128
+ * varints unless noted; strings are a length byte followed by the
+ * characters.
+ *
+ *   magic "RSNP", version (byte), flags (byte, 0)
+ *   number of containers, objects and connections
+ *   containers, parents first:
+ *	id, parent (index + 1, 0 for the snapshot root), options, label
+ *   objects:
+ *	type code (byte), state (byte), id, container (index + 1),
+ *	label, number of create parameters, parameters
+ *   connections, two endpoints each:
+ *	type code (byte), object (index + 1, 0 for an object outside
+ *	the snapshot), id, interface
+ *   FNV-1a checksum of everything above (4 bytes, little endian)
+ */
+#define SNAPSHOT_MAGIC		"RSNP"
+#define SNAPSHOT_VERSION	1
+
+/**
+ * Maximum number of create parameters of one object
+ */
+#define SNAPSHOT_MAX_PARAMS	16
+
+/**
+ * Maximum container nesting below the snapshot root
+ */
+#define SNAPSHOT_MAX_DEPTH	16
+
+/**
+ * Object state bit: the object is plugged
+ */
+#define SNAPSHOT_STATE_PLUGGED	0x1
+
+/**
+ * snapshot save/restore command options
+ */
+enum snapshot_options {
+	SNAPSHOT_OPT_HELP = 0,
+	SNAPSHOT_OPT_FILE,
+};
+
+static struct option snapshot_save_options[] = {
+	[SNAPSHOT_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[SNAPSHOT_OPT_FILE] = {
+		.name = "file",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(snapshot_save_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+static struct option snapshot_restore_options[] = {
+	[SNAPSHOT_OPT_HELP] = {
+		.name = "help",
+		.has_arg = 0,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	[SNAPSHOT_OPT_FILE] = {
+		.name = "file",
+		.has_arg = 1,
+		.flag = NULL,
+		.val = 0,
+	},
+
+	{ 0 },
+};
+
+C_ASSERT(ARRAY_SIZE(snapshot_restore_options) <= MAX_NUM_CMD_LINE_OPTIONS + 1);
+
+/**
+ * struct snap_container - container below the snapshot root
+ * @id: container id when the snapshot was saved
+ * @parent: index of the parent container, -1 for the snapshot root
+ * @depth: nesting level below the snapshot root, from 1
+ * @options: container configuration options
+ * @label: container label
+ * @new_id: id of the container created by a restore
+ */
+struct snap_container {
+	uint32_t id;
+	int parent;
+	int depth;
+	uint64_t options;
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	uint32_t new_id;
+};
+
+/**
+ * struct snap_obj - object in one of the snapshot containers
+ * @type: index in snap_types[]
+ * @state: SNAPSHOT_STATE_* bits
+ * @id: object id when the snapshot was saved
+ * @container: index of the container holding the object
+ * @label: object label
+ * @params: create parameters, in the order of the type's fetch and
+ *	create functions; missing ones are 0
+ * @new_id: id of the object created by a restore
+ */
+struct snap_obj {
+	int type;
+	uint8_t state;
+	uint32_t id;
+	int container;
+	char label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+	uint64_t params[SNAPSHOT_MAX_PARAMS];
+	uint32_t new_id;
+};
+
+/**
+ * struct snap_endpoint - one end of a connection
+ * @type: index in snap_types[]
+ * @obj: index of the snapshot object, -1 for an object outside the
+ *	snapshot, which keeps its id across a restore
+ * @id: object id when the snapshot was saved
+ * @if_id: interface of the object
+ */
+struct snap_endpoint {
+	int type;
+	int obj;
+	uint32_t id;
+	uint16_t if_id;
+};
+
+struct snap_conn {
+	struct snap_endpoint ep[2];
+};
+
+struct snapshot {
+	int num_containers;
+	struct snap_container *containers;
+	int num_objs;
+	struct snap_obj *objs;
+	int num_conns;
+	struct snap_conn *conns;
+};
+
+typedef int snap_fetch_t(struct fsl_mc_io *mc_io, uint32_t id,
+			 uint64_t *params);
+
+typedef int snap_create_t(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			  const uint64_t *params, uint32_t *obj_id);
+
+static int fetch_dpci(struct fsl_mc_io *mc_io, uint32_t id, uint64_t *params)
+{
+	struct dpci_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpci_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpci_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpci_close_v10(mc_io, 0, token);
+	params[0] = attr.num_of_priorities;
+	return error ? error : error2;
+}
+
+static int fetch_dpcon(struct fsl_mc_io *mc_io, uint32_t id, uint64_t *params)
+{
+	struct dpcon_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpcon_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpcon_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpcon_close_v10(mc_io, 0, token);
+	params[0] = attr.num_priorities;
+	return error ? error : error2;
+}
+
+static int fetch_dpdcei(struct fsl_mc_io *mc_io, uint32_t id,
+			uint64_t *params)
+{
+	struct dpdcei_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpdcei_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpdcei_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpdcei_close_v10(mc_io, 0, token);
+	params[0] = attr.engine;
+	return error ? error : error2;
+}
+
+static int fetch_dpdmai(struct fsl_mc_io *mc_io, uint32_t id,
+			uint64_t *params)
+{
+	struct dpdmai_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpdmai_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpdmai_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpdmai_close_v10(mc_io, 0, token);
+	params[0] = attr.num_of_queues;
+	return error ? error : error2;
+}
+
+static int fetch_dpdmux(struct fsl_mc_io *mc_io, uint32_t id,
+			uint64_t *params)
+{
+	struct dpdmux_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpdmux_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpdmux_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpdmux_close_v10(mc_io, 0, token);
+	params[0] = attr.num_ifs;
+	params[1] = attr.method;
+	params[2] = attr.manip;
+	params[3] = attr.options;
+	return error ? error : error2;
+}
+
+static int fetch_dpio(struct fsl_mc_io *mc_io, uint32_t id, uint64_t *params)
+{
+	struct dpio_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpio_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpio_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpio_close_v10(mc_io, 0, token);
+	params[0] = attr.channel_mode;
+	params[1] = attr.num_priorities;
+	return error ? error : error2;
+}
+
+static int fetch_dpmac(struct fsl_mc_io *mc_io, uint32_t id,
+		       uint64_t *params)
+{
+	(void)mc_io;
+
+	/* A DPMAC is created for the MAC of the same number */
+	params[0] = id;
+	return 0;
+}
+
+static int fetch_dpni(struct fsl_mc_io *mc_io, uint32_t id, uint64_t *params)
+{
+	struct dpni_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpni_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpni_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpni_close_v10(mc_io, 0, token);
+	params[0] = attr.options;
+	params[1] = attr.num_queues;
+	params[2] = attr.num_rx_tcs;
+	params[3] = attr.mac_filter_entries;
+	params[4] = attr.vlan_filter_entries;
+	params[5] = attr.qos_entries;
+	params[6] = attr.fs_entries;
+	return error ? error : error2;
+}
+
+static int fetch_dpseci(struct fsl_mc_io *mc_io, uint32_t id,
+			uint64_t *params)
+{
+	struct dpseci_tx_queue_attr_v10 tx_attr;
+	struct dpseci_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpseci_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpseci_get_attributes_v10(mc_io, 0, token, &attr);
+	params[0] = attr.options;
+	params[1] = attr.num_tx_queues;
+	params[2] = attr.num_rx_queues;
+	for (int i = 0; error == 0 && i < attr.num_tx_queues &&
+	     i < DPSECI_PRIO_NUM; i++) {
+		memset(&tx_attr, 0, sizeof(tx_attr));
+		error = dpseci_get_tx_queue_v10(mc_io, 0, token, i, &tx_attr);
+		params[3 + i] = tx_attr.priority;
+	}
+
+	error2 = dpseci_close_v10(mc_io, 0, token);
+	return error ? error : error2;
+}
+
+static int fetch_dpsw(struct fsl_mc_io *mc_io, uint32_t id, uint64_t *params)
+{
+	struct dpsw_attr_v10 attr;
+	uint16_t token;
+	int error, error2;
+
+	error = dpsw_open_v10(mc_io, 0, id, &token);
+	if (error < 0)
+		return error;
+
+	memset(&attr, 0, sizeof(attr));
+	error = dpsw_get_attributes_v10(mc_io, 0, token, &attr);
+	error2 = dpsw_close_v10(mc_io, 0, token);
+	params[0] = attr.num_ifs;
+	params[1] = attr.options;
+	params[2] = attr.max_vlans;
+	params[3] = attr.max_meters_per_if;
+	params[4] = attr.max_fdbs;
+	params[5] = attr.max_fdb_entries;
+	params[6] = attr.fdb_aging_time;
+	params[7] = attr.max_fdb_mc_groups;
+	params[8] = attr.component_type;
+	return error ? error : error2;
+}
+
+static int create_dpbp(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+		       const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpbp_cfg_v10 cfg;
+
+	(void)params;
+	memset(&cfg, 0, sizeof(cfg));
+	return dpbp_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpci(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+		       const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpci_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_of_priorities = params[0];
+	return dpci_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpcon(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpcon_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_priorities = params[0];
+	return dpcon_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpdcei(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			 const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpdcei_cfg_v10 cfg;
+
+	/* The queue priority cannot be read back from the MC */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.engine = (enum dpdcei_engine)params[0];
+	cfg.priority = 1;
+	return dpdcei_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpdmai(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			 const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpdmai_cfg_v10 cfg;
+
+	/* Queue priorities cannot be read back: use the create defaults */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_queues = params[0];
+	cfg.priorities[0] = 1;
+	cfg.priorities[1] = 2;
+	return dpdmai_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpdmux(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			 const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpdmux_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_ifs = params[0];
+	cfg.method = (enum dpdmux_method)params[1];
+	cfg.manip = (enum dpdmux_manip)params[2];
+	cfg.adv.options = params[3];
+	return dpdmux_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpio(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+		       const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpio_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.channel_mode = (enum dpio_channel_mode)params[0];
+	cfg.num_priorities = params[1];
+	return dpio_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpmac(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpmac_cfg cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.mac_id = params[0];
+	return dpmac_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpmcp(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpmcp_cfg cfg;
+
+	(void)params;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.portal_id = DPMCP_GET_PORTAL_ID_FROM_POOL;
+	return dpmcp_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpni(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+		       const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpni_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.options = params[0];
+	cfg.num_queues = params[1];
+	cfg.num_tcs = params[2];
+	cfg.mac_filter_entries = params[3];
+	cfg.vlan_filter_entries = params[4];
+	cfg.qos_entries = params[5];
+	cfg.fs_entries = params[6];
+	return dpni_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dprtc(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			const uint64_t *params, uint32_t *obj_id)
+{
+	struct dprtc_cfg cfg;
+
+	(void)params;
+	memset(&cfg, 0, sizeof(cfg));
+	return dprtc_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpseci(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+			 const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpseci_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.options = params[0];
+	cfg.num_tx_queues = params[1];
+	cfg.num_rx_queues = params[2];
+	for (int i = 0; i < DPSECI_PRIO_NUM; i++)
+		cfg.priorities[i] = params[3 + i];
+	return dpseci_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+static int create_dpsw(struct fsl_mc_io *mc_io, uint16_t dprc_token,
+		       const uint64_t *params, uint32_t *obj_id)
+{
+	struct dpsw_cfg_v10 cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.num_ifs = params[0];
+	cfg.adv.options = params[1];
+	cfg.adv.max_vlans = params[2];
+	cfg.adv.max_meters_per_if = params[3];
+	cfg.adv.max_fdbs = params[4];
+	cfg.adv.max_fdb_entries = params[5];
+	cfg.adv.fdb_aging_time = params[6];
+	cfg.adv.max_fdb_mc_groups = params[7];
+	cfg.adv.component_type = (enum dpsw_component_type)params[8];
+	return dpsw_create_v10(mc_io, dprc_token, 0, &cfg, obj_id);
+}
+
+/**
+ * Object types a snapshot can hold. The index of an entry plus one is
+ * its type code in snapshot files: append new types at the end only.
+ * @fetch reads the create parameters of an object, NULL when it has
+ * none. @num_ifs_param is the parameter holding the number of
+ * interfaces of a multi-interface object, or -1.
+ */
+static const struct snap_type {
+	const char *name;
+	snap_fetch_t *fetch;
+	snap_create_t *create;
+	bool connectable;
+	int num_ifs_param;
+} snap_types[] = {
+	{ "dpbp", NULL, create_dpbp, false, -1 },
+	{ "dpci", fetch_dpci, create_dpci, true, -1 },
+	{ "dpcon", fetch_dpcon, create_dpcon, false, -1 },
+	{ "dpdcei", fetch_dpdcei, create_dpdcei, false, -1 },
+	{ "dpdmai", fetch_dpdmai, create_dpdmai, false, -1 },
+	{ "dpdmux", fetch_dpdmux, create_dpdmux, true, 0 },
+	{ "dpio", fetch_dpio, create_dpio, false, -1 },
+	{ "dpmac", fetch_dpmac, create_dpmac, true, -1 },
+	{ "dpmcp", NULL, create_dpmcp, false, -1 },
+	{ "dpni", fetch_dpni, create_dpni, true, -1 },
+	{ "dprtc", NULL, create_dprtc, false, -1 },
+	{ "dpseci", fetch_dpseci, create_dpseci, false, -1 },
+	{ "dpsw", fetch_dpsw, create_dpsw, true, 0 },
+};
+
+static int find_snap_type(const char *name)
+{
+	for (unsigned int i = 0; i < ARRAY_SIZE(snap_types); i++) {
+		if (strcmp(snap_types[i].name, name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+static uint16_t snap_obj_num_ifs(const struct snap_obj *obj)
+{
+	int param = snap_types[obj->type].num_ifs_param;
+
+	if (param < 0)
+		return 1;
+
+	/* DPDMUX interface 0 is the uplink */
+	if (strcmp(snap_types[obj->type].name, "dpdmux") == 0)
+		return obj->params[param] + 1;
+
+	return obj->params[param];
+}
+
+static void snapshot_free(struct snapshot *snap)
+{
+	free(snap->containers);
+	free(snap->objs);
+	free(snap->conns);
+	memset(snap, 0, sizeof(*snap));
+}
+
+static void print_mc_error(const char *type, uint32_t id, int error)
+{
+	enum mc_cmd_status mc_status;
+
+	mc_status = flib_error_to_mc_status(error);
+	ERROR_PRINTF("%s.%u: MC error: %s (status %#x)\n", type, id,
+		     mc_status_to_string(mc_status), mc_status);
+}
+
+/*
+ * Saving
+ */
+
+static int count_subtree(struct dprc_walk_node *node, int *num_containers,
+			 int *num_objs)
+{
+	for (int i = 0; i < node->num_objs; i++) {
+		if (node->obj_types[i] != OBJ_TYPE_DPRC)
+			(*num_objs)++;
+	}
+
+	*num_containers += node->num_children;
+	for (int i = 0; i < node->num_children; i++)
+		count_subtree(node->children[i], num_containers, num_objs);
+
+	return 0;
+}
+
+static int add_objs(struct snapshot *snap, struct dprc_walk_node *node,
+		    int container, int *num_errors)
+{
+	for (int i = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+		struct snap_obj *obj;
+		int type;
+		int error;
+
+		if (node->obj_types[i] == OBJ_TYPE_DPRC)
+			continue;
+
+		type = find_snap_type(desc->type);
+		if (type < 0) {
+			ERROR_PRINTF("%s.%d cannot be saved in a snapshot\n",
+				     desc->type, desc->id);
+			(*num_errors)++;
+			continue;
+		}
+
+		obj = &snap->objs[snap->num_objs++];
+		obj->type = type;
+		obj->id = desc->id;
+		obj->container = container;
+		if (desc->state & DPRC_OBJ_STATE_PLUGGED)
+			obj->state |= SNAPSHOT_STATE_PLUGGED;
+		snprintf(obj->label, sizeof(obj->label), "%s", desc->label);
+		if (!snap_types[type].fetch)
+			continue;
+
+		error = snap_types[type].fetch(&restool.mc_io, desc->id,
+					       obj->params);
+		if (error < 0) {
+			print_mc_error(desc->type, desc->id, error);
+			return error;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Adds the child containers of node, and then everything below them,
+ * so that parents always come before their children.
+ */
+static int add_containers(struct snapshot *snap, struct dprc_walk_node *node,
+			  int index, int depth, int *num_errors)
+{
+	int first = snap->num_containers;
+	int error;
+
+	for (int i = 0, k = 0; i < node->num_objs; i++) {
+		struct dprc_obj_desc *desc = &node->objs[i];
+		struct snap_container *c;
+
+		if (node->obj_types[i] != OBJ_TYPE_DPRC)
+			continue;
+
+		assert(k < node->num_children &&
+		       node->children[k]->id == (uint32_t)desc->id);
+		if (depth > SNAPSHOT_MAX_DEPTH) {
+			ERROR_PRINTF("dprc.%d is nested deeper than %d levels\n",
+				     desc->id, SNAPSHOT_MAX_DEPTH);
+			(*num_errors)++;
+		}
+
+		c = &snap->containers[snap->num_containers++];
+		c->id = desc->id;
+		c->parent = index;
+		c->depth = depth;
+		c->options = node->children[k]->options;
+		snprintf(c->label, sizeof(c->label), "%s", desc->label);
+		k++;
+	}
+
+	for (int i = 0; i < node->num_children; i++) {
+		error = add_objs(snap, node->children[i], first + i,
+				 num_errors);
+		if (error < 0)
+			return error;
+
+		error = add_containers(snap, node->children[i], first + i,
+				       depth + 1, num_errors);
+		if (error < 0)
+			return error;
+	}
+
+	return 0;
+}
+
+static int find_snap_obj(const struct snapshot *snap, int type, uint32_t id)
+{
+	for (int i = 0; i < snap->num_objs; i++) {
+		if (snap->objs[i].type == type && snap->objs[i].id == id)
+			return i;
+	}
+
+	return -1;
+}
+
+static int add_conn(struct snapshot *snap, int *max_conns,
+		    const struct snap_conn *conn)
+{
+	if (snap->num_conns == *max_conns) {
+		int max = *max_conns ? 2 * *max_conns : 16;
+		struct snap_conn *conns;
+
+		conns = realloc(snap->conns, max * sizeof(*conns));
+		if (!conns) {
+			ERROR_PRINTF("realloc failed\n");
+			return -ENOMEM;
+		}
+
+		snap->conns = conns;
+		*max_conns = max;
+	}
+
+	snap->conns[snap->num_conns++] = *conn;
+	return 0;
+}
+
+/**
+ * Records the connections of the snapshot objects. A connection
+ * between two snapshot objects is found from both ends and recorded
+ * from the one that comes first.
+ */
+static int add_conns(struct snapshot *snap, int *num_errors)
+{
+	struct dprc_endpoint endpoint1, endpoint2;
+	int max_conns = 0;
+	int state;
+	int error;
+
+	for (int i = 0; i < snap->num_objs; i++) {
+		struct snap_obj *obj = &snap->objs[i];
+		const struct snap_type *type = &snap_types[obj->type];
+		uint16_t num_ifs = snap_obj_num_ifs(obj);
+
+		if (!type->connectable)
+			continue;
+
+		memset(&endpoint1, 0, sizeof(endpoint1));
+		strncpy(endpoint1.type, type->name, sizeof(endpoint1.type) - 1);
+		endpoint1.id = obj->id;
+		for (uint16_t k = 0; k < num_ifs; k++) {
+			struct snap_conn conn;
+
+			endpoint1.if_id = k;
+			memset(&endpoint2, 0, sizeof(endpoint2));
+			error = dprc_get_connection(&restool.mc_io, 0,
+						    restool.root_dprc_handle,
+						    &endpoint1, &endpoint2,
+						    &state);
+			if (error == -ENAVAIL || (error == 0 && state == -1))
+				continue;
+			if (error < 0) {
+				print_mc_error(type->name, obj->id, error);
+				return error;
+			}
+
+			endpoint2.type[sizeof(endpoint2.type) - 1] = '\0';
+			conn.ep[0].type = obj->type;
+			conn.ep[0].obj = i;
+			conn.ep[0].id = obj->id;
+			conn.ep[0].if_id = k;
+			conn.ep[1].type = find_snap_type(endpoint2.type);
+			if (conn.ep[1].type < 0) {
+				ERROR_PRINTF("%s.%d cannot be saved in a snapshot\n",
+					     endpoint2.type, endpoint2.id);
+				(*num_errors)++;
+				continue;
+			}
+
+			conn.ep[1].obj = find_snap_obj(snap, conn.ep[1].type,
+						       endpoint2.id);
+			conn.ep[1].id = endpoint2.id;
+			conn.ep[1].if_id = endpoint2.if_id;
+			if (conn.ep[1].obj >= 0 &&
+			    (conn.ep[1].obj < i ||
+			     (conn.ep[1].obj == i && conn.ep[1].if_id < k)))
+				continue;
+
+			error = add_conn(snap, &max_conns, &conn);
+			if (error < 0)
+				return error;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * struct snap_buf - growing buffer a snapshot file is encoded into
+ */
+struct snap_buf {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+	bool failed;
+};
+
+static void put_bytes(struct snap_buf *buf, const void *data, size_t len)
+{
+	if (buf->failed)
+		return;
+
+	if (buf->len + len > buf->size) {
+		size_t size = buf->size ? 2 * buf->size : 4096;
+		uint8_t *p;
+
+		while (size < buf->len + len)
+			size *= 2;
+
+		p = realloc(buf->data, size);
+		if (!p) {
+			buf->failed = true;
+			return;
+		}
+
+		buf->data = p;
+		buf->size = size;
+	}
+
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+static void put_u8(struct snap_buf *buf, uint8_t value)
+{
+	put_bytes(buf, &value, 1);
+}
+
+static void put_varint(struct snap_buf *buf, uint64_t value)
+{
+	do {
+		uint8_t byte = value & 0x7f;
+
+		value >>= 7;
+		put_u8(buf, value ? byte | 0x80 : byte);
+	} while (value);
+}
+
+static void put_string(struct snap_buf *buf, const char *s)
+{
+	size_t len = strlen(s);
+
+	put_u8(buf, len);
+	put_bytes(buf, s, len);
+}
+
+static uint32_t fnv1a(const uint8_t *data, size_t len)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void put_endpoint(struct snap_buf *buf, const struct snap_endpoint *ep)
+{
+	put_u8(buf, ep->type + 1);
+	put_varint(buf, ep->obj + 1);
+	put_varint(buf, ep->id);
+	put_varint(buf, ep->if_id);
+}
+
+static int encode_snapshot(const struct snapshot *snap, struct snap_buf *buf)
+{
+	uint32_t checksum;
+	uint8_t trailer[4];
+
+	put_bytes(buf, SNAPSHOT_MAGIC, 4);
+	put_u8(buf, SNAPSHOT_VERSION);
+	put_u8(buf, 0);
+	put_varint(buf, snap->num_containers);
+	put_varint(buf, snap->num_objs);
+	put_varint(buf, snap->num_conns);
+
+	for (int i = 0; i < snap->num_containers; i++) {
+		const struct snap_container *c = &snap->containers[i];
+
+		put_varint(buf, c->id);
+		put_varint(buf, c->parent + 1);
+		put_varint(buf, c->options);
+		put_string(buf, c->label);
+	}
+
+	for (int i = 0; i < snap->num_objs; i++) {
+		const struct snap_obj *obj = &snap->objs[i];
+		int num_params = SNAPSHOT_MAX_PARAMS;
+
+		while (num_params > 0 && obj->params[num_params - 1] == 0)
+			num_params--;
+
+		put_u8(buf, obj->type + 1);
+		put_u8(buf, obj->state);
+		put_varint(buf, obj->id);
+		put_varint(buf, obj->container + 1);
+		put_string(buf, obj->label);
+		put_u8(buf, num_params);
+		for (int k = 0; k < num_params; k++)
+			put_varint(buf, obj->params[k]);
+	}
+
+	for (int i = 0; i < snap->num_conns; i++) {
+		put_endpoint(buf, &snap->conns[i].ep[0]);
+		put_endpoint(buf, &snap->conns[i].ep[1]);
+	}
+
+	if (buf->failed) {
+		ERROR_PRINTF("realloc failed\n");
+		return -ENOMEM;
+	}
+
+	checksum = fnv1a(buf->data, buf->len);
+	for (int i = 0; i < 4; i++)
+		trailer[i] = checksum >> (8 * i);
+	put_bytes(buf, trailer, sizeof(trailer));
+
+	return buf->failed ? -ENOMEM : 0;
+}
+
+static int write_file(const char *file, const struct snap_buf *buf)
+{
+	FILE *fp;
+	int error = 0;
+
+	fp = fopen(file, "wb");
+	if (!fp) {
+		error = -errno;
+		ERROR_PRINTF("cannot open %s: %s\n", file, strerror(errno));
+		return error;
+	}
+
+	if (fwrite(buf->data, 1, buf->len, fp) != buf->len)
+		error = -EIO;
+	if (fclose(fp) != 0 && error == 0)
+		error = -errno;
+	if (error < 0)
+		ERROR_PRINTF("error writing %s\n", file);
+
+	return error;
+}
+
+static int snapshot_save(uint32_t dprc_id, const char *file)
+{
+	struct dprc_walk_node *root = NULL;
+	struct snap_buf buf = { 0 };
+	struct snapshot snap;
+	int num_containers = 0;
+	int num_objs = 0;
+	int num_errors = 0;
+	int error;
+
+	memset(&snap, 0, sizeof(snap));
+	error = dprc_walk(dprc_id, &root);
+	if (error < 0)
+		goto out;
+
+	count_subtree(root, &num_containers, &num_objs);
+	snap.containers = calloc(num_containers + 1, sizeof(*snap.containers));
+	snap.objs = calloc(num_objs + 1, sizeof(*snap.objs));
+	if (!snap.containers || !snap.objs) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	error = add_containers(&snap, root, -1, 1, &num_errors);
+	if (error == 0)
+		error = add_conns(&snap, &num_errors);
+	if (error == 0 && num_errors)
+		error = -EINVAL;
+	if (error < 0) {
+		ERROR_PRINTF("dprc.%u cannot be saved, no snapshot was written\n",
+			     dprc_id);
+		goto out;
+	}
+
+	error = encode_snapshot(&snap, &buf);
+	if (error == 0)
+		error = write_file(file, &buf);
+	if (error == 0 && !restool.script)
+		printf("dprc.%u: %d containers, %d objects, %d connections saved to %s (%zu bytes)\n",
+		       dprc_id, snap.num_containers, snap.num_objs,
+		       snap.num_conns, file, buf.len);
+out:
+	free(buf.data);
+	snapshot_free(&snap);
+	dprc_walk_free(root);
+	return error;
+}
+
+/*
+ * Restoring
+ */
+
+/**
+ * struct snap_reader - cursor over a snapshot file being decoded
+ */
+struct snap_reader {
+	const uint8_t *p;
+	const uint8_t *end;
+	bool failed;
+};
+
+static uint8_t get_u8(struct snap_reader *r)
+{
+	if (r->p >= r->end) {
+		r->failed = true;
+		return 0;
+	}
+
+	return *r->p++;
+}
+
+static uint64_t get_varint(struct snap_reader *r)
+{
+	uint64_t value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte = get_u8(r);
+
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+
+	r->failed = true;
+	return 0;
+}
+
+static void get_string(struct snap_reader *r, char *s, size_t size)
+{
+	size_t len = get_u8(r);
+
+	if (len >= size || (size_t)(r->end - r->p) < len) {
+		r->failed = true;
+		s[0] = '\0';
+		return;
+	}
+
+	memcpy(s, r->p, len);
+	s[len] = '\0';
+	r->p += len;
+}
+
+/**
+ * Reads an index + 1 field, accepting 0 when allow_none, as -1
+ */
+static int get_index(struct snap_reader *r, int count, bool allow_none)
+{
+	uint64_t value = get_varint(r);
+
+	if ((value == 0 && !allow_none) || value > (uint64_t)count) {
+		r->failed = true;
+		return -1;
+	}
+
+	return (int)value - 1;
+}
+
+static void get_endpoint(struct snap_reader *r, const struct snapshot *snap,
+			 struct snap_endpoint *ep)
+{
+	ep->type = get_index(r, ARRAY_SIZE(snap_types), false);
+	ep->obj = get_index(r, snap->num_objs, true);
+	ep->id = get_varint(r);
+	ep->if_id = get_varint(r);
+	if (ep->obj >= 0 && ep->type != snap->objs[ep->obj].type)
+		r->failed = true;
+}
+
+static int decode_snapshot(const uint8_t *data, size_t len,
+			   struct snapshot *snap)
+{
+	struct snap_reader r = { data + 6, data + len - 4, false };
+	uint32_t checksum = 0;
+	uint64_t count;
+
+	if (len < 10 || memcmp(data, SNAPSHOT_MAGIC, 4) != 0) {
+		ERROR_PRINTF("not a restool snapshot\n");
+		return -EINVAL;
+	}
+
+	if (data[4] != SNAPSHOT_VERSION) {
+		ERROR_PRINTF("unsupported snapshot version %u\n", data[4]);
+		return -EINVAL;
+	}
+
+	for (int i = 0; i < 4; i++)
+		checksum |= (uint32_t)data[len - 4 + i] << (8 * i);
+	if (checksum != fnv1a(data, len - 4)) {
+		ERROR_PRINTF("snapshot checksum mismatch\n");
+		return -EINVAL;
+	}
+
+	/* Each record takes at least one byte */
+	count = get_varint(&r);
+	if (count > len)
+		goto corrupt;
+	snap->num_containers = count;
+	count = get_varint(&r);
+	if (count > len)
+		goto corrupt;
+	snap->num_objs = count;
+	count = get_varint(&r);
+	if (count > len)
+		goto corrupt;
+	snap->num_conns = count;
+
+	snap->containers = calloc(snap->num_containers + 1,
+				  sizeof(*snap->containers));
+	snap->objs = calloc(snap->num_objs + 1, sizeof(*snap->objs));
+	snap->conns = calloc(snap->num_conns + 1, sizeof(*snap->conns));
+	if (!snap->containers || !snap->objs || !snap->conns) {
+		ERROR_PRINTF("calloc failed\n");
+		return -ENOMEM;
+	}
+
+	for (int i = 0; i < snap->num_containers && !r.failed; i++) {
+		struct snap_container *c = &snap->containers[i];
+
+		c->id = get_varint(&r);
+		/* Parents come first */
+		c->parent = get_index(&r, i, true);
+		c->depth = c->parent < 0 ? 1 :
+			   snap->containers[c->parent].depth + 1;
+		c->options = get_varint(&r);
+		get_string(&r, c->label, sizeof(c->label));
+		if (c->depth > SNAPSHOT_MAX_DEPTH)
+			r.failed = true;
+	}
+
+	for (int i = 0; i < snap->num_objs && !r.failed; i++) {
+		struct snap_obj *obj = &snap->objs[i];
+		int num_params;
+
+		obj->type = get_index(&r, ARRAY_SIZE(snap_types), false);
+		obj->state = get_u8(&r);
+		obj->id = get_varint(&r);
+		obj->container = get_index(&r, snap->num_containers, false);
+		get_string(&r, obj->label, sizeof(obj->label));
+		num_params = get_u8(&r);
+		if (num_params > SNAPSHOT_MAX_PARAMS)
+			r.failed = true;
+		for (int k = 0; k < num_params && !r.failed; k++)
+			obj->params[k] = get_varint(&r);
+	}
+
+	for (int i = 0; i < snap->num_conns && !r.failed; i++) {
+		get_endpoint(&r, snap, &snap->conns[i].ep[0]);
+		get_endpoint(&r, snap, &snap->conns[i].ep[1]);
+	}
+
+	if (!r.failed && r.p == r.end)
+		return 0;
+
+corrupt:
+	ERROR_PRINTF("corrupt snapshot\n");
+	return -EINVAL;
+}
+
+static int read_snapshot(const char *file, struct snapshot *snap)
+{
+	uint8_t *data = NULL;
+	size_t len = 0;
+	size_t size = 0;
+	FILE *fp;
+	int error = 0;
+
+	fp = fopen(file, "rb");
+	if (!fp) {
+		error = -errno;
+		ERROR_PRINTF("cannot open %s: %s\n", file, strerror(errno));
+		return error;
+	}
+
+	for ( ; ; ) {
+		size_t n;
+
+		if (len == size) {
+			uint8_t *p;
+
+			size = size ? 2 * size : 4096;
+			p = realloc(data, size);
+			if (!p) {
+				ERROR_PRINTF("realloc failed\n");
+				error = -ENOMEM;
+				break;
+			}
+			data = p;
+		}
+
+		n = fread(data + len, 1, size - len, fp);
+		len += n;
+		if (n == 0) {
+			if (ferror(fp)) {
+				ERROR_PRINTF("error reading %s\n", file);
+				error = -EIO;
+			}
+			break;
+		}
+	}
+
+	fclose(fp);
+	if (error == 0)
+		error = decode_snapshot(data, len, snap);
+
+	free(data);
+	return error;
+}
+
+typedef int restore_op_t(struct dprc_worker *worker, int index);
+
+/**
+ * struct restore_ctx - state shared by the restore workers
+ * @lock: protects the fields below, the transaction journal and the
+ *	progress output
+ * @snap: snapshot being restored
+ * @dprc_id: container the snapshot is restored under
+ * @op: operation of the current phase
+ * @jobs: snapshot indexes the current phase applies @op to
+ * @num_jobs: number of entries in @jobs
+ * @next: next entry of @jobs to hand out
+ * @error: first error of the current phase, stops it
+ */
+struct restore_ctx {
+	pthread_mutex_t lock;
+	struct snapshot *snap;
+	uint32_t dprc_id;
+	restore_op_t *op;
+	int *jobs;
+	int num_jobs;
+	int next;
+	int error;
+};
+
+static int open_container(struct dprc_worker *worker, uint32_t dprc_id,
+			  uint16_t *handle)
+{
+	int error;
+
+	if (dprc_id == restool.root_dprc_id) {
+		*handle = worker->root_handle;
+		return 0;
+	}
+
+	error = dprc_open(worker->mc_io, 0, dprc_id, handle);
+	if (error < 0) {
+		print_mc_error("dprc", dprc_id, error);
+		return error;
+	}
+
+	return 0;
+}
+
+static void close_container(struct dprc_worker *worker, uint32_t dprc_id,
+			    uint16_t handle)
+{
+	if (dprc_id != restool.root_dprc_id)
+		(void)dprc_close(worker->mc_io, 0, handle);
+}
+
+static uint32_t container_new_id(struct restore_ctx *ctx, int index)
+{
+	return index < 0 ? ctx->dprc_id : ctx->snap->containers[index].new_id;
+}
+
+static int restore_container(struct dprc_worker *worker, int index)
+{
+	struct restore_ctx *ctx = worker->ctx;
+	struct snap_container *c = &ctx->snap->containers[index];
+	uint32_t parent_id = container_new_id(ctx, c->parent);
+	uint64_t portal_offset;
+	struct dprc_cfg cfg;
+	uint16_t handle;
+	int child_id;
+	int error;
+
+	error = open_container(worker, parent_id, &handle);
+	if (error < 0)
+		return error;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.icid = DPRC_GET_ICID_FROM_POOL;
+	cfg.portal_id = DPRC_GET_PORTAL_ID_FROM_POOL;
+	cfg.options = c->options;
+	snprintf(cfg.label, sizeof(cfg.label), "%s", c->label);
+	error = dprc_create_container(worker->mc_io, 0, handle, &cfg,
+				      &child_id, &portal_offset);
+	close_container(worker, parent_id, handle);
+	if (error < 0) {
+		print_mc_error("dprc", c->id, error);
+		return error;
+	}
+
+	c->new_id = child_id;
+	pthread_mutex_lock(&ctx->lock);
+	error = txn_record_create("dprc", child_id);
+	if (!restool.script)
+		printf("dprc.%d is created under dprc.%u (was dprc.%u)\n",
+		       child_id, parent_id, c->id);
+	pthread_mutex_unlock(&ctx->lock);
+
+	return error;
+}
+
+static int restore_obj(struct dprc_worker *worker, int index)
+{
+	struct restore_ctx *ctx = worker->ctx;
+	struct snap_obj *obj = &ctx->snap->objs[index];
+	const struct snap_type *type = &snap_types[obj->type];
+	uint16_t handle;
+	int error;
+
+	error = open_container(worker, ctx->dprc_id, &handle);
+	if (error < 0)
+		return error;
+
+	error = type->create(worker->mc_io, handle, obj->params,
+			     &obj->new_id);
+	close_container(worker, ctx->dprc_id, handle);
+	if (error < 0) {
+		print_mc_error(type->name, obj->id, error);
+		return error;
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	error = txn_record_create(type->name, obj->new_id);
+	pthread_mutex_unlock(&ctx->lock);
+
+	return error;
+}
+
+/**
+ * Moves a created object down the container chain to where the
+ * snapshot had it, plugs it on the last move if it was plugged, and
+ * sets its label there.
+ */
+static int restore_assignment(struct dprc_worker *worker, int index)
+{
+	struct restore_ctx *ctx = worker->ctx;
+	struct snapshot *snap = ctx->snap;
+	struct snap_obj *obj = &snap->objs[index];
+	const char *type_name = snap_types[obj->type].name;
+	int path[SNAPSHOT_MAX_DEPTH];
+	struct dprc_res_req res_req;
+	int depth = 0;
+	uint16_t handle;
+	uint32_t dprc_id;
+	int error;
+
+	for (int c = obj->container; c >= 0; c = snap->containers[c].parent)
+		path[depth++] = c;
+
+	memset(&res_req, 0, sizeof(res_req));
+	strncpy(res_req.type, type_name, sizeof(res_req.type) - 1);
+	res_req.num = 1;
+	res_req.id_base_align = obj->new_id;
+	for (int k = depth - 1; k >= 0; k--) {
+		uint32_t parent_id = container_new_id(ctx, k + 1 < depth ?
+						      path[k + 1] : -1);
+		uint32_t child_id = snap->containers[path[k]].new_id;
+
+		res_req.options = DPRC_RES_REQ_OPT_EXPLICIT;
+		if (k == 0 && (obj->state & SNAPSHOT_STATE_PLUGGED))
+			res_req.options |= DPRC_RES_REQ_OPT_PLUGGED;
+
+		error = open_container(worker, parent_id, &handle);
+		if (error < 0)
+			return error;
+
+		error = dprc_assign(worker->mc_io, 0, handle, child_id,
+				    &res_req);
+		close_container(worker, parent_id, handle);
+		if (error < 0) {
+			print_mc_error(type_name, obj->new_id, error);
+			return error;
+		}
+
+		pthread_mutex_lock(&ctx->lock);
+		error = txn_record_assign(true, parent_id, child_id, &res_req);
+		pthread_mutex_unlock(&ctx->lock);
+		if (error < 0)
+			return error;
+	}
+
+	if (obj->label[0] == '\0')
+		return 0;
+
+	dprc_id = snap->containers[obj->container].new_id;
+	error = open_container(worker, dprc_id, &handle);
+	if (error < 0)
+		return error;
+
+	error = dprc_set_obj_label(worker->mc_io, 0, handle, (char *)type_name,
+				   obj->new_id, obj->label);
+	close_container(worker, dprc_id, handle);
+	if (error < 0) {
+		print_mc_error(type_name, obj->new_id, error);
+		return error;
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	error = txn_record_set_label(dprc_id, type_name, obj->new_id, "");
+	pthread_mutex_unlock(&ctx->lock);
+
+	return error;
+}
+
+static void to_dprc_endpoint(struct restore_ctx *ctx,
+			     const struct snap_endpoint *ep,
+			     struct dprc_endpoint *endpoint)
+{
+	memset(endpoint, 0, sizeof(*endpoint));
+	strncpy(endpoint->type, snap_types[ep->type].name,
+		sizeof(endpoint->type) - 1);
+	endpoint->id = ep->obj >= 0 ? ctx->snap->objs[ep->obj].new_id : ep->id;
+	endpoint->if_id = ep->if_id;
+}
+
+static int restore_conn(struct dprc_worker *worker, int index)
+{
+	struct restore_ctx *ctx = worker->ctx;
+	struct snap_conn *conn = &ctx->snap->conns[index];
+	struct dprc_endpoint endpoint1, endpoint2;
+	struct dprc_connection_cfg cfg;
+	int error;
+
+	to_dprc_endpoint(ctx, &conn->ep[0], &endpoint1);
+	to_dprc_endpoint(ctx, &conn->ep[1], &endpoint2);
+	memset(&cfg, 0, sizeof(cfg));
+	error = dprc_connect(worker->mc_io, 0, worker->root_handle,
+			     &endpoint1, &endpoint2, &cfg);
+	if (error < 0) {
+		print_mc_error(endpoint1.type, endpoint1.id, error);
+		return error;
+	}
+
+	pthread_mutex_lock(&ctx->lock);
+	error = txn_record_connect(restool.root_dprc_id, &endpoint1);
+	pthread_mutex_unlock(&ctx->lock);
+
+	return error;
+}
+
+static void *restore_worker_run(void *arg)
+{
+	struct dprc_worker *worker = arg;
+	struct restore_ctx *ctx = worker->ctx;
+
+	pthread_mutex_lock(&ctx->lock);
+	while (ctx->next < ctx->num_jobs && ctx->error == 0) {
+		int index = ctx->jobs[ctx->next++];
+		int error;
+
+		pthread_mutex_unlock(&ctx->lock);
+		error = ctx->op(worker, index);
+		pthread_mutex_lock(&ctx->lock);
+		if (error < 0 && ctx->error == 0)
+			ctx->error = error;
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
+	return NULL;
+}
+
+/**
+ * Applies op to all jobs of a phase, spread over the workers. The
+ * jobs of a phase are independent of each other.
+ */
+static int run_phase(struct dprc_worker *workers, int num_workers,
+		     restore_op_t *op, int num_jobs)
+{
+	struct restore_ctx *ctx = workers[0].ctx;
+
+	ctx->op = op;
+	ctx->num_jobs = num_jobs;
+	ctx->next = 0;
+	if (num_workers > num_jobs)
+		num_workers = num_jobs;
+	dprc_workers_run(workers, num_workers, restore_worker_run);
+
+	return ctx->error;
+}
+
+static int run_phases(struct dprc_worker *workers, int num_workers)
+{
+	struct restore_ctx *ctx = workers[0].ctx;
+	struct snapshot *snap = ctx->snap;
+	int error;
+
+	/* Containers, a nesting level at a time */
+	for (int depth = 1; depth <= SNAPSHOT_MAX_DEPTH; depth++) {
+		int n = 0;
+
+		for (int i = 0; i < snap->num_containers; i++) {
+			if (snap->containers[i].depth == depth)
+				ctx->jobs[n++] = i;
+		}
+
+		if (n == 0)
+			break;
+
+		error = run_phase(workers, num_workers, restore_container, n);
+		if (error < 0)
+			return error;
+	}
+
+	for (int i = 0; i < snap->num_objs; i++)
+		ctx->jobs[i] = i;
+
+	error = run_phase(workers, num_workers, restore_obj, snap->num_objs);
+	if (error < 0)
+		return error;
+
+	error = run_phase(workers, num_workers, restore_assignment,
+			  snap->num_objs);
+	if (error < 0)
+		return error;
+
+	for (int i = 0; i < snap->num_conns; i++)
+		ctx->jobs[i] = i;
+
+	return run_phase(workers, num_workers, restore_conn, snap->num_conns);
+}
+
+/**
+ * Recreates the containers, objects and connections of a snapshot below
+ * a container. Containers are created first, a nesting level at a time,
+ * then all objects, which are then moved to their containers, and the
+ * connections last. The operations of each phase are independent and
+ * run on up to --portals MC portals at the same time. Everything is
+ * undone if any of them fails.
+ */
+static int snapshot_restore(uint32_t dprc_id, const char *file)
+{
+	struct dprc_worker workers[MAX_WALK_PORTALS];
+	struct restore_ctx ctx;
+	int num_workers;
+	struct snapshot snap;
+	int max_jobs;
+	int error;
+
+	memset(&snap, 0, sizeof(snap));
+	memset(&ctx, 0, sizeof(ctx));
+	error = read_snapshot(file, &snap);
+	if (error < 0)
+		goto out;
+
+	max_jobs = snap.num_containers;
+	if (snap.num_objs > max_jobs)
+		max_jobs = snap.num_objs;
+	if (snap.num_conns > max_jobs)
+		max_jobs = snap.num_conns;
+	ctx.jobs = calloc(max_jobs + 1, sizeof(*ctx.jobs));
+	if (!ctx.jobs) {
+		ERROR_PRINTF("calloc failed\n");
+		error = -ENOMEM;
+		goto out;
+	}
+
+	pthread_mutex_init(&ctx.lock, NULL);
+	ctx.snap = &snap;
+	ctx.dprc_id = dprc_id;
+
+	num_workers = dprc_workers_open(workers, MAX_WALK_PORTALS, &ctx);
+
+	txn_begin();
+	error = run_phases(workers, num_workers);
+	label_index_invalidate();
+	if (error < 0) {
+		if (txn_rollback() < 0)
+			ERROR_PRINTF("rollback incomplete, manual cleanup needed\n");
+	} else {
+		txn_end();
+		if (!restool.script)
+			printf("%d containers, %d objects, %d connections restored under dprc.%u\n",
+			       snap.num_containers, snap.num_objs,
+			       snap.num_conns, dprc_id);
+	}
+
+	dprc_workers_close(workers, num_workers);
+	pthread_mutex_destroy(&ctx.lock);
+out:
+	free(ctx.jobs);
+	snapshot_free(&snap);
+	return error;
+}
+
+static int cmd_snapshot_help(void)
+{
+	static const char help_msg[] =
+		"\n"
+		"Usage: restool snapshot <command> [--help] [ARGS...]\n"
+		"Where <command> can be:\n"
+		"   save - saves the layout below a container to a file.\n"
+		"   restore - recreates a saved layout below a container.\n"
+		"\n"
+		"For command-specific help, use the --help option of each command.\n"
+		"\n";
+
+	printf(help_msg);
+	return 0;
+}
+
+static int parse_snapshot_args(const char *usage_msg, uint32_t *dprc_id,
+			       const char **file)
+{
+	int error;
+
+	*dprc_id = restool.root_dprc_id;
+	if (restool.obj_name != NULL) {
+		error = parse_object_name(restool.obj_name, "dprc", dprc_id);
+		if (error < 0)
+			return error;
+	}
+
+	if (!(restool.cmd_option_mask & ONE_BIT_MASK(SNAPSHOT_OPT_FILE))) {
+		ERROR_PRINTF("--file option missing\n");
+		puts(usage_msg);
+		return -EINVAL;
+	}
+
+	restool.cmd_option_mask &= ~ONE_BIT_MASK(SNAPSHOT_OPT_FILE);
+	*file = restool.cmd_option_args[SNAPSHOT_OPT_FILE];
+	return 0;
+}
+
+static int cmd_snapshot_save(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool snapshot save [<container>] --file=<file>\n"
+		"   <container> is the container whose child containers are saved,\n"
+		"	with everything below them. Defaults to the root container.\n"
+		"\n"
+		"The snapshot holds the containers with their options and labels,\n"
+		"their objects with their create settings, labels and plugged\n"
+		"state, and the connections of those objects, including those to\n"
+		"objects outside the snapshot.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Save the layout below the root container:\n"
+		"   $ restool snapshot save --file=layout-a.snap\n"
+		"\n";
+
+	const char *file;
+	uint32_t dprc_id;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(SNAPSHOT_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(SNAPSHOT_OPT_HELP);
+		return 0;
+	}
+
+	error = parse_snapshot_args(usage_msg, &dprc_id, &file);
+	if (error < 0)
+		return error;
+
+	return snapshot_save(dprc_id, file);
+}
+
+static int cmd_snapshot_restore(void)
+{
+	static const char usage_msg[] =
+		"\n"
+		"Usage: restool snapshot restore [<container>] --file=<file>\n"
+		"   <container> is the container the saved containers are\n"
+		"	recreated under. Defaults to the root container.\n"
+		"\n"
+		"Containers and objects get new ids; connections to objects\n"
+		"outside the snapshot use the saved ids. With --portals=<n>,\n"
+		"independent operations run on up to <n> MC portals at the same\n"
+		"time. Everything is undone if any operation fails.\n"
+		"\n"
+		"EXAMPLE:\n"
+		"Switch the root container to a saved layout:\n"
+		"   $ restool dprc destroy dprc.2 --recursive\n"
+		"   $ restool --portals=4 snapshot restore --file=layout-b.snap\n"
+		"\n";
+
+	const char *file;
+	uint32_t dprc_id;
+	int error;
+
+	if (restool.cmd_option_mask & ONE_BIT_MASK(SNAPSHOT_OPT_HELP)) {
+		puts(usage_msg);
+		restool.cmd_option_mask &= ~ONE_BIT_MASK(SNAPSHOT_OPT_HELP);
+		return 0;
+	}
+
+	error = parse_snapshot_args(usage_msg, &dprc_id, &file);
+	if (error < 0)
+		return error;
+
+	if (txn_active()) {
+		ERROR_PRINTF("snapshot restore cannot be used inside a plan\n");
+		return -EINVAL;
+	}
+
+	return snapshot_restore(dprc_id, file);
+}
+
+struct object_command snapshot_commands[] = {
+	{ .cmd_name = "help",
+	  .options = NULL,
+	  .cmd_func = cmd_snapshot_help },
+
+	{ .cmd_name = "save",
+	  .options = snapshot_save_options,
+	  .cmd_func = cmd_snapshot_save },
+
+	{ .cmd_name = "restore",
+	  .options = snapshot_restore_options,
+	  .cmd_func = cmd_snapshot_restore },
+
+	{ .cmd_name = NULL },
+};
@@ -0,0 +1,96 @@
+#!/bin/sh
+
+# Copyright 2018 NXP
+
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+# * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+# * Redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution.
+# * Neither the name of the above-listed copyright holders nor the
+# names of any contributors may be used to endorse or promote products
+# derived from this software without specific prior written permission.
+
+
+# ALTERNATIVELY, this software may be distributed under the terms of the
+# GNU General Public License ("GPL") as published by the Free Software
+# Foundation, either version 2 of that License or (at your option) any
+# later version.
+
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# Runs the restool regression tests. Every tests/*.test file is a shell
+# fragment that drives restool with --replay against MC traces recorded
+# in tests/data, so no MC is needed. A test fails when restool's output
+# or exit status differs, or when the commands restool sends diverge
+# from the recorded ones.
+#
+# Usage: tests/run.sh <restool binary>
+
+TESTDIR=$(cd "$(dirname "$0")" && pwd)
+DATA=$TESTDIR/data
+RESTOOL=$(cd "$(dirname "${1:-./restool}")" && pwd)/$(basename "${1:-./restool}")
+OUT=$(mktemp)
+trap 'rm -f "$OUT"' EXIT
+
+passed=0
+failed=0
+
+# run <trace> <restool arguments...>: replays one command, keeping its
+# combined output in $OUT and its exit status in $status
+run()
+{
+	trace=$1
+	shift
+	status=0
+	"$RESTOOL" --replay="$DATA/$trace" "$@" >"$OUT" 2>&1 || status=$?
+}
+
+fail()
+{
+	echo "FAIL: $name: $*"
+	sed 's/^/	/' "$OUT"
+	test_failed=1
+}
+
+expect_status()
+{
+	[ "$status" -eq "$1" ] || fail "exit status $status, expected $1"
+}
+
+expect_line()
+{
+	grep -qxF -- "$1" "$OUT" || fail "missing line: $1"
+}
+
+expect_no_match()
+{
+	! grep -qF -- "$1" "$OUT" || fail "unexpected output: $1"
+}
+
+for test in "$TESTDIR"/*.test; do
+	name=$(basename "$test" .test)
+	test_failed=0
+	. "$test"
+	if [ $test_failed -eq 0 ]; then
+		echo "PASS: $name"
+		passed=$((passed + 1))
+	else
+		failed=$((failed + 1))
+	fi
+done
+
+echo "$passed passed, $failed failed"
+[ $failed -eq 0 ]
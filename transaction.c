@@ -0,0 +1,459 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include "restool.h"
+#include "utils.h"
+#include "handle_cache.h"
+#include "label_index.h"
+#include "fsl_mc_lane.h"
+#include "transaction.h"
+
+/**
+ * Kinds of MC changes kept in the undo journal
+ */
+enum txn_op {
+	TXN_OP_CREATE,
+	TXN_OP_ASSIGN,
+	TXN_OP_UNASSIGN,
+	TXN_OP_CONNECT,
+	TXN_OP_DISCONNECT,
+	TXN_OP_SET_LABEL,
+};
+
+/**
+ * struct txn_entry - one MC change, with what is needed to undo it
+ * @op: kind of change
+ * @obj_name: "<type>.<id>" of a created or relabelled object
+ * @dprc_id: container the change was issued on
+ * @child_dprc_id: destination container of an assign, source
+ *	container of an unassign
+ * @res_req: resource request of an assign or unassign
+ * @endpoint: first endpoint of a connection
+ * @peer: other endpoint of a removed connection
+ * @type: object type of a relabelled object
+ * @id: object id of a relabelled object
+ * @old_label: label a relabelled object had before
+ */
+struct txn_entry {
+	enum txn_op op;
+	char obj_name[OBJ_TYPE_MAX_LENGTH + 12];
+	uint32_t dprc_id;
+	uint32_t child_dprc_id;
+	struct dprc_res_req res_req;
+	struct dprc_endpoint endpoint;
+	struct dprc_endpoint peer;
+	char type[OBJ_TYPE_MAX_LENGTH + 1];
+	int id;
+	char old_label[MC_OBJ_LABEL_MAX_LENGTH + 1];
+};
+
+static struct txn_entry *journal;
+static int num_entries;
+static int max_entries;
+static bool active;
+
+bool txn_active(void)
+{
+	return active;
+}
+
+/**
+ * Starts recording MC changes made by commands into the undo journal
+ */
+void txn_begin(void)
+{
+	num_entries = 0;
+	active = true;
+}
+
+/**
+ * Stops recording and forgets the journal, keeping all changes
+ */
+void txn_end(void)
+{
+	active = false;
+	free(journal);
+	journal = NULL;
+	num_entries = 0;
+	max_entries = 0;
+}
+
+static struct txn_entry *new_entry(enum txn_op op)
+{
+	struct txn_entry *entry;
+
+	if (num_entries == max_entries) {
+		struct txn_entry *new_journal;
+		int max = max_entries ? 2 * max_entries : 16;
+
+		new_journal = realloc(journal, max * sizeof(*new_journal));
+		if (!new_journal) {
+			ERROR_PRINTF("realloc failed\n");
+			return NULL;
+		}
+
+		journal = new_journal;
+		max_entries = max;
+	}
+
+	entry = &journal[num_entries++];
+	memset(entry, 0, sizeof(*entry));
+	entry->op = op;
+	return entry;
+}
+
+int txn_record_create(const char *type, int id)
+{
+	struct txn_entry *entry;
+
+	if (!active)
+		return 0;
+
+	entry = new_entry(TXN_OP_CREATE);
+	if (!entry)
+		return -ENOMEM;
+
+	snprintf(entry->obj_name, sizeof(entry->obj_name), "%s.%d", type, id);
+	return 0;
+}
+
+int txn_record_assign(bool do_assign, uint32_t parent_dprc_id,
+		      uint32_t child_dprc_id,
+		      const struct dprc_res_req *res_req)
+{
+	struct txn_entry *entry;
+
+	if (!active)
+		return 0;
+
+	entry = new_entry(do_assign ? TXN_OP_ASSIGN : TXN_OP_UNASSIGN);
+	if (!entry)
+		return -ENOMEM;
+
+	entry->dprc_id = parent_dprc_id;
+	entry->child_dprc_id = child_dprc_id;
+	entry->res_req = *res_req;
+	return 0;
+}
+
+int txn_record_connect(uint32_t dprc_id, const struct dprc_endpoint *endpoint)
+{
+	struct txn_entry *entry;
+
+	if (!active)
+		return 0;
+
+	entry = new_entry(TXN_OP_CONNECT);
+	if (!entry)
+		return -ENOMEM;
+
+	entry->dprc_id = dprc_id;
+	entry->endpoint = *endpoint;
+	return 0;
+}
+
+int txn_record_disconnect(uint32_t dprc_id,
+			  const struct dprc_endpoint *endpoint,
+			  const struct dprc_endpoint *peer)
+{
+	struct txn_entry *entry;
+
+	if (!active)
+		return 0;
+
+	entry = new_entry(TXN_OP_DISCONNECT);
+	if (!entry)
+		return -ENOMEM;
+
+	entry->dprc_id = dprc_id;
+	entry->endpoint = *endpoint;
+	entry->peer = *peer;
+	return 0;
+}
+
+int txn_record_set_label(uint32_t parent_dprc_id, const char *type, int id,
+			 const char *old_label)
+{
+	struct txn_entry *entry;
+
+	if (!active)
+		return 0;
+
+	entry = new_entry(TXN_OP_SET_LABEL);
+	if (!entry)
+		return -ENOMEM;
+
+	entry->dprc_id = parent_dprc_id;
+	strncpy(entry->type, type, OBJ_TYPE_MAX_LENGTH);
+	entry->id = id;
+	strncpy(entry->old_label, old_label, MC_OBJ_LABEL_MAX_LENGTH);
+	snprintf(entry->obj_name, sizeof(entry->obj_name), "%s.%d", type, id);
+	return 0;
+}
+
+/**
+ * Name of the index-th object created since txn_begin(), or NULL
+ */
+const char *txn_created_obj(int index)
+{
+	for (int i = 0; i < num_entries; i++) {
+		if (journal[i].op != TXN_OP_CREATE)
+			continue;
+
+		if (index-- == 0)
+			return journal[i].obj_name;
+	}
+
+	return NULL;
+}
+
+/**
+ * Number of objects created since txn_begin()
+ */
+int txn_num_created(void)
+{
+	int count = 0;
+
+	for (int i = 0; i < num_entries; i++) {
+		if (journal[i].op == TXN_OP_CREATE)
+			count++;
+	}
+
+	return count;
+}
+
+static int undo_create(struct txn_entry *entry)
+{
+	char type[OBJ_TYPE_MAX_LENGTH + 1];
+	char destroy[] = "destroy";
+	char *argv[] = { destroy, entry->obj_name, NULL };
+	char *dot;
+
+	strncpy(type, entry->obj_name, OBJ_TYPE_MAX_LENGTH);
+	type[OBJ_TYPE_MAX_LENGTH] = '\0';
+	dot = strchr(type, '.');
+	if (dot)
+		*dot = '\0';
+
+	return parse_obj_command(type, argv[0], 2, argv);
+}
+
+/**
+ * Unplugs an object that an assign plugged into a child container, since
+ * the MC refuses to move a plugged object back out. The plugged state
+ * is changed by assigning the object to the child itself.
+ */
+static int unplug_in_child(struct txn_entry *entry)
+{
+	struct dprc_res_req res_req = entry->res_req;
+	uint16_t child_handle;
+	int error;
+	int error2;
+
+	error = open_dprc(entry->child_dprc_id, &child_handle);
+	if (error < 0)
+		return error;
+
+	res_req.options &= ~DPRC_RES_REQ_OPT_PLUGGED;
+	error = dprc_assign(&restool.mc_io, 0, child_handle,
+			    entry->child_dprc_id, &res_req);
+
+	error2 = close_dprc(child_handle);
+	if (error == 0)
+		error = error2;
+
+	return error;
+}
+
+static int undo_mc_change(struct txn_entry *entry)
+{
+	uint16_t dprc_handle;
+	bool dprc_opened = false;
+	int error;
+
+	if (entry->dprc_id != restool.root_dprc_id) {
+		error = open_dprc(entry->dprc_id, &dprc_handle);
+		if (error < 0)
+			return error;
+
+		dprc_opened = true;
+	} else {
+		dprc_handle = restool.root_dprc_handle;
+	}
+
+	switch (entry->op) {
+	case TXN_OP_ASSIGN:
+		/* A plugged state change is undone by flipping it back */
+		if (entry->child_dprc_id == entry->dprc_id) {
+			entry->res_req.options ^= DPRC_RES_REQ_OPT_PLUGGED;
+			error = dprc_assign(&restool.mc_io, 0, dprc_handle,
+					    entry->child_dprc_id,
+					    &entry->res_req);
+		} else {
+			if (entry->res_req.options & DPRC_RES_REQ_OPT_PLUGGED) {
+				error = unplug_in_child(entry);
+				if (error < 0)
+					break;
+			}
+
+			entry->res_req.options &= ~DPRC_RES_REQ_OPT_PLUGGED;
+			error = dprc_unassign(&restool.mc_io, 0, dprc_handle,
+					      entry->child_dprc_id,
+					      &entry->res_req);
+		}
+		break;
+	case TXN_OP_UNASSIGN:
+		error = dprc_assign(&restool.mc_io, 0, dprc_handle,
+				    entry->child_dprc_id, &entry->res_req);
+		break;
+	case TXN_OP_CONNECT:
+		error = dprc_disconnect(&restool.mc_io, 0, dprc_handle,
+					&entry->endpoint);
+		break;
+	case TXN_OP_DISCONNECT: {
+		/* The MC does not report link rates, reconnect with defaults */
+		struct dprc_connection_cfg cfg = { 0 };
+
+		error = dprc_connect(&restool.mc_io, 0, dprc_handle,
+				     &entry->endpoint, &entry->peer, &cfg);
+		break;
+	}
+	case TXN_OP_SET_LABEL:
+		error = dprc_set_obj_label(&restool.mc_io, 0, dprc_handle,
+					   entry->type, entry->id,
+					   entry->old_label);
+		break;
+	default:
+		error = -EINVAL;
+		break;
+	}
+
+	if (error < 0) {
+		enum mc_cmd_status mc_status = flib_error_to_mc_status(error);
+
+		ERROR_PRINTF("MC error: %s (status %#x)\n",
+			     mc_status_to_string(mc_status), mc_status);
+	}
+
+	if (dprc_opened) {
+		int error2 = close_dprc(dprc_handle);
+
+		if (error == 0)
+			error = error2;
+	}
+
+	return error;
+}
+
+static void print_undo(const struct txn_entry *entry)
+{
+	char name[OBJ_TYPE_MAX_LENGTH + 24];
+
+	if (entry->res_req.options & DPRC_RES_REQ_OPT_EXPLICIT)
+		snprintf(name, sizeof(name), "%s.%d", entry->res_req.type,
+			 entry->res_req.id_base_align);
+	else
+		snprintf(name, sizeof(name), "%u %s resources",
+			 entry->res_req.num, entry->res_req.type);
+
+	switch (entry->op) {
+	case TXN_OP_CREATE:
+		printf("rollback: destroying %s\n", entry->obj_name);
+		break;
+	case TXN_OP_ASSIGN:
+		if (entry->child_dprc_id == entry->dprc_id)
+			printf("rollback: restoring plugged state of %s\n",
+			       name);
+		else
+			printf("rollback: moving %s back from dprc.%u to dprc.%u\n",
+			       name, entry->child_dprc_id, entry->dprc_id);
+		break;
+	case TXN_OP_UNASSIGN:
+		printf("rollback: moving %s back from dprc.%u to dprc.%u\n",
+		       name, entry->dprc_id, entry->child_dprc_id);
+		break;
+	case TXN_OP_CONNECT:
+		printf("rollback: disconnecting %s.%d\n",
+		       entry->endpoint.type, entry->endpoint.id);
+		break;
+	case TXN_OP_DISCONNECT:
+		printf("rollback: reconnecting %s.%d to %s.%d\n",
+		       entry->endpoint.type, entry->endpoint.id,
+		       entry->peer.type, entry->peer.id);
+		break;
+	case TXN_OP_SET_LABEL:
+		printf("rollback: restoring label \"%s\" of %s\n",
+		       entry->old_label, entry->obj_name);
+		break;
+	}
+}
+
+/**
+ * Undoes the journalled changes, newest first, and ends the
+ * transaction. Keeps going past an entry that cannot be undone and
+ * returns the first error seen. The undo commands go out on the
+ * priority lane, whatever the failed command was using.
+ */
+int txn_rollback(void)
+{
+	enum mc_lane lane = mc_lane_get();
+	int ret_error = 0;
+
+	active = false;
+	mc_lane_set(MC_LANE_PRIORITY);
+	for (int i = num_entries - 1; i >= 0; i--) {
+		struct txn_entry *entry = &journal[i];
+		int error;
+
+		print_undo(entry);
+		if (entry->op == TXN_OP_CREATE)
+			error = undo_create(entry);
+		else
+			error = undo_mc_change(entry);
+
+		if (error < 0) {
+			ERROR_PRINTF("rollback of journal entry %d failed\n",
+				     i + 1);
+			if (ret_error == 0)
+				ret_error = error;
+		}
+	}
+
+	mc_lane_set(lane);
+	label_index_invalidate();
+	txn_end();
+	return ret_error;
+}
@@ -0,0 +1,68 @@
+/* Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * * Neither the name of the above-listed copyright holders nor the
+ * names of any contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ *
+ * ALTERNATIVELY, this software may be distributed under the terms of the
+ * GNU General Public License ("GPL") as published by the Free Software
+ * Foundation, either version 2 of that License or (at your option) any
+ * later version.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TRANSACTION_H_
+#define _TRANSACTION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mc_v10/fsl_dprc.h"
+
+bool txn_active(void);
+
+void txn_begin(void);
+
+void txn_end(void);
+
+int txn_rollback(void);
+
+int txn_record_create(const char *type, int id);
+
+int txn_record_assign(bool do_assign, uint32_t parent_dprc_id,
+		      uint32_t child_dprc_id,
+		      const struct dprc_res_req *res_req);
+
+int txn_record_connect(uint32_t dprc_id,
+		       const struct dprc_endpoint *endpoint);
+
+int txn_record_disconnect(uint32_t dprc_id,
+			  const struct dprc_endpoint *endpoint,
+			  const struct dprc_endpoint *peer);
+
+int txn_record_set_label(uint32_t parent_dprc_id, const char *type, int id,
+			 const char *old_label);
+
+const char *txn_created_obj(int index);
+
+int txn_num_created(void);
+
+#endif /* _TRANSACTION_H_ */